@@ -7,36 +7,266 @@ GPU Computing / GPGPU Praktikum source code.
 
 #include "CReductionTask.h"
 #include "CScanTask.h"
+#include "CCompactionTask.h"
+#include "CRadixSortTask.h"
+#include "CRunLengthTask.h"
+#include "CIntegralImageTask.h"
+#include "CBatchedScanTask.h"
+#include "CGenericScanTask.h"
+#include "CReduceThenScanTask.h"
+#include "CStreamingTask.h"
+#include "CSegmentTreeTask.h"
+#include "CIncrementalScanTask.h"
+#include "CCompressedTask.h"
+#include "CNarrowTask.h"
+#include "CHybridTask.h"
+#include "CDispatchTask.h"
+#include "CTransferTask.h"
+
+#include "../Common/CResultLog.h"
 
 #include <iostream>
+#include <memory>
 
 using namespace std;
 
 ///////////////////////////////////////////////////////////////////////////////
 // CAssignment2
 
-bool CAssignment2::DoCompute()
+// A task of the main run, the heading is printed in front of the first task of each group
+struct SComputeTaskEntry
 {
-	// Task 1: parallel reduction
+	const char* Heading;
+	unique_ptr<IComputeTask> Task;
+};
+
+// Validates and benchmarks every variant of Task for each local work size, one log row per data point
+template <class TTask>
+static void SweepTask(const char* TaskName, TTask& Task, size_t N, const vector<size_t>& LocalWorkSizes,
+	cl_device_id Device, cl_context Context, cl_command_queue CommandQueue, CBenchmark& Benchmark, CResultLog& Log)
+{
+	if (!Task.InitResources(Device, Context))
+	{
+		cerr << "Error during resource allocation of " << TaskName << " for N = " << N << endl;
+		Task.ReleaseResources();
+		return;
+	}
+	Task.ComputeCPU();
+
+	if (!Task.InitPrograms(Device, Context))
+	{
+		cerr << "Error during program creation of " << TaskName << " for N = " << N << endl;
+		Task.ReleaseResources();
+		return;
+	}
+
+	for (size_t i = 0; i < LocalWorkSizes.size(); i++)
+	{
+		if (!Task.SupportsSize(LocalWorkSizes[i]))
+			continue;
+
+		size_t LocalWorkSize[3] = {LocalWorkSizes[i], 1, 1};
+		for (unsigned int variant = 0; variant < TTask::GetVariantCount(); variant++)
+		{
+			CResultLog::SRow row;
+			row.Task = TaskName;
+			row.Variant = TTask::GetVariantName(variant);
+			row.N = N;
+			row.LocalWorkSize = LocalWorkSize[0];
+			row.BytesPerElement = TTask::GetBytesPerElement();
+			row.bValid = Task.ValidateVariant(Context, CommandQueue, LocalWorkSize, variant);
+			row.Result = Task.BenchmarkVariant(Context, CommandQueue, LocalWorkSize, variant, Benchmark);
+			Log.Write(row);
+
+			cout << "  " << TaskName << " " << row.Variant << " N = " << N << " local = " << LocalWorkSize[0]
+				<< ": " << row.Result.Median << " ms" << (row.bValid ? "" : " INVALID") << endl;
+		}
+	}
+
+	Task.ReleaseResources();
+}
+
+bool CAssignment2::DoSweep()
+{
+	string baseName = GetArgumentValue("--sweep-output", "Sweep");
+	CResultLog log;
+	if (!log.Open(baseName, m_CLDevice))
+		return false;
+
+	// powers of two from 64 up to the device limit
+	size_t maxWorkGroupSize = 0;
+	V_RETURN_FALSE_CL(clGetDeviceInfo(m_CLDevice, CL_DEVICE_MAX_WORK_GROUP_SIZE, sizeof(size_t), &maxWorkGroupSize, NULL),
+		"Failed to query the maximum work-group size");
+	vector<size_t> localWorkSizes;
+	for (size_t localWorkSize = 64; localWorkSize <= min(maxWorkGroupSize, (size_t)1024); localWorkSize *= 2)
+		localWorkSizes.push_back(localWorkSize);
+	if (localWorkSizes.empty())
+		return false;
+
+	// powers of two and odd sizes in between, the odd ones show the cost of the partial blocks
+	vector<size_t> arraySizes;
+	for (unsigned int log2N = 10; log2N <= 24; log2N += 2)
+	{
+		arraySizes.push_back((size_t)1 << log2N);
+		arraySizes.push_back((((size_t)3 << log2N) / 2) | 1);
+	}
+
+	// shorter runs per data point than the default, the sweep has a few hundred of them
+	CBenchmark::SSettings settings;
+	settings.WarmupIterations = 2;
+	settings.MaxSeconds = 1.0;
+	CBenchmark benchmark(settings);
+
 	cout<<"########################################"<<endl;
-	cout<<"Running parallel reduction task..."<<endl<<endl;
+	cout<<"Running parameter sweep..."<<endl<<endl;
+	for (size_t i = 0; i < arraySizes.size(); i++)
 	{
-		size_t LocalWorkSize[3] = {256, 1, 1};
-		CReductionTask reduction(1024 * 1024 * 16);
-		RunComputeTask(reduction, LocalWorkSize);
+		CReductionTask reduction(arraySizes[i], localWorkSizes[0]);
+		SweepTask("reduction", reduction, arraySizes[i], localWorkSizes, m_CLDevice, m_CLContext, m_CLCommandQueue, benchmark, log);
+
+		CScanTask scan(arraySizes[i], localWorkSizes[0]);
+		SweepTask("scan", scan, arraySizes[i], localWorkSizes, m_CLDevice, m_CLContext, m_CLCommandQueue, benchmark, log);
 	}
 
+	log.Close();
+	cout << "Results written to " << baseName << ".csv and " << baseName << ".json" << endl;
+
+	return true;
+}
+
+bool CAssignment2::DoCompute()
+{
+	if (HasArgument("--sweep"))
+		return DoSweep();
+
+	// All tasks are created up front, so their programs can compile in the background
+	// (see CProgramBuilder) while the earlier tasks run. Heading starts a group of tasks.
+	vector<SComputeTaskEntry> tasks;
+	auto addTask = [&tasks](const char* Heading, IComputeTask* Task)
+	{
+		tasks.push_back(SComputeTaskEntry());
+		tasks.back().Heading = Heading;
+		tasks.back().Task.reset(Task);
+	};
+
+	size_t LocalWorkSize[3] = {256, 1, 1};
+
+	// Task 1: parallel reduction
+	addTask("Running parallel reduction task...", new CReductionTask(1024 * 1024 * 16, LocalWorkSize[0]));
+
 	// Task 2: parallel prefix sum
-	cout<<"########################################"<<endl;
-	cout<<"Running parallel prefix sum task..."<<endl<<endl;
+	//addTask("Running parallel prefix sum task...", new CScanTask(1024 * 1024 * 64, LocalWorkSize[0]));
+	addTask("Running parallel prefix sum task...", new CScanTask(512, LocalWorkSize[0]));
+
+	// Scan and reduction routed to the host, one work-group or the multi-pass kernels by size
+	addTask("Running size-aware dispatch task...", new CDispatchTask(1024 * 1024 * 16, LocalWorkSize[0]));
+
+	// Stream compaction on top of the scan
+	addTask("Running stream compaction task...", new CCompactionTask(1024 * 1024 * 16, LocalWorkSize[0], "(x & 3) == 0",
+		[](unsigned int x) { return (x & 3) == 0; }));
+
+	// Radix sort on top of the scan
+	addTask("Running radix sort task...", new CRadixSortTask(1024 * 1024 * 4, LocalWorkSize[0], 32, 4, false));
+	addTask(NULL, new CRadixSortTask(1024 * 1024 * 4, LocalWorkSize[0], 32, 8, true));
+	addTask(NULL, new CRadixSortTask(1024 * 1024 * 4, LocalWorkSize[0], 64, 8, true));
+
+	// Run-length encoding and unique on top of the scan
+	addTask("Running run-length encoding task...", new CRunLengthTask(1024 * 1024 * 16, LocalWorkSize[0]));
+
+	// Summed-area table from row and column scans
+	addTask("Running integral image task...", new CIntegralImageTask(3840, 2160));
+	addTask(NULL, new CIntegralImageTask(1001, 777));
+
+	// Batched scans of many short rows
+	addTask("Running batched scan task...", new CBatchedScanTask(8192, 256, LocalWorkSize[0]));
+	addTask(NULL, new CBatchedScanTask(1024, 16384, LocalWorkSize[0]));
+
+	// Scans with other element types and operators
+	{
+		unsigned int arraySize = 16 * 1024 * 1024;
+		addTask("Running generic scan task...", new CGenericScanTask<CScanOpMaxUInt>(arraySize, LocalWorkSize[0]));
+		addTask(NULL, new CGenericScanTask<CScanOpAddFloat>(arraySize, LocalWorkSize[0]));
+		addTask(NULL, new CGenericScanTask<CScanOpMaxFloat>(arraySize, LocalWorkSize[0]));
+		addTask(NULL, new CGenericScanTask<CScanOpLinearRecurrence>(arraySize, LocalWorkSize[0]));
+	}
+
+	// Reduce-then-scan compared with the multi-level scan, the array has to fit into one buffer
+	{
+		cl_ulong maxAllocSize = 0;
+		V_RETURN_FALSE_CL(clGetDeviceInfo(m_CLDevice, CL_DEVICE_MAX_MEM_ALLOC_SIZE, sizeof(cl_ulong), &maxAllocSize, NULL),
+			"Failed to query the maximum allocation size");
+
+		const char* heading = "Running reduce-then-scan task...";
+		size_t arraySizes[] = { 1024 * 1024, 16 * 1024 * 1024, 64 * 1024 * 1024, 256 * 1024 * 1024 };
+		for (size_t i = 0; i < ARRAYLEN(arraySizes); i++)
+		{
+			if (sizeof(cl_uint) * arraySizes[i] > maxAllocSize)
+			{
+				cout << "Skipping reduce-then-scan with " << arraySizes[i] << " elements, the device allocates at most "
+					<< maxAllocSize << " bytes per buffer" << endl;
+				continue;
+			}
+			addTask(heading, new CReduceThenScanTask(arraySizes[i], LocalWorkSize[0]));
+			heading = NULL;
+		}
+	}
+
+	// Host-device bandwidth of the pageable, pinned, host-pointer and zero-copy transfers
+	addTask("Running transfer strategy task...", new CTransferTask(1024 * 1024 * 16));
+
+	// Out-of-core scan and reduction, the input is streamed through the device in chunks
+	addTask("Running streaming task...", new CStreamingTask(256 * 1024 * 1024, 16 * 1024 * 1024, LocalWorkSize[0]));
+
+	// Range queries and point updates on a persistent segment tree, the prime size leaves
+	// partial nodes on every level
 	{
-		//size_t LocalWorkSize[3] = { 4, 1, 1 };
-		size_t LocalWorkSize[3] = {256, 1, 1};
-		//CScanTask scan(1024 * 1024 * 64, LocalWorkSize[0]);
-		CScanTask scan(512, LocalWorkSize[0]);
-		RunComputeTask(scan, LocalWorkSize);
+		size_t arraySizes[] = { 16 * 1024 * 1024, 1000003 };
+		ESegmentTreeOp ops[] = { SEGMENT_TREE_SUM, SEGMENT_TREE_MIN, SEGMENT_TREE_MAX };
+		for (size_t i = 0; i < ARRAYLEN(arraySizes); i++)
+			for (size_t j = 0; j < ARRAYLEN(ops); j++)
+				addTask(i == 0 && j == 0 ? "Running segment tree task..." : NULL,
+					new CSegmentTreeTask(arraySizes[i], 1024 * 1024, 64 * 1024, ops[j]));
 	}
 
+	// Incremental maintenance of a resident scan
+	addTask("Running incremental scan task...", new CIncrementalScanTask(16 * 1024 * 1024, 4096, 10000, 100000));
+
+	// Reduction and scan of bit-packed and delta-encoded columns
+	{
+		unsigned int bits[] = {4, 8, 12, 16};
+		for (int delta = 0; delta < 2; delta++)
+			for (size_t i = 0; i < ARRAYLEN(bits); i++)
+				addTask(delta == 0 && i == 0 ? "Running compressed column tasks..." : NULL, new CCompressedTask(16 * 1024 * 1024, bits[i], delta != 0));
+	}
+
+	// Reduction and scan of narrow inputs with wider accumulators
+	{
+		unsigned int arraySize = 16 * 1024 * 1024;
+		addTask("Running narrow input tasks...", new CNarrowTask<CNarrowUChar>(arraySize));
+		addTask(NULL, new CNarrowTask<CNarrowUShort>(arraySize));
+		addTask(NULL, new CNarrowTask<CNarrowUShortULong>(arraySize));
+		addTask(NULL, new CNarrowTask<CNarrowHalf>(arraySize));
+	}
+
+	// Scan and reduction split between the host threads and the device
+	addTask("Running hybrid host/device task...", new CHybridTask(64 * 1024 * 1024, LocalWorkSize[0]));
+
+	for (size_t i = 0; i < tasks.size(); i++)
+		tasks[i].Task->StartProgramBuilds(m_CLDevice, m_CLContext);
+
+	for (size_t i = 0; i < tasks.size(); i++)
+	{
+		if (tasks[i].Heading != NULL)
+		{
+			cout<<"########################################"<<endl;
+			cout<<tasks[i].Heading<<endl<<endl;
+		}
+
+		RunComputeTask(*tasks[i].Task, LocalWorkSize);
+
+		// the device buffers are gone after RunComputeTask, the host data goes with the task
+		tasks[i].Task.reset();
+	}
 
 	return true;
 }
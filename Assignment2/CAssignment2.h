@@ -30,6 +30,10 @@ public:
 
 	//! This overloaded method contains the specific solution of A2
 	virtual bool DoCompute();
+
+protected:
+	//! Benchmarks the reduction and scan variants over array sizes and local work sizes (command line: --sweep [--sweep-output BaseName])
+	bool DoSweep();
 };
 
 #endif // _CASSIGNMENT2_H
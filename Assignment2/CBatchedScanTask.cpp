@@ -0,0 +1,343 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+
+#include "CBatchedScanTask.h"
+
+#include "../Common/CLUtil.h"
+#include "../Common/CProgramBuilder.h"
+#include "../Common/CTimer.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// CBatchedScanTask
+
+// only useful for debug info
+static const string g_BatchedScanNames[3] =
+{
+	"perRowScanWorkEfficient",
+	"oneGroupPerRow",
+	"multiGroupPerRow"
+};
+
+CBatchedScanTask::CBatchedScanTask(size_t nRows, size_t RowLength, size_t MinLocalWorkSize)
+	: m_nRows(nRows), m_RowLength(RowLength), m_N(nRows * RowLength),
+	m_hInput(NULL), m_hResultCPU(NULL), m_hResultGPU(NULL),
+	m_dInput(NULL), m_dOutput(NULL), m_dBlockSums(NULL),
+	m_MinLocalWorkSize(MinLocalWorkSize), m_RowScan(RowLength, MinLocalWorkSize),
+	m_Program(NULL), m_ScanRowsKernel(NULL), m_ScanBatchedKernel(NULL), m_ScanBatchedAddKernel(NULL)
+{
+	// Reset validation results
+	for (int i = 0; i < (int)ARRAYLEN(m_bValidationResults); i++)
+		m_bValidationResults[i] = false;
+}
+
+CBatchedScanTask::~CBatchedScanTask()
+{
+	ReleaseResources();
+}
+
+bool CBatchedScanTask::InitResources(cl_device_id Device, cl_context Context)
+{
+	//CPU resources
+	m_hInput	 = new unsigned int[m_N];
+	m_hResultCPU = new unsigned int[m_N];
+	m_hResultGPU = new unsigned int[m_N];
+
+	//fill the array with some values
+	for(size_t i = 0; i < m_N; i++)
+		m_hInput[i] = rand() & 15;
+
+	//device resources
+	size_t blocksPerRow = (m_RowLength + 2 * m_MinLocalWorkSize - 1) / (2 * m_MinLocalWorkSize);
+
+	cl_int clError, clError2;
+	m_dInput = clCreateBuffer(Context, CL_MEM_READ_ONLY, sizeof(cl_uint) * m_N, NULL, &clError2);
+	clError = clError2;
+	m_dOutput = clCreateBuffer(Context, CL_MEM_READ_WRITE, sizeof(cl_uint) * m_N, NULL, &clError2);
+	clError |= clError2;
+	m_dBlockSums = clCreateBuffer(Context, CL_MEM_READ_WRITE, sizeof(cl_uint) * blocksPerRow * m_nRows, NULL, &clError2);
+	clError |= clError2;
+	V_RETURN_FALSE_CL(clError, "Error allocating device arrays");
+
+	// the per-row baseline needs one sub-buffer per row, which requires aligned row starts
+	cl_uint baseAddrAlign;
+	clGetDeviceInfo(Device, CL_DEVICE_MEM_BASE_ADDR_ALIGN, sizeof(cl_uint), &baseAddrAlign, NULL);
+	if ((m_RowLength * sizeof(cl_uint) * 8) % baseAddrAlign == 0)
+	{
+		for (unsigned int row = 0; row < m_nRows; row++) {
+			cl_buffer_region region = { row * m_RowLength * sizeof(cl_uint), m_RowLength * sizeof(cl_uint) };
+			m_dRows.push_back(clCreateSubBuffer(m_dOutput, CL_MEM_READ_WRITE, CL_BUFFER_CREATE_TYPE_REGION, &region, &clError));
+			V_RETURN_FALSE_CL(clError, "Error creating row sub-buffers");
+		}
+	}
+	else
+	{
+		cout << "Rows are not aligned to " << baseAddrAlign << " bits, skipping the per-row baseline." << endl;
+	}
+
+	return true;
+}
+
+bool CBatchedScanTask::InitPrograms(cl_device_id Device, cl_context Context)
+{
+	cl_int clError;
+
+	//load and compile kernels
+	string programCode;
+
+	if (!CLUtil::LoadProgramSourceToMemory("Scan.cl", programCode))
+		return false;
+	m_Program = CLUtil::BuildCLProgramFromMemory(Device, Context, programCode);
+	if(m_Program == nullptr) return false;
+
+	//create kernels
+	m_ScanRowsKernel = clCreateKernel(m_Program, "Scan_WorkEfficientRows", &clError);
+	V_RETURN_FALSE_CL(clError, "Failed to create kernel: Scan_WorkEfficientRows.");
+
+	m_ScanBatchedKernel = clCreateKernel(m_Program, "Scan_WorkEfficientBatched", &clError);
+	V_RETURN_FALSE_CL(clError, "Failed to create kernel: Scan_WorkEfficientBatched.");
+
+	m_ScanBatchedAddKernel = clCreateKernel(m_Program, "Scan_WorkEfficientBatchedAdd", &clError);
+	V_RETURN_FALSE_CL(clError, "Failed to create kernel: Scan_WorkEfficientBatchedAdd.");
+
+	if (!m_RowScan.InitResources(Context, m_Program))
+		return false;
+
+	return true;
+}
+
+void CBatchedScanTask::StartProgramBuilds(cl_device_id Device, cl_context Context)
+{
+	string programCode;
+
+	if (CLUtil::LoadProgramSourceToMemory("Scan.cl", programCode))
+		CProgramBuilder::BuildAsync(Device, Context, programCode);
+}
+
+void CBatchedScanTask::ReleaseResources()
+{
+	// host resources
+	SAFE_DELETE_ARRAY(m_hInput);
+	SAFE_DELETE_ARRAY(m_hResultCPU);
+	SAFE_DELETE_ARRAY(m_hResultGPU);
+
+	// device resources
+	for (size_t i = 0; i < m_dRows.size(); i++)
+		SAFE_RELEASE_MEMOBJECT(m_dRows[i]);
+	m_dRows.clear();
+
+	SAFE_RELEASE_MEMOBJECT(m_dInput);
+	SAFE_RELEASE_MEMOBJECT(m_dOutput);
+	SAFE_RELEASE_MEMOBJECT(m_dBlockSums);
+
+	m_RowScan.ReleaseResources();
+
+	SAFE_RELEASE_KERNEL(m_ScanRowsKernel);
+	SAFE_RELEASE_KERNEL(m_ScanBatchedKernel);
+	SAFE_RELEASE_KERNEL(m_ScanBatchedAddKernel);
+
+	SAFE_RELEASE_PROGRAM(m_Program);
+}
+
+void CBatchedScanTask::ComputeGPU(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
+{
+	cout << endl;
+
+	for (unsigned int task = 0; task < 3; task++)
+		ValidateTask(Context, CommandQueue, LocalWorkSize, task);
+
+	cout << endl;
+
+	for (unsigned int task = 0; task < 3; task++)
+		TestPerformance(Context, CommandQueue, LocalWorkSize, task);
+
+	cout << endl;
+}
+
+void CBatchedScanTask::ComputeCPU()
+{
+	CTimer timer;
+	timer.Start();
+
+	for(unsigned int row = 0; row < m_nRows; row++) {
+		size_t rowStart = (size_t)row * m_RowLength;
+		unsigned int sum = 0;
+		for(unsigned int i = 0; i < m_RowLength; i++) {
+			sum += m_hInput[rowStart + i];
+			m_hResultCPU[rowStart + i] = sum;
+		}
+	}
+
+	timer.Stop();
+	double ms = timer.GetElapsedMilliseconds();
+	cout << "  average time: " << ms << " ms, throughput: " << 1.0e-6 * (double)m_N / ms << " Gelem/s" <<endl;
+}
+
+bool CBatchedScanTask::ValidateResults()
+{
+	bool success = true;
+
+	for(int i = 0; i < (int)ARRAYLEN(m_bValidationResults); i++)
+		if(!m_bValidationResults[i])
+		{
+			cout<<"Validation of batched scan "<<g_BatchedScanNames[i]<<" failed." << endl;
+			success = false;
+		}
+
+	return success;
+}
+
+void CBatchedScanTask::Scan_PerRow(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
+{
+	for (size_t row = 0; row < m_dRows.size(); row++)
+		m_RowScan.Scan(CommandQueue, m_dRows[row], m_RowLength, LocalWorkSize[0]);
+}
+
+void CBatchedScanTask::Scan_OneGroupPerRow(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
+{
+	cl_int clErr;
+	size_t globalWorkSize[2] = { LocalWorkSize[0], m_nRows };
+	size_t localWorkSize[2] = { LocalWorkSize[0], 1 };
+
+	clErr = clSetKernelArg(m_ScanRowsKernel, 0, sizeof(cl_mem), (void*)&m_dInput);
+	clErr |= clSetKernelArg(m_ScanRowsKernel, 1, sizeof(cl_mem), (void*)&m_dOutput);
+	clErr |= clSetKernelArg(m_ScanRowsKernel, 2, sizeof(cl_uint), (void*)&m_RowLength);
+	clErr |= clSetKernelArg(m_ScanRowsKernel, 3, 4 * localWorkSize[0] * sizeof(cl_uint), NULL);
+	V_RETURN_CL(clErr, "Failed to set Scan_WorkEfficientRows arguments");
+
+	clErr = clEnqueueNDRangeKernel(CommandQueue, m_ScanRowsKernel, 2, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+	V_RETURN_CL(clErr, "Error executing Scan_WorkEfficientRows!");
+}
+
+void CBatchedScanTask::Scan_MultiGroupPerRow(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
+{
+	cl_int clErr;
+	size_t globalWorkSize[2];
+	size_t localWorkSize[2] = { LocalWorkSize[0], 1 };
+
+	cl_uint blocksPerRow = (cl_uint)((m_RowLength + 2 * localWorkSize[0] - 1) / (2 * localWorkSize[0]));
+
+	// 1. scan every block of every row
+	globalWorkSize[0] = blocksPerRow * localWorkSize[0];
+	globalWorkSize[1] = m_nRows;
+
+	clErr = clSetKernelArg(m_ScanBatchedKernel, 0, sizeof(cl_mem), (void*)&m_dInput);
+	clErr |= clSetKernelArg(m_ScanBatchedKernel, 1, sizeof(cl_mem), (void*)&m_dOutput);
+	clErr |= clSetKernelArg(m_ScanBatchedKernel, 2, sizeof(cl_mem), (void*)&m_dBlockSums);
+	clErr |= clSetKernelArg(m_ScanBatchedKernel, 3, sizeof(cl_uint), (void*)&m_RowLength);
+	clErr |= clSetKernelArg(m_ScanBatchedKernel, 4, 4 * localWorkSize[0] * sizeof(cl_uint), NULL);
+	V_RETURN_CL(clErr, "Failed to set Scan_WorkEfficientBatched arguments");
+
+	clErr = clEnqueueNDRangeKernel(CommandQueue, m_ScanBatchedKernel, 2, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+	V_RETURN_CL(clErr, "Error executing Scan_WorkEfficientBatched!");
+
+	// a row that fits into one block is done
+	if (blocksPerRow == 1)
+		return;
+
+	// 2. scan the block sums of every row in place
+	globalWorkSize[0] = localWorkSize[0];
+
+	clErr = clSetKernelArg(m_ScanRowsKernel, 0, sizeof(cl_mem), (void*)&m_dBlockSums);
+	clErr |= clSetKernelArg(m_ScanRowsKernel, 1, sizeof(cl_mem), (void*)&m_dBlockSums);
+	clErr |= clSetKernelArg(m_ScanRowsKernel, 2, sizeof(cl_uint), (void*)&blocksPerRow);
+	clErr |= clSetKernelArg(m_ScanRowsKernel, 3, 4 * localWorkSize[0] * sizeof(cl_uint), NULL);
+	V_RETURN_CL(clErr, "Failed to set Scan_WorkEfficientRows arguments");
+
+	clErr = clEnqueueNDRangeKernel(CommandQueue, m_ScanRowsKernel, 2, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+	V_RETURN_CL(clErr, "Error executing Scan_WorkEfficientRows!");
+
+	// 3. add the sums of the preceding blocks
+	globalWorkSize[0] = CLUtil::GetGlobalWorkSize(m_RowLength, localWorkSize[0]);
+
+	clErr = clSetKernelArg(m_ScanBatchedAddKernel, 0, sizeof(cl_mem), (void*)&m_dBlockSums);
+	clErr |= clSetKernelArg(m_ScanBatchedAddKernel, 1, sizeof(cl_mem), (void*)&m_dOutput);
+	clErr |= clSetKernelArg(m_ScanBatchedAddKernel, 2, sizeof(cl_uint), (void*)&m_RowLength);
+	V_RETURN_CL(clErr, "Failed to set Scan_WorkEfficientBatchedAdd arguments");
+
+	clErr = clEnqueueNDRangeKernel(CommandQueue, m_ScanBatchedAddKernel, 2, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+	V_RETURN_CL(clErr, "Error executing Scan_WorkEfficientBatchedAdd!");
+}
+
+void CBatchedScanTask::ValidateTask(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task)
+{
+	m_bValidationResults[Task] = false;
+
+	//the per-row baseline is optional
+	if (Task == 0 && m_dRows.empty())
+	{
+		m_bValidationResults[Task] = true;
+		return;
+	}
+
+	V_RETURN_CL(clEnqueueWriteBuffer(CommandQueue, m_dInput, CL_FALSE, 0, m_N * sizeof(cl_uint), m_hInput, 0, NULL, NULL), "Error copying data from host to device!");
+
+	//run selected task
+	switch (Task){
+		case 0:
+			V_RETURN_CL(clEnqueueCopyBuffer(CommandQueue, m_dInput, m_dOutput, 0, 0, m_N * sizeof(cl_uint), 0, NULL, NULL), "Error copying the input!");
+			Scan_PerRow(Context, CommandQueue, LocalWorkSize);
+			break;
+		case 1:
+			Scan_OneGroupPerRow(Context, CommandQueue, LocalWorkSize);
+			break;
+		case 2:
+			Scan_MultiGroupPerRow(Context, CommandQueue, LocalWorkSize);
+			break;
+	}
+
+	V_RETURN_CL(clEnqueueReadBuffer(CommandQueue, m_dOutput, CL_TRUE, 0, m_N * sizeof(cl_uint), m_hResultGPU, 0, NULL, NULL), "Error reading data from device!");
+
+	// validate results
+	m_bValidationResults[Task] = (memcmp(m_hResultCPU, m_hResultGPU, m_N * sizeof(unsigned int)) == 0);
+}
+
+void CBatchedScanTask::TestPerformance(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task)
+{
+	if (Task == 0 && m_dRows.empty())
+		return;
+
+	cout << "Testing performance of " << g_BatchedScanNames[Task] << " (" << m_nRows << " rows of " << m_RowLength << " elements)" << endl;
+
+	//write input data to the GPU
+	V_RETURN_CL(clEnqueueWriteBuffer(CommandQueue, m_dInput, CL_FALSE, 0, m_N * sizeof(cl_uint), m_hInput, 0, NULL, NULL), "Error copying data from host to device!");
+	//finish all before we start meassuring the time
+	V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
+
+	CTimer timer;
+	timer.Start();
+
+	//run the kernel N times
+	unsigned int nIterations = 10;
+	for(unsigned int i = 0; i < nIterations; i++) {
+		//run selected task
+		switch (Task){
+			case 0:
+				Scan_PerRow(Context, CommandQueue, LocalWorkSize);
+				break;
+			case 1:
+				Scan_OneGroupPerRow(Context, CommandQueue, LocalWorkSize);
+				break;
+			case 2:
+				Scan_MultiGroupPerRow(Context, CommandQueue, LocalWorkSize);
+				break;
+		}
+	}
+
+	//wait until the command queue is empty again
+	V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
+
+	timer.Stop();
+
+	double ms = timer.GetElapsedMilliseconds() / double(nIterations);
+	cout << "  average time: " << ms << " ms, throughput: " << 1.0e-6 * (double)m_N / ms << " Gelem/s" <<endl;
+}
+
+///////////////////////////////////////////////////////////////////////////////
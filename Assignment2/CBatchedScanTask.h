@@ -0,0 +1,96 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CBATCHED_SCAN_TASK_H
+#define _CBATCHED_SCAN_TASK_H
+
+#include "../Common/IComputeTask.h"
+
+#include "CScanHierarchy.h"
+
+#include <vector>
+
+//! Inclusive prefix sums of many independent rows
+/*!
+	Compares three ways to scan a batch of rows:
+	- perRowScanWorkEfficient: one work-efficient scan (CScanHierarchy) per row, launched from the host
+	- oneGroupPerRow: one launch of Scan_WorkEfficientRows, every work-group walks over its row
+	- multiGroupPerRow: 2D NDRange with several work-groups per row, their block sums are
+	  scanned with Scan_WorkEfficientRows and added back (3 launches in total)
+*/
+class CBatchedScanTask : public IComputeTask
+{
+public:
+	CBatchedScanTask(size_t nRows, size_t RowLength, size_t MinLocalWorkSize);
+
+	virtual ~CBatchedScanTask();
+
+	// IComputeTask
+	virtual bool InitResources(cl_device_id Device, cl_context Context);
+
+	virtual void StartProgramBuilds(cl_device_id Device, cl_context Context);
+
+	virtual bool InitPrograms(cl_device_id Device, cl_context Context);
+
+	virtual void ReleaseResources();
+
+	virtual void ComputeGPU(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
+
+	virtual void ComputeCPU();
+
+	virtual bool ValidateResults();
+
+protected:
+
+	//! All variants scan m_dInput into m_dOutput, except the per-row loop which scans m_dOutput in place
+	void Scan_PerRow(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
+	void Scan_OneGroupPerRow(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
+	void Scan_MultiGroupPerRow(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
+
+	void ValidateTask(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task);
+	void TestPerformance(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task);
+
+	unsigned int		m_nRows;
+	unsigned int		m_RowLength;
+	size_t				m_N;
+
+	unsigned int		*m_hInput;
+
+	unsigned int		*m_hResultCPU;
+	unsigned int		*m_hResultGPU;
+	bool				m_bValidationResults[3];
+
+	cl_mem				m_dInput;
+	cl_mem				m_dOutput;
+	cl_mem				m_dBlockSums;
+
+	// sub-buffers of m_dOutput for the per-row scans (empty if the rows are not aligned for sub-buffers)
+	std::vector<cl_mem>	m_dRows;
+
+	size_t				m_MinLocalWorkSize;
+	CScanHierarchy		m_RowScan;
+
+	//OpenCL program and kernels
+	cl_program			m_Program;
+	cl_kernel			m_ScanRowsKernel;
+	cl_kernel			m_ScanBatchedKernel;
+	cl_kernel			m_ScanBatchedAddKernel;
+};
+
+#endif // _CBATCHED_SCAN_TASK_H
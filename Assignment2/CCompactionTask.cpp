@@ -0,0 +1,245 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+
+#include "CCompactionTask.h"
+
+#include "../Common/CLUtil.h"
+#include "../Common/CProgramBuilder.h"
+#include "../Common/CTimer.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// CCompactionTask
+
+CCompactionTask::CCompactionTask(size_t ArraySize, size_t MinLocalWorkSize, const std::string& Predicate, bool (*pCPUPredicate)(unsigned int))
+	: m_N(ArraySize), m_Predicate(Predicate), m_pCPUPredicate(pCPUPredicate),
+	m_hInput(NULL), m_hResultCPU(NULL), m_hResultGPU(NULL),
+	m_nSelectedCPU(0), m_nSelectedGPU(0), m_bValidationResult(false),
+	m_dInput(NULL), m_dOutput(NULL), m_dBlockCounts(NULL),
+	m_MinLocalWorkSize(MinLocalWorkSize), m_BlockScan((ArraySize + 2 * MinLocalWorkSize - 1) / (2 * MinLocalWorkSize), MinLocalWorkSize),
+	m_Program(NULL), m_CountBlocksKernel(NULL), m_ScatterKernel(NULL)
+{
+}
+
+CCompactionTask::~CCompactionTask()
+{
+	ReleaseResources();
+}
+
+bool CCompactionTask::InitResources(cl_device_id Device, cl_context Context)
+{
+	//CPU resources
+	m_hInput	 = new unsigned int[m_N];
+	m_hResultCPU = new unsigned int[m_N];
+	m_hResultGPU = new unsigned int[m_N];
+
+	//fill the array with some values
+	for(unsigned int i = 0; i < m_N; i++)
+		m_hInput[i] = rand() & 15;
+
+	//device resources
+	size_t nBlocks = (m_N + 2 * m_MinLocalWorkSize - 1) / (2 * m_MinLocalWorkSize);
+
+	cl_int clError, clError2;
+	m_dInput = clCreateBuffer(Context, CL_MEM_READ_ONLY, sizeof(cl_uint) * m_N, NULL, &clError2);
+	clError = clError2;
+	m_dOutput = clCreateBuffer(Context, CL_MEM_WRITE_ONLY, sizeof(cl_uint) * m_N, NULL, &clError2);
+	clError |= clError2;
+	m_dBlockCounts = clCreateBuffer(Context, CL_MEM_READ_WRITE, sizeof(cl_uint) * nBlocks, NULL, &clError2);
+	clError |= clError2;
+	V_RETURN_FALSE_CL(clError, "Error allocating device arrays");
+
+	return true;
+}
+
+bool CCompactionTask::InitPrograms(cl_device_id Device, cl_context Context)
+{
+	cl_int clError;
+
+	//load and compile kernels, the predicate is injected in front of the source
+	string scanCode, compactionCode;
+
+	if (!CLUtil::LoadProgramSourceToMemory("Scan.cl", scanCode) ||
+		!CLUtil::LoadProgramSourceToMemory("Compaction.cl", compactionCode))
+		return false;
+
+	string programCode = "#define PREDICATE(x) (" + m_Predicate + ")\n" + scanCode + "\n" + compactionCode;
+	m_Program = CLUtil::BuildCLProgramFromMemory(Device, Context, programCode);
+	if(m_Program == nullptr) return false;
+
+	//create kernels
+	m_CountBlocksKernel = clCreateKernel(m_Program, "Compact_CountBlocks", &clError);
+	V_RETURN_FALSE_CL(clError, "Failed to create kernel: Compact_CountBlocks.");
+
+	m_ScatterKernel = clCreateKernel(m_Program, "Compact_Scatter", &clError);
+	V_RETURN_FALSE_CL(clError, "Failed to create kernel: Compact_Scatter.");
+
+	if (!m_BlockScan.InitResources(Context, m_Program))
+		return false;
+
+	return true;
+}
+
+void CCompactionTask::StartProgramBuilds(cl_device_id Device, cl_context Context)
+{
+	string scanCode, compactionCode;
+
+	if (CLUtil::LoadProgramSourceToMemory("Scan.cl", scanCode) &&
+		CLUtil::LoadProgramSourceToMemory("Compaction.cl", compactionCode))
+		CProgramBuilder::BuildAsync(Device, Context, "#define PREDICATE(x) (" + m_Predicate + ")\n" + scanCode + "\n" + compactionCode);
+}
+
+void CCompactionTask::ReleaseResources()
+{
+	// host resources
+	SAFE_DELETE_ARRAY(m_hInput);
+
+	SAFE_DELETE_ARRAY(m_hResultCPU);
+	SAFE_DELETE_ARRAY(m_hResultGPU);
+
+	// device resources
+	SAFE_RELEASE_MEMOBJECT(m_dInput);
+	SAFE_RELEASE_MEMOBJECT(m_dOutput);
+	SAFE_RELEASE_MEMOBJECT(m_dBlockCounts);
+
+	m_BlockScan.ReleaseResources();
+
+	SAFE_RELEASE_KERNEL(m_CountBlocksKernel);
+	SAFE_RELEASE_KERNEL(m_ScatterKernel);
+
+	SAFE_RELEASE_PROGRAM(m_Program);
+}
+
+void CCompactionTask::ComputeGPU(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
+{
+	cout << endl;
+
+	ValidateTask(Context, CommandQueue, LocalWorkSize);
+
+	cout << endl;
+
+	TestPerformance(Context, CommandQueue, LocalWorkSize);
+
+	cout << endl;
+}
+
+void CCompactionTask::ComputeCPU()
+{
+	CTimer timer;
+	timer.Start();
+
+	m_nSelectedCPU = 0;
+	for(unsigned int i = 0; i < m_N; i++) {
+		if (m_pCPUPredicate(m_hInput[i]))
+			m_hResultCPU[m_nSelectedCPU++] = m_hInput[i];
+	}
+
+	timer.Stop();
+	double ms = timer.GetElapsedMilliseconds();
+	cout << "  average time: " << ms << " ms, throughput: " << 1.0e-6 * (double)m_N / ms << " Gelem/s" <<endl;
+	cout << "  selected " << m_nSelectedCPU << " of " << m_N << " elements" << endl;
+}
+
+bool CCompactionTask::ValidateResults()
+{
+	if (!m_bValidationResult)
+	{
+		cout << "Validation of compaction kernel failed (CPU selected " << m_nSelectedCPU << ", GPU selected " << m_nSelectedGPU << ")." << endl;
+	}
+
+	return m_bValidationResult;
+}
+
+void CCompactionTask::Compact(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
+{
+	cl_int clErr;
+	size_t globalWorkSize[1];
+	size_t localWorkSize[1];
+
+	localWorkSize[0] = LocalWorkSize[0];
+	size_t nBlocks = (m_N + 2 * localWorkSize[0] - 1) / (2 * localWorkSize[0]);
+	globalWorkSize[0] = nBlocks * localWorkSize[0];
+
+	// 1. count the selected elements of each block
+	clErr = clSetKernelArg(m_CountBlocksKernel, 0, sizeof(cl_mem), (void*)&m_dInput);
+	clErr |= clSetKernelArg(m_CountBlocksKernel, 1, sizeof(cl_mem), (void*)&m_dBlockCounts);
+	clErr |= clSetKernelArg(m_CountBlocksKernel, 2, sizeof(cl_uint), (void*)&m_N);
+	clErr |= clSetKernelArg(m_CountBlocksKernel, 3, localWorkSize[0] * sizeof(cl_uint), NULL);
+	V_RETURN_CL(clErr, "Failed to set Compact_CountBlocks arguments");
+
+	clErr = clEnqueueNDRangeKernel(CommandQueue, m_CountBlocksKernel, 1, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+	V_RETURN_CL(clErr, "Error executing Compact_CountBlocks!");
+
+	// 2. the inclusive scan of the block counts gives the output offset of each block
+	m_BlockScan.Scan(CommandQueue, m_dBlockCounts, nBlocks, localWorkSize[0]);
+
+	// 3. scan the flags of each block in local memory and scatter
+	clErr = clSetKernelArg(m_ScatterKernel, 0, sizeof(cl_mem), (void*)&m_dInput);
+	clErr |= clSetKernelArg(m_ScatterKernel, 1, sizeof(cl_mem), (void*)&m_dBlockCounts);
+	clErr |= clSetKernelArg(m_ScatterKernel, 2, sizeof(cl_mem), (void*)&m_dOutput);
+	clErr |= clSetKernelArg(m_ScatterKernel, 3, sizeof(cl_uint), (void*)&m_N);
+	clErr |= clSetKernelArg(m_ScatterKernel, 4, 4 * localWorkSize[0] * sizeof(cl_uint), NULL);
+	V_RETURN_CL(clErr, "Failed to set Compact_Scatter arguments");
+
+	clErr = clEnqueueNDRangeKernel(CommandQueue, m_ScatterKernel, 1, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+	V_RETURN_CL(clErr, "Error executing Compact_Scatter!");
+}
+
+void CCompactionTask::ValidateTask(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
+{
+	m_bValidationResult = false;
+
+	size_t nBlocks = (m_N + 2 * LocalWorkSize[0] - 1) / (2 * LocalWorkSize[0]);
+
+	V_RETURN_CL(clEnqueueWriteBuffer(CommandQueue, m_dInput, CL_FALSE, 0, m_N * sizeof(cl_uint), m_hInput, 0, NULL, NULL), "Error copying data from host to device!");
+	Compact(Context, CommandQueue, LocalWorkSize);
+
+	// the last scanned block count is the number of selected elements
+	V_RETURN_CL(clEnqueueReadBuffer(CommandQueue, m_dBlockCounts, CL_TRUE, (nBlocks - 1) * sizeof(cl_uint), sizeof(cl_uint), &m_nSelectedGPU, 0, NULL, NULL), "Error reading data from device!");
+	cout << "GPU selected " << m_nSelectedGPU << " of " << m_N << " elements" << endl;
+
+	if (m_nSelectedGPU != m_nSelectedCPU)
+		return;
+
+	if (m_nSelectedGPU > 0)
+		V_RETURN_CL(clEnqueueReadBuffer(CommandQueue, m_dOutput, CL_TRUE, 0, m_nSelectedGPU * sizeof(cl_uint), m_hResultGPU, 0, NULL, NULL), "Error reading data from device!");
+
+	// validate results
+	m_bValidationResult = (memcmp(m_hResultCPU, m_hResultGPU, m_nSelectedCPU * sizeof(unsigned int)) == 0);
+}
+
+void CCompactionTask::TestPerformance(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
+{
+	cout << "Testing performance of compaction with predicate " << m_Predicate << endl;
+
+	//write input data to the GPU
+	V_RETURN_CL(clEnqueueWriteBuffer(CommandQueue, m_dInput, CL_FALSE, 0, m_N * sizeof(cl_uint), m_hInput, 0, NULL, NULL), "Error copying data from host to device!");
+	//finish all before we start meassuring the time
+	V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
+
+	CTimer timer;
+	timer.Start();
+
+	//run the kernel N times
+	unsigned int nIterations = 100;
+	for(unsigned int i = 0; i < nIterations; i++) {
+		Compact(Context, CommandQueue, LocalWorkSize);
+	}
+
+	//wait until the command queue is empty again
+	V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
+
+	timer.Stop();
+
+	double ms = timer.GetElapsedMilliseconds() / double(nIterations);
+	cout << "  average time: " << ms << " ms, throughput: " << 1.0e-6 * (double)m_N / ms << " Gelem/s" <<endl;
+}
+
+///////////////////////////////////////////////////////////////////////////////
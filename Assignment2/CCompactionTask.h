@@ -0,0 +1,96 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CCOMPACTION_TASK_H
+#define _CCOMPACTION_TASK_H
+
+#include "../Common/IComputeTask.h"
+
+#include "CScanHierarchy.h"
+
+#include <string>
+
+//! Stream compaction: keeps the elements that satisfy a predicate, in their original order
+/*!
+	The predicate is an OpenCL C expression of the element x (e.g. "(x & 1) == 0")
+	that is compiled into the kernels. The CPU reference uses the equivalent host function.
+
+	The GPU version works in three steps:
+	counting the selected elements per block, scanning the block counts with the
+	work-efficient scan and scattering the selected elements. The last step evaluates
+	the predicate again and scans the flags in local memory.
+*/
+class CCompactionTask : public IComputeTask
+{
+public:
+	CCompactionTask(size_t ArraySize, size_t MinLocalWorkSize, const std::string& Predicate, bool (*pCPUPredicate)(unsigned int));
+
+	virtual ~CCompactionTask();
+
+	// IComputeTask
+	virtual bool InitResources(cl_device_id Device, cl_context Context);
+
+	virtual void StartProgramBuilds(cl_device_id Device, cl_context Context);
+
+	virtual bool InitPrograms(cl_device_id Device, cl_context Context);
+
+	virtual void ReleaseResources();
+
+	virtual void ComputeGPU(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
+
+	virtual void ComputeCPU();
+
+	virtual bool ValidateResults();
+
+protected:
+
+	//! Enqueues the compaction of m_dInput into m_dOutput. The number of selected elements is in m_dBlockCounts[nBlocks - 1].
+	void Compact(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
+
+	void ValidateTask(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
+	void TestPerformance(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
+
+	unsigned int		m_N;
+
+	std::string			m_Predicate;
+	bool				(*m_pCPUPredicate)(unsigned int);
+
+	unsigned int		*m_hInput;
+
+	unsigned int		*m_hResultCPU;
+	unsigned int		*m_hResultGPU;
+	unsigned int		m_nSelectedCPU;
+	unsigned int		m_nSelectedGPU;
+	bool				m_bValidationResult;
+
+	cl_mem				m_dInput;
+	cl_mem				m_dOutput;
+	cl_mem				m_dBlockCounts;
+
+	// scan of the block counts
+	size_t				m_MinLocalWorkSize;
+	CScanHierarchy		m_BlockScan;
+
+	//OpenCL program and kernels
+	cl_program			m_Program;
+	cl_kernel			m_CountBlocksKernel;
+	cl_kernel			m_ScatterKernel;
+};
+
+#endif // _CCOMPACTION_TASK_H
@@ -0,0 +1,436 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+
+#include "CCompressedTask.h"
+
+#include "../Common/CLUtil.h"
+#include "../Common/CProgramBuilder.h"
+#include "../Common/CTimer.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <sstream>
+
+using namespace std;
+
+// work-groups of the reduction, the partial sums are combined on the host
+#define REDUCTION_GROUPS	256
+// upper bound for the number of tiles of the scan, see CReduceThenScanTask
+#define MAX_TILES			2048
+
+///////////////////////////////////////////////////////////////////////////////
+// CCompressedTask
+
+// only useful for debug info
+static const string g_CompressedTaskNames[4] =
+{
+	"reduceExpanded",
+	"reducePacked",
+	"scanExpanded",
+	"scanPacked"
+};
+
+CCompressedTask::CCompressedTask(size_t ArraySize, unsigned int Bits, bool Delta)
+	: m_N(ArraySize), m_Bits(Bits), m_bDelta(Delta), m_nPackedWords((ArraySize * Bits + 31) / 32 + 1),
+	m_hColumn(NULL), m_hPacked(NULL), m_hScanCPU(NULL), m_hScanGPU(NULL), m_ReductionCPU(0), m_hPartials(NULL),
+	m_dResult(NULL), m_dPartials(NULL), m_dTileSums(NULL), m_dTileColumnSums(NULL),
+	m_ScanTileSumsKernel(NULL), m_DeltaTileCarriesKernel(NULL)
+{
+	for (int i = 0; i < 2; i++)
+	{
+		m_dInputs[i] = NULL;
+		m_Programs[i] = NULL;
+		m_ReduceKernels[i] = NULL;
+		m_ReduceTilesKernels[i] = NULL;
+		m_ScanTilesKernels[i] = NULL;
+	}
+
+	// Reset validation results
+	for (int i = 0; i < (int)ARRAYLEN(m_bValidationResults); i++)
+		m_bValidationResults[i] = false;
+}
+
+CCompressedTask::~CCompressedTask()
+{
+	ReleaseResources();
+}
+
+bool CCompressedTask::InitResources(cl_device_id Device, cl_context Context)
+{
+	if (m_Bits < 1 || m_Bits > 16)
+	{
+		cerr << "Packed columns need 1 to 16 bits per value, not " << m_Bits << endl;
+		return false;
+	}
+
+	//CPU resources
+	m_hColumn	 = new unsigned int[m_N];
+	m_hPacked	 = new unsigned int[m_nPackedWords];
+	m_hScanCPU	 = new unsigned int[m_N];
+	m_hScanGPU	 = new unsigned int[m_N];
+	m_hPartials	 = new unsigned int[REDUCTION_GROUPS];
+
+	//fill the column with random values (or deltas) and pack them
+	memset(m_hPacked, 0, m_nPackedWords * sizeof(unsigned int));
+	unsigned int mask = (1u << m_Bits) - 1;
+	unsigned int column = 0;
+	for (size_t i = 0; i < m_N; i++)
+	{
+		unsigned int value = rand() & mask;
+		column = m_bDelta ? column + value : value;
+		m_hColumn[i] = column;
+
+		size_t bit = i * m_Bits;
+		size_t word = bit / 32;
+		unsigned int shift = bit % 32;
+		m_hPacked[word] |= value << shift;
+		if (shift + m_Bits > 32)
+			m_hPacked[word + 1] |= value >> (32 - shift);
+	}
+
+	//device resources
+	cl_int clError, clError2;
+	m_dInputs[EXPANDED] = clCreateBuffer(Context, CL_MEM_READ_ONLY, sizeof(cl_uint) * m_N, NULL, &clError2);
+	clError = clError2;
+	m_dInputs[PACKED] = clCreateBuffer(Context, CL_MEM_READ_ONLY, sizeof(cl_uint) * m_nPackedWords, NULL, &clError2);
+	clError |= clError2;
+	m_dResult = clCreateBuffer(Context, CL_MEM_READ_WRITE, sizeof(cl_uint) * m_N, NULL, &clError2);
+	clError |= clError2;
+	m_dPartials = clCreateBuffer(Context, CL_MEM_READ_WRITE, sizeof(cl_uint) * REDUCTION_GROUPS, NULL, &clError2);
+	clError |= clError2;
+	m_dTileSums = clCreateBuffer(Context, CL_MEM_READ_WRITE, sizeof(cl_uint) * MAX_TILES, NULL, &clError2);
+	clError |= clError2;
+	m_dTileColumnSums = clCreateBuffer(Context, CL_MEM_READ_WRITE, sizeof(cl_uint) * MAX_TILES, NULL, &clError2);
+	clError |= clError2;
+	V_RETURN_FALSE_CL(clError, "Error allocating device arrays");
+
+	return true;
+}
+
+bool CCompressedTask::InitPrograms(cl_device_id Device, cl_context Context)
+{
+	cl_int clError;
+
+	//load and compile kernels, once for the expanded and once for the packed column
+	string scanCode, compressedCode;
+
+	if (!CLUtil::LoadProgramSourceToMemory("Scan.cl", scanCode) ||
+		!CLUtil::LoadProgramSourceToMemory("Compressed.cl", compressedCode))
+		return false;
+
+	for (int i = 0; i < 2; i++)
+	{
+		m_Programs[i] = CLUtil::BuildCLProgramFromMemory(Device, Context, scanCode + "\n" + compressedCode, GetCompileOptions(i));
+		if(m_Programs[i] == nullptr) return false;
+
+		m_ReduceKernels[i] = clCreateKernel(m_Programs[i], "Packed_Reduce", &clError);
+		V_RETURN_FALSE_CL(clError, "Failed to create kernel: Packed_Reduce.");
+
+		m_ReduceTilesKernels[i] = clCreateKernel(m_Programs[i], "Packed_ReduceTiles", &clError);
+		V_RETURN_FALSE_CL(clError, "Failed to create kernel: Packed_ReduceTiles.");
+
+		m_ScanTilesKernels[i] = clCreateKernel(m_Programs[i], "Packed_ScanTiles", &clError);
+		V_RETURN_FALSE_CL(clError, "Failed to create kernel: Packed_ScanTiles.");
+	}
+
+	m_ScanTileSumsKernel = clCreateKernel(m_Programs[PACKED], "Scan_WorkEfficientRows", &clError);
+	V_RETURN_FALSE_CL(clError, "Failed to create kernel: Scan_WorkEfficientRows.");
+
+	m_DeltaTileCarriesKernel = clCreateKernel(m_Programs[PACKED], "Packed_DeltaTileCarries", &clError);
+	V_RETURN_FALSE_CL(clError, "Failed to create kernel: Packed_DeltaTileCarries.");
+
+	return true;
+}
+
+string CCompressedTask::GetCompileOptions(int Column) const
+{
+	stringstream compileOptions;
+	compileOptions << "-D PACK_BITS=" << (Column == PACKED ? m_Bits : 32);
+	if (Column == PACKED && m_bDelta)
+		compileOptions << " -D PACK_DELTA";
+
+	return compileOptions.str();
+}
+
+void CCompressedTask::StartProgramBuilds(cl_device_id Device, cl_context Context)
+{
+	string scanCode, compressedCode;
+
+	if (!CLUtil::LoadProgramSourceToMemory("Scan.cl", scanCode) ||
+		!CLUtil::LoadProgramSourceToMemory("Compressed.cl", compressedCode))
+		return;
+
+	for (int i = 0; i < 2; i++)
+		CProgramBuilder::BuildAsync(Device, Context, scanCode + "\n" + compressedCode, GetCompileOptions(i));
+}
+
+void CCompressedTask::ReleaseResources()
+{
+	// host resources
+	SAFE_DELETE_ARRAY(m_hColumn);
+	SAFE_DELETE_ARRAY(m_hPacked);
+	SAFE_DELETE_ARRAY(m_hScanCPU);
+	SAFE_DELETE_ARRAY(m_hScanGPU);
+	SAFE_DELETE_ARRAY(m_hPartials);
+
+	// device resources
+	SAFE_RELEASE_MEMOBJECT(m_dResult);
+	SAFE_RELEASE_MEMOBJECT(m_dPartials);
+	SAFE_RELEASE_MEMOBJECT(m_dTileSums);
+	SAFE_RELEASE_MEMOBJECT(m_dTileColumnSums);
+
+	SAFE_RELEASE_KERNEL(m_ScanTileSumsKernel);
+	SAFE_RELEASE_KERNEL(m_DeltaTileCarriesKernel);
+
+	for (int i = 0; i < 2; i++)
+	{
+		SAFE_RELEASE_MEMOBJECT(m_dInputs[i]);
+		SAFE_RELEASE_KERNEL(m_ReduceKernels[i]);
+		SAFE_RELEASE_KERNEL(m_ReduceTilesKernels[i]);
+		SAFE_RELEASE_KERNEL(m_ScanTilesKernels[i]);
+		SAFE_RELEASE_PROGRAM(m_Programs[i]);
+	}
+}
+
+void CCompressedTask::ComputeGPU(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
+{
+	cout << endl;
+
+	for (unsigned int task = 0; task < ARRAYLEN(m_bValidationResults); task++)
+		ValidateTask(Context, CommandQueue, LocalWorkSize, task);
+
+	cout << endl;
+
+	TestTransfer(CommandQueue);
+	for (unsigned int task = 0; task < ARRAYLEN(m_bValidationResults); task++)
+		TestPerformance(Context, CommandQueue, LocalWorkSize, task);
+
+	cout << endl;
+}
+
+void CCompressedTask::ComputeCPU()
+{
+	CTimer timer;
+	timer.Start();
+
+	unsigned int sum = 0;
+	for(size_t i = 0; i < m_N; i++) {
+		sum += m_hColumn[i];
+		m_hScanCPU[i] = sum;
+	}
+	m_ReductionCPU = sum;
+
+	timer.Stop();
+	double ms = timer.GetElapsedMilliseconds();
+	cout << "  average time: " << ms << " ms, throughput: " << 1.0e-6 * (double)m_N / ms << " Gelem/s" <<endl;
+}
+
+bool CCompressedTask::ValidateResults()
+{
+	bool success = true;
+
+	for(int i = 0; i < (int)ARRAYLEN(m_bValidationResults); i++)
+		if(!m_bValidationResults[i])
+		{
+			cout<<"Validation of compressed column task "<<g_CompressedTaskNames[i]<<" failed." << endl;
+			success = false;
+		}
+
+	return success;
+}
+
+void CCompressedTask::Reduce(cl_command_queue CommandQueue, size_t LocalWorkSize[3], int Input)
+{
+	cl_int clErr;
+	cl_kernel kernel = m_ReduceKernels[Input];
+	cl_uint n = (cl_uint)m_N;
+	size_t localWorkSize[1] = { LocalWorkSize[0] };
+	size_t globalWorkSize[1] = { REDUCTION_GROUPS * LocalWorkSize[0] };
+
+	clErr = clSetKernelArg(kernel, 0, sizeof(cl_mem), (void*)&m_dInputs[Input]);
+	clErr |= clSetKernelArg(kernel, 1, sizeof(cl_mem), (void*)&m_dPartials);
+	clErr |= clSetKernelArg(kernel, 2, sizeof(cl_uint), (void*)&n);
+	clErr |= clSetKernelArg(kernel, 3, localWorkSize[0] * sizeof(cl_uint), NULL);
+	V_RETURN_CL(clErr, "Failed to set Packed_Reduce arguments");
+
+	clErr = clEnqueueNDRangeKernel(CommandQueue, kernel, 1, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+	V_RETURN_CL(clErr, "Error executing Packed_Reduce!");
+}
+
+void CCompressedTask::Scan(cl_command_queue CommandQueue, size_t LocalWorkSize[3], int Input)
+{
+	cl_int clErr;
+	size_t globalWorkSize[2];
+	size_t localWorkSize[2] = { LocalWorkSize[0], 1 };
+	bool delta = (Input == PACKED && m_bDelta);
+
+	// tiles are multiples of the block size of the local scan
+	size_t blockSize = 2 * localWorkSize[0];
+	size_t tileSize = (m_N + MAX_TILES - 1) / MAX_TILES;
+	tileSize = (tileSize + blockSize - 1) / blockSize * blockSize;
+	cl_uint nTiles = (cl_uint)((m_N + tileSize - 1) / tileSize);
+	cl_uint tileSizeArg = (cl_uint)tileSize;
+	cl_uint n = (cl_uint)m_N;
+
+	// 1. sum of every tile (and of the decoded column of every tile)
+	globalWorkSize[0] = nTiles * localWorkSize[0];
+
+	cl_kernel kernel = m_ReduceTilesKernels[Input];
+	clErr = clSetKernelArg(kernel, 0, sizeof(cl_mem), (void*)&m_dInputs[Input]);
+	clErr |= clSetKernelArg(kernel, 1, sizeof(cl_mem), (void*)&m_dTileSums);
+	clErr |= clSetKernelArg(kernel, 2, sizeof(cl_mem), (void*)&m_dTileColumnSums);
+	clErr |= clSetKernelArg(kernel, 3, sizeof(cl_uint), (void*)&n);
+	clErr |= clSetKernelArg(kernel, 4, sizeof(cl_uint), (void*)&tileSizeArg);
+	clErr |= clSetKernelArg(kernel, 5, 2 * localWorkSize[0] * sizeof(cl_uint), NULL);
+	V_RETURN_CL(clErr, "Failed to set Packed_ReduceTiles arguments");
+
+	clErr = clEnqueueNDRangeKernel(CommandQueue, kernel, 1, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+	V_RETURN_CL(clErr, "Error executing Packed_ReduceTiles!");
+
+	// 2. scan of the tile sums in a single work-group, with delta encoding followed by the scan of the column sums
+	cl_mem tileArrays[2] = { m_dTileSums, m_dTileColumnSums };
+	for (int i = 0; i < (delta ? 2 : 1); i++)
+	{
+		if (i == 1)
+		{
+			size_t carriesLocalWorkSize[1] = { localWorkSize[0] };
+			size_t carriesGlobalWorkSize[1] = { CLUtil::GetGlobalWorkSize(nTiles, localWorkSize[0]) };
+
+			clErr = clSetKernelArg(m_DeltaTileCarriesKernel, 0, sizeof(cl_mem), (void*)&m_dTileSums);
+			clErr |= clSetKernelArg(m_DeltaTileCarriesKernel, 1, sizeof(cl_mem), (void*)&m_dTileColumnSums);
+			clErr |= clSetKernelArg(m_DeltaTileCarriesKernel, 2, sizeof(cl_uint), (void*)&n);
+			clErr |= clSetKernelArg(m_DeltaTileCarriesKernel, 3, sizeof(cl_uint), (void*)&tileSizeArg);
+			clErr |= clSetKernelArg(m_DeltaTileCarriesKernel, 4, sizeof(cl_uint), (void*)&nTiles);
+			V_RETURN_CL(clErr, "Failed to set Packed_DeltaTileCarries arguments");
+
+			clErr = clEnqueueNDRangeKernel(CommandQueue, m_DeltaTileCarriesKernel, 1, NULL, carriesGlobalWorkSize, carriesLocalWorkSize, 0, NULL, NULL);
+			V_RETURN_CL(clErr, "Error executing Packed_DeltaTileCarries!");
+		}
+
+		globalWorkSize[0] = localWorkSize[0];
+		globalWorkSize[1] = 1;
+
+		clErr = clSetKernelArg(m_ScanTileSumsKernel, 0, sizeof(cl_mem), (void*)&tileArrays[i]);
+		clErr |= clSetKernelArg(m_ScanTileSumsKernel, 1, sizeof(cl_mem), (void*)&tileArrays[i]);
+		clErr |= clSetKernelArg(m_ScanTileSumsKernel, 2, sizeof(cl_uint), (void*)&nTiles);
+		clErr |= clSetKernelArg(m_ScanTileSumsKernel, 3, 4 * localWorkSize[0] * sizeof(cl_uint), NULL);
+		V_RETURN_CL(clErr, "Failed to set Scan_WorkEfficientRows arguments");
+
+		clErr = clEnqueueNDRangeKernel(CommandQueue, m_ScanTileSumsKernel, 2, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+		V_RETURN_CL(clErr, "Error executing Scan_WorkEfficientRows!");
+	}
+
+	// 3. scan of the decoded column of every tile
+	globalWorkSize[0] = nTiles * localWorkSize[0];
+
+	kernel = m_ScanTilesKernels[Input];
+	clErr = clSetKernelArg(kernel, 0, sizeof(cl_mem), (void*)&m_dInputs[Input]);
+	clErr |= clSetKernelArg(kernel, 1, sizeof(cl_mem), (void*)&m_dResult);
+	clErr |= clSetKernelArg(kernel, 2, sizeof(cl_mem), (void*)&m_dTileSums);
+	clErr |= clSetKernelArg(kernel, 3, sizeof(cl_mem), (void*)&m_dTileColumnSums);
+	clErr |= clSetKernelArg(kernel, 4, sizeof(cl_uint), (void*)&n);
+	clErr |= clSetKernelArg(kernel, 5, sizeof(cl_uint), (void*)&tileSizeArg);
+	clErr |= clSetKernelArg(kernel, 6, 4 * localWorkSize[0] * sizeof(cl_uint), NULL);
+	V_RETURN_CL(clErr, "Failed to set Packed_ScanTiles arguments");
+
+	clErr = clEnqueueNDRangeKernel(CommandQueue, kernel, 1, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+	V_RETURN_CL(clErr, "Error executing Packed_ScanTiles!");
+}
+
+void CCompressedTask::ValidateTask(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task)
+{
+	int input = Task % 2;
+
+	if (input == PACKED)
+	{
+		V_RETURN_CL(clEnqueueWriteBuffer(CommandQueue, m_dInputs[PACKED], CL_FALSE, 0, m_nPackedWords * sizeof(cl_uint), m_hPacked, 0, NULL, NULL), "Error copying data from host to device!");
+	}
+	else
+	{
+		V_RETURN_CL(clEnqueueWriteBuffer(CommandQueue, m_dInputs[EXPANDED], CL_FALSE, 0, m_N * sizeof(cl_uint), m_hColumn, 0, NULL, NULL), "Error copying data from host to device!");
+	}
+
+	if (Task < 2)
+	{
+		Reduce(CommandQueue, LocalWorkSize, input);
+
+		V_RETURN_CL(clEnqueueReadBuffer(CommandQueue, m_dPartials, CL_TRUE, 0, REDUCTION_GROUPS * sizeof(cl_uint), m_hPartials, 0, NULL, NULL), "Error reading the partial sums!");
+
+		unsigned int sum = 0;
+		for (int i = 0; i < REDUCTION_GROUPS; i++)
+			sum += m_hPartials[i];
+		m_bValidationResults[Task] = (sum == m_ReductionCPU);
+	}
+	else
+	{
+		Scan(CommandQueue, LocalWorkSize, input);
+
+		V_RETURN_CL(clEnqueueReadBuffer(CommandQueue, m_dResult, CL_TRUE, 0, m_N * sizeof(cl_uint), m_hScanGPU, 0, NULL, NULL), "Error reading data from device!");
+
+		m_bValidationResults[Task] = (memcmp(m_hScanCPU, m_hScanGPU, m_N * sizeof(unsigned int)) == 0);
+	}
+}
+
+void CCompressedTask::TestPerformance(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task)
+{
+	int input = Task % 2;
+	size_t inputBytes = (input == PACKED ? m_nPackedWords : m_N) * sizeof(cl_uint);
+
+	cout << "Testing performance of " << g_CompressedTaskNames[Task] << " (" << m_N << " elements, " << inputBytes << " bytes of input)" << endl;
+
+	//finish all before we start meassuring the time
+	V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
+
+	CTimer timer;
+	timer.Start();
+
+	//run the kernels N times
+	unsigned int nIterations = 100;
+	for(unsigned int i = 0; i < nIterations; i++) {
+		if (Task < 2)
+			Reduce(CommandQueue, LocalWorkSize, input);
+		else
+			Scan(CommandQueue, LocalWorkSize, input);
+	}
+
+	//wait until the command queue is empty again
+	V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
+
+	timer.Stop();
+
+	double ms = timer.GetElapsedMilliseconds() / double(nIterations);
+	cout << "  average time: " << ms << " ms, throughput: " << 1.0e-6 * (double)m_N / ms << " Gelem/s" <<endl;
+}
+
+void CCompressedTask::TestTransfer(cl_command_queue CommandQueue)
+{
+	const char* names[2] = { "expanded", "packed" };
+	size_t bytes[2] = { m_N * sizeof(cl_uint), m_nPackedWords * sizeof(cl_uint) };
+	void* data[2] = { m_hColumn, m_hPacked };
+
+	cout << "Testing upload of the column (" << m_Bits << " bits per value" << (m_bDelta ? ", delta-encoded" : "") << ")" << endl;
+
+	for (int i = 0; i < 2; i++)
+	{
+		V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
+
+		CTimer timer;
+		timer.Start();
+
+		unsigned int nIterations = 10;
+		for(unsigned int j = 0; j < nIterations; j++)
+			V_RETURN_CL(clEnqueueWriteBuffer(CommandQueue, m_dInputs[i], CL_FALSE, 0, bytes[i], data[i], 0, NULL, NULL), "Error copying data from host to device!");
+
+		V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
+
+		timer.Stop();
+
+		double ms = timer.GetElapsedMilliseconds() / double(nIterations);
+		cout << "  " << names[i] << ": " << bytes[i] << " bytes, average time: " << ms << " ms" << endl;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
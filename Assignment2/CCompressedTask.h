@@ -0,0 +1,112 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CCOMPRESSED_TASK_H
+#define _CCOMPRESSED_TASK_H
+
+#include "../Common/IComputeTask.h"
+
+#include <string>
+
+//! Reduction and scan of bit-packed and delta-encoded uint columns
+/*!
+	The column is stored with Bits (1..16) bits per value, delta-encoded if Delta is set.
+	The kernels in Compressed.cl decode the values while they are loaded, so only the packed words
+	are uploaded and read by the device:
+	- reduction: fixed number of partial sums on the device, combined on the host
+	- scan: reduce-then-scan over tiles, delta decoding is folded into the tile scan
+
+	The same kernels built with PACK_BITS=32 run on the expanded column for comparison.
+*/
+class CCompressedTask : public IComputeTask
+{
+public:
+	CCompressedTask(size_t ArraySize, unsigned int Bits, bool Delta);
+
+	virtual ~CCompressedTask();
+
+	// IComputeTask
+	virtual bool InitResources(cl_device_id Device, cl_context Context);
+
+	virtual void StartProgramBuilds(cl_device_id Device, cl_context Context);
+
+	virtual bool InitPrograms(cl_device_id Device, cl_context Context);
+
+	virtual void ReleaseResources();
+
+	virtual void ComputeGPU(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
+
+	virtual void ComputeCPU();
+
+	virtual bool ValidateResults();
+
+protected:
+
+	// index of the kernels and inputs
+	enum
+	{
+		EXPANDED = 0,
+		PACKED = 1
+	};
+
+	//! Program options for the EXPANDED or the PACKED column
+	std::string GetCompileOptions(int Column) const;
+
+	//! Partial sums of the column in m_dPartials
+	void Reduce(cl_command_queue CommandQueue, size_t LocalWorkSize[3], int Input);
+	//! Scan of the column into m_dResult
+	void Scan(cl_command_queue CommandQueue, size_t LocalWorkSize[3], int Input);
+
+	void ValidateTask(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task);
+	void TestPerformance(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task);
+
+	//! Upload time of the expanded and the packed column
+	void TestTransfer(cl_command_queue CommandQueue);
+
+	size_t				m_N;
+	unsigned int		m_Bits;
+	bool				m_bDelta;
+	size_t				m_nPackedWords;
+
+	// decoded column and stored (packed, maybe delta-encoded) data
+	unsigned int		*m_hColumn;
+	unsigned int		*m_hPacked;
+
+	unsigned int		*m_hScanCPU;
+	unsigned int		*m_hScanGPU;
+	unsigned int		m_ReductionCPU;
+	unsigned int		*m_hPartials;
+	bool				m_bValidationResults[4];
+
+	cl_mem				m_dInputs[2];
+	cl_mem				m_dResult;
+	cl_mem				m_dPartials;
+	cl_mem				m_dTileSums;
+	cl_mem				m_dTileColumnSums;
+
+	//OpenCL programs and kernels, one program per input format
+	cl_program			m_Programs[2];
+	cl_kernel			m_ReduceKernels[2];
+	cl_kernel			m_ReduceTilesKernels[2];
+	cl_kernel			m_ScanTilesKernels[2];
+	cl_kernel			m_ScanTileSumsKernel;
+	cl_kernel			m_DeltaTileCarriesKernel;
+};
+
+#endif // _CCOMPRESSED_TASK_H
@@ -0,0 +1,190 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+
+#include "CDispatchTask.h"
+
+#include "../Common/CLUtil.h"
+#include "../Common/CTimer.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// CDispatchTask
+
+// only useful for debug info
+static const string g_DispatchOpNames[DISPATCH_OP_COUNT] =
+{
+	"scan",
+	"reduction"
+};
+
+CDispatchTask::CDispatchTask(size_t MaxArraySize, size_t LocalWorkSize)
+	: m_N(MaxArraySize), m_Dispatcher(MaxArraySize, LocalWorkSize)
+{
+	// Reset validation results
+	for (int i = 0; i < (int)ARRAYLEN(m_bValidationResults); i++)
+		m_bValidationResults[i] = false;
+}
+
+CDispatchTask::~CDispatchTask()
+{
+	ReleaseResources();
+}
+
+bool CDispatchTask::InitResources(cl_device_id Device, cl_context Context)
+{
+	//CPU resources
+	m_hInput.resize(m_N);
+	m_hScanCPU.resize(m_N);
+	m_hResult.resize(m_N);
+
+	//fill the array with some values
+	for(size_t i = 0; i < m_N; i++)
+		m_hInput[i] = rand() & 15;
+
+	return m_Dispatcher.InitResources(Device, Context);
+}
+
+void CDispatchTask::StartProgramBuilds(cl_device_id Device, cl_context Context)
+{
+	m_Dispatcher.StartProgramBuilds(Device, Context);
+}
+
+bool CDispatchTask::InitPrograms(cl_device_id Device, cl_context Context)
+{
+	return m_Dispatcher.InitPrograms(Device, Context);
+}
+
+void CDispatchTask::ReleaseResources()
+{
+	// host resources
+	m_hInput.clear();
+	m_hScanCPU.clear();
+	m_hResult.clear();
+
+	// device resources
+	m_Dispatcher.ReleaseResources();
+}
+
+void CDispatchTask::ComputeGPU(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
+{
+	cout << endl;
+
+	m_Dispatcher.Calibrate(CommandQueue);
+
+	cout << endl;
+
+	ValidateTask(CommandQueue);
+	TestPerformance(CommandQueue);
+
+	cout << endl;
+}
+
+void CDispatchTask::ComputeCPU()
+{
+	CTimer timer;
+	timer.Start();
+
+	cl_uint sum = 0;
+	for(size_t i = 0; i < m_N; i++) {
+		sum += m_hInput[i];
+		m_hScanCPU[i] = sum;
+	}
+
+	timer.Stop();
+	double ms = timer.GetElapsedMilliseconds();
+	cout << "  average time: " << ms << " ms, throughput: " << 1.0e-6 * (double)m_N / ms << " Gelem/s" <<endl;
+}
+
+bool CDispatchTask::ValidateResults()
+{
+	bool success = true;
+
+	for(int i = 0; i < (int)ARRAYLEN(m_bValidationResults); i++)
+		if(!m_bValidationResults[i])
+		{
+			cout<<"Validation of dispatched "<<g_DispatchOpNames[i]<<" failed." << endl;
+			success = false;
+		}
+
+	return success;
+}
+
+void CDispatchTask::ValidateTask(cl_command_queue CommandQueue)
+{
+	size_t sizes[] = { 1, 100, 512, 5000, 70000, 1024 * 1024 + 3, m_N };
+
+	m_bValidationResults[DISPATCH_SCAN] = true;
+	m_bValidationResults[DISPATCH_REDUCE] = true;
+
+	for (size_t i = 0; i < ARRAYLEN(sizes); i++)
+	{
+		size_t N = min(sizes[i], m_N);
+
+		// every path and the dispatched one (DISPATCH_PATH_COUNT)
+		for (int path = 0; path <= DISPATCH_PATH_COUNT; path++)
+		{
+			memset(&m_hResult[0], 0, N * sizeof(cl_uint));
+			cl_uint sum;
+			if (path == DISPATCH_PATH_COUNT)
+			{
+				m_Dispatcher.Scan(CommandQueue, &m_hInput[0], &m_hResult[0], N);
+				sum = m_Dispatcher.Reduce(CommandQueue, &m_hInput[0], N);
+			}
+			else
+			{
+				m_Dispatcher.Scan(CommandQueue, &m_hInput[0], &m_hResult[0], N, (EDispatchPath)path);
+				sum = m_Dispatcher.Reduce(CommandQueue, &m_hInput[0], N, (EDispatchPath)path);
+			}
+
+			if (memcmp(&m_hScanCPU[0], &m_hResult[0], N * sizeof(cl_uint)) != 0)
+				m_bValidationResults[DISPATCH_SCAN] = false;
+			if (sum != m_hScanCPU[N - 1])
+				m_bValidationResults[DISPATCH_REDUCE] = false;
+		}
+	}
+}
+
+void CDispatchTask::TestPerformance(cl_command_queue CommandQueue)
+{
+	for (int op = 0; op < DISPATCH_OP_COUNT; op++)
+	{
+		cout << "Testing latency of " << g_DispatchOpNames[op] << " (including transfers)" << endl;
+
+		for (size_t N = 512; N <= m_N; N *= 8)
+		{
+			// dispatched path and multi-pass path
+			double ms[2];
+			for (int i = 0; i < 2; i++)
+			{
+				EDispatchPath path = (i == 0) ? m_Dispatcher.SelectPath((EDispatchOp)op, N) : DISPATCH_MULTI_PASS;
+				unsigned int nIterations = (unsigned int)max((size_t)3, min((size_t)1000, ((size_t)1 << 24) / N));
+
+				CTimer timer;
+				timer.Start();
+
+				for (unsigned int j = 0; j < nIterations; j++)
+				{
+					if (op == DISPATCH_SCAN)
+						m_Dispatcher.Scan(CommandQueue, &m_hInput[0], &m_hResult[0], N, path);
+					else
+						m_Dispatcher.Reduce(CommandQueue, &m_hInput[0], N, path);
+				}
+
+				timer.Stop();
+				ms[i] = timer.GetElapsedMilliseconds() / double(nIterations);
+			}
+
+			cout << "  " << N << " elements: " << CSizeDispatcher::GetPathName(m_Dispatcher.SelectPath((EDispatchOp)op, N))
+				<< " " << ms[0] << " ms, multi-pass " << ms[1] << " ms" << endl;
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
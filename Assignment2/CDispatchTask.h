@@ -0,0 +1,73 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CDISPATCH_TASK_H
+#define _CDISPATCH_TASK_H
+
+#include "../Common/IComputeTask.h"
+
+#include "CSizeDispatcher.h"
+
+#include <vector>
+
+//! Scan and reduction of host arrays of many sizes through CSizeDispatcher
+/*!
+	Calibrates the dispatcher (or loads its calibration), validates every path for a range
+	of sizes and compares the latency of the dispatched calls with the multi-pass path.
+*/
+class CDispatchTask : public IComputeTask
+{
+public:
+	CDispatchTask(size_t MaxArraySize, size_t LocalWorkSize);
+
+	virtual ~CDispatchTask();
+
+	// IComputeTask
+	virtual bool InitResources(cl_device_id Device, cl_context Context);
+
+	virtual void StartProgramBuilds(cl_device_id Device, cl_context Context);
+
+	virtual bool InitPrograms(cl_device_id Device, cl_context Context);
+
+	virtual void ReleaseResources();
+
+	virtual void ComputeGPU(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
+
+	virtual void ComputeCPU();
+
+	virtual bool ValidateResults();
+
+protected:
+
+	void ValidateTask(cl_command_queue CommandQueue);
+	void TestPerformance(cl_command_queue CommandQueue);
+
+	size_t					m_N;
+
+	std::vector<cl_uint>	m_hInput;
+
+	// the prefix sums of the whole input are the reference for every size
+	std::vector<cl_uint>	m_hScanCPU;
+	std::vector<cl_uint>	m_hResult;
+	bool					m_bValidationResults[DISPATCH_OP_COUNT];
+
+	CSizeDispatcher			m_Dispatcher;
+};
+
+#endif // _CDISPATCH_TASK_H
@@ -0,0 +1,210 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CGENERIC_SCAN_TASK_H
+#define _CGENERIC_SCAN_TASK_H
+
+#include "../Common/IComputeTask.h"
+#include "../Common/CLUtil.h"
+#include "../Common/CProgramBuilder.h"
+#include "../Common/CTimer.h"
+
+#include "CScanHierarchy.h"
+#include "ScanOperators.h"
+
+#include <vector>
+
+//! Inclusive work-efficient scan with an arbitrary element type and associative operator
+/*!
+	GenericScan.cl is specialized at build time with the -D options of the operator
+	(see ScanOperators.h), the levels are driven by CScanHierarchy.
+*/
+template<class TOp>
+class CGenericScanTask : public IComputeTask
+{
+public:
+	typedef typename TOp::Type Type;
+	typedef typename TOp::HostType HostType;
+
+	CGenericScanTask(size_t ArraySize, size_t MinLocalWorkSize)
+		: m_N(ArraySize), m_bValidationResult(false), m_dArray(NULL),
+		m_Scan(ArraySize, MinLocalWorkSize, sizeof(Type)), m_Program(NULL)
+	{
+	}
+
+	virtual ~CGenericScanTask()
+	{
+		ReleaseResources();
+	}
+
+	// IComputeTask
+	virtual bool InitResources(cl_device_id Device, cl_context Context)
+	{
+		//CPU resources
+		m_hInput.resize(m_N);
+		m_hResultCPU.resize(m_N);
+		m_hResultGPU.resize(m_N);
+
+		for(size_t i = 0; i < m_N; i++)
+			m_hInput[i] = TOp::Random();
+
+		//device resources
+		cl_int clError;
+		m_dArray = clCreateBuffer(Context, CL_MEM_READ_WRITE, sizeof(Type) * m_N, NULL, &clError);
+		V_RETURN_FALSE_CL(clError, "Error allocating device arrays");
+
+		return true;
+	}
+
+	virtual void StartProgramBuilds(cl_device_id Device, cl_context Context)
+	{
+		std::string programCode;
+
+		if (CLUtil::LoadProgramSourceToMemory("GenericScan.cl", programCode))
+			CProgramBuilder::BuildAsync(Device, Context, programCode, TOp::CompileOptions());
+	}
+
+	virtual bool InitPrograms(cl_device_id Device, cl_context Context)
+	{
+		//load and compile kernels
+		std::string programCode;
+
+		if (!CLUtil::LoadProgramSourceToMemory("GenericScan.cl", programCode))
+			return false;
+		m_Program = CLUtil::BuildCLProgramFromMemory(Device, Context, programCode, TOp::CompileOptions());
+		if(m_Program == nullptr) return false;
+
+		if (!m_Scan.InitResources(Context, m_Program))
+			return false;
+
+		return true;
+	}
+
+	virtual void ReleaseResources()
+	{
+		// host resources
+		m_hInput.clear();
+		m_hResultCPU.clear();
+		m_hResultGPU.clear();
+
+		// device resources
+		SAFE_RELEASE_MEMOBJECT(m_dArray);
+
+		m_Scan.ReleaseResources();
+
+		SAFE_RELEASE_PROGRAM(m_Program);
+	}
+
+	virtual void ComputeGPU(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
+	{
+		std::cout << std::endl;
+
+		ValidateTask(Context, CommandQueue, LocalWorkSize);
+		TestPerformance(Context, CommandQueue, LocalWorkSize);
+
+		std::cout << std::endl;
+	}
+
+	virtual void ComputeCPU()
+	{
+		CTimer timer;
+		timer.Start();
+
+		HostType value = TOp::Identity();
+		for(size_t i = 0; i < m_N; i++) {
+			value = TOp::Apply(value, TOp::ToHost(m_hInput[i]));
+			m_hResultCPU[i] = value;
+		}
+
+		timer.Stop();
+		double ms = timer.GetElapsedMilliseconds();
+		std::cout << "  average time: " << ms << " ms, throughput: " << 1.0e-6 * (double)m_N / ms << " Gelem/s" << std::endl;
+	}
+
+	virtual bool ValidateResults()
+	{
+		if (!m_bValidationResult)
+			std::cout << "Validation of scan " << TOp::Name() << " failed." << std::endl;
+
+		return m_bValidationResult;
+	}
+
+protected:
+
+	void ValidateTask(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
+	{
+		m_bValidationResult = false;
+
+		V_RETURN_CL(clEnqueueWriteBuffer(CommandQueue, m_dArray, CL_FALSE, 0, m_N * sizeof(Type), &m_hInput[0], 0, NULL, NULL), "Error copying data from host to device!");
+
+		m_Scan.Scan(CommandQueue, m_dArray, m_N, LocalWorkSize[0]);
+
+		V_RETURN_CL(clEnqueueReadBuffer(CommandQueue, m_dArray, CL_TRUE, 0, m_N * sizeof(Type), &m_hResultGPU[0], 0, NULL, NULL), "Error reading data from device!");
+
+		for (size_t i = 0; i < m_N; i++)
+			if (!TOp::Equal(m_hResultGPU[i], m_hResultCPU[i]))
+			{
+				std::cout << "  first mismatch of scan " << TOp::Name() << " at element " << i << std::endl;
+				return;
+			}
+
+		m_bValidationResult = true;
+	}
+
+	void TestPerformance(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
+	{
+		std::cout << "Testing performance of scan " << TOp::Name() << std::endl;
+
+		V_RETURN_CL(clEnqueueWriteBuffer(CommandQueue, m_dArray, CL_FALSE, 0, m_N * sizeof(Type), &m_hInput[0], 0, NULL, NULL), "Error copying data from host to device!");
+		//finish all before we start meassuring the time
+		V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
+
+		CTimer timer;
+		timer.Start();
+
+		//run the scan N times, the operators are not idempotent, but the timing does not depend on the values
+		unsigned int nIterations = 100;
+		for(unsigned int i = 0; i < nIterations; i++)
+			m_Scan.Scan(CommandQueue, m_dArray, m_N, LocalWorkSize[0]);
+
+		//wait until the command queue is empty again
+		V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
+
+		timer.Stop();
+
+		double ms = timer.GetElapsedMilliseconds() / double(nIterations);
+		std::cout << "  average time: " << ms << " ms, throughput: " << 1.0e-6 * (double)m_N / ms << " Gelem/s" << std::endl;
+	}
+
+	size_t					m_N;
+
+	std::vector<Type>		m_hInput;
+	std::vector<HostType>	m_hResultCPU;
+	std::vector<Type>		m_hResultGPU;
+	bool					m_bValidationResult;
+
+	cl_mem					m_dArray;
+
+	CScanHierarchy			m_Scan;
+
+	//OpenCL program, the kernels are owned by m_Scan
+	cl_program				m_Program;
+};
+
+#endif // _CGENERIC_SCAN_TASK_H
@@ -0,0 +1,379 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+
+#include "CHybridTask.h"
+
+#include "../Common/CLUtil.h"
+#include "../Common/CProgramBuilder.h"
+#include "../Common/CTimer.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+using namespace std;
+
+// work-groups of the device reduction, see CStreamingTask
+#define REDUCTION_GROUPS	256
+
+///////////////////////////////////////////////////////////////////////////////
+// CHybridTask
+
+// only useful for debug info
+static const string g_HybridTaskNames[2] =
+{
+	"scan",
+	"reduction"
+};
+
+CHybridTask::CHybridTask(size_t ArraySize, size_t MinLocalWorkSize, unsigned int NumThreads, double CpuFraction)
+	: m_N(ArraySize), m_RequestedCpuFraction(CpuFraction), m_ReductionCPU(0), m_ReductionResult(0), m_Carry(0),
+	m_ThreadPool(NumThreads), m_dArray(NULL), m_dPartials(NULL),
+	m_Scan(ArraySize, MinLocalWorkSize), m_Program(NULL), m_AddCarryKernel(NULL), m_ReduceChunkKernel(NULL)
+{
+	m_dCarries[0] = m_dCarries[1] = NULL;
+	m_CpuFraction[0] = m_CpuFraction[1] = max(CpuFraction, 0.0);
+
+	// Reset validation results
+	for (int i = 0; i < (int)ARRAYLEN(m_bValidationResults); i++)
+		m_bValidationResults[i] = false;
+}
+
+CHybridTask::~CHybridTask()
+{
+	ReleaseResources();
+}
+
+bool CHybridTask::InitResources(cl_device_id Device, cl_context Context)
+{
+	//CPU resources
+	m_hInput.resize(m_N);
+	m_hScanCPU.resize(m_N);
+	m_hScanResult.resize(m_N);
+	m_hPartials.resize(REDUCTION_GROUPS);
+	m_hThreadSums.resize(m_ThreadPool.GetNumThreads());
+
+	//fill the array with some values
+	for(size_t i = 0; i < m_N; i++)
+		m_hInput[i] = rand() & 15;
+
+	//device resources, the device part is at most the whole array
+	cl_int clError, clError2;
+	m_dArray = clCreateBuffer(Context, CL_MEM_READ_WRITE, sizeof(cl_uint) * m_N, NULL, &clError2);
+	clError = clError2;
+	m_dPartials = clCreateBuffer(Context, CL_MEM_READ_WRITE, sizeof(cl_uint) * REDUCTION_GROUPS, NULL, &clError2);
+	clError |= clError2;
+	for (int i = 0; i < 2; i++) {
+		m_dCarries[i] = clCreateBuffer(Context, CL_MEM_READ_WRITE, sizeof(cl_uint), NULL, &clError2);
+		clError |= clError2;
+	}
+	V_RETURN_FALSE_CL(clError, "Error allocating device arrays");
+
+	return true;
+}
+
+bool CHybridTask::InitPrograms(cl_device_id Device, cl_context Context)
+{
+	cl_int clError;
+
+	//load and compile kernels
+	string scanCode, streamingCode;
+
+	if (!CLUtil::LoadProgramSourceToMemory("Scan.cl", scanCode) ||
+		!CLUtil::LoadProgramSourceToMemory("Streaming.cl", streamingCode))
+		return false;
+
+	m_Program = CLUtil::BuildCLProgramFromMemory(Device, Context, scanCode + "\n" + streamingCode);
+	if(m_Program == nullptr) return false;
+
+	//create kernels
+	m_AddCarryKernel = clCreateKernel(m_Program, "Stream_AddCarry", &clError);
+	V_RETURN_FALSE_CL(clError, "Failed to create kernel: Stream_AddCarry.");
+
+	m_ReduceChunkKernel = clCreateKernel(m_Program, "Stream_ReduceChunk", &clError);
+	V_RETURN_FALSE_CL(clError, "Failed to create kernel: Stream_ReduceChunk.");
+
+	if (!m_Scan.InitResources(Context, m_Program))
+		return false;
+
+	return true;
+}
+
+void CHybridTask::StartProgramBuilds(cl_device_id Device, cl_context Context)
+{
+	string scanCode, streamingCode;
+
+	if (CLUtil::LoadProgramSourceToMemory("Scan.cl", scanCode) &&
+		CLUtil::LoadProgramSourceToMemory("Streaming.cl", streamingCode))
+		CProgramBuilder::BuildAsync(Device, Context, scanCode + "\n" + streamingCode);
+}
+
+void CHybridTask::ReleaseResources()
+{
+	// host resources
+	m_hInput.clear();
+	m_hScanCPU.clear();
+	m_hScanResult.clear();
+	m_hPartials.clear();
+	m_hThreadSums.clear();
+
+	// device resources
+	SAFE_RELEASE_MEMOBJECT(m_dArray);
+	SAFE_RELEASE_MEMOBJECT(m_dPartials);
+	SAFE_RELEASE_MEMOBJECT(m_dCarries[0]);
+	SAFE_RELEASE_MEMOBJECT(m_dCarries[1]);
+
+	m_Scan.ReleaseResources();
+
+	SAFE_RELEASE_KERNEL(m_AddCarryKernel);
+	SAFE_RELEASE_KERNEL(m_ReduceChunkKernel);
+
+	SAFE_RELEASE_PROGRAM(m_Program);
+}
+
+void CHybridTask::ComputeGPU(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
+{
+	cout << endl;
+
+	for (unsigned int task = 0; task < 2; task++)
+	{
+		if (m_RequestedCpuFraction < 0.0)
+			Calibrate(CommandQueue, LocalWorkSize, task);
+		ValidateTask(Context, CommandQueue, LocalWorkSize, task);
+	}
+
+	cout << endl;
+
+	TestPerformance(Context, CommandQueue, LocalWorkSize, 0);
+	TestPerformance(Context, CommandQueue, LocalWorkSize, 1);
+
+	cout << endl;
+}
+
+void CHybridTask::ComputeCPU()
+{
+	CTimer timer;
+	timer.Start();
+
+	cl_uint sum = 0;
+	for(size_t i = 0; i < m_N; i++) {
+		sum += m_hInput[i];
+		m_hScanCPU[i] = sum;
+	}
+	m_ReductionCPU = sum;
+
+	timer.Stop();
+	double ms = timer.GetElapsedMilliseconds();
+	cout << "  average time (single thread): " << ms << " ms, throughput: " << 1.0e-6 * (double)m_N / ms << " Gelem/s" <<endl;
+}
+
+bool CHybridTask::ValidateResults()
+{
+	bool success = true;
+
+	for(int i = 0; i < (int)ARRAYLEN(m_bValidationResults); i++)
+		if(!m_bValidationResults[i])
+		{
+			cout<<"Validation of hybrid "<<g_HybridTaskNames[i]<<" failed." << endl;
+			success = false;
+		}
+
+	return success;
+}
+
+cl_uint CHybridTask::ScanHost(size_t Count)
+{
+	unsigned int nThreads = m_ThreadPool.GetNumThreads();
+	size_t chunkSize = (Count + nThreads - 1) / nThreads;
+
+	// 1. every thread scans its chunk
+	m_ThreadPool.Run([&](unsigned int Thread) {
+		size_t start = min(Thread * chunkSize, Count);
+		size_t end = min(start + chunkSize, Count);
+		cl_uint sum = 0;
+		for (size_t i = start; i < end; i++) {
+			sum += m_hInput[i];
+			m_hScanResult[i] = sum;
+		}
+		m_hThreadSums[Thread] = sum;
+	});
+
+	// 2. exclusive scan of the chunk totals
+	cl_uint total = 0;
+	for (unsigned int t = 0; t < nThreads; t++) {
+		cl_uint sum = m_hThreadSums[t];
+		m_hThreadSums[t] = total;
+		total += sum;
+	}
+
+	// 3. every thread adds the total of the preceding chunks
+	m_ThreadPool.Run([&](unsigned int Thread) {
+		size_t start = min(Thread * chunkSize, Count);
+		size_t end = min(start + chunkSize, Count);
+		cl_uint carry = m_hThreadSums[Thread];
+		if (carry != 0)
+			for (size_t i = start; i < end; i++)
+				m_hScanResult[i] += carry;
+	});
+
+	return total;
+}
+
+cl_uint CHybridTask::ReduceHost(size_t Count)
+{
+	unsigned int nThreads = m_ThreadPool.GetNumThreads();
+	size_t chunkSize = (Count + nThreads - 1) / nThreads;
+
+	m_ThreadPool.Run([&](unsigned int Thread) {
+		size_t start = min(Thread * chunkSize, Count);
+		size_t end = min(start + chunkSize, Count);
+		cl_uint sum = 0;
+		for (size_t i = start; i < end; i++)
+			sum += m_hInput[i];
+		m_hThreadSums[Thread] = sum;
+	});
+
+	cl_uint total = 0;
+	for (unsigned int t = 0; t < nThreads; t++)
+		total += m_hThreadSums[t];
+
+	return total;
+}
+
+void CHybridTask::Hybrid(cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task, double CpuFraction)
+{
+	cl_int clErr;
+	size_t cpuCount = min((size_t)(CpuFraction * (double)m_N), m_N);
+	size_t gpuCount = m_N - cpuCount;
+	cl_uint gpuCountArg = (cl_uint)gpuCount;
+
+	// 1. device part, the host only enqueues the commands
+	if (gpuCount > 0)
+	{
+		V_RETURN_CL(clEnqueueWriteBuffer(CommandQueue, m_dArray, CL_FALSE, 0, gpuCount * sizeof(cl_uint), &m_hInput[cpuCount], 0, NULL, NULL), "Error copying data from host to device!");
+
+		if (Task == 0)
+		{
+			m_Scan.Scan(CommandQueue, m_dArray, gpuCount, LocalWorkSize[0]);
+		}
+		else
+		{
+			cl_uint partialOffset = 0;
+			size_t localWorkSize[1] = { LocalWorkSize[0] };
+			size_t globalWorkSize[1] = { REDUCTION_GROUPS * LocalWorkSize[0] };
+
+			clErr = clSetKernelArg(m_ReduceChunkKernel, 0, sizeof(cl_mem), (void*)&m_dArray);
+			clErr |= clSetKernelArg(m_ReduceChunkKernel, 1, sizeof(cl_uint), (void*)&gpuCountArg);
+			clErr |= clSetKernelArg(m_ReduceChunkKernel, 2, sizeof(cl_mem), (void*)&m_dPartials);
+			clErr |= clSetKernelArg(m_ReduceChunkKernel, 3, sizeof(cl_uint), (void*)&partialOffset);
+			clErr |= clSetKernelArg(m_ReduceChunkKernel, 4, localWorkSize[0] * sizeof(cl_uint), NULL);
+			V_RETURN_CL(clErr, "Failed to set Stream_ReduceChunk arguments");
+
+			clErr = clEnqueueNDRangeKernel(CommandQueue, m_ReduceChunkKernel, 1, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+			V_RETURN_CL(clErr, "Error executing Stream_ReduceChunk!");
+
+			V_RETURN_CL(clEnqueueReadBuffer(CommandQueue, m_dPartials, CL_FALSE, 0, REDUCTION_GROUPS * sizeof(cl_uint), &m_hPartials[0], 0, NULL, NULL), "Error reading the partial sums!");
+		}
+
+		// start the device while the host threads work
+		V_RETURN_CL(clFlush(CommandQueue), "Error flushing the queue!");
+	}
+
+	// 2. host part
+	cl_uint hostTotal = (Task == 0) ? ScanHost(cpuCount) : ReduceHost(cpuCount);
+
+	// 3. combine
+	if (Task == 0)
+	{
+		if (gpuCount > 0)
+		{
+			m_Carry = hostTotal;
+			V_RETURN_CL(clEnqueueWriteBuffer(CommandQueue, m_dCarries[0], CL_FALSE, 0, sizeof(cl_uint), &m_Carry, 0, NULL, NULL), "Error copying data from host to device!");
+
+			size_t localWorkSize[1] = { LocalWorkSize[0] };
+			size_t globalWorkSize[1] = { CLUtil::GetGlobalWorkSize(gpuCount, LocalWorkSize[0]) };
+
+			clErr = clSetKernelArg(m_AddCarryKernel, 0, sizeof(cl_mem), (void*)&m_dArray);
+			clErr |= clSetKernelArg(m_AddCarryKernel, 1, sizeof(cl_uint), (void*)&gpuCountArg);
+			clErr |= clSetKernelArg(m_AddCarryKernel, 2, sizeof(cl_mem), (void*)&m_dCarries[0]);
+			clErr |= clSetKernelArg(m_AddCarryKernel, 3, sizeof(cl_mem), (void*)&m_dCarries[1]);
+			V_RETURN_CL(clErr, "Failed to set Stream_AddCarry arguments");
+
+			clErr = clEnqueueNDRangeKernel(CommandQueue, m_AddCarryKernel, 1, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+			V_RETURN_CL(clErr, "Error executing Stream_AddCarry!");
+
+			V_RETURN_CL(clEnqueueReadBuffer(CommandQueue, m_dArray, CL_TRUE, 0, gpuCount * sizeof(cl_uint), &m_hScanResult[cpuCount], 0, NULL, NULL), "Error reading data from device!");
+		}
+	}
+	else
+	{
+		m_ReductionResult = hostTotal;
+		if (gpuCount > 0)
+		{
+			V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
+			for (int i = 0; i < REDUCTION_GROUPS; i++)
+				m_ReductionResult += m_hPartials[i];
+		}
+	}
+}
+
+double CHybridTask::Measure(cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task, double CpuFraction, unsigned int Iterations)
+{
+	//finish all before we start meassuring the time
+	clFinish(CommandQueue);
+
+	CTimer timer;
+	timer.Start();
+
+	// every call returns with its results on the host
+	for(unsigned int i = 0; i < Iterations; i++)
+		Hybrid(CommandQueue, LocalWorkSize, Task, CpuFraction);
+
+	timer.Stop();
+
+	return timer.GetElapsedMilliseconds() / double(Iterations);
+}
+
+void CHybridTask::Calibrate(cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task)
+{
+	// warm up both sides once
+	Hybrid(CommandQueue, LocalWorkSize, Task, 0.5);
+
+	double gpuMs = Measure(CommandQueue, LocalWorkSize, Task, 0.0, 3);
+	double cpuMs = Measure(CommandQueue, LocalWorkSize, Task, 1.0, 3);
+
+	// the split at which both sides take the same time, the fractions are proportional to the throughputs
+	m_CpuFraction[Task] = gpuMs / (gpuMs + cpuMs);
+
+	cout << "Calibrated hybrid " << g_HybridTaskNames[Task] << ": device " << gpuMs << " ms, host (" << m_ThreadPool.GetNumThreads()
+		<< " threads) " << cpuMs << " ms, host fraction " << m_CpuFraction[Task] << endl;
+}
+
+void CHybridTask::ValidateTask(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task)
+{
+	Hybrid(CommandQueue, LocalWorkSize, Task, m_CpuFraction[Task]);
+
+	if (Task == 0)
+		m_bValidationResults[Task] = (memcmp(&m_hScanCPU[0], &m_hScanResult[0], m_N * sizeof(cl_uint)) == 0);
+	else
+		m_bValidationResults[Task] = (m_ReductionResult == m_ReductionCPU);
+}
+
+void CHybridTask::TestPerformance(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task)
+{
+	cout << "Testing performance of hybrid " << g_HybridTaskNames[Task] << " (" << m_N << " elements, including transfers)" << endl;
+
+	unsigned int nIterations = 10;
+	const char* names[3] = { "device only", "host only", "hybrid" };
+	double fractions[3] = { 0.0, 1.0, m_CpuFraction[Task] };
+
+	for (int i = 0; i < 3; i++)
+	{
+		double ms = Measure(CommandQueue, LocalWorkSize, Task, fractions[i], nIterations);
+		cout << "  " << names[i] << " (host fraction " << fractions[i] << "): average time " << ms << " ms, throughput: " << 1.0e-6 * (double)m_N / ms << " Gelem/s" << endl;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
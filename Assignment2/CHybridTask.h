@@ -0,0 +1,111 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CHYBRID_TASK_H
+#define _CHYBRID_TASK_H
+
+#include "../Common/IComputeTask.h"
+#include "../Common/CThreadPool.h"
+
+#include "CScanHierarchy.h"
+
+#include <vector>
+
+//! Scan and reduction split between a host thread pool and the device
+/*!
+	The first CpuFraction of the input is processed by the host threads while the device
+	uploads and processes the rest:
+	- scan: the device part is scanned with CScanHierarchy, the total of the host part is
+	  added to it on the device afterwards (Stream_AddCarry)
+	- reduction: the device reduces its part to partial sums, they are added to the host part
+
+	With a negative CpuFraction the split is calibrated for each task from the measured time
+	of the host alone and of the device alone, so both sides finish at about the same time.
+*/
+class CHybridTask : public IComputeTask
+{
+public:
+	CHybridTask(size_t ArraySize, size_t MinLocalWorkSize, unsigned int NumThreads = 0, double CpuFraction = -1.0);
+
+	virtual ~CHybridTask();
+
+	// IComputeTask
+	virtual bool InitResources(cl_device_id Device, cl_context Context);
+
+	virtual void StartProgramBuilds(cl_device_id Device, cl_context Context);
+
+	virtual bool InitPrograms(cl_device_id Device, cl_context Context);
+
+	virtual void ReleaseResources();
+
+	virtual void ComputeGPU(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
+
+	virtual void ComputeCPU();
+
+	virtual bool ValidateResults();
+
+protected:
+
+	//! Task 0 is the scan (result in m_hScanResult), task 1 the reduction (result in m_ReductionResult)
+	void Hybrid(cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task, double CpuFraction);
+
+	//! The host part of the scan into m_hScanResult, returns its total
+	cl_uint ScanHost(size_t Count);
+	//! Sum of the host part
+	cl_uint ReduceHost(size_t Count);
+
+	//! Average time of Hybrid() in ms
+	double Measure(cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task, double CpuFraction, unsigned int Iterations);
+	void Calibrate(cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task);
+
+	void ValidateTask(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task);
+	void TestPerformance(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task);
+
+	size_t					m_N;
+	double					m_RequestedCpuFraction;
+	// split of the scan and the reduction
+	double					m_CpuFraction[2];
+
+	std::vector<cl_uint>	m_hInput;
+
+	std::vector<cl_uint>	m_hScanCPU;
+	std::vector<cl_uint>	m_hScanResult;
+	cl_uint					m_ReductionCPU;
+	cl_uint					m_ReductionResult;
+	std::vector<cl_uint>	m_hPartials;
+	// per host thread
+	std::vector<cl_uint>	m_hThreadSums;
+	cl_uint					m_Carry;
+	bool					m_bValidationResults[2];
+
+	CThreadPool				m_ThreadPool;
+
+	cl_mem					m_dArray;
+	cl_mem					m_dPartials;
+	cl_mem					m_dCarries[2];
+
+	CScanHierarchy			m_Scan;
+
+	//OpenCL program and kernels
+	cl_program				m_Program;
+	cl_kernel				m_AddCarryKernel;
+	cl_kernel				m_ReduceChunkKernel;
+};
+
+#endif // _CHYBRID_TASK_H
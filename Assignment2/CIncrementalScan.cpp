@@ -0,0 +1,176 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+
+#include "CIncrementalScan.h"
+
+#include "../Common/CLUtil.h"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// CIncrementalScan
+
+CIncrementalScan::CIncrementalScan(size_t MaxElements, size_t TileSize)
+	: m_MaxElements(MaxElements), m_TileSize(TileSize), m_N(0),
+	m_dInput(NULL), m_dOutput(NULL), m_dTileSums(NULL),
+	m_ReduceTilesKernel(NULL), m_ScanTileSumsKernel(NULL), m_ScanTilesKernel(NULL), m_AddTileDeltaKernel(NULL)
+{
+	m_dScannedTileSums[0] = m_dScannedTileSums[1] = NULL;
+}
+
+CIncrementalScan::~CIncrementalScan()
+{
+	ReleaseResources();
+}
+
+bool CIncrementalScan::InitResources(cl_context Context, cl_program Program)
+{
+	size_t maxTiles = (m_MaxElements + m_TileSize - 1) / m_TileSize;
+
+	cl_int clError, clError2;
+	m_dInput = clCreateBuffer(Context, CL_MEM_READ_WRITE, sizeof(cl_uint) * m_MaxElements, NULL, &clError2);
+	clError = clError2;
+	m_dOutput = clCreateBuffer(Context, CL_MEM_READ_WRITE, sizeof(cl_uint) * m_MaxElements, NULL, &clError2);
+	clError |= clError2;
+	m_dTileSums = clCreateBuffer(Context, CL_MEM_READ_WRITE, sizeof(cl_uint) * maxTiles, NULL, &clError2);
+	clError |= clError2;
+	for (int i = 0; i < 2; i++) {
+		m_dScannedTileSums[i] = clCreateBuffer(Context, CL_MEM_READ_WRITE, sizeof(cl_uint) * maxTiles, NULL, &clError2);
+		clError |= clError2;
+	}
+	V_RETURN_FALSE_CL(clError, "Error allocating the incremental scan arrays");
+
+	m_ReduceTilesKernel = clCreateKernel(Program, "Scan_ReduceTiles", &clError);
+	V_RETURN_FALSE_CL(clError, "Failed to create kernel: Scan_ReduceTiles.");
+
+	m_ScanTileSumsKernel = clCreateKernel(Program, "Scan_WorkEfficientRows", &clError);
+	V_RETURN_FALSE_CL(clError, "Failed to create kernel: Scan_WorkEfficientRows.");
+
+	m_ScanTilesKernel = clCreateKernel(Program, "Scan_ScanTiles", &clError);
+	V_RETURN_FALSE_CL(clError, "Failed to create kernel: Scan_ScanTiles.");
+
+	m_AddTileDeltaKernel = clCreateKernel(Program, "Scan_AddTileDelta", &clError);
+	V_RETURN_FALSE_CL(clError, "Failed to create kernel: Scan_AddTileDelta.");
+
+	return true;
+}
+
+void CIncrementalScan::ReleaseResources()
+{
+	SAFE_RELEASE_MEMOBJECT(m_dInput);
+	SAFE_RELEASE_MEMOBJECT(m_dOutput);
+	SAFE_RELEASE_MEMOBJECT(m_dTileSums);
+	SAFE_RELEASE_MEMOBJECT(m_dScannedTileSums[0]);
+	SAFE_RELEASE_MEMOBJECT(m_dScannedTileSums[1]);
+
+	SAFE_RELEASE_KERNEL(m_ReduceTilesKernel);
+	SAFE_RELEASE_KERNEL(m_ScanTileSumsKernel);
+	SAFE_RELEASE_KERNEL(m_ScanTilesKernel);
+	SAFE_RELEASE_KERNEL(m_AddTileDeltaKernel);
+}
+
+void CIncrementalScan::ScanTiles(cl_command_queue CommandQueue, size_t N, cl_uint FirstTile, cl_uint LastTile, size_t LocalWorkSize)
+{
+	cl_int clErr;
+	size_t globalWorkSize[2];
+	size_t localWorkSize[2] = { LocalWorkSize, 1 };
+
+	cl_uint n = (cl_uint)N;
+	cl_uint tileSize = (cl_uint)m_TileSize;
+	cl_uint nTiles = (cl_uint)((N + m_TileSize - 1) / m_TileSize);
+
+	// 1. sums of the tiles
+	globalWorkSize[0] = (LastTile - FirstTile + 1) * localWorkSize[0];
+
+	clErr = clSetKernelArg(m_ReduceTilesKernel, 0, sizeof(cl_mem), (void*)&m_dInput);
+	clErr |= clSetKernelArg(m_ReduceTilesKernel, 1, sizeof(cl_mem), (void*)&m_dTileSums);
+	clErr |= clSetKernelArg(m_ReduceTilesKernel, 2, sizeof(cl_uint), (void*)&n);
+	clErr |= clSetKernelArg(m_ReduceTilesKernel, 3, sizeof(cl_uint), (void*)&tileSize);
+	clErr |= clSetKernelArg(m_ReduceTilesKernel, 4, sizeof(cl_uint), (void*)&FirstTile);
+	clErr |= clSetKernelArg(m_ReduceTilesKernel, 5, localWorkSize[0] * sizeof(cl_uint), NULL);
+	V_RETURN_CL(clErr, "Failed to set Scan_ReduceTiles arguments");
+
+	clErr = clEnqueueNDRangeKernel(CommandQueue, m_ReduceTilesKernel, 1, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+	V_RETURN_CL(clErr, "Error executing Scan_ReduceTiles!");
+
+	// 2. scan of all tile sums in a single work-group, into the buffer that is not current
+	globalWorkSize[0] = localWorkSize[0];
+	globalWorkSize[1] = 1;
+
+	clErr = clSetKernelArg(m_ScanTileSumsKernel, 0, sizeof(cl_mem), (void*)&m_dTileSums);
+	clErr |= clSetKernelArg(m_ScanTileSumsKernel, 1, sizeof(cl_mem), (void*)&m_dScannedTileSums[1]);
+	clErr |= clSetKernelArg(m_ScanTileSumsKernel, 2, sizeof(cl_uint), (void*)&nTiles);
+	clErr |= clSetKernelArg(m_ScanTileSumsKernel, 3, 4 * localWorkSize[0] * sizeof(cl_uint), NULL);
+	V_RETURN_CL(clErr, "Failed to set Scan_WorkEfficientRows arguments");
+
+	clErr = clEnqueueNDRangeKernel(CommandQueue, m_ScanTileSumsKernel, 2, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+	V_RETURN_CL(clErr, "Error executing Scan_WorkEfficientRows!");
+
+	// 3. scan of the tiles with the new carries
+	globalWorkSize[0] = (LastTile - FirstTile + 1) * localWorkSize[0];
+
+	clErr = clSetKernelArg(m_ScanTilesKernel, 0, sizeof(cl_mem), (void*)&m_dInput);
+	clErr |= clSetKernelArg(m_ScanTilesKernel, 1, sizeof(cl_mem), (void*)&m_dOutput);
+	clErr |= clSetKernelArg(m_ScanTilesKernel, 2, sizeof(cl_mem), (void*)&m_dScannedTileSums[1]);
+	clErr |= clSetKernelArg(m_ScanTilesKernel, 3, sizeof(cl_uint), (void*)&n);
+	clErr |= clSetKernelArg(m_ScanTilesKernel, 4, sizeof(cl_uint), (void*)&tileSize);
+	clErr |= clSetKernelArg(m_ScanTilesKernel, 5, sizeof(cl_uint), (void*)&FirstTile);
+	clErr |= clSetKernelArg(m_ScanTilesKernel, 6, 4 * localWorkSize[0] * sizeof(cl_uint), NULL);
+	V_RETURN_CL(clErr, "Failed to set Scan_ScanTiles arguments");
+
+	clErr = clEnqueueNDRangeKernel(CommandQueue, m_ScanTilesKernel, 1, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+	V_RETURN_CL(clErr, "Error executing Scan_ScanTiles!");
+}
+
+void CIncrementalScan::Scan(cl_command_queue CommandQueue, size_t N, size_t LocalWorkSize)
+{
+	if (N == 0)
+		return;
+
+	ScanTiles(CommandQueue, N, 0, (cl_uint)((N - 1) / m_TileSize), LocalWorkSize);
+
+	swap(m_dScannedTileSums[0], m_dScannedTileSums[1]);
+	m_N = N;
+}
+
+void CIncrementalScan::Update(cl_command_queue CommandQueue, size_t First, size_t Count, size_t LocalWorkSize)
+{
+	if (Count == 0)
+		return;
+
+	// elements between the current end and First are new as well
+	size_t N = max(m_N, First + Count);
+	cl_uint firstTile = (cl_uint)(min(First, m_N) / m_TileSize);
+	cl_uint lastTile = (cl_uint)((First + Count - 1) / m_TileSize);
+
+	ScanTiles(CommandQueue, N, firstTile, lastTile, LocalWorkSize);
+
+	// the following tiles only change by the difference of the carry
+	cl_uint start = (cl_uint)((lastTile + 1) * m_TileSize);
+	if (start < N)
+	{
+		cl_int clErr;
+		cl_uint n = (cl_uint)N;
+		size_t localWorkSize[1] = { LocalWorkSize };
+		size_t globalWorkSize[1] = { CLUtil::GetGlobalWorkSize((N - start + 3) / 4, LocalWorkSize) };
+
+		clErr = clSetKernelArg(m_AddTileDeltaKernel, 0, sizeof(cl_mem), (void*)&m_dOutput);
+		clErr |= clSetKernelArg(m_AddTileDeltaKernel, 1, sizeof(cl_uint), (void*)&start);
+		clErr |= clSetKernelArg(m_AddTileDeltaKernel, 2, sizeof(cl_uint), (void*)&n);
+		clErr |= clSetKernelArg(m_AddTileDeltaKernel, 3, sizeof(cl_mem), (void*)&m_dScannedTileSums[1]);
+		clErr |= clSetKernelArg(m_AddTileDeltaKernel, 4, sizeof(cl_mem), (void*)&m_dScannedTileSums[0]);
+		clErr |= clSetKernelArg(m_AddTileDeltaKernel, 5, sizeof(cl_uint), (void*)&lastTile);
+		V_RETURN_CL(clErr, "Failed to set Scan_AddTileDelta arguments");
+
+		clErr = clEnqueueNDRangeKernel(CommandQueue, m_AddTileDeltaKernel, 1, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+		V_RETURN_CL(clErr, "Error executing Scan_AddTileDelta!");
+	}
+
+	swap(m_dScannedTileSums[0], m_dScannedTileSums[1]);
+	m_N = N;
+}
+
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,83 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CINCREMENTAL_SCAN_H
+#define _CINCREMENTAL_SCAN_H
+
+#include "../Common/IComputeTask.h"
+
+//! Prefix sum that stays resident on the device and is updated incrementally
+/*!
+	The input and its inclusive prefix sum are kept in device buffers, together with the
+	sum of every tile of TileSize elements and the scanned tile sums (the reduce-then-scan
+	kernels of Scan.cl).
+	After a range of the input was changed, Update() only
+	- reduces and rescans the tiles of the range (the carry-in comes from the scanned tile sums)
+	- adds the change of the total to all following elements in one vectorized pass.
+	Appending to the input is an update behind the current end.
+
+	TileSize has to be a multiple of 2 * LocalWorkSize.
+*/
+class CIncrementalScan
+{
+public:
+	CIncrementalScan(size_t MaxElements, size_t TileSize);
+
+	virtual ~CIncrementalScan();
+
+	bool InitResources(cl_context Context, cl_program Program);
+
+	void ReleaseResources();
+
+	//! Input buffer of MaxElements elements, write the input here before Scan() or Update()
+	cl_mem GetInput() const { return m_dInput; }
+
+	//! Inclusive prefix sum of the first GetSize() input elements
+	cl_mem GetOutput() const { return m_dOutput; }
+
+	size_t GetSize() const { return m_N; }
+
+	//! Full scan of the first N elements of the input
+	void Scan(cl_command_queue CommandQueue, size_t N, size_t LocalWorkSize);
+
+	//! The input elements [First, First + Count) have changed, First + Count may be behind the current end (append)
+	void Update(cl_command_queue CommandQueue, size_t First, size_t Count, size_t LocalWorkSize);
+
+protected:
+
+	//! Reduces and scans the tiles [FirstTile, LastTile] of the first N elements
+	void ScanTiles(cl_command_queue CommandQueue, size_t N, cl_uint FirstTile, cl_uint LastTile, size_t LocalWorkSize);
+
+	size_t				m_MaxElements;
+	size_t				m_TileSize;
+	size_t				m_N;
+
+	cl_mem				m_dInput;
+	cl_mem				m_dOutput;
+	cl_mem				m_dTileSums;
+	// the scanned tile sums before and after an update, swapped after every scan
+	cl_mem				m_dScannedTileSums[2];
+
+	cl_kernel			m_ReduceTilesKernel;
+	cl_kernel			m_ScanTileSumsKernel;
+	cl_kernel			m_ScanTilesKernel;
+	cl_kernel			m_AddTileDeltaKernel;
+};
+
+#endif // _CINCREMENTAL_SCAN_H
@@ -0,0 +1,214 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+
+#include "CIncrementalScanTask.h"
+
+#include "../Common/CLUtil.h"
+#include "../Common/CProgramBuilder.h"
+#include "../Common/CTimer.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// CIncrementalScanTask
+
+// only useful for debug info
+static const string g_IncrementalStepNames[3] =
+{
+	"initial scan",
+	"update",
+	"append"
+};
+
+CIncrementalScanTask::CIncrementalScanTask(size_t ArraySize, size_t TileSize, size_t UpdateSize, size_t AppendSize)
+	: m_N(ArraySize), m_UpdateSize(UpdateSize), m_AppendSize(AppendSize), m_UpdateStart((ArraySize - AppendSize) / 3),
+	m_Scan(ArraySize, TileSize), m_Program(NULL)
+{
+	// Reset validation results
+	for (int i = 0; i < (int)ARRAYLEN(m_bValidationResults); i++)
+		m_bValidationResults[i] = false;
+}
+
+CIncrementalScanTask::~CIncrementalScanTask()
+{
+	ReleaseResources();
+}
+
+bool CIncrementalScanTask::InitResources(cl_device_id Device, cl_context Context)
+{
+	//CPU resources
+	m_hInput.resize(m_N);
+	m_hUpdate.resize(m_UpdateSize);
+	m_hResultGPU.resize(m_N);
+
+	//fill the array with some values
+	for(size_t i = 0; i < m_N; i++)
+		m_hInput[i] = rand() & 15;
+	for(size_t i = 0; i < m_UpdateSize; i++)
+		m_hUpdate[i] = rand() & 15;
+
+	return true;
+}
+
+bool CIncrementalScanTask::InitPrograms(cl_device_id Device, cl_context Context)
+{
+	//load and compile kernels
+	string programCode;
+
+	if (!CLUtil::LoadProgramSourceToMemory("Scan.cl", programCode))
+		return false;
+	m_Program = CLUtil::BuildCLProgramFromMemory(Device, Context, programCode);
+	if(m_Program == nullptr) return false;
+
+	//device resources
+	if (!m_Scan.InitResources(Context, m_Program))
+		return false;
+
+	return true;
+}
+
+void CIncrementalScanTask::StartProgramBuilds(cl_device_id Device, cl_context Context)
+{
+	string programCode;
+
+	if (CLUtil::LoadProgramSourceToMemory("Scan.cl", programCode))
+		CProgramBuilder::BuildAsync(Device, Context, programCode);
+}
+
+void CIncrementalScanTask::ReleaseResources()
+{
+	// host resources
+	m_hInput.clear();
+	m_hUpdate.clear();
+	for (int i = 0; i < 3; i++)
+		m_hResultCPU[i].clear();
+	m_hResultGPU.clear();
+
+	// device resources
+	m_Scan.ReleaseResources();
+
+	SAFE_RELEASE_PROGRAM(m_Program);
+}
+
+void CIncrementalScanTask::ComputeGPU(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
+{
+	cout << endl;
+
+	ValidateTask(Context, CommandQueue, LocalWorkSize);
+
+	cout << endl;
+
+	TestPerformance(Context, CommandQueue, LocalWorkSize);
+
+	cout << endl;
+}
+
+void CIncrementalScanTask::ComputeCPU()
+{
+	CTimer timer;
+	timer.Start();
+
+	size_t initialN = m_N - m_AppendSize;
+
+	// the input of the three steps
+	vector<cl_uint> input(m_hInput.begin(), m_hInput.begin() + initialN);
+	for (int step = 0; step < 3; step++)
+	{
+		if (step == 1)
+			copy(m_hUpdate.begin(), m_hUpdate.end(), input.begin() + m_UpdateStart);
+		if (step == 2)
+			input.insert(input.end(), m_hInput.begin() + initialN, m_hInput.end());
+
+		m_hResultCPU[step].resize(input.size());
+		cl_uint sum = 0;
+		for(size_t i = 0; i < input.size(); i++) {
+			sum += input[i];
+			m_hResultCPU[step][i] = sum;
+		}
+	}
+
+	timer.Stop();
+	double ms = timer.GetElapsedMilliseconds();
+	cout << "  average time: " << ms << " ms for the three full scans" << endl;
+}
+
+bool CIncrementalScanTask::ValidateResults()
+{
+	bool success = true;
+
+	for(int i = 0; i < (int)ARRAYLEN(m_bValidationResults); i++)
+		if(!m_bValidationResults[i])
+		{
+			cout<<"Validation of incremental scan ("<<g_IncrementalStepNames[i]<<") failed." << endl;
+			success = false;
+		}
+
+	return success;
+}
+
+bool CIncrementalScanTask::CheckResult(cl_command_queue CommandQueue, const vector<cl_uint>& Reference, size_t N)
+{
+	V_RETURN_FALSE_CL(clEnqueueReadBuffer(CommandQueue, m_Scan.GetOutput(), CL_TRUE, 0, N * sizeof(cl_uint), &m_hResultGPU[0], 0, NULL, NULL), "Error reading data from device!");
+
+	return m_Scan.GetSize() == N && memcmp(&Reference[0], &m_hResultGPU[0], N * sizeof(cl_uint)) == 0;
+}
+
+void CIncrementalScanTask::ValidateTask(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
+{
+	size_t initialN = m_N - m_AppendSize;
+	cl_mem dInput = m_Scan.GetInput();
+
+	// initial scan
+	V_RETURN_CL(clEnqueueWriteBuffer(CommandQueue, dInput, CL_FALSE, 0, initialN * sizeof(cl_uint), &m_hInput[0], 0, NULL, NULL), "Error copying data from host to device!");
+	m_Scan.Scan(CommandQueue, initialN, LocalWorkSize[0]);
+	m_bValidationResults[0] = CheckResult(CommandQueue, m_hResultCPU[0], initialN);
+
+	// replace a slice
+	V_RETURN_CL(clEnqueueWriteBuffer(CommandQueue, dInput, CL_FALSE, m_UpdateStart * sizeof(cl_uint), m_UpdateSize * sizeof(cl_uint), &m_hUpdate[0], 0, NULL, NULL), "Error copying data from host to device!");
+	m_Scan.Update(CommandQueue, m_UpdateStart, m_UpdateSize, LocalWorkSize[0]);
+	m_bValidationResults[1] = CheckResult(CommandQueue, m_hResultCPU[1], initialN);
+
+	// append the tail
+	V_RETURN_CL(clEnqueueWriteBuffer(CommandQueue, dInput, CL_FALSE, initialN * sizeof(cl_uint), m_AppendSize * sizeof(cl_uint), &m_hInput[initialN], 0, NULL, NULL), "Error copying data from host to device!");
+	m_Scan.Update(CommandQueue, initialN, m_AppendSize, LocalWorkSize[0]);
+	m_bValidationResults[2] = CheckResult(CommandQueue, m_hResultCPU[2], m_N);
+}
+
+void CIncrementalScanTask::TestPerformance(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
+{
+	cout << "Testing performance of incremental scan, " << m_N << " elements, " << m_UpdateSize << " updated, " << m_AppendSize << " appended" << endl;
+
+	//finish all before we start meassuring the time
+	V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
+
+	size_t initialN = m_N - m_AppendSize;
+	unsigned int nIterations = 100;
+	CTimer timer;
+
+	// 0: full rescan, 1: update of the slice, 2: rescan of the tail (the input data stays the same)
+	const char* names[3] = { "full rescan", "slice update", "tail update" };
+	for (int op = 0; op < 3; op++)
+	{
+		timer.Start();
+		for(unsigned int i = 0; i < nIterations; i++) {
+			switch (op) {
+				case 0: m_Scan.Scan(CommandQueue, m_N, LocalWorkSize[0]); break;
+				case 1: m_Scan.Update(CommandQueue, m_UpdateStart, m_UpdateSize, LocalWorkSize[0]); break;
+				case 2: m_Scan.Update(CommandQueue, initialN, m_AppendSize, LocalWorkSize[0]); break;
+			}
+		}
+		V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
+		timer.Stop();
+
+		double ms = timer.GetElapsedMilliseconds() / double(nIterations);
+		cout << "  " << names[op] << ": average time " << ms << " ms" << endl;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
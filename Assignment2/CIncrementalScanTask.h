@@ -0,0 +1,84 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CINCREMENTAL_SCAN_TASK_H
+#define _CINCREMENTAL_SCAN_TASK_H
+
+#include "../Common/IComputeTask.h"
+
+#include "CIncrementalScan.h"
+
+#include <vector>
+
+//! Keeps a prefix sum up to date while the input changes
+/*!
+	Scans ArraySize - AppendSize elements, replaces UpdateSize elements in the first third,
+	then appends AppendSize elements, validating the resident result after every step.
+	The performance test compares a full rescan with the incremental updates.
+*/
+class CIncrementalScanTask : public IComputeTask
+{
+public:
+	CIncrementalScanTask(size_t ArraySize, size_t TileSize, size_t UpdateSize, size_t AppendSize);
+
+	virtual ~CIncrementalScanTask();
+
+	// IComputeTask
+	virtual bool InitResources(cl_device_id Device, cl_context Context);
+
+	virtual void StartProgramBuilds(cl_device_id Device, cl_context Context);
+
+	virtual bool InitPrograms(cl_device_id Device, cl_context Context);
+
+	virtual void ReleaseResources();
+
+	virtual void ComputeGPU(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
+
+	virtual void ComputeCPU();
+
+	virtual bool ValidateResults();
+
+protected:
+
+	//! Compares the first N elements of the resident scan with Reference
+	bool CheckResult(cl_command_queue CommandQueue, const std::vector<cl_uint>& Reference, size_t N);
+
+	void ValidateTask(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
+	void TestPerformance(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
+
+	size_t					m_N;
+	size_t					m_UpdateSize;
+	size_t					m_AppendSize;
+	size_t					m_UpdateStart;
+
+	std::vector<cl_uint>	m_hInput;
+	std::vector<cl_uint>	m_hUpdate;
+
+	// after the initial scan, the update and the append
+	std::vector<cl_uint>	m_hResultCPU[3];
+	std::vector<cl_uint>	m_hResultGPU;
+	bool					m_bValidationResults[3];
+
+	CIncrementalScan		m_Scan;
+
+	//OpenCL program, the kernels are owned by m_Scan
+	cl_program				m_Program;
+};
+
+#endif // _CINCREMENTAL_SCAN_TASK_H
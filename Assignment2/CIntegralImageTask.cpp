@@ -0,0 +1,267 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+
+#include "CIntegralImageTask.h"
+
+#include "../Common/CLUtil.h"
+#include "../Common/CProgramBuilder.h"
+#include "../Common/CTimer.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+using namespace std;
+
+// rows per column strip
+#define SAT_STRIP_HEIGHT	64
+
+///////////////////////////////////////////////////////////////////////////////
+// CIntegralImageTask
+
+CIntegralImageTask::CIntegralImageTask(size_t Width, size_t Height)
+	: m_Width(Width), m_Height(Height), m_StripHeight(SAT_STRIP_HEIGHT),
+	m_hImage(NULL), m_hTableCPU(NULL), m_hTableGPU(NULL), m_bValidationResult(false),
+	m_dImage(NULL), m_dTable(NULL), m_dStripSums(NULL),
+	m_Program(NULL), m_ScanRowsKernel(NULL), m_ScanColumnsKernel(NULL), m_ColumnStripSumsKernel(NULL), m_ScanColumnStripsKernel(NULL)
+{
+	m_nStrips = (m_Height + m_StripHeight - 1) / m_StripHeight;
+}
+
+CIntegralImageTask::~CIntegralImageTask()
+{
+	ReleaseResources();
+}
+
+bool CIntegralImageTask::InitResources(cl_device_id Device, cl_context Context)
+{
+	size_t nPixels = (size_t)m_Width * m_Height;
+
+	//CPU resources
+	m_hImage	= new unsigned int[nPixels];
+	m_hTableCPU	= new unsigned int[nPixels];
+	m_hTableGPU	= new unsigned int[nPixels];
+
+	//8 bit gray values
+	for(size_t i = 0; i < nPixels; i++)
+		m_hImage[i] = rand() & 255;
+
+	//device resources
+	cl_int clError, clError2;
+	m_dImage = clCreateBuffer(Context, CL_MEM_READ_ONLY, sizeof(cl_uint) * nPixels, NULL, &clError2);
+	clError = clError2;
+	m_dTable = clCreateBuffer(Context, CL_MEM_READ_WRITE, sizeof(cl_uint) * nPixels, NULL, &clError2);
+	clError |= clError2;
+	m_dStripSums = clCreateBuffer(Context, CL_MEM_READ_WRITE, sizeof(cl_uint) * m_Width * m_nStrips, NULL, &clError2);
+	clError |= clError2;
+	V_RETURN_FALSE_CL(clError, "Error allocating device arrays");
+
+	return true;
+}
+
+bool CIntegralImageTask::InitPrograms(cl_device_id Device, cl_context Context)
+{
+	cl_int clError;
+
+	//load and compile kernels
+	string scanCode, satCode;
+
+	if (!CLUtil::LoadProgramSourceToMemory("Scan.cl", scanCode) ||
+		!CLUtil::LoadProgramSourceToMemory("IntegralImage.cl", satCode))
+		return false;
+
+	m_Program = CLUtil::BuildCLProgramFromMemory(Device, Context, scanCode + "\n" + satCode);
+	if(m_Program == nullptr) return false;
+
+	//create kernels
+	m_ScanRowsKernel = clCreateKernel(m_Program, "Scan_WorkEfficientRows", &clError);
+	V_RETURN_FALSE_CL(clError, "Failed to create kernel: Scan_WorkEfficientRows.");
+
+	m_ScanColumnsKernel = clCreateKernel(m_Program, "SAT_ScanColumns", &clError);
+	V_RETURN_FALSE_CL(clError, "Failed to create kernel: SAT_ScanColumns.");
+
+	m_ColumnStripSumsKernel = clCreateKernel(m_Program, "SAT_ColumnStripSums", &clError);
+	V_RETURN_FALSE_CL(clError, "Failed to create kernel: SAT_ColumnStripSums.");
+
+	m_ScanColumnStripsKernel = clCreateKernel(m_Program, "SAT_ScanColumnStrips", &clError);
+	V_RETURN_FALSE_CL(clError, "Failed to create kernel: SAT_ScanColumnStrips.");
+
+	return true;
+}
+
+void CIntegralImageTask::StartProgramBuilds(cl_device_id Device, cl_context Context)
+{
+	string scanCode, satCode;
+
+	if (CLUtil::LoadProgramSourceToMemory("Scan.cl", scanCode) &&
+		CLUtil::LoadProgramSourceToMemory("IntegralImage.cl", satCode))
+		CProgramBuilder::BuildAsync(Device, Context, scanCode + "\n" + satCode);
+}
+
+void CIntegralImageTask::ReleaseResources()
+{
+	// host resources
+	SAFE_DELETE_ARRAY(m_hImage);
+	SAFE_DELETE_ARRAY(m_hTableCPU);
+	SAFE_DELETE_ARRAY(m_hTableGPU);
+
+	// device resources
+	SAFE_RELEASE_MEMOBJECT(m_dImage);
+	SAFE_RELEASE_MEMOBJECT(m_dTable);
+	SAFE_RELEASE_MEMOBJECT(m_dStripSums);
+
+	SAFE_RELEASE_KERNEL(m_ScanRowsKernel);
+	SAFE_RELEASE_KERNEL(m_ScanColumnsKernel);
+	SAFE_RELEASE_KERNEL(m_ColumnStripSumsKernel);
+	SAFE_RELEASE_KERNEL(m_ScanColumnStripsKernel);
+
+	SAFE_RELEASE_PROGRAM(m_Program);
+}
+
+void CIntegralImageTask::ComputeGPU(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
+{
+	cout << endl;
+
+	ValidateTask(Context, CommandQueue, LocalWorkSize);
+
+	cout << endl;
+
+	TestPerformance(Context, CommandQueue, LocalWorkSize);
+
+	cout << endl;
+}
+
+void CIntegralImageTask::ComputeCPU()
+{
+	CTimer timer;
+	timer.Start();
+
+	// S(x, y) = I(x, y) + S(x - 1, y) + S(x, y - 1) - S(x - 1, y - 1), computed as row sum + table above
+	for(unsigned int y = 0; y < m_Height; y++) {
+		unsigned int rowSum = 0;
+		for(unsigned int x = 0; x < m_Width; x++) {
+			size_t index = (size_t)y * m_Width + x;
+			rowSum += m_hImage[index];
+			m_hTableCPU[index] = rowSum + ((y > 0) ? m_hTableCPU[index - m_Width] : 0);
+		}
+	}
+
+	timer.Stop();
+	double ms = timer.GetElapsedMilliseconds();
+	cout << "  average time: " << ms << " ms, throughput: " << 1.0e-6 * (double)m_Width * m_Height / ms << " Gpixel/s" <<endl;
+}
+
+bool CIntegralImageTask::ValidateResults()
+{
+	if (!m_bValidationResult)
+	{
+		cout << "Validation of integral image " << m_Width << "x" << m_Height << " failed." << endl;
+	}
+
+	return m_bValidationResult;
+}
+
+void CIntegralImageTask::IntegralImage(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
+{
+	cl_int clErr;
+	size_t globalWorkSize[2];
+	size_t localWorkSize[2];
+
+	// 1. scan all rows, one work-group per row
+	localWorkSize[0] = LocalWorkSize[0];
+	localWorkSize[1] = 1;
+	globalWorkSize[0] = localWorkSize[0];
+	globalWorkSize[1] = m_Height;
+
+	clErr = clSetKernelArg(m_ScanRowsKernel, 0, sizeof(cl_mem), (void*)&m_dImage);
+	clErr |= clSetKernelArg(m_ScanRowsKernel, 1, sizeof(cl_mem), (void*)&m_dTable);
+	clErr |= clSetKernelArg(m_ScanRowsKernel, 2, sizeof(cl_uint), (void*)&m_Width);
+	clErr |= clSetKernelArg(m_ScanRowsKernel, 3, 4 * localWorkSize[0] * sizeof(cl_uint), NULL);
+	V_RETURN_CL(clErr, "Failed to set Scan_WorkEfficientRows arguments");
+
+	clErr = clEnqueueNDRangeKernel(CommandQueue, m_ScanRowsKernel, 2, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+	V_RETURN_CL(clErr, "Error executing Scan_WorkEfficientRows!");
+
+	// 2. sum of every column strip
+	globalWorkSize[0] = CLUtil::GetGlobalWorkSize(m_Width, localWorkSize[0]);
+	globalWorkSize[1] = m_nStrips;
+
+	clErr = clSetKernelArg(m_ColumnStripSumsKernel, 0, sizeof(cl_mem), (void*)&m_dTable);
+	clErr |= clSetKernelArg(m_ColumnStripSumsKernel, 1, sizeof(cl_mem), (void*)&m_dStripSums);
+	clErr |= clSetKernelArg(m_ColumnStripSumsKernel, 2, sizeof(cl_uint), (void*)&m_Width);
+	clErr |= clSetKernelArg(m_ColumnStripSumsKernel, 3, sizeof(cl_uint), (void*)&m_Height);
+	clErr |= clSetKernelArg(m_ColumnStripSumsKernel, 4, sizeof(cl_uint), (void*)&m_StripHeight);
+	V_RETURN_CL(clErr, "Failed to set SAT_ColumnStripSums arguments");
+
+	clErr = clEnqueueNDRangeKernel(CommandQueue, m_ColumnStripSumsKernel, 2, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+	V_RETURN_CL(clErr, "Error executing SAT_ColumnStripSums!");
+
+	// 3. scan the strip sums of every column
+	clErr = clSetKernelArg(m_ScanColumnsKernel, 0, sizeof(cl_mem), (void*)&m_dStripSums);
+	clErr |= clSetKernelArg(m_ScanColumnsKernel, 1, sizeof(cl_uint), (void*)&m_Width);
+	clErr |= clSetKernelArg(m_ScanColumnsKernel, 2, sizeof(cl_uint), (void*)&m_nStrips);
+	V_RETURN_CL(clErr, "Failed to set SAT_ScanColumns arguments");
+
+	clErr = clEnqueueNDRangeKernel(CommandQueue, m_ScanColumnsKernel, 1, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+	V_RETURN_CL(clErr, "Error executing SAT_ScanColumns!");
+
+	// 4. scan every column strip with its carry-in
+	globalWorkSize[1] = m_nStrips;
+
+	clErr = clSetKernelArg(m_ScanColumnStripsKernel, 0, sizeof(cl_mem), (void*)&m_dTable);
+	clErr |= clSetKernelArg(m_ScanColumnStripsKernel, 1, sizeof(cl_mem), (void*)&m_dStripSums);
+	clErr |= clSetKernelArg(m_ScanColumnStripsKernel, 2, sizeof(cl_uint), (void*)&m_Width);
+	clErr |= clSetKernelArg(m_ScanColumnStripsKernel, 3, sizeof(cl_uint), (void*)&m_Height);
+	clErr |= clSetKernelArg(m_ScanColumnStripsKernel, 4, sizeof(cl_uint), (void*)&m_StripHeight);
+	V_RETURN_CL(clErr, "Failed to set SAT_ScanColumnStrips arguments");
+
+	clErr = clEnqueueNDRangeKernel(CommandQueue, m_ScanColumnStripsKernel, 2, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+	V_RETURN_CL(clErr, "Error executing SAT_ScanColumnStrips!");
+}
+
+void CIntegralImageTask::ValidateTask(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
+{
+	size_t nPixels = (size_t)m_Width * m_Height;
+
+	m_bValidationResult = false;
+
+	V_RETURN_CL(clEnqueueWriteBuffer(CommandQueue, m_dImage, CL_FALSE, 0, nPixels * sizeof(cl_uint), m_hImage, 0, NULL, NULL), "Error copying data from host to device!");
+	IntegralImage(Context, CommandQueue, LocalWorkSize);
+	V_RETURN_CL(clEnqueueReadBuffer(CommandQueue, m_dTable, CL_TRUE, 0, nPixels * sizeof(cl_uint), m_hTableGPU, 0, NULL, NULL), "Error reading data from device!");
+
+	// validate results
+	m_bValidationResult = (memcmp(m_hTableCPU, m_hTableGPU, nPixels * sizeof(unsigned int)) == 0);
+}
+
+void CIntegralImageTask::TestPerformance(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
+{
+	size_t nPixels = (size_t)m_Width * m_Height;
+
+	cout << "Testing performance of integral image " << m_Width << "x" << m_Height << endl;
+
+	//write input data to the GPU
+	V_RETURN_CL(clEnqueueWriteBuffer(CommandQueue, m_dImage, CL_FALSE, 0, nPixels * sizeof(cl_uint), m_hImage, 0, NULL, NULL), "Error copying data from host to device!");
+	//finish all before we start meassuring the time
+	V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
+
+	CTimer timer;
+	timer.Start();
+
+	//run the kernel N times
+	unsigned int nIterations = 100;
+	for(unsigned int i = 0; i < nIterations; i++) {
+		IntegralImage(Context, CommandQueue, LocalWorkSize);
+	}
+
+	//wait until the command queue is empty again
+	V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
+
+	timer.Stop();
+
+	double ms = timer.GetElapsedMilliseconds() / double(nIterations);
+	cout << "  average time: " << ms << " ms, throughput: " << 1.0e-6 * (double)nPixels / ms << " Gpixel/s" <<endl;
+}
+
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,84 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CINTEGRAL_IMAGE_TASK_H
+#define _CINTEGRAL_IMAGE_TASK_H
+
+#include "../Common/IComputeTask.h"
+
+//! Summed-area table (integral image) of an arbitrary sized image
+/*!
+	The rows are scanned in one launch with one work-group per row (Scan_WorkEfficientRows),
+	then the columns are scanned in strips: sum of each strip, scan of the strip sums,
+	scan of each strip with its carry-in.
+*/
+class CIntegralImageTask : public IComputeTask
+{
+public:
+	CIntegralImageTask(size_t Width, size_t Height);
+
+	virtual ~CIntegralImageTask();
+
+	// IComputeTask
+	virtual bool InitResources(cl_device_id Device, cl_context Context);
+
+	virtual void StartProgramBuilds(cl_device_id Device, cl_context Context);
+
+	virtual bool InitPrograms(cl_device_id Device, cl_context Context);
+
+	virtual void ReleaseResources();
+
+	virtual void ComputeGPU(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
+
+	virtual void ComputeCPU();
+
+	virtual bool ValidateResults();
+
+protected:
+
+	//! Computes the table of m_dImage into m_dTable
+	void IntegralImage(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
+
+	void ValidateTask(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
+	void TestPerformance(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
+
+	unsigned int		m_Width;
+	unsigned int		m_Height;
+	unsigned int		m_StripHeight;
+	unsigned int		m_nStrips;
+
+	unsigned int		*m_hImage;
+
+	unsigned int		*m_hTableCPU;
+	unsigned int		*m_hTableGPU;
+	bool				m_bValidationResult;
+
+	cl_mem				m_dImage;
+	cl_mem				m_dTable;
+	cl_mem				m_dStripSums;
+
+	//OpenCL program and kernels
+	cl_program			m_Program;
+	cl_kernel			m_ScanRowsKernel;
+	cl_kernel			m_ScanColumnsKernel;
+	cl_kernel			m_ColumnStripSumsKernel;
+	cl_kernel			m_ScanColumnStripsKernel;
+};
+
+#endif // _CINTEGRAL_IMAGE_TASK_H
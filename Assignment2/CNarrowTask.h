@@ -0,0 +1,462 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CNARROW_TASK_H
+#define _CNARROW_TASK_H
+
+#include "../Common/IComputeTask.h"
+#include "../Common/CLUtil.h"
+#include "../Common/CProgramBuilder.h"
+#include "../Common/CTimer.h"
+
+#include "NarrowTypes.h"
+
+#include <string>
+#include <vector>
+
+//! Reduction and scan of 8- and 16-bit inputs with wider accumulators
+/*!
+	Narrow.cl is specialized at build time with the -D options of the input type (see NarrowTypes.h).
+	The narrow input is uploaded as it is and widened in registers after vector loads:
+	- reduction: fixed number of partial sums on the device, combined on the host
+	- scan: reduce-then-scan over tiles, the result has the accumulator type
+
+	The same kernels built for the input widened on the host run for comparison.
+*/
+template<class TIn>
+class CNarrowTask : public IComputeTask
+{
+public:
+	typedef typename TIn::Type Type;
+	typedef typename TIn::AccType AccType;
+	typedef typename TIn::HostType HostType;
+
+	CNarrowTask(size_t ArraySize)
+		: m_N(ArraySize), m_ReductionCPU(0), m_dResult(NULL), m_dPartials(NULL), m_dTileSums(NULL)
+	{
+		for (int i = 0; i < 2; i++)
+		{
+			m_dInputs[i] = NULL;
+			m_Programs[i] = NULL;
+			m_ReduceKernels[i] = NULL;
+			m_ReduceTilesKernels[i] = NULL;
+			m_ScanTileSumsKernels[i] = NULL;
+			m_ScanTilesKernels[i] = NULL;
+		}
+
+		// Reset validation results
+		for (int i = 0; i < (int)ARRAYLEN(m_bValidationResults); i++)
+			m_bValidationResults[i] = false;
+	}
+
+	virtual ~CNarrowTask()
+	{
+		ReleaseResources();
+	}
+
+	// IComputeTask
+	virtual bool InitResources(cl_device_id Device, cl_context Context)
+	{
+		//CPU resources
+		m_hInput.resize(m_N);
+		m_hWideInput.resize(m_N);
+		m_hScanCPU.resize(m_N);
+		m_hScanGPU.resize(m_N);
+		m_hPartials.resize(REDUCTION_GROUPS);
+
+		for(size_t i = 0; i < m_N; i++) {
+			m_hInput[i] = TIn::Random();
+			m_hWideInput[i] = TIn::Widen(m_hInput[i]);
+		}
+
+		//device resources
+		cl_int clError, clError2;
+		m_dInputs[NARROW] = clCreateBuffer(Context, CL_MEM_READ_ONLY, sizeof(Type) * m_N, NULL, &clError2);
+		clError = clError2;
+		m_dInputs[WIDE] = clCreateBuffer(Context, CL_MEM_READ_ONLY, sizeof(AccType) * m_N, NULL, &clError2);
+		clError |= clError2;
+		m_dResult = clCreateBuffer(Context, CL_MEM_READ_WRITE, sizeof(AccType) * m_N, NULL, &clError2);
+		clError |= clError2;
+		m_dPartials = clCreateBuffer(Context, CL_MEM_READ_WRITE, sizeof(AccType) * REDUCTION_GROUPS, NULL, &clError2);
+		clError |= clError2;
+		m_dTileSums = clCreateBuffer(Context, CL_MEM_READ_WRITE, sizeof(AccType) * MAX_TILES, NULL, &clError2);
+		clError |= clError2;
+		V_RETURN_FALSE_CL(clError, "Error allocating device arrays");
+
+		return true;
+	}
+
+	virtual void StartProgramBuilds(cl_device_id Device, cl_context Context)
+	{
+		std::string scanCode, narrowCode;
+
+		if (!CLUtil::LoadProgramSourceToMemory("GenericScan.cl", scanCode) ||
+			!CLUtil::LoadProgramSourceToMemory("Narrow.cl", narrowCode))
+			return;
+
+		for (int i = 0; i < 2; i++)
+			CProgramBuilder::BuildAsync(Device, Context, scanCode + "\n" + narrowCode, GetCompileOptions(i));
+	}
+
+	virtual bool InitPrograms(cl_device_id Device, cl_context Context)
+	{
+		cl_int clError;
+
+		//load and compile kernels, once for the narrow and once for the widened input
+		std::string scanCode, narrowCode;
+
+		if (!CLUtil::LoadProgramSourceToMemory("GenericScan.cl", scanCode) ||
+			!CLUtil::LoadProgramSourceToMemory("Narrow.cl", narrowCode))
+			return false;
+
+		for (int i = 0; i < 2; i++)
+		{
+			m_Programs[i] = CLUtil::BuildCLProgramFromMemory(Device, Context, scanCode + "\n" + narrowCode, GetCompileOptions(i));
+			if(m_Programs[i] == nullptr) return false;
+
+			m_ReduceKernels[i] = clCreateKernel(m_Programs[i], "Narrow_Reduce", &clError);
+			V_RETURN_FALSE_CL(clError, "Failed to create kernel: Narrow_Reduce.");
+
+			m_ReduceTilesKernels[i] = clCreateKernel(m_Programs[i], "Narrow_ReduceTiles", &clError);
+			V_RETURN_FALSE_CL(clError, "Failed to create kernel: Narrow_ReduceTiles.");
+
+			m_ScanTileSumsKernels[i] = clCreateKernel(m_Programs[i], "Narrow_ScanTileSums", &clError);
+			V_RETURN_FALSE_CL(clError, "Failed to create kernel: Narrow_ScanTileSums.");
+
+			m_ScanTilesKernels[i] = clCreateKernel(m_Programs[i], "Narrow_ScanTiles", &clError);
+			V_RETURN_FALSE_CL(clError, "Failed to create kernel: Narrow_ScanTiles.");
+		}
+
+		return true;
+	}
+
+	virtual void ReleaseResources()
+	{
+		// host resources
+		m_hInput.clear();
+		m_hWideInput.clear();
+		m_hScanCPU.clear();
+		m_hScanGPU.clear();
+		m_hPartials.clear();
+
+		// device resources
+		SAFE_RELEASE_MEMOBJECT(m_dResult);
+		SAFE_RELEASE_MEMOBJECT(m_dPartials);
+		SAFE_RELEASE_MEMOBJECT(m_dTileSums);
+
+		for (int i = 0; i < 2; i++)
+		{
+			SAFE_RELEASE_MEMOBJECT(m_dInputs[i]);
+			SAFE_RELEASE_KERNEL(m_ReduceKernels[i]);
+			SAFE_RELEASE_KERNEL(m_ReduceTilesKernels[i]);
+			SAFE_RELEASE_KERNEL(m_ScanTileSumsKernels[i]);
+			SAFE_RELEASE_KERNEL(m_ScanTilesKernels[i]);
+			SAFE_RELEASE_PROGRAM(m_Programs[i]);
+		}
+	}
+
+	virtual void ComputeGPU(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
+	{
+		std::cout << std::endl;
+
+		for (unsigned int task = 0; task < ARRAYLEN(m_bValidationResults); task++)
+			ValidateTask(Context, CommandQueue, LocalWorkSize, task);
+
+		std::cout << std::endl;
+
+		TestTransfer(CommandQueue);
+		for (unsigned int task = 0; task < ARRAYLEN(m_bValidationResults); task++)
+			TestPerformance(Context, CommandQueue, LocalWorkSize, task);
+
+		std::cout << std::endl;
+	}
+
+	virtual void ComputeCPU()
+	{
+		CTimer timer;
+		timer.Start();
+
+		HostType sum = 0;
+		for(size_t i = 0; i < m_N; i++) {
+			sum += TIn::ToHost(m_hInput[i]);
+			m_hScanCPU[i] = sum;
+		}
+		m_ReductionCPU = sum;
+
+		timer.Stop();
+		double ms = timer.GetElapsedMilliseconds();
+		std::cout << "  average time: " << ms << " ms, throughput: " << 1.0e-6 * (double)m_N / ms << " Gelem/s" << std::endl;
+	}
+
+	virtual bool ValidateResults()
+	{
+		bool success = true;
+
+		for(int i = 0; i < (int)ARRAYLEN(m_bValidationResults); i++)
+			if(!m_bValidationResults[i])
+			{
+				std::cout << "Validation of " << TaskName(i) << " (" << TIn::Name() << ") failed." << std::endl;
+				success = false;
+			}
+
+		return success;
+	}
+
+	//! Partial sums of the input (NARROW or WIDE) in GetPartials(), REDUCTION_GROUPS values
+	void Reduce(cl_command_queue CommandQueue, size_t LocalWorkSize, int Input)
+	{
+		cl_int clErr;
+		cl_kernel kernel = m_ReduceKernels[Input];
+		cl_uint n = (cl_uint)m_N;
+		size_t localWorkSize[1] = { LocalWorkSize };
+		size_t globalWorkSize[1] = { REDUCTION_GROUPS * LocalWorkSize };
+
+		clErr = clSetKernelArg(kernel, 0, sizeof(cl_mem), (void*)&m_dInputs[Input]);
+		clErr |= clSetKernelArg(kernel, 1, sizeof(cl_mem), (void*)&m_dPartials);
+		clErr |= clSetKernelArg(kernel, 2, sizeof(cl_uint), (void*)&n);
+		clErr |= clSetKernelArg(kernel, 3, LocalWorkSize * sizeof(AccType), NULL);
+		V_RETURN_CL(clErr, "Failed to set Narrow_Reduce arguments");
+
+		clErr = clEnqueueNDRangeKernel(CommandQueue, kernel, 1, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+		V_RETURN_CL(clErr, "Error executing Narrow_Reduce!");
+	}
+
+	//! Inclusive scan of the input (NARROW or WIDE) into GetResult()
+	void Scan(cl_command_queue CommandQueue, size_t LocalWorkSize, int Input)
+	{
+		cl_int clErr;
+		size_t localWorkSize[1] = { LocalWorkSize };
+		size_t globalWorkSize[1];
+
+		// tiles are multiples of the 8 * LocalWorkSize inputs scanned by one group at a time
+		size_t blockSize = 8 * LocalWorkSize;
+		size_t tileSize = (m_N + MAX_TILES - 1) / MAX_TILES;
+		tileSize = (tileSize + blockSize - 1) / blockSize * blockSize;
+		cl_uint nTiles = (cl_uint)((m_N + tileSize - 1) / tileSize);
+		cl_uint tileSizeArg = (cl_uint)tileSize;
+		cl_uint n = (cl_uint)m_N;
+
+		// 1. sum of every tile
+		globalWorkSize[0] = nTiles * LocalWorkSize;
+
+		cl_kernel kernel = m_ReduceTilesKernels[Input];
+		clErr = clSetKernelArg(kernel, 0, sizeof(cl_mem), (void*)&m_dInputs[Input]);
+		clErr |= clSetKernelArg(kernel, 1, sizeof(cl_mem), (void*)&m_dTileSums);
+		clErr |= clSetKernelArg(kernel, 2, sizeof(cl_uint), (void*)&n);
+		clErr |= clSetKernelArg(kernel, 3, sizeof(cl_uint), (void*)&tileSizeArg);
+		clErr |= clSetKernelArg(kernel, 4, LocalWorkSize * sizeof(AccType), NULL);
+		V_RETURN_CL(clErr, "Failed to set Narrow_ReduceTiles arguments");
+
+		clErr = clEnqueueNDRangeKernel(CommandQueue, kernel, 1, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+		V_RETURN_CL(clErr, "Error executing Narrow_ReduceTiles!");
+
+		// 2. scan of the tile sums in a single work-group
+		globalWorkSize[0] = LocalWorkSize;
+
+		kernel = m_ScanTileSumsKernels[Input];
+		clErr = clSetKernelArg(kernel, 0, sizeof(cl_mem), (void*)&m_dTileSums);
+		clErr |= clSetKernelArg(kernel, 1, sizeof(cl_uint), (void*)&nTiles);
+		clErr |= clSetKernelArg(kernel, 2, 4 * LocalWorkSize * sizeof(AccType), NULL);
+		V_RETURN_CL(clErr, "Failed to set Narrow_ScanTileSums arguments");
+
+		clErr = clEnqueueNDRangeKernel(CommandQueue, kernel, 1, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+		V_RETURN_CL(clErr, "Error executing Narrow_ScanTileSums!");
+
+		// 3. scan of every tile with the sum of the preceding tiles
+		globalWorkSize[0] = nTiles * LocalWorkSize;
+
+		kernel = m_ScanTilesKernels[Input];
+		clErr = clSetKernelArg(kernel, 0, sizeof(cl_mem), (void*)&m_dInputs[Input]);
+		clErr |= clSetKernelArg(kernel, 1, sizeof(cl_mem), (void*)&m_dResult);
+		clErr |= clSetKernelArg(kernel, 2, sizeof(cl_mem), (void*)&m_dTileSums);
+		clErr |= clSetKernelArg(kernel, 3, sizeof(cl_uint), (void*)&n);
+		clErr |= clSetKernelArg(kernel, 4, sizeof(cl_uint), (void*)&tileSizeArg);
+		clErr |= clSetKernelArg(kernel, 5, 4 * LocalWorkSize * sizeof(AccType), NULL);
+		V_RETURN_CL(clErr, "Failed to set Narrow_ScanTiles arguments");
+
+		clErr = clEnqueueNDRangeKernel(CommandQueue, kernel, 1, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+		V_RETURN_CL(clErr, "Error executing Narrow_ScanTiles!");
+	}
+
+	cl_mem GetPartials() const { return m_dPartials; }
+	cl_mem GetResult() const { return m_dResult; }
+
+protected:
+
+	// index of the inputs and programs
+	enum
+	{
+		NARROW = 0,
+		WIDE = 1
+	};
+
+	enum
+	{
+		// work-groups of the reduction, the partial sums are combined on the host
+		REDUCTION_GROUPS = 256,
+		// upper bound for the number of tiles of the scan, see CReduceThenScanTask
+		MAX_TILES = 2048
+	};
+
+	//! Program options for the NARROW or the WIDE input
+	static std::string GetCompileOptions(int Input)
+	{
+		return std::string(Input == NARROW ? TIn::CompileOptions() : TIn::WideCompileOptions()) +
+			" -D SCAN_OP=SCAN_OP_ADD -D SCAN_IDENTITY=0";
+	}
+
+	// only useful for debug info
+	static const char* TaskName(unsigned int Task)
+	{
+		static const char* names[4] = { "reduceNarrow", "reduceWide", "scanNarrow", "scanWide" };
+		return names[Task];
+	}
+
+	void Upload(cl_command_queue CommandQueue, int Input)
+	{
+		if (Input == NARROW)
+		{
+			V_RETURN_CL(clEnqueueWriteBuffer(CommandQueue, m_dInputs[NARROW], CL_FALSE, 0, m_N * sizeof(Type), &m_hInput[0], 0, NULL, NULL), "Error copying data from host to device!");
+		}
+		else
+		{
+			V_RETURN_CL(clEnqueueWriteBuffer(CommandQueue, m_dInputs[WIDE], CL_FALSE, 0, m_N * sizeof(AccType), &m_hWideInput[0], 0, NULL, NULL), "Error copying data from host to device!");
+		}
+	}
+
+	void ValidateTask(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task)
+	{
+		int input = Task % 2;
+		m_bValidationResults[Task] = false;
+
+		Upload(CommandQueue, input);
+
+		if (Task < 2)
+		{
+			Reduce(CommandQueue, LocalWorkSize[0], input);
+
+			V_RETURN_CL(clEnqueueReadBuffer(CommandQueue, m_dPartials, CL_TRUE, 0, REDUCTION_GROUPS * sizeof(AccType), &m_hPartials[0], 0, NULL, NULL), "Error reading the partial sums!");
+
+			HostType sum = 0;
+			for (int i = 0; i < REDUCTION_GROUPS; i++)
+				sum += m_hPartials[i];
+			m_bValidationResults[Task] = TIn::Equal((AccType)sum, m_ReductionCPU);
+		}
+		else
+		{
+			Scan(CommandQueue, LocalWorkSize[0], input);
+
+			V_RETURN_CL(clEnqueueReadBuffer(CommandQueue, m_dResult, CL_TRUE, 0, m_N * sizeof(AccType), &m_hScanGPU[0], 0, NULL, NULL), "Error reading data from device!");
+
+			for (size_t i = 0; i < m_N; i++)
+				if (!TIn::Equal(m_hScanGPU[i], m_hScanCPU[i]))
+				{
+					std::cout << "  first mismatch of " << TaskName(Task) << " (" << TIn::Name() << ") at element " << i << std::endl;
+					return;
+				}
+
+			m_bValidationResults[Task] = true;
+		}
+	}
+
+	void TestPerformance(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task)
+	{
+		int input = Task % 2;
+		size_t inputBytes = m_N * (input == NARROW ? sizeof(Type) : sizeof(AccType));
+
+		std::cout << "Testing performance of " << TaskName(Task) << " (" << TIn::Name() << ", " << inputBytes << " bytes of input)" << std::endl;
+
+		Upload(CommandQueue, input);
+		//finish all before we start meassuring the time
+		V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
+
+		CTimer timer;
+		timer.Start();
+
+		//run the kernels N times
+		unsigned int nIterations = 100;
+		for(unsigned int i = 0; i < nIterations; i++) {
+			if (Task < 2)
+				Reduce(CommandQueue, LocalWorkSize[0], input);
+			else
+				Scan(CommandQueue, LocalWorkSize[0], input);
+		}
+
+		//wait until the command queue is empty again
+		V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
+
+		timer.Stop();
+
+		double ms = timer.GetElapsedMilliseconds() / double(nIterations);
+		std::cout << "  average time: " << ms << " ms, throughput: " << 1.0e-6 * (double)m_N / ms << " Gelem/s" << std::endl;
+	}
+
+	//! Upload time of the narrow and the widened input
+	void TestTransfer(cl_command_queue CommandQueue)
+	{
+		const char* names[2] = { "narrow", "widened" };
+		size_t bytes[2] = { m_N * sizeof(Type), m_N * sizeof(AccType) };
+
+		std::cout << "Testing upload of the input (" << TIn::Name() << ")" << std::endl;
+
+		for (int i = 0; i < 2; i++)
+		{
+			V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
+
+			CTimer timer;
+			timer.Start();
+
+			unsigned int nIterations = 10;
+			for(unsigned int j = 0; j < nIterations; j++)
+				Upload(CommandQueue, i);
+
+			V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
+
+			timer.Stop();
+
+			double ms = timer.GetElapsedMilliseconds() / double(nIterations);
+			std::cout << "  " << names[i] << ": " << bytes[i] << " bytes, average time: " << ms << " ms" << std::endl;
+		}
+	}
+
+	size_t					m_N;
+
+	std::vector<Type>		m_hInput;
+	std::vector<AccType>	m_hWideInput;
+
+	std::vector<HostType>	m_hScanCPU;
+	std::vector<AccType>	m_hScanGPU;
+	HostType				m_ReductionCPU;
+	std::vector<AccType>	m_hPartials;
+	bool					m_bValidationResults[4];
+
+	cl_mem					m_dInputs[2];
+	cl_mem					m_dResult;
+	cl_mem					m_dPartials;
+	cl_mem					m_dTileSums;
+
+	//OpenCL programs and kernels, one program per input type
+	cl_program				m_Programs[2];
+	cl_kernel				m_ReduceKernels[2];
+	cl_kernel				m_ReduceTilesKernels[2];
+	cl_kernel				m_ScanTileSumsKernels[2];
+	cl_kernel				m_ScanTilesKernels[2];
+};
+
+#endif // _CNARROW_TASK_H
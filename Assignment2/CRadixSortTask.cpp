@@ -0,0 +1,318 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+
+#include "CRadixSortTask.h"
+
+#include "../Common/CLUtil.h"
+#include "../Common/CProgramBuilder.h"
+#include "../Common/CTimer.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <sstream>
+#include <vector>
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// CRadixSortTask
+
+// Stable CPU sort of the raw key bytes, the values follow their keys
+template<class KeyType>
+static void StableSortCPU(const unsigned char* pKeys, const unsigned int* pValues, unsigned char* pSortedKeys, unsigned int* pSortedValues, size_t N)
+{
+	const KeyType* keys = (const KeyType*)pKeys;
+	KeyType* sortedKeys = (KeyType*)pSortedKeys;
+
+	vector<unsigned int> order(N);
+	for (size_t i = 0; i < N; i++)
+		order[i] = (unsigned int)i;
+
+	stable_sort(order.begin(), order.end(), [keys](unsigned int a, unsigned int b) { return keys[a] < keys[b]; });
+
+	for (size_t i = 0; i < N; i++) {
+		sortedKeys[i] = keys[order[i]];
+		pSortedValues[i] = pValues[order[i]];
+	}
+}
+
+static size_t GetNumBlocks(size_t N, size_t LocalWorkSize)
+{
+	return (N + 2 * LocalWorkSize - 1) / (2 * LocalWorkSize);
+}
+
+CRadixSortTask::CRadixSortTask(size_t ArraySize, size_t MinLocalWorkSize, unsigned int KeyBits, unsigned int RadixBits, bool WithValues)
+	: m_N(ArraySize), m_KeyBits(KeyBits), m_RadixBits(RadixBits), m_bWithValues(WithValues), m_KeySize(KeyBits / 8),
+	m_hKeys(NULL), m_hValues(NULL), m_hKeysCPU(NULL), m_hValuesCPU(NULL), m_hKeysGPU(NULL), m_hValuesGPU(NULL),
+	m_bValidationResult(false),
+	m_dHistograms(NULL),
+	m_MinLocalWorkSize(MinLocalWorkSize), m_HistogramScan(GetNumBlocks(ArraySize, MinLocalWorkSize) << RadixBits, MinLocalWorkSize),
+	m_Program(NULL), m_HistogramKernel(NULL), m_ScatterKernel(NULL)
+{
+	m_dKeys[0] = m_dKeys[1] = NULL;
+	m_dValues[0] = m_dValues[1] = NULL;
+}
+
+CRadixSortTask::~CRadixSortTask()
+{
+	ReleaseResources();
+}
+
+bool CRadixSortTask::InitResources(cl_device_id Device, cl_context Context)
+{
+	if ((m_KeyBits != 32 && m_KeyBits != 64) || (m_RadixBits != 4 && m_RadixBits != 8))
+	{
+		cerr << "Radix sort supports 32 or 64 bit keys and 4 or 8 bit digits." << endl;
+		return false;
+	}
+
+	//CPU resources
+	m_hKeys		 = new unsigned char[m_N * m_KeySize];
+	m_hValues	 = new unsigned int[m_N];
+	m_hKeysCPU	 = new unsigned char[m_N * m_KeySize];
+	m_hValuesCPU = new unsigned int[m_N];
+	m_hKeysGPU	 = new unsigned char[m_N * m_KeySize];
+	m_hValuesGPU = new unsigned int[m_N];
+
+	//random keys, the values are the original positions
+	for(size_t i = 0; i < m_N * m_KeySize; i++)
+		m_hKeys[i] = rand() & 0xff;
+	for(unsigned int i = 0; i < m_N; i++)
+		m_hValues[i] = i;
+
+	//device resources
+	size_t nHistogramEntries = GetNumBlocks(m_N, m_MinLocalWorkSize) << m_RadixBits;
+
+	cl_int clError, clError2;
+	clError = CL_SUCCESS;
+	for (int i = 0; i < 2; i++) {
+		m_dKeys[i] = clCreateBuffer(Context, CL_MEM_READ_WRITE, m_KeySize * m_N, NULL, &clError2);
+		clError |= clError2;
+		if (m_bWithValues) {
+			m_dValues[i] = clCreateBuffer(Context, CL_MEM_READ_WRITE, sizeof(cl_uint) * m_N, NULL, &clError2);
+			clError |= clError2;
+		}
+	}
+	m_dHistograms = clCreateBuffer(Context, CL_MEM_READ_WRITE, sizeof(cl_uint) * nHistogramEntries, NULL, &clError2);
+	clError |= clError2;
+	V_RETURN_FALSE_CL(clError, "Error allocating device arrays");
+
+	return true;
+}
+
+bool CRadixSortTask::InitPrograms(cl_device_id Device, cl_context Context)
+{
+	cl_int clError;
+
+	//load and compile kernels
+	string scanCode, sortCode;
+
+	if (!CLUtil::LoadProgramSourceToMemory("Scan.cl", scanCode) ||
+		!CLUtil::LoadProgramSourceToMemory("RadixSort.cl", sortCode))
+		return false;
+
+	m_Program = CLUtil::BuildCLProgramFromMemory(Device, Context, scanCode + "\n" + sortCode, GetCompileOptions());
+	if(m_Program == nullptr) return false;
+
+	//create kernels
+	m_HistogramKernel = clCreateKernel(m_Program, "RadixSort_Histogram", &clError);
+	V_RETURN_FALSE_CL(clError, "Failed to create kernel: RadixSort_Histogram.");
+
+	m_ScatterKernel = clCreateKernel(m_Program, "RadixSort_Scatter", &clError);
+	V_RETURN_FALSE_CL(clError, "Failed to create kernel: RadixSort_Scatter.");
+
+	if (!m_HistogramScan.InitResources(Context, m_Program))
+		return false;
+
+	return true;
+}
+
+string CRadixSortTask::GetCompileOptions() const
+{
+	stringstream compileOptions;
+	compileOptions << "-D KEY_TYPE=" << (m_KeyBits == 64 ? "ulong" : "uint") << " -D RADIX_BITS=" << m_RadixBits;
+	if (m_bWithValues)
+		compileOptions << " -D WITH_VALUES";
+
+	return compileOptions.str();
+}
+
+void CRadixSortTask::StartProgramBuilds(cl_device_id Device, cl_context Context)
+{
+	string scanCode, sortCode;
+
+	if (CLUtil::LoadProgramSourceToMemory("Scan.cl", scanCode) &&
+		CLUtil::LoadProgramSourceToMemory("RadixSort.cl", sortCode))
+		CProgramBuilder::BuildAsync(Device, Context, scanCode + "\n" + sortCode, GetCompileOptions());
+}
+
+void CRadixSortTask::ReleaseResources()
+{
+	// host resources
+	SAFE_DELETE_ARRAY(m_hKeys);
+	SAFE_DELETE_ARRAY(m_hValues);
+	SAFE_DELETE_ARRAY(m_hKeysCPU);
+	SAFE_DELETE_ARRAY(m_hValuesCPU);
+	SAFE_DELETE_ARRAY(m_hKeysGPU);
+	SAFE_DELETE_ARRAY(m_hValuesGPU);
+
+	// device resources
+	for (int i = 0; i < 2; i++) {
+		SAFE_RELEASE_MEMOBJECT(m_dKeys[i]);
+		SAFE_RELEASE_MEMOBJECT(m_dValues[i]);
+	}
+	SAFE_RELEASE_MEMOBJECT(m_dHistograms);
+
+	m_HistogramScan.ReleaseResources();
+
+	SAFE_RELEASE_KERNEL(m_HistogramKernel);
+	SAFE_RELEASE_KERNEL(m_ScatterKernel);
+
+	SAFE_RELEASE_PROGRAM(m_Program);
+}
+
+void CRadixSortTask::ComputeGPU(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
+{
+	cout << endl;
+
+	ValidateTask(Context, CommandQueue, LocalWorkSize);
+
+	cout << endl;
+
+	TestPerformance(Context, CommandQueue, LocalWorkSize);
+
+	cout << endl;
+}
+
+void CRadixSortTask::ComputeCPU()
+{
+	CTimer timer;
+	timer.Start();
+
+	if (m_KeyBits == 64)
+		StableSortCPU<cl_ulong>(m_hKeys, m_hValues, m_hKeysCPU, m_hValuesCPU, m_N);
+	else
+		StableSortCPU<cl_uint>(m_hKeys, m_hValues, m_hKeysCPU, m_hValuesCPU, m_N);
+
+	timer.Stop();
+	double ms = timer.GetElapsedMilliseconds();
+	cout << "  average time: " << ms << " ms, throughput: " << 1.0e-6 * (double)m_N / ms << " Gelem/s" <<endl;
+}
+
+bool CRadixSortTask::ValidateResults()
+{
+	if (!m_bValidationResult)
+	{
+		cout << "Validation of radix sort (" << m_KeyBits << " bit keys, " << m_RadixBits << " bit digits) failed." << endl;
+	}
+
+	return m_bValidationResult;
+}
+
+void CRadixSortTask::Sort(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
+{
+	cl_int clErr;
+	size_t globalWorkSize[1];
+	size_t localWorkSize[1];
+
+	localWorkSize[0] = LocalWorkSize[0];
+	size_t nBlocks = GetNumBlocks(m_N, localWorkSize[0]);
+	size_t nHistogramEntries = nBlocks << m_RadixBits;
+	globalWorkSize[0] = nBlocks * localWorkSize[0];
+
+	size_t radix = (size_t)1 << m_RadixBits;
+	size_t localValuesSize = m_bWithValues ? 2 * localWorkSize[0] * sizeof(cl_uint) : sizeof(cl_uint);
+
+	for (cl_uint shift = 0; shift < m_KeyBits; shift += m_RadixBits)
+	{
+		// 1. digit histogram of each block
+		clErr = clSetKernelArg(m_HistogramKernel, 0, sizeof(cl_mem), (void*)&m_dKeys[0]);
+		clErr |= clSetKernelArg(m_HistogramKernel, 1, sizeof(cl_mem), (void*)&m_dHistograms);
+		clErr |= clSetKernelArg(m_HistogramKernel, 2, sizeof(cl_uint), (void*)&m_N);
+		clErr |= clSetKernelArg(m_HistogramKernel, 3, sizeof(cl_uint), (void*)&shift);
+		clErr |= clSetKernelArg(m_HistogramKernel, 4, radix * sizeof(cl_uint), NULL);
+		V_RETURN_CL(clErr, "Failed to set RadixSort_Histogram arguments");
+
+		clErr = clEnqueueNDRangeKernel(CommandQueue, m_HistogramKernel, 1, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+		V_RETURN_CL(clErr, "Error executing RadixSort_Histogram!");
+
+		// 2. global offsets of each (digit, block)
+		m_HistogramScan.Scan(CommandQueue, m_dHistograms, nHistogramEntries, localWorkSize[0]);
+
+		// 3. local sort and scatter
+		clErr = clSetKernelArg(m_ScatterKernel, 0, sizeof(cl_mem), (void*)&m_dKeys[0]);
+		clErr |= clSetKernelArg(m_ScatterKernel, 1, sizeof(cl_mem), (void*)&m_dKeys[1]);
+		clErr |= clSetKernelArg(m_ScatterKernel, 2, sizeof(cl_mem), (void*)&m_dValues[0]);
+		clErr |= clSetKernelArg(m_ScatterKernel, 3, sizeof(cl_mem), (void*)&m_dValues[1]);
+		clErr |= clSetKernelArg(m_ScatterKernel, 4, sizeof(cl_mem), (void*)&m_dHistograms);
+		clErr |= clSetKernelArg(m_ScatterKernel, 5, sizeof(cl_uint), (void*)&m_N);
+		clErr |= clSetKernelArg(m_ScatterKernel, 6, sizeof(cl_uint), (void*)&shift);
+		clErr |= clSetKernelArg(m_ScatterKernel, 7, 2 * localWorkSize[0] * m_KeySize, NULL);
+		clErr |= clSetKernelArg(m_ScatterKernel, 8, localValuesSize, NULL);
+		clErr |= clSetKernelArg(m_ScatterKernel, 9, 4 * localWorkSize[0] * sizeof(cl_uint), NULL);
+		clErr |= clSetKernelArg(m_ScatterKernel, 10, radix * sizeof(cl_uint), NULL);
+		V_RETURN_CL(clErr, "Failed to set RadixSort_Scatter arguments");
+
+		clErr = clEnqueueNDRangeKernel(CommandQueue, m_ScatterKernel, 1, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+		V_RETURN_CL(clErr, "Error executing RadixSort_Scatter!");
+
+		swap(m_dKeys[0], m_dKeys[1]);
+		swap(m_dValues[0], m_dValues[1]);
+	}
+}
+
+void CRadixSortTask::ValidateTask(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
+{
+	m_bValidationResult = false;
+
+	V_RETURN_CL(clEnqueueWriteBuffer(CommandQueue, m_dKeys[0], CL_FALSE, 0, m_N * m_KeySize, m_hKeys, 0, NULL, NULL), "Error copying data from host to device!");
+	if (m_bWithValues)
+		V_RETURN_CL(clEnqueueWriteBuffer(CommandQueue, m_dValues[0], CL_FALSE, 0, m_N * sizeof(cl_uint), m_hValues, 0, NULL, NULL), "Error copying data from host to device!");
+
+	Sort(Context, CommandQueue, LocalWorkSize);
+
+	V_RETURN_CL(clEnqueueReadBuffer(CommandQueue, m_dKeys[0], CL_TRUE, 0, m_N * m_KeySize, m_hKeysGPU, 0, NULL, NULL), "Error reading data from device!");
+	m_bValidationResult = (memcmp(m_hKeysCPU, m_hKeysGPU, m_N * m_KeySize) == 0);
+
+	// the values are the original positions, so this also checks the stability
+	if (m_bWithValues)
+	{
+		V_RETURN_CL(clEnqueueReadBuffer(CommandQueue, m_dValues[0], CL_TRUE, 0, m_N * sizeof(cl_uint), m_hValuesGPU, 0, NULL, NULL), "Error reading data from device!");
+		m_bValidationResult = m_bValidationResult && (memcmp(m_hValuesCPU, m_hValuesGPU, m_N * sizeof(cl_uint)) == 0);
+	}
+}
+
+void CRadixSortTask::TestPerformance(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
+{
+	cout << "Testing performance of radix sort (" << m_KeyBits << " bit keys, " << m_RadixBits << " bit digits"
+		<< (m_bWithValues ? ", with values)" : ")") << endl;
+
+	//write input data to the GPU
+	V_RETURN_CL(clEnqueueWriteBuffer(CommandQueue, m_dKeys[0], CL_FALSE, 0, m_N * m_KeySize, m_hKeys, 0, NULL, NULL), "Error copying data from host to device!");
+	if (m_bWithValues)
+		V_RETURN_CL(clEnqueueWriteBuffer(CommandQueue, m_dValues[0], CL_FALSE, 0, m_N * sizeof(cl_uint), m_hValues, 0, NULL, NULL), "Error copying data from host to device!");
+	//finish all before we start meassuring the time
+	V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
+
+	CTimer timer;
+	timer.Start();
+
+	//run the sort N times (sorting already sorted keys costs the same)
+	unsigned int nIterations = 10;
+	for(unsigned int i = 0; i < nIterations; i++) {
+		Sort(Context, CommandQueue, LocalWorkSize);
+	}
+
+	//wait until the command queue is empty again
+	V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
+
+	timer.Stop();
+
+	double ms = timer.GetElapsedMilliseconds() / double(nIterations);
+	cout << "  average time: " << ms << " ms, throughput: " << 1.0e-6 * (double)m_N / ms << " Gelem/s" <<endl;
+}
+
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,99 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CRADIX_SORT_TASK_H
+#define _CRADIX_SORT_TASK_H
+
+#include "../Common/IComputeTask.h"
+
+#include "CScanHierarchy.h"
+
+#include <string>
+
+//! LSD radix sort of 32 or 64 bit keys, optionally with 32 bit values
+/*!
+	Every pass sorts by one digit of RadixBits (4 or 8) bits:
+	the digit histogram of each block is computed, all histograms are scanned with the
+	work-efficient scan and each block is sorted locally and scattered to its offsets.
+	The local sort is stable, so the whole sort is stable, which is validated against std::stable_sort.
+*/
+class CRadixSortTask : public IComputeTask
+{
+public:
+	CRadixSortTask(size_t ArraySize, size_t MinLocalWorkSize, unsigned int KeyBits, unsigned int RadixBits, bool WithValues);
+
+	virtual ~CRadixSortTask();
+
+	// IComputeTask
+	virtual bool InitResources(cl_device_id Device, cl_context Context);
+
+	virtual void StartProgramBuilds(cl_device_id Device, cl_context Context);
+
+	virtual bool InitPrograms(cl_device_id Device, cl_context Context);
+
+	virtual void ReleaseResources();
+
+	virtual void ComputeGPU(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
+
+	virtual void ComputeCPU();
+
+	virtual bool ValidateResults();
+
+protected:
+
+	//! Program options for the key type, radix and payload
+	std::string GetCompileOptions() const;
+
+	//! Sorts m_dKeys[0] (and m_dValues[0]) in place. The number of passes is even, so the result ends up in the same buffers.
+	void Sort(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
+
+	void ValidateTask(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
+	void TestPerformance(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
+
+	unsigned int		m_N;
+	unsigned int		m_KeyBits;
+	unsigned int		m_RadixBits;
+	bool				m_bWithValues;
+	size_t				m_KeySize;
+
+	// keys are stored as raw bytes of m_KeySize each
+	unsigned char		*m_hKeys;
+	unsigned int		*m_hValues;
+
+	unsigned char		*m_hKeysCPU;
+	unsigned int		*m_hValuesCPU;
+	unsigned char		*m_hKeysGPU;
+	unsigned int		*m_hValuesGPU;
+	bool				m_bValidationResult;
+
+	// ping-pong buffers for the passes
+	cl_mem				m_dKeys[2];
+	cl_mem				m_dValues[2];
+	cl_mem				m_dHistograms;
+
+	size_t				m_MinLocalWorkSize;
+	CScanHierarchy		m_HistogramScan;
+
+	//OpenCL program and kernels
+	cl_program			m_Program;
+	cl_kernel			m_HistogramKernel;
+	cl_kernel			m_ScatterKernel;
+};
+
+#endif // _CRADIX_SORT_TASK_H
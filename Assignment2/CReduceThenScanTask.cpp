@@ -0,0 +1,288 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+
+#include "CReduceThenScanTask.h"
+
+#include "../Common/CLUtil.h"
+#include "../Common/CProgramBuilder.h"
+#include "../Common/CTimer.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+using namespace std;
+
+// upper bound for the number of tiles: enough work-groups to fill the device,
+// few enough to scan the tile sums in one work-group
+#define MAX_TILES	2048
+
+///////////////////////////////////////////////////////////////////////////////
+// CReduceThenScanTask
+
+// only useful for debug info
+static const string g_ReduceThenScanNames[2] =
+{
+	"scanHierarchy",
+	"scanReduceThenScan"
+};
+
+CReduceThenScanTask::CReduceThenScanTask(size_t ArraySize, size_t MinLocalWorkSize)
+	: m_N(ArraySize), m_hArray(NULL), m_hResultCPU(NULL), m_hResultGPU(NULL),
+	m_dArray(NULL), m_dTileSums(NULL),
+	m_MinLocalWorkSize(MinLocalWorkSize), m_HierarchyScan(ArraySize, MinLocalWorkSize),
+	m_Program(NULL), m_ReduceTilesKernel(NULL), m_ScanTileSumsKernel(NULL), m_ScanTilesKernel(NULL)
+{
+	// Reset validation results
+	for (int i = 0; i < (int)ARRAYLEN(m_bValidationResults); i++)
+		m_bValidationResults[i] = false;
+}
+
+CReduceThenScanTask::~CReduceThenScanTask()
+{
+	ReleaseResources();
+}
+
+bool CReduceThenScanTask::InitResources(cl_device_id Device, cl_context Context)
+{
+	//CPU resources
+	m_hArray	 = new unsigned int[m_N];
+	m_hResultCPU = new unsigned int[m_N];
+	m_hResultGPU = new unsigned int[m_N];
+
+	//fill the array with some values
+	for(unsigned int i = 0; i < m_N; i++)
+		m_hArray[i] = rand() & 15;
+
+	//device resources
+	cl_int clError, clError2;
+	m_dArray = clCreateBuffer(Context, CL_MEM_READ_WRITE, sizeof(cl_uint) * m_N, NULL, &clError2);
+	clError = clError2;
+	m_dTileSums = clCreateBuffer(Context, CL_MEM_READ_WRITE, sizeof(cl_uint) * MAX_TILES, NULL, &clError2);
+	clError |= clError2;
+	V_RETURN_FALSE_CL(clError, "Error allocating device arrays");
+
+	return true;
+}
+
+bool CReduceThenScanTask::InitPrograms(cl_device_id Device, cl_context Context)
+{
+	cl_int clError;
+
+	//load and compile kernels
+	string programCode;
+
+	if (!CLUtil::LoadProgramSourceToMemory("Scan.cl", programCode))
+		return false;
+	m_Program = CLUtil::BuildCLProgramFromMemory(Device, Context, programCode);
+	if(m_Program == nullptr) return false;
+
+	//create kernels
+	m_ReduceTilesKernel = clCreateKernel(m_Program, "Scan_ReduceTiles", &clError);
+	V_RETURN_FALSE_CL(clError, "Failed to create kernel: Scan_ReduceTiles.");
+
+	m_ScanTileSumsKernel = clCreateKernel(m_Program, "Scan_WorkEfficientRows", &clError);
+	V_RETURN_FALSE_CL(clError, "Failed to create kernel: Scan_WorkEfficientRows.");
+
+	m_ScanTilesKernel = clCreateKernel(m_Program, "Scan_ScanTiles", &clError);
+	V_RETURN_FALSE_CL(clError, "Failed to create kernel: Scan_ScanTiles.");
+
+	if (!m_HierarchyScan.InitResources(Context, m_Program))
+		return false;
+
+	return true;
+}
+
+void CReduceThenScanTask::StartProgramBuilds(cl_device_id Device, cl_context Context)
+{
+	string programCode;
+
+	if (CLUtil::LoadProgramSourceToMemory("Scan.cl", programCode))
+		CProgramBuilder::BuildAsync(Device, Context, programCode);
+}
+
+void CReduceThenScanTask::ReleaseResources()
+{
+	// host resources
+	SAFE_DELETE_ARRAY(m_hArray);
+	SAFE_DELETE_ARRAY(m_hResultCPU);
+	SAFE_DELETE_ARRAY(m_hResultGPU);
+
+	// device resources
+	SAFE_RELEASE_MEMOBJECT(m_dArray);
+	SAFE_RELEASE_MEMOBJECT(m_dTileSums);
+
+	m_HierarchyScan.ReleaseResources();
+
+	SAFE_RELEASE_KERNEL(m_ReduceTilesKernel);
+	SAFE_RELEASE_KERNEL(m_ScanTileSumsKernel);
+	SAFE_RELEASE_KERNEL(m_ScanTilesKernel);
+
+	SAFE_RELEASE_PROGRAM(m_Program);
+}
+
+void CReduceThenScanTask::ComputeGPU(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
+{
+	cout << endl;
+
+	ValidateTask(Context, CommandQueue, LocalWorkSize, 0);
+	ValidateTask(Context, CommandQueue, LocalWorkSize, 1);
+
+	cout << endl;
+
+	TestPerformance(Context, CommandQueue, LocalWorkSize, 0);
+	TestPerformance(Context, CommandQueue, LocalWorkSize, 1);
+
+	cout << endl;
+}
+
+void CReduceThenScanTask::ComputeCPU()
+{
+	CTimer timer;
+	timer.Start();
+
+	unsigned int sum = 0;
+	for(unsigned int i = 0; i < m_N; i++) {
+		sum += m_hArray[i];
+		m_hResultCPU[i] = sum;
+	}
+
+	timer.Stop();
+	double ms = timer.GetElapsedMilliseconds();
+	cout << "  average time: " << ms << " ms, throughput: " << 1.0e-6 * (double)m_N / ms << " Gelem/s" <<endl;
+}
+
+bool CReduceThenScanTask::ValidateResults()
+{
+	bool success = true;
+
+	for(int i = 0; i < (int)ARRAYLEN(m_bValidationResults); i++)
+		if(!m_bValidationResults[i])
+		{
+			cout<<"Validation of scan "<<g_ReduceThenScanNames[i]<<" failed." << endl;
+			success = false;
+		}
+
+	return success;
+}
+
+void CReduceThenScanTask::Scan_Hierarchy(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
+{
+	m_HierarchyScan.Scan(CommandQueue, m_dArray, m_N, LocalWorkSize[0]);
+}
+
+void CReduceThenScanTask::Scan_ReduceThenScan(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
+{
+	cl_int clErr;
+	size_t globalWorkSize[2];
+	size_t localWorkSize[2] = { LocalWorkSize[0], 1 };
+
+	// tiles are multiples of the block size of the local scan
+	size_t blockSize = 2 * localWorkSize[0];
+	size_t tileSize = (m_N + MAX_TILES - 1) / MAX_TILES;
+	tileSize = (tileSize + blockSize - 1) / blockSize * blockSize;
+	cl_uint nTiles = (cl_uint)((m_N + tileSize - 1) / tileSize);
+	cl_uint tileSizeArg = (cl_uint)tileSize;
+	cl_uint firstTile = 0;
+
+	// 1. sum of every tile
+	globalWorkSize[0] = nTiles * localWorkSize[0];
+
+	clErr = clSetKernelArg(m_ReduceTilesKernel, 0, sizeof(cl_mem), (void*)&m_dArray);
+	clErr |= clSetKernelArg(m_ReduceTilesKernel, 1, sizeof(cl_mem), (void*)&m_dTileSums);
+	clErr |= clSetKernelArg(m_ReduceTilesKernel, 2, sizeof(cl_uint), (void*)&m_N);
+	clErr |= clSetKernelArg(m_ReduceTilesKernel, 3, sizeof(cl_uint), (void*)&tileSizeArg);
+	clErr |= clSetKernelArg(m_ReduceTilesKernel, 4, sizeof(cl_uint), (void*)&firstTile);
+	clErr |= clSetKernelArg(m_ReduceTilesKernel, 5, localWorkSize[0] * sizeof(cl_uint), NULL);
+	V_RETURN_CL(clErr, "Failed to set Scan_ReduceTiles arguments");
+
+	clErr = clEnqueueNDRangeKernel(CommandQueue, m_ReduceTilesKernel, 1, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+	V_RETURN_CL(clErr, "Error executing Scan_ReduceTiles!");
+
+	// 2. scan of the tile sums in a single work-group
+	globalWorkSize[0] = localWorkSize[0];
+	globalWorkSize[1] = 1;
+
+	clErr = clSetKernelArg(m_ScanTileSumsKernel, 0, sizeof(cl_mem), (void*)&m_dTileSums);
+	clErr |= clSetKernelArg(m_ScanTileSumsKernel, 1, sizeof(cl_mem), (void*)&m_dTileSums);
+	clErr |= clSetKernelArg(m_ScanTileSumsKernel, 2, sizeof(cl_uint), (void*)&nTiles);
+	clErr |= clSetKernelArg(m_ScanTileSumsKernel, 3, 4 * localWorkSize[0] * sizeof(cl_uint), NULL);
+	V_RETURN_CL(clErr, "Failed to set Scan_WorkEfficientRows arguments");
+
+	clErr = clEnqueueNDRangeKernel(CommandQueue, m_ScanTileSumsKernel, 2, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+	V_RETURN_CL(clErr, "Error executing Scan_WorkEfficientRows!");
+
+	// 3. scan of every tile with the sum of the preceding tiles
+	globalWorkSize[0] = nTiles * localWorkSize[0];
+
+	clErr = clSetKernelArg(m_ScanTilesKernel, 0, sizeof(cl_mem), (void*)&m_dArray);
+	clErr |= clSetKernelArg(m_ScanTilesKernel, 1, sizeof(cl_mem), (void*)&m_dArray);
+	clErr |= clSetKernelArg(m_ScanTilesKernel, 2, sizeof(cl_mem), (void*)&m_dTileSums);
+	clErr |= clSetKernelArg(m_ScanTilesKernel, 3, sizeof(cl_uint), (void*)&m_N);
+	clErr |= clSetKernelArg(m_ScanTilesKernel, 4, sizeof(cl_uint), (void*)&tileSizeArg);
+	clErr |= clSetKernelArg(m_ScanTilesKernel, 5, sizeof(cl_uint), (void*)&firstTile);
+	clErr |= clSetKernelArg(m_ScanTilesKernel, 6, 4 * localWorkSize[0] * sizeof(cl_uint), NULL);
+	V_RETURN_CL(clErr, "Failed to set Scan_ScanTiles arguments");
+
+	clErr = clEnqueueNDRangeKernel(CommandQueue, m_ScanTilesKernel, 1, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+	V_RETURN_CL(clErr, "Error executing Scan_ScanTiles!");
+}
+
+void CReduceThenScanTask::ValidateTask(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task)
+{
+	V_RETURN_CL(clEnqueueWriteBuffer(CommandQueue, m_dArray, CL_FALSE, 0, m_N * sizeof(cl_uint), m_hArray, 0, NULL, NULL), "Error copying data from host to device!");
+
+	//run selected task
+	switch (Task){
+		case 0:
+			Scan_Hierarchy(Context, CommandQueue, LocalWorkSize);
+			break;
+		case 1:
+			Scan_ReduceThenScan(Context, CommandQueue, LocalWorkSize);
+			break;
+	}
+
+	V_RETURN_CL(clEnqueueReadBuffer(CommandQueue, m_dArray, CL_TRUE, 0, m_N * sizeof(cl_uint), m_hResultGPU, 0, NULL, NULL), "Error reading data from device!");
+
+	// validate results
+	m_bValidationResults[Task] = (memcmp(m_hResultCPU, m_hResultGPU, m_N * sizeof(unsigned int)) == 0);
+}
+
+void CReduceThenScanTask::TestPerformance(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task)
+{
+	cout << "Testing performance of " << g_ReduceThenScanNames[Task] << " (" << m_N << " elements)" << endl;
+
+	//write input data to the GPU
+	V_RETURN_CL(clEnqueueWriteBuffer(CommandQueue, m_dArray, CL_FALSE, 0, m_N * sizeof(cl_uint), m_hArray, 0, NULL, NULL), "Error copying data from host to device!");
+	//finish all before we start meassuring the time
+	V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
+
+	CTimer timer;
+	timer.Start();
+
+	//run the scan N times, fewer iterations as the arrays are very large
+	unsigned int nIterations = 20;
+	for(unsigned int i = 0; i < nIterations; i++) {
+		//run selected task
+		switch (Task){
+			case 0:
+				Scan_Hierarchy(Context, CommandQueue, LocalWorkSize);
+				break;
+			case 1:
+				Scan_ReduceThenScan(Context, CommandQueue, LocalWorkSize);
+				break;
+		}
+	}
+
+	//wait until the command queue is empty again
+	V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
+
+	timer.Stop();
+
+	double ms = timer.GetElapsedMilliseconds() / double(nIterations);
+	cout << "  average time: " << ms << " ms, throughput: " << 1.0e-6 * (double)m_N / ms << " Gelem/s" <<endl;
+}
+
+///////////////////////////////////////////////////////////////////////////////
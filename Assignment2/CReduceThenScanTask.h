@@ -0,0 +1,88 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CREDUCE_THEN_SCAN_TASK_H
+#define _CREDUCE_THEN_SCAN_TASK_H
+
+#include "../Common/IComputeTask.h"
+
+#include "CScanHierarchy.h"
+
+//! Reduce-then-scan prefix sum compared with the multi-level work-efficient scan
+/*!
+	The array is split into at most MaxTiles tiles, one work-group per tile:
+	- Scan_ReduceTiles computes the sum of every tile
+	- Scan_WorkEfficientRows scans the tile sums in one work-group
+	- Scan_ScanTiles scans every tile in place, starting with the sum of the preceding tiles
+	Three launches and about 2N reads + N writes for any N, and only the tile sums as extra memory,
+	while CScanHierarchy needs two launches and one block-sum array per level.
+*/
+class CReduceThenScanTask : public IComputeTask
+{
+public:
+	CReduceThenScanTask(size_t ArraySize, size_t MinLocalWorkSize);
+
+	virtual ~CReduceThenScanTask();
+
+	// IComputeTask
+	virtual bool InitResources(cl_device_id Device, cl_context Context);
+
+	virtual void StartProgramBuilds(cl_device_id Device, cl_context Context);
+
+	virtual bool InitPrograms(cl_device_id Device, cl_context Context);
+
+	virtual void ReleaseResources();
+
+	virtual void ComputeGPU(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
+
+	virtual void ComputeCPU();
+
+	virtual bool ValidateResults();
+
+protected:
+
+	//! Both variants scan m_dArray in place
+	void Scan_Hierarchy(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
+	void Scan_ReduceThenScan(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
+
+	void ValidateTask(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task);
+	void TestPerformance(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task);
+
+	unsigned int		m_N;
+
+	unsigned int		*m_hArray;
+
+	unsigned int		*m_hResultCPU;
+	unsigned int		*m_hResultGPU;
+	bool				m_bValidationResults[2];
+
+	cl_mem				m_dArray;
+	cl_mem				m_dTileSums;
+
+	size_t				m_MinLocalWorkSize;
+	CScanHierarchy		m_HierarchyScan;
+
+	//OpenCL program and kernels
+	cl_program			m_Program;
+	cl_kernel			m_ReduceTilesKernel;
+	cl_kernel			m_ScanTileSumsKernel;
+	cl_kernel			m_ScanTilesKernel;
+};
+
+#endif // _CREDUCE_THEN_SCAN_TASK_H
@@ -6,27 +6,33 @@ GPU Computing / GPGPU Praktikum source code.
 #include "CReductionTask.h"
 
 #include "../Common/CLUtil.h"
+#include "../Common/CProgramBuilder.h"
 #include "../Common/CTimer.h"
+#include "../Common/CAutoTuner.h"
 
 using namespace std;
 
 ///////////////////////////////////////////////////////////////////////////////
 // CReductionTask
 
-string g_kernelNames[5] = {
+string g_kernelNames[6] = {
 	"interleavedAddressing",
 	"sequentialAddressing",
 	"kernelDecomposition",
 	"kernelDecompositionUnroll",
-	"kernelDecompositionAtomics"
+	"kernelDecompositionAtomics",
+	"kernelDecompositionTuned"
 };
 
-CReductionTask::CReductionTask(size_t ArraySize)
+CReductionTask::CReductionTask(size_t ArraySize, size_t MinLocalWorkSize)
 	: m_N(ArraySize), m_hInput(NULL), 
+	m_MinLocalWorkSize(MinLocalWorkSize),
+	m_dInputArray(NULL),
 	m_dPingArray(NULL),
 	m_dPongArray(NULL),
 	m_Program(NULL), 
-	m_InterleavedAddressingKernel(NULL), m_SequentialAddressingKernel(NULL), m_DecompKernel(NULL), m_DecompUnrollKernel(NULL), m_DecompAtomicsKernel(NULL)
+	m_InterleavedAddressingKernel(NULL), m_SequentialAddressingKernel(NULL), m_DecompKernel(NULL), m_DecompAtomicsKernel(NULL),
+	m_Device(NULL), m_bTuned(false), m_TunedProgram(NULL), m_TunedKernel(NULL)
 {
 }
 
@@ -38,7 +44,8 @@ CReductionTask::~CReductionTask()
 bool CReductionTask::InitResources(cl_device_id Device, cl_context Context)
 {
 	//CPU resources
-	m_hInput = new unsigned int[m_N];
+	m_PinnedInput.Allocate(Device, Context, m_N * sizeof(cl_uint));
+	m_hInput = (unsigned int*)m_PinnedInput.GetPointer();
 
 	//fill the array with some values
 	for(unsigned int i = 0; i < m_N; i++) 
@@ -46,12 +53,33 @@ bool CReductionTask::InitResources(cl_device_id Device, cl_context Context)
 		//m_hInput[i] = rand() & 15;
 
 	//device resources
-	cl_int clError, clError2;
-	m_dPingArray = clCreateBuffer(Context, CL_MEM_READ_WRITE, sizeof(cl_uint) * m_N, NULL, &clError2);
-	clError = clError2;
-	m_dPongArray = clCreateBuffer(Context, CL_MEM_READ_WRITE, sizeof(cl_uint) * m_N, NULL, &clError2);
-	clError |= clError2;
-	V_RETURN_FALSE_CL(clError, "Error allocating device arrays");
+	// one arena allocation: the input and the partial sums of the first pass (one per work-group)
+	CTimer timer;
+	timer.Start();
+
+	size_t nPartials = (m_N + 2 * m_MinLocalWorkSize - 1) / (2 * m_MinLocalWorkSize);
+
+	m_Arena.Init(Device);
+	unsigned int inputRegion = m_Arena.Reserve(sizeof(cl_uint) * m_N);
+	unsigned int partialsRegion = m_Arena.Reserve(sizeof(cl_uint) * nPartials);
+	if (!m_Arena.Allocate(Context))
+		return false;
+
+	m_dInputArray = m_Arena.CreateSubBuffer(inputRegion);
+	m_dPongArray = m_Arena.CreateSubBuffer(partialsRegion);
+	if (m_dInputArray == NULL || m_dPongArray == NULL)
+		return false;
+	m_dPingArray = m_dInputArray;
+
+	timer.Stop();
+	m_Arena.PrintStatistics(2 * sizeof(cl_uint) * m_N, timer.GetElapsedMilliseconds());
+
+	return true;
+}
+
+bool CReductionTask::InitPrograms(cl_device_id Device, cl_context Context)
+{
+	cl_int clError;
 
 	//load and compile kernels
 	string programCode;
@@ -70,46 +98,130 @@ bool CReductionTask::InitResources(cl_device_id Device, cl_context Context)
 	m_DecompKernel = clCreateKernel(m_Program, "Reduction_Decomp", &clError);
 	V_RETURN_FALSE_CL(clError, "Failed to create kernel: Reduction_Decomp.");
 
-	m_DecompUnrollKernel = clCreateKernel(m_Program, "Reduction_DecompUnroll", &clError);
-	V_RETURN_FALSE_CL(clError, "Failed to create kernel: Reduction_DecompUnroll.");
+	// Reduction_DecompUnroll is specialized per work-group size: MinLocalWorkSize now, the other sizes when they first run
+	m_Device = Device;
+	if (GetDecompUnrollKernel(Context, m_MinLocalWorkSize) == NULL)
+		return false;
 
 	m_DecompAtomicsKernel = clCreateKernel(m_Program, "Reduction_DecompAtomics", &clError);
 	V_RETURN_FALSE_CL(clError, "Failed to create kernel: Reduction_DecompAtomics.");
 
+	//launch configuration of the tuned decomposition, 2 elements per work-item like Reduction_Decomp until it is tuned.
+	//the key does not include MinLocalWorkSize, so an entry can have too many work-groups for m_dPongArray
+	m_bTuned = CTuningDatabase::Lookup("Reduction_Tuned", Device, m_N, m_TunedConfig) && FitsPartialSums(m_TunedConfig);
+	if (!m_bTuned)
+		m_TunedConfig = STuningConfig(m_MinLocalWorkSize, 2, 1, 1);
+
+	if (!BuildTunedKernel(Context, m_TunedConfig))
+		return false;
+
 	return true;
 }
 
+cl_kernel CReductionTask::GetDecompUnrollKernel(cl_context Context, size_t LocalWorkSize)
+{
+	map<size_t, cl_kernel>::iterator it = m_DecompUnrollKernels.find(LocalWorkSize);
+	if (it != m_DecompUnrollKernels.end())
+		return it->second;
+
+	CLUtil::TSpecialization specialization;
+	specialization["WORK_GROUP_SIZE"] = to_string(LocalWorkSize);
+
+	cl_program program = CLUtil::BuildSpecializedProgram(m_Device, Context, "Reduction.cl", specialization);
+	if (program == nullptr) return NULL;
+
+	// the kernel keeps its program alive
+	cl_int clError;
+	cl_kernel kernel = clCreateKernel(program, "Reduction_DecompUnroll", &clError);
+	clReleaseProgram(program);
+	V_RETURN_0_CL(clError, "Failed to create kernel: Reduction_DecompUnroll.");
+
+	m_DecompUnrollKernels[LocalWorkSize] = kernel;
+	return kernel;
+}
+
+bool CReductionTask::BuildTunedKernel(cl_context Context, const STuningConfig& Config)
+{
+	SAFE_RELEASE_KERNEL(m_TunedKernel);
+	SAFE_RELEASE_PROGRAM(m_TunedProgram);
+
+	string programCode;
+
+	if (!CLUtil::LoadProgramSourceToMemory("Reduction.cl", programCode))
+		return false;
+	m_TunedProgram = CLUtil::BuildCLProgramFromMemory(m_Device, Context, programCode, Config.GetCompileOptions());
+	if(m_TunedProgram == nullptr) return false;
+
+	cl_int clError;
+	m_TunedKernel = clCreateKernel(m_TunedProgram, "Reduction_Tuned", &clError);
+	V_RETURN_FALSE_CL(clError, "Failed to create kernel: Reduction_Tuned.");
+
+	return true;
+}
+
+void CReductionTask::StartProgramBuilds(cl_device_id Device, cl_context Context)
+{
+	string programCode;
+
+	if (!CLUtil::LoadProgramSourceToMemory("Reduction.cl", programCode))
+		return;
+
+	CProgramBuilder::BuildAsync(Device, Context, programCode);
+
+	CLUtil::TSpecialization specialization;
+	specialization["WORK_GROUP_SIZE"] = to_string(m_MinLocalWorkSize);
+	CProgramBuilder::BuildAsync(Device, Context, programCode, CLUtil::GetSpecializationOptions(specialization));
+
+	STuningConfig tunedConfig;
+	if (CTuningDatabase::Lookup("Reduction_Tuned", Device, m_N, tunedConfig) && FitsPartialSums(tunedConfig))
+		CProgramBuilder::BuildAsync(Device, Context, programCode, tunedConfig.GetCompileOptions());
+}
+
 void CReductionTask::ReleaseResources()
 {
 	// host resources
-	SAFE_DELETE_ARRAY(m_hInput);
+	m_PinnedInput.Release();
+	m_hInput = NULL;
 
 	// device resources
 	SAFE_RELEASE_MEMOBJECT(m_dPingArray);
 	SAFE_RELEASE_MEMOBJECT(m_dPongArray);
+	m_dInputArray = NULL;
+	m_Arena.Release();
 
 	SAFE_RELEASE_KERNEL(m_InterleavedAddressingKernel);
 	SAFE_RELEASE_KERNEL(m_SequentialAddressingKernel);
 	SAFE_RELEASE_KERNEL(m_DecompKernel);
-	SAFE_RELEASE_KERNEL(m_DecompUnrollKernel);
+	for (map<size_t, cl_kernel>::iterator it = m_DecompUnrollKernels.begin(); it != m_DecompUnrollKernels.end(); ++it)
+		clReleaseKernel(it->second);
+	m_DecompUnrollKernels.clear();
 	SAFE_RELEASE_KERNEL(m_DecompAtomicsKernel);
+	SAFE_RELEASE_KERNEL(m_TunedKernel);
 
 	SAFE_RELEASE_PROGRAM(m_Program);
+	SAFE_RELEASE_PROGRAM(m_TunedProgram);
 }
 
 void CReductionTask::ComputeGPU(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
 {
+	// the tuned decomposition ignores LocalWorkSize, it is tuned here if the tuning database has no entry for the device
+	if (!m_bTuned && CTuningDatabase::IsEnabled())
+		Tune(Context, CommandQueue);
+	cout << "Tuned decomposition: " << m_TunedConfig.ToString() << (m_bTuned ? "" : " (not tuned)") << endl;
+
 	ExecuteTask(Context, CommandQueue, LocalWorkSize, 0);
 	ExecuteTask(Context, CommandQueue, LocalWorkSize, 1);
 	ExecuteTask(Context, CommandQueue, LocalWorkSize, 2);
 	ExecuteTask(Context, CommandQueue, LocalWorkSize, 3);
 	ExecuteTask(Context, CommandQueue, LocalWorkSize, 4);
+	ExecuteTask(Context, CommandQueue, LocalWorkSize, 5);
 
 	TestPerformance(Context, CommandQueue, LocalWorkSize, 0);
 	TestPerformance(Context, CommandQueue, LocalWorkSize, 1);
 	TestPerformance(Context, CommandQueue, LocalWorkSize, 2);
 	TestPerformance(Context, CommandQueue, LocalWorkSize, 3);
 	TestPerformance(Context, CommandQueue, LocalWorkSize, 4);
+	TestPerformance(Context, CommandQueue, LocalWorkSize, 5);
 
 }
 
@@ -144,7 +256,7 @@ bool CReductionTask::ValidateResults()
 	cout << "Decomp Unroll GPU=" << m_resultGPU[3] << endl;
 	cout << "Decomp Atomics GPU=" << m_resultGPU[4] << endl;*/
 
-	for(int i = 0; i < 5; i++)
+	for(int i = 0; i < (int)ARRAYLEN(m_resultGPU); i++)
 		if(m_resultGPU[i] != m_resultCPU)
 		{
 			cout<<"Validation of reduction kernel "<<g_kernelNames[i]<<" failed." << endl;
@@ -161,11 +273,12 @@ void CReductionTask::Reduction_InterleavedAddressing(cl_context Context, cl_comm
 	size_t globalWorkSize[1];
 	size_t localWorkSize[1];
 	unsigned int stride = 1;
+	int level = 0;
 
 	globalWorkSize[0] = CLUtil::GetGlobalWorkSize(m_N/2, LocalWorkSize[0]);
 	localWorkSize[0] = LocalWorkSize[0];
 
-	for (stride = 1; stride < m_N; stride *=2)
+	for (stride = 1; stride < m_N; stride *=2, level++)
 	{
 		//binding arguments
 		clErr = clSetKernelArg(m_InterleavedAddressingKernel, 0, sizeof(cl_mem), (void*)&m_dPingArray);
@@ -173,7 +286,7 @@ void CReductionTask::Reduction_InterleavedAddressing(cl_context Context, cl_comm
 		clErr = clSetKernelArg(m_InterleavedAddressingKernel, 1, sizeof(cl_int), (void*)&stride);
 		V_RETURN_CL(clErr, "Failed to set kernel stride argument");
 
-		clErr = clEnqueueNDRangeKernel(CommandQueue, m_InterleavedAddressingKernel, 1, NULL, &globalWorkSize[0], localWorkSize, 0, NULL, NULL);
+		clErr = clEnqueueNDRangeKernel(CommandQueue, m_InterleavedAddressingKernel, 1, NULL, &globalWorkSize[0], localWorkSize, 0, NULL, m_Profiler.Event("Reduction_InterleavedAddressing", level));
 		V_RETURN_CL(clErr, "Error Executing Kernel!");
 
 		globalWorkSize[0] = CLUtil::GetGlobalWorkSize(globalWorkSize[0]/2, localWorkSize[0]); //actualize global size
@@ -192,11 +305,12 @@ void CReductionTask::Reduction_SequentialAddressing(cl_context Context, cl_comma
 	size_t globalWorkSize[1];
 	size_t localWorkSize[1];
 	unsigned int stride;
+	int level = 0;
 
 	globalWorkSize[0] = CLUtil::GetGlobalWorkSize(m_N/2, LocalWorkSize[0]);
 	localWorkSize[0] = LocalWorkSize[0];
 
-	for (stride = 1; stride < m_N; stride *= 2)
+	for (stride = 1; stride < m_N; stride *= 2, level++)
 	{
 		//binding arguments
 		clErr = clSetKernelArg(m_SequentialAddressingKernel, 0, sizeof(cl_mem), (void*)&m_dPingArray);
@@ -204,7 +318,7 @@ void CReductionTask::Reduction_SequentialAddressing(cl_context Context, cl_comma
 		clErr = clSetKernelArg(m_SequentialAddressingKernel, 1, sizeof(cl_int), (void*)&stride);
 		V_RETURN_CL(clErr, "Failed to set kernel stride argument");
 
-		clErr = clEnqueueNDRangeKernel(CommandQueue, m_SequentialAddressingKernel, 1, NULL, &globalWorkSize[0], localWorkSize, 0, NULL, NULL);
+		clErr = clEnqueueNDRangeKernel(CommandQueue, m_SequentialAddressingKernel, 1, NULL, &globalWorkSize[0], localWorkSize, 0, NULL, m_Profiler.Event("Reduction_SequentialAddressing", level));
 		V_RETURN_CL(clErr, "Error Executing Kernel!");
 
 		if (localWorkSize[0] != 1 && localWorkSize[0] == globalWorkSize[0])
@@ -251,7 +365,7 @@ void CReductionTask::Reduction_Decomp(cl_context Context, cl_command_queue Comma
 		V_RETURN_CL(clErr, "Error allocating shared memory");
 
 		//launching kernel
-		clErr = clEnqueueNDRangeKernel(CommandQueue, m_DecompKernel, 1, NULL, &globalWorkSize[0], localWorkSize, 0, NULL, NULL);
+		clErr = clEnqueueNDRangeKernel(CommandQueue, m_DecompKernel, 1, NULL, &globalWorkSize[0], localWorkSize, 0, NULL, m_Profiler.Event("Reduction_Decomp", i));
 		V_RETURN_CL(clErr, "Error Executing Kernel!");
 
 		if (localWorkSize[0] >= nGroups[0] && nGroups[0] > 1)
@@ -289,18 +403,22 @@ void CReductionTask::Reduction_DecompUnroll(cl_context Context, cl_command_queue
 
 		nGroups[0] = globalWorkSize[0] / localWorkSize[0]; //actualize number of work groups
 
+		cl_kernel decompUnrollKernel = GetDecompUnrollKernel(Context, localWorkSize[0]);
+		if (decompUnrollKernel == NULL)
+			return;
+
 		//binding arguments
-		clErr = clSetKernelArg(m_DecompUnrollKernel, 0, sizeof(cl_mem), (void*)&m_dPingArray);
+		clErr = clSetKernelArg(decompUnrollKernel, 0, sizeof(cl_mem), (void*)&m_dPingArray);
 		V_RETURN_CL(clErr, "Failed to set kernel input array argument");
-		clErr = clSetKernelArg(m_DecompUnrollKernel, 1, sizeof(cl_mem), (void*)&m_dPongArray);
+		clErr = clSetKernelArg(decompUnrollKernel, 1, sizeof(cl_mem), (void*)&m_dPongArray);
 		V_RETURN_CL(clErr, "Failed to set kernel output array argument");
-		clErr = clSetKernelArg(m_DecompUnrollKernel, 2, sizeof(cl_int), (void*)&m_N);
+		clErr = clSetKernelArg(decompUnrollKernel, 2, sizeof(cl_int), (void*)&m_N);
 		V_RETURN_CL(clErr, "Failed to set kernel array size argument");
-		clErr = clSetKernelArg(m_DecompUnrollKernel, 3, localWorkSize[0] * sizeof(cl_int), NULL);
+		clErr = clSetKernelArg(decompUnrollKernel, 3, localWorkSize[0] * sizeof(cl_int), NULL);
 		V_RETURN_CL(clErr, "Error allocating shared memory");
 
 		//launching kernel
-		clErr = clEnqueueNDRangeKernel(CommandQueue, m_DecompUnrollKernel, 1, NULL, &globalWorkSize[0], localWorkSize, 0, NULL, NULL);
+		clErr = clEnqueueNDRangeKernel(CommandQueue, decompUnrollKernel, 1, NULL, &globalWorkSize[0], localWorkSize, 0, NULL, m_Profiler.Event("Reduction_DecompUnroll", i));
 		V_RETURN_CL(clErr, "Error Executing Kernel!");
 
 		if (localWorkSize[0] >= nGroups[0] && nGroups[0] > 1)
@@ -351,7 +469,7 @@ void CReductionTask::Reduction_DecompAtomics(cl_context Context, cl_command_queu
 		V_RETURN_CL(clErr, "Error allocating shared memory");
 
 		//launching kernel
-		clErr = clEnqueueNDRangeKernel(CommandQueue, m_DecompAtomicsKernel, 1, NULL, &globalWorkSize[0], localWorkSize, 0, NULL, NULL);
+		clErr = clEnqueueNDRangeKernel(CommandQueue, m_DecompAtomicsKernel, 1, NULL, &globalWorkSize[0], localWorkSize, 0, NULL, m_Profiler.Event("Reduction_DecompAtomics", i));
 		V_RETURN_CL(clErr, "Error Executing Kernel!");
 
 		if (localWorkSize[0] >= nGroups[0] && nGroups[0] > 1)
@@ -365,12 +483,90 @@ void CReductionTask::Reduction_DecompAtomics(cl_context Context, cl_command_queu
 	}
 }
 
-void CReductionTask::ExecuteTask(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task)
+void CReductionTask::Reduction_Tuned(cl_context Context, cl_command_queue CommandQueue, const STuningConfig& Config)
 {
-	//write input data to the GPU
-	V_RETURN_CL(clEnqueueWriteBuffer(CommandQueue, m_dPingArray, CL_FALSE, 0, m_N * sizeof(cl_uint), m_hInput, 0, NULL, NULL), "Error copying data from host to device!");
+	cl_int clErr;
+	size_t localWorkSize = Config.LocalWorkSize;
+	size_t elementsPerGroup = localWorkSize * Config.ElementsPerThread * Config.VectorWidth;
 
-	//run selected task
+	// every pass leaves one partial sum per work-group, until a single one is left in m_dPingArray
+	size_t n = m_N;
+	for (int i = 0; n > 1; i++)
+	{
+		size_t nGroups = (n + elementsPerGroup - 1) / elementsPerGroup;
+		size_t globalWorkSize = nGroups * localWorkSize;
+		cl_uint N = (cl_uint)n;
+
+		//binding arguments
+		clErr = clSetKernelArg(m_TunedKernel, 0, sizeof(cl_mem), (void*)&m_dPingArray);
+		V_RETURN_CL(clErr, "Failed to set kernel input array argument");
+		clErr = clSetKernelArg(m_TunedKernel, 1, sizeof(cl_mem), (void*)&m_dPongArray);
+		V_RETURN_CL(clErr, "Failed to set kernel output array argument");
+		clErr = clSetKernelArg(m_TunedKernel, 2, sizeof(cl_uint), (void*)&N);
+		V_RETURN_CL(clErr, "Failed to set kernel array size argument");
+		clErr = clSetKernelArg(m_TunedKernel, 3, localWorkSize * sizeof(cl_uint), NULL);
+		V_RETURN_CL(clErr, "Error allocating shared memory");
+
+		clErr = clEnqueueNDRangeKernel(CommandQueue, m_TunedKernel, 1, NULL, &globalWorkSize, &localWorkSize, 0, NULL, m_Profiler.Event("Reduction_Tuned", i));
+		V_RETURN_CL(clErr, "Error Executing Kernel!");
+
+		swap(m_dPingArray, m_dPongArray);
+		n = nGroups;
+	}
+}
+
+bool CReductionTask::FitsPartialSums(const STuningConfig& Config) const
+{
+	// m_dPongArray holds one partial sum per 2 * m_MinLocalWorkSize inputs
+	return Config.LocalWorkSize * Config.ElementsPerThread * Config.VectorWidth >= 2 * m_MinLocalWorkSize;
+}
+
+void CReductionTask::Tune(cl_context Context, cl_command_queue CommandQueue)
+{
+	CAutoTuner tuner(m_Device);
+
+	STuningConfig best;
+	bool bFound = tuner.Tune("Reduction_Tuned", m_N,
+		[&](const STuningConfig& Config) -> cl_kernel {
+			return BuildTunedKernel(Context, Config) ? m_TunedKernel : NULL;
+		},
+		[&](const STuningConfig& Config) -> bool {
+			if (!FitsPartialSums(Config))
+				return false;
+
+			ResetPingPong();
+			V_RETURN_FALSE_CL(clEnqueueWriteBuffer(CommandQueue, m_dPingArray, CL_FALSE, 0, m_N * sizeof(cl_uint), m_hInput, 0, NULL, NULL), "Error copying data from host to device!");
+			Reduction_Tuned(Context, CommandQueue, Config);
+
+			cl_uint result = 0;
+			V_RETURN_FALSE_CL(clEnqueueReadBuffer(CommandQueue, m_dPingArray, CL_TRUE, 0, sizeof(cl_uint), &result, 0, NULL, NULL), "Error reading data from device!");
+			return result == m_resultCPU;
+		},
+		[&](const STuningConfig& Config) {
+			ResetPingPong();
+			Reduction_Tuned(Context, CommandQueue, Config);
+			V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
+		},
+		best);
+
+	if (bFound)
+	{
+		m_TunedConfig = best;
+		m_bTuned = true;
+	}
+
+	// the search leaves the kernel of its last configuration behind
+	BuildTunedKernel(Context, m_TunedConfig);
+}
+
+void CReductionTask::ResetPingPong()
+{
+	if (m_dPingArray != m_dInputArray)
+		swap(m_dPingArray, m_dPongArray);
+}
+
+void CReductionTask::RunTask(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task)
+{
 	switch (Task){
 		case 0:
 			Reduction_InterleavedAddressing(Context, CommandQueue, LocalWorkSize);
@@ -387,56 +583,77 @@ void CReductionTask::ExecuteTask(cl_context Context, cl_command_queue CommandQue
 		case 4:
 			Reduction_DecompAtomics(Context, CommandQueue, LocalWorkSize);
 			break;
-
+		case 5:
+			Reduction_Tuned(Context, CommandQueue, m_TunedConfig);
+			break;
 	}
+}
+
+void CReductionTask::ExecuteTask(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task)
+{
+	ResetPingPong();
+
+	//write input data to the GPU
+	V_RETURN_CL(clEnqueueWriteBuffer(CommandQueue, m_dPingArray, CL_FALSE, 0, m_N * sizeof(cl_uint), m_hInput, 0, NULL, NULL), "Error copying data from host to device!");
+
+	//run selected task
+	RunTask(Context, CommandQueue, LocalWorkSize, Task);
 
 	//read back the results synchronously.
 	m_resultGPU[Task] = 0;
 	V_RETURN_CL(clEnqueueReadBuffer(CommandQueue, m_dPingArray, CL_TRUE, 0, 1 * sizeof(cl_uint), &m_resultGPU[Task], 0, NULL, NULL), "Error reading data from device!");
 }
 
+const char* CReductionTask::GetVariantName(unsigned int Task)
+{
+	return g_kernelNames[Task].c_str();
+}
+
+bool CReductionTask::SupportsSize(size_t LocalWorkSize) const
+{
+	return (m_N & (m_N - 1)) == 0 && m_N >= 4 * LocalWorkSize && LocalWorkSize >= m_MinLocalWorkSize;
+}
+
+bool CReductionTask::ValidateVariant(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task)
+{
+	ExecuteTask(Context, CommandQueue, LocalWorkSize, Task);
+	return m_resultGPU[Task] == m_resultCPU;
+}
+
+CBenchmark::SResult CReductionTask::BenchmarkVariant(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task, CBenchmark& Benchmark)
+{
+	return Benchmark.Run([&]() {
+		ResetPingPong();
+		RunTask(Context, CommandQueue, LocalWorkSize, Task);
+		V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
+	});
+}
+
 void CReductionTask::TestPerformance(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task)
 {
 	cout << "Testing performance of task " << g_kernelNames[Task] << endl;
 
+	ResetPingPong();
+
 	//write input data to the GPU
 	V_RETURN_CL(clEnqueueWriteBuffer(CommandQueue, m_dPingArray, CL_FALSE, 0, m_N * sizeof(cl_uint), m_hInput, 0, NULL, NULL), "Error copying data from host to device!");
 	//finish all before we start meassuring the time
 	V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
 
-	CTimer timer;
-	timer.Start();
+	//run the task until the timing is stable, every iteration waits for the device
+	CBenchmark benchmark;
+	CBenchmark::SResult result = BenchmarkVariant(Context, CommandQueue, LocalWorkSize, Task, benchmark);
+	CBenchmark::Print(result, m_N, GetBytesPerElement() * m_N);
 
-	//run the kernel N times
-	unsigned int nIterations = 100;
-	for(unsigned int i = 0; i < nIterations; i++) {
-		//run selected task
-		switch (Task){
-			case 0:
-				Reduction_InterleavedAddressing(Context, CommandQueue, LocalWorkSize);
-				break;
-			case 1:
-				Reduction_SequentialAddressing(Context, CommandQueue, LocalWorkSize);
-				break;
-			case 2:
-				Reduction_Decomp(Context, CommandQueue, LocalWorkSize);
-				break;
-			case 3:
-				Reduction_DecompUnroll(Context, CommandQueue, LocalWorkSize);
-				break;
-			case 4:
-				Reduction_DecompAtomics(Context, CommandQueue, LocalWorkSize);
-				break;
-		}
-	}
-
-	//wait until the command queue is empty again
+	// one more run with events, the device timestamps show how the time splits over the levels
+	ResetPingPong();
+	m_Profiler.Enable(true);
+	RunTask(Context, CommandQueue, LocalWorkSize, Task);
+	m_Profiler.Enable(false);
 	V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
 
-	timer.Stop();
-
-	double ms = timer.GetElapsedMilliseconds() / double(nIterations);
-	cout << "  average time: " << ms << " ms, throughput: " << 1.0e-6 * (double)m_N / ms << " Gelem/s" <<endl;
+	m_Profiler.Report(cout);
+	m_Profiler.Clear();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
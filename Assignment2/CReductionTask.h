@@ -21,18 +21,30 @@
 #define _CREDUCTION_TASK_H
 
 #include "../Common/IComputeTask.h"
+#include "../Common/CDeviceArena.h"
+#include "../Common/CPinnedHostMemory.h"
+#include "../Common/CEventProfiler.h"
+#include "../Common/CBenchmark.h"
+#include "../Common/CTuningDatabase.h"
+
+#include <map>
 
 //! A2/T1: Parallel reduction
 class CReductionTask : public IComputeTask
 {
 public:
-	CReductionTask(size_t ArraySize);
+	//! The second parameter determines the size of the array for the partial sums
+	CReductionTask(size_t ArraySize, size_t MinLocalWorkSize);
 
 	virtual ~CReductionTask();
 
 	// IComputeTask
 
 	virtual bool InitResources(cl_device_id Device, cl_context Context);
+
+	virtual void StartProgramBuilds(cl_device_id Device, cl_context Context);
+
+	virtual bool InitPrograms(cl_device_id Device, cl_context Context);
 	
 	virtual void ReleaseResources();
 
@@ -42,6 +54,24 @@ public:
 
 	virtual bool ValidateResults();
 
+	// parameter sweep, see CAssignment2::DoSweep
+
+	//! The tuned decomposition (variant 5) chooses its own launch configuration and is not part of the sweep
+	static unsigned int GetVariantCount() { return 5; }
+	static const char* GetVariantName(unsigned int Task);
+
+	//! The kernels assume a power of two N of at least two work-groups, the partial sums were sized for MinLocalWorkSize
+	bool SupportsSize(size_t LocalWorkSize) const;
+
+	//! Runs variant Task once and compares it with the result of ComputeCPU()
+	bool ValidateVariant(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task);
+
+	//! Times variant Task until Benchmark considers the timing stable
+	CBenchmark::SResult BenchmarkVariant(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task, CBenchmark& Benchmark);
+
+	//! The input is read once
+	static size_t GetBytesPerElement() { return sizeof(cl_uint); }
+
 protected:
 
 	void Reduction_InterleavedAddressing(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
@@ -49,6 +79,26 @@ protected:
 	void Reduction_Decomp(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
 	void Reduction_DecompUnroll(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
 	void Reduction_DecompAtomics(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
+	//! Decomposition with the launch configuration Config, m_TunedKernel has to be built for it
+	void Reduction_Tuned(cl_context Context, cl_command_queue CommandQueue, const STuningConfig& Config);
+
+	//! Reduction_DecompUnroll specialized for LocalWorkSize, built on first use
+	cl_kernel GetDecompUnrollKernel(cl_context Context, size_t LocalWorkSize);
+
+	//! Builds m_TunedKernel with the compile-time parameters of Config
+	bool BuildTunedKernel(cl_context Context, const STuningConfig& Config);
+
+	//! Whether the first pass of Config writes no more partial sums than m_dPongArray holds
+	bool FitsPartialSums(const STuningConfig& Config) const;
+
+	//! Searches the launch configuration of Reduction_Tuned with CAutoTuner and stores it in the tuning database
+	void Tune(cl_context Context, cl_command_queue CommandQueue);
+
+	//! The decomposition variants swap the buffers, this makes the full-size buffer the input again
+	void ResetPingPong();
+
+	//! Enqueues the kernels of Task without synchronization
+	void RunTask(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task);
 
 	void ExecuteTask(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int task);
 	void TestPerformance(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int task);
@@ -58,12 +108,17 @@ protected:
 
 	unsigned int		m_N;
 
-	// input data
+	// input data, in pinned memory so the uploads are DMA transfers
 	unsigned int		*m_hInput;
+	CPinnedHostMemory	m_PinnedInput;
 	// results
 	unsigned int		m_resultCPU;
-	unsigned int		m_resultGPU[5];
+	unsigned int		m_resultGPU[6];
 
+	// both arrays are sub-buffers of m_Arena, the pong array only holds the partial sums of the first pass
+	size_t				m_MinLocalWorkSize;
+	CDeviceArena		m_Arena;
+	cl_mem				m_dInputArray;
 	cl_mem				m_dPingArray;
 	cl_mem				m_dPongArray;
 
@@ -72,9 +127,20 @@ protected:
 	cl_kernel			m_InterleavedAddressingKernel;
 	cl_kernel			m_SequentialAddressingKernel;
 	cl_kernel			m_DecompKernel;
-	cl_kernel			m_DecompUnrollKernel;
+	// by local work size, the work-group size is a compile-time constant of each kernel
+	std::map<size_t, cl_kernel>	m_DecompUnrollKernels;
 	cl_kernel			m_DecompAtomicsKernel;
 
+	// the tuned decomposition is built separately, its compile options depend on the configuration
+	cl_device_id		m_Device;
+	STuningConfig		m_TunedConfig;
+	bool				m_bTuned;
+	cl_program			m_TunedProgram;
+	cl_kernel			m_TunedKernel;
+
+	// records the kernel launches of the profiled run in TestPerformance
+	CEventProfiler		m_Profiler;
+
 };
 
 #endif // _CREDUCTION_TASK_H
@@ -0,0 +1,349 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+
+#include "CRunLengthTask.h"
+
+#include "../Common/CLUtil.h"
+#include "../Common/CProgramBuilder.h"
+#include "../Common/CTimer.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// CRunLengthTask
+
+// only useful for debug info
+static const string g_RLEKernelNames[3] =
+{
+	"unique",
+	"runLengthEncode",
+	"runLengthDecode"
+};
+
+CRunLengthTask::CRunLengthTask(size_t ArraySize, size_t MinLocalWorkSize)
+	: m_N(ArraySize), m_hInput(NULL),
+	m_hValuesCPU(NULL), m_hLengthsCPU(NULL), m_nRunsCPU(0),
+	m_hValuesGPU(NULL), m_hLengthsGPU(NULL), m_hDecodedGPU(NULL), m_nRunsGPU(0),
+	m_dInput(NULL), m_dHeads(NULL), m_dValues(NULL), m_dRunStarts(NULL), m_dLengths(NULL), m_dRunEnds(NULL), m_dDecoded(NULL),
+	m_MinLocalWorkSize(MinLocalWorkSize), m_Scan(ArraySize, MinLocalWorkSize),
+	m_Program(NULL), m_HeadFlagsKernel(NULL), m_ScatterKernel(NULL), m_LengthsKernel(NULL), m_ExpandKernel(NULL)
+{
+	// Reset validation results
+	for (int i = 0; i < (int)ARRAYLEN(m_bValidationResults); i++)
+		m_bValidationResults[i] = false;
+}
+
+CRunLengthTask::~CRunLengthTask()
+{
+	ReleaseResources();
+}
+
+bool CRunLengthTask::InitResources(cl_device_id Device, cl_context Context)
+{
+	//CPU resources
+	m_hInput		= new unsigned int[m_N];
+	m_hValuesCPU	= new unsigned int[m_N];
+	m_hLengthsCPU	= new unsigned int[m_N];
+	m_hValuesGPU	= new unsigned int[m_N];
+	m_hLengthsGPU	= new unsigned int[m_N];
+	m_hDecodedGPU	= new unsigned int[m_N];
+
+	//a sorted column, a new run starts on average every 8 elements
+	m_hInput[0] = rand() & 15;
+	for(unsigned int i = 1; i < m_N; i++)
+		m_hInput[i] = m_hInput[i - 1] + (((rand() & 7) == 0) ? 1 : 0);
+
+	//device resources
+	cl_mem* buffers[] = { &m_dInput, &m_dHeads, &m_dValues, &m_dRunStarts, &m_dLengths, &m_dRunEnds, &m_dDecoded };
+	cl_int clError, clError2;
+	clError = CL_SUCCESS;
+	for (size_t i = 0; i < ARRAYLEN(buffers); i++) {
+		*buffers[i] = clCreateBuffer(Context, CL_MEM_READ_WRITE, sizeof(cl_uint) * m_N, NULL, &clError2);
+		clError |= clError2;
+	}
+	V_RETURN_FALSE_CL(clError, "Error allocating device arrays");
+
+	return true;
+}
+
+bool CRunLengthTask::InitPrograms(cl_device_id Device, cl_context Context)
+{
+	cl_int clError;
+
+	//load and compile kernels
+	string scanCode, rleCode;
+
+	if (!CLUtil::LoadProgramSourceToMemory("Scan.cl", scanCode) ||
+		!CLUtil::LoadProgramSourceToMemory("RunLength.cl", rleCode))
+		return false;
+
+	m_Program = CLUtil::BuildCLProgramFromMemory(Device, Context, scanCode + "\n" + rleCode);
+	if(m_Program == nullptr) return false;
+
+	//create kernels
+	m_HeadFlagsKernel = clCreateKernel(m_Program, "RLE_HeadFlags", &clError);
+	V_RETURN_FALSE_CL(clError, "Failed to create kernel: RLE_HeadFlags.");
+
+	m_ScatterKernel = clCreateKernel(m_Program, "RLE_Scatter", &clError);
+	V_RETURN_FALSE_CL(clError, "Failed to create kernel: RLE_Scatter.");
+
+	m_LengthsKernel = clCreateKernel(m_Program, "RLE_Lengths", &clError);
+	V_RETURN_FALSE_CL(clError, "Failed to create kernel: RLE_Lengths.");
+
+	m_ExpandKernel = clCreateKernel(m_Program, "RLE_Expand", &clError);
+	V_RETURN_FALSE_CL(clError, "Failed to create kernel: RLE_Expand.");
+
+	if (!m_Scan.InitResources(Context, m_Program))
+		return false;
+
+	return true;
+}
+
+void CRunLengthTask::StartProgramBuilds(cl_device_id Device, cl_context Context)
+{
+	string scanCode, rleCode;
+
+	if (CLUtil::LoadProgramSourceToMemory("Scan.cl", scanCode) &&
+		CLUtil::LoadProgramSourceToMemory("RunLength.cl", rleCode))
+		CProgramBuilder::BuildAsync(Device, Context, scanCode + "\n" + rleCode);
+}
+
+void CRunLengthTask::ReleaseResources()
+{
+	// host resources
+	SAFE_DELETE_ARRAY(m_hInput);
+	SAFE_DELETE_ARRAY(m_hValuesCPU);
+	SAFE_DELETE_ARRAY(m_hLengthsCPU);
+	SAFE_DELETE_ARRAY(m_hValuesGPU);
+	SAFE_DELETE_ARRAY(m_hLengthsGPU);
+	SAFE_DELETE_ARRAY(m_hDecodedGPU);
+
+	// device resources
+	SAFE_RELEASE_MEMOBJECT(m_dInput);
+	SAFE_RELEASE_MEMOBJECT(m_dHeads);
+	SAFE_RELEASE_MEMOBJECT(m_dValues);
+	SAFE_RELEASE_MEMOBJECT(m_dRunStarts);
+	SAFE_RELEASE_MEMOBJECT(m_dLengths);
+	SAFE_RELEASE_MEMOBJECT(m_dRunEnds);
+	SAFE_RELEASE_MEMOBJECT(m_dDecoded);
+
+	m_Scan.ReleaseResources();
+
+	SAFE_RELEASE_KERNEL(m_HeadFlagsKernel);
+	SAFE_RELEASE_KERNEL(m_ScatterKernel);
+	SAFE_RELEASE_KERNEL(m_LengthsKernel);
+	SAFE_RELEASE_KERNEL(m_ExpandKernel);
+
+	SAFE_RELEASE_PROGRAM(m_Program);
+}
+
+void CRunLengthTask::ComputeGPU(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
+{
+	cout << endl;
+
+	ValidateTask(Context, CommandQueue, LocalWorkSize);
+
+	cout << endl;
+
+	TestPerformance(Context, CommandQueue, LocalWorkSize);
+
+	cout << endl;
+}
+
+void CRunLengthTask::ComputeCPU()
+{
+	CTimer timer;
+	timer.Start();
+
+	m_nRunsCPU = 0;
+	for(unsigned int i = 0; i < m_N; i++) {
+		if (i == 0 || m_hInput[i] != m_hInput[i - 1]) {
+			m_hValuesCPU[m_nRunsCPU] = m_hInput[i];
+			m_hLengthsCPU[m_nRunsCPU] = 0;
+			m_nRunsCPU++;
+		}
+		m_hLengthsCPU[m_nRunsCPU - 1]++;
+	}
+
+	timer.Stop();
+	double ms = timer.GetElapsedMilliseconds();
+	cout << "  average time: " << ms << " ms, throughput: " << 1.0e-6 * (double)m_N / ms << " Gelem/s" <<endl;
+	cout << "  " << m_nRunsCPU << " runs in " << m_N << " elements" << endl;
+}
+
+bool CRunLengthTask::ValidateResults()
+{
+	bool success = true;
+
+	for(int i = 0; i < (int)ARRAYLEN(m_bValidationResults); i++)
+		if(!m_bValidationResults[i])
+		{
+			cout<<"Validation of run-length kernel "<<g_RLEKernelNames[i]<<" failed." << endl;
+			success = false;
+		}
+
+	return success;
+}
+
+void CRunLengthTask::Unique(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
+{
+	cl_int clErr;
+	size_t globalWorkSize[1];
+	size_t localWorkSize[1];
+
+	localWorkSize[0] = LocalWorkSize[0];
+	globalWorkSize[0] = CLUtil::GetGlobalWorkSize(m_N, localWorkSize[0]);
+
+	// 1. flag the first element of every run
+	clErr = clSetKernelArg(m_HeadFlagsKernel, 0, sizeof(cl_mem), (void*)&m_dInput);
+	clErr |= clSetKernelArg(m_HeadFlagsKernel, 1, sizeof(cl_mem), (void*)&m_dHeads);
+	clErr |= clSetKernelArg(m_HeadFlagsKernel, 2, sizeof(cl_uint), (void*)&m_N);
+	V_RETURN_CL(clErr, "Failed to set RLE_HeadFlags arguments");
+
+	clErr = clEnqueueNDRangeKernel(CommandQueue, m_HeadFlagsKernel, 1, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+	V_RETURN_CL(clErr, "Error executing RLE_HeadFlags!");
+
+	// 2. run index of every element
+	m_Scan.Scan(CommandQueue, m_dHeads, m_N, localWorkSize[0]);
+
+	// 3. write the run values and starts
+	clErr = clSetKernelArg(m_ScatterKernel, 0, sizeof(cl_mem), (void*)&m_dInput);
+	clErr |= clSetKernelArg(m_ScatterKernel, 1, sizeof(cl_mem), (void*)&m_dHeads);
+	clErr |= clSetKernelArg(m_ScatterKernel, 2, sizeof(cl_mem), (void*)&m_dValues);
+	clErr |= clSetKernelArg(m_ScatterKernel, 3, sizeof(cl_mem), (void*)&m_dRunStarts);
+	clErr |= clSetKernelArg(m_ScatterKernel, 4, sizeof(cl_uint), (void*)&m_N);
+	V_RETURN_CL(clErr, "Failed to set RLE_Scatter arguments");
+
+	clErr = clEnqueueNDRangeKernel(CommandQueue, m_ScatterKernel, 1, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+	V_RETURN_CL(clErr, "Error executing RLE_Scatter!");
+}
+
+void CRunLengthTask::Encode(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], cl_uint nRuns)
+{
+	// NOTE: nRuns has to be read back after Unique() before the lengths can be computed,
+	// in the performance test we use the known number of runs to avoid the synchronization
+	Unique(Context, CommandQueue, LocalWorkSize);
+
+	cl_int clErr;
+	size_t globalWorkSize[1];
+	size_t localWorkSize[1];
+
+	localWorkSize[0] = LocalWorkSize[0];
+	globalWorkSize[0] = CLUtil::GetGlobalWorkSize(nRuns, localWorkSize[0]);
+
+	clErr = clSetKernelArg(m_LengthsKernel, 0, sizeof(cl_mem), (void*)&m_dRunStarts);
+	clErr |= clSetKernelArg(m_LengthsKernel, 1, sizeof(cl_mem), (void*)&m_dLengths);
+	clErr |= clSetKernelArg(m_LengthsKernel, 2, sizeof(cl_uint), (void*)&nRuns);
+	clErr |= clSetKernelArg(m_LengthsKernel, 3, sizeof(cl_uint), (void*)&m_N);
+	V_RETURN_CL(clErr, "Failed to set RLE_Lengths arguments");
+
+	clErr = clEnqueueNDRangeKernel(CommandQueue, m_LengthsKernel, 1, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+	V_RETURN_CL(clErr, "Error executing RLE_Lengths!");
+}
+
+void CRunLengthTask::Decode(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], cl_uint nRuns)
+{
+	cl_int clErr;
+	size_t globalWorkSize[1];
+	size_t localWorkSize[1];
+
+	localWorkSize[0] = LocalWorkSize[0];
+
+	// 1. the run ends are the inclusive prefix sum of the lengths
+	V_RETURN_CL(clEnqueueCopyBuffer(CommandQueue, m_dLengths, m_dRunEnds, 0, 0, nRuns * sizeof(cl_uint), 0, NULL, NULL), "Error copying the run lengths!");
+	m_Scan.Scan(CommandQueue, m_dRunEnds, nRuns, localWorkSize[0]);
+
+	// 2. expand, 4 elements per work-item
+	globalWorkSize[0] = CLUtil::GetGlobalWorkSize((m_N + 3) / 4, localWorkSize[0]);
+
+	clErr = clSetKernelArg(m_ExpandKernel, 0, sizeof(cl_mem), (void*)&m_dValues);
+	clErr |= clSetKernelArg(m_ExpandKernel, 1, sizeof(cl_mem), (void*)&m_dRunEnds);
+	clErr |= clSetKernelArg(m_ExpandKernel, 2, sizeof(cl_mem), (void*)&m_dDecoded);
+	clErr |= clSetKernelArg(m_ExpandKernel, 3, sizeof(cl_uint), (void*)&nRuns);
+	clErr |= clSetKernelArg(m_ExpandKernel, 4, sizeof(cl_uint), (void*)&m_N);
+	V_RETURN_CL(clErr, "Failed to set RLE_Expand arguments");
+
+	clErr = clEnqueueNDRangeKernel(CommandQueue, m_ExpandKernel, 1, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+	V_RETURN_CL(clErr, "Error executing RLE_Expand!");
+}
+
+void CRunLengthTask::ValidateTask(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
+{
+	for (int i = 0; i < (int)ARRAYLEN(m_bValidationResults); i++)
+		m_bValidationResults[i] = false;
+
+	// unique
+	V_RETURN_CL(clEnqueueWriteBuffer(CommandQueue, m_dInput, CL_FALSE, 0, m_N * sizeof(cl_uint), m_hInput, 0, NULL, NULL), "Error copying data from host to device!");
+	Unique(Context, CommandQueue, LocalWorkSize);
+
+	V_RETURN_CL(clEnqueueReadBuffer(CommandQueue, m_dHeads, CL_TRUE, (m_N - 1) * sizeof(cl_uint), sizeof(cl_uint), &m_nRunsGPU, 0, NULL, NULL), "Error reading data from device!");
+	cout << "GPU found " << m_nRunsGPU << " runs" << endl;
+	if (m_nRunsGPU != m_nRunsCPU)
+		return;
+
+	V_RETURN_CL(clEnqueueReadBuffer(CommandQueue, m_dValues, CL_TRUE, 0, m_nRunsGPU * sizeof(cl_uint), m_hValuesGPU, 0, NULL, NULL), "Error reading data from device!");
+	m_bValidationResults[0] = (memcmp(m_hValuesCPU, m_hValuesGPU, m_nRunsCPU * sizeof(unsigned int)) == 0);
+
+	// encode
+	Encode(Context, CommandQueue, LocalWorkSize, m_nRunsGPU);
+
+	V_RETURN_CL(clEnqueueReadBuffer(CommandQueue, m_dValues, CL_TRUE, 0, m_nRunsGPU * sizeof(cl_uint), m_hValuesGPU, 0, NULL, NULL), "Error reading data from device!");
+	V_RETURN_CL(clEnqueueReadBuffer(CommandQueue, m_dLengths, CL_TRUE, 0, m_nRunsGPU * sizeof(cl_uint), m_hLengthsGPU, 0, NULL, NULL), "Error reading data from device!");
+	m_bValidationResults[1] = (memcmp(m_hValuesCPU, m_hValuesGPU, m_nRunsCPU * sizeof(unsigned int)) == 0) &&
+		(memcmp(m_hLengthsCPU, m_hLengthsGPU, m_nRunsCPU * sizeof(unsigned int)) == 0);
+
+	// decode the runs we have just encoded
+	Decode(Context, CommandQueue, LocalWorkSize, m_nRunsGPU);
+
+	V_RETURN_CL(clEnqueueReadBuffer(CommandQueue, m_dDecoded, CL_TRUE, 0, m_N * sizeof(cl_uint), m_hDecodedGPU, 0, NULL, NULL), "Error reading data from device!");
+	m_bValidationResults[2] = (memcmp(m_hInput, m_hDecodedGPU, m_N * sizeof(unsigned int)) == 0);
+}
+
+void CRunLengthTask::TestPerformance(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
+{
+	//write input data to the GPU
+	V_RETURN_CL(clEnqueueWriteBuffer(CommandQueue, m_dInput, CL_FALSE, 0, m_N * sizeof(cl_uint), m_hInput, 0, NULL, NULL), "Error copying data from host to device!");
+
+	for (int task = 0; task < 3; task++)
+	{
+		cout << "Testing performance of task " << g_RLEKernelNames[task] << endl;
+
+		//finish all before we start meassuring the time
+		V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
+
+		CTimer timer;
+		timer.Start();
+
+		//run the kernel N times
+		unsigned int nIterations = 100;
+		for(unsigned int i = 0; i < nIterations; i++) {
+			switch (task) {
+				case 0:
+					Unique(Context, CommandQueue, LocalWorkSize);
+					break;
+				case 1:
+					Encode(Context, CommandQueue, LocalWorkSize, m_nRunsCPU);
+					break;
+				case 2:
+					Decode(Context, CommandQueue, LocalWorkSize, m_nRunsCPU);
+					break;
+			}
+		}
+
+		//wait until the command queue is empty again
+		V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
+
+		timer.Stop();
+
+		double ms = timer.GetElapsedMilliseconds() / double(nIterations);
+		cout << "  average time: " << ms << " ms, throughput: " << 1.0e-6 * (double)m_N / ms << " Gelem/s" <<endl;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,104 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CRUN_LENGTH_TASK_H
+#define _CRUN_LENGTH_TASK_H
+
+#include "../Common/IComputeTask.h"
+
+#include "CScanHierarchy.h"
+
+//! Run-length encoding / decoding and unique (keep the first element of every run)
+/*!
+	Unique and encoding flag the first element of every run (adjacent difference),
+	scan the flags to get the run index and scatter the run values and run starts.
+	The run lengths follow from the run starts.
+
+	Decoding scans the run lengths to get the run ends and expands the runs,
+	4 output elements per work-item.
+*/
+class CRunLengthTask : public IComputeTask
+{
+public:
+	CRunLengthTask(size_t ArraySize, size_t MinLocalWorkSize);
+
+	virtual ~CRunLengthTask();
+
+	// IComputeTask
+	virtual bool InitResources(cl_device_id Device, cl_context Context);
+
+	virtual void StartProgramBuilds(cl_device_id Device, cl_context Context);
+
+	virtual bool InitPrograms(cl_device_id Device, cl_context Context);
+
+	virtual void ReleaseResources();
+
+	virtual void ComputeGPU(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
+
+	virtual void ComputeCPU();
+
+	virtual bool ValidateResults();
+
+protected:
+
+	//! Run values of m_dInput to m_dValues and run starts to m_dRunStarts. The number of runs is the last element of m_dHeads.
+	void Unique(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
+	//! Unique() plus the run lengths in m_dLengths
+	void Encode(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], cl_uint nRuns);
+	//! Expands nRuns runs of m_dValues / m_dLengths to m_dDecoded
+	void Decode(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], cl_uint nRuns);
+
+	void ValidateTask(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
+	void TestPerformance(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
+
+	unsigned int		m_N;
+
+	// sorted input column with runs
+	unsigned int		*m_hInput;
+
+	unsigned int		*m_hValuesCPU;
+	unsigned int		*m_hLengthsCPU;
+	unsigned int		m_nRunsCPU;
+
+	unsigned int		*m_hValuesGPU;
+	unsigned int		*m_hLengthsGPU;
+	unsigned int		*m_hDecodedGPU;
+	unsigned int		m_nRunsGPU;
+	bool				m_bValidationResults[3];
+
+	cl_mem				m_dInput;
+	cl_mem				m_dHeads;
+	cl_mem				m_dValues;
+	cl_mem				m_dRunStarts;
+	cl_mem				m_dLengths;
+	cl_mem				m_dRunEnds;
+	cl_mem				m_dDecoded;
+
+	size_t				m_MinLocalWorkSize;
+	CScanHierarchy		m_Scan;
+
+	//OpenCL program and kernels
+	cl_program			m_Program;
+	cl_kernel			m_HeadFlagsKernel;
+	cl_kernel			m_ScatterKernel;
+	cl_kernel			m_LengthsKernel;
+	cl_kernel			m_ExpandKernel;
+};
+
+#endif // _CRUN_LENGTH_TASK_H
@@ -0,0 +1,162 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+
+#include "CScanHierarchy.h"
+
+#include "../Common/CLUtil.h"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// CScanHierarchy
+
+CScanHierarchy::CScanHierarchy(size_t MaxElements, size_t MinLocalWorkSize, size_t ElementSize)
+	: m_MaxElements(MaxElements), m_MinLocalWorkSize(MinLocalWorkSize), m_ElementSize(ElementSize),
+	m_BlockScanKernel(NULL), m_ScanWorkEfficientAddKernel(NULL), m_pProfiler(NULL)
+{
+}
+
+CScanHierarchy::~CScanHierarchy()
+{
+	ReleaseResources();
+}
+
+vector<size_t> CScanHierarchy::GetLevelSizes() const
+{
+	// one level per block-sum array, until a single element remains
+	vector<size_t> levelSizes;
+	size_t blockSize = 2 * m_MinLocalWorkSize;
+	size_t N = m_MaxElements;
+	do
+	{
+		N = (N + blockSize - 1) / blockSize;
+		levelSizes.push_back(N);
+	} while (N > 1);
+
+	return levelSizes;
+}
+
+size_t CScanHierarchy::GetLevelArraysSize(const CDeviceArena& Arena) const
+{
+	vector<size_t> levelSizes = GetLevelSizes();
+
+	size_t size = 0;
+	for (size_t i = 0; i < levelSizes.size(); i++)
+		size += Arena.Align(m_ElementSize * levelSizes[i]);
+
+	return size;
+}
+
+bool CScanHierarchy::InitResources(cl_context Context, cl_program Program, const char* BlockScanKernel, CDeviceArena* pArena, unsigned int ArenaRegion)
+{
+	cl_int clError, clError2;
+
+	vector<size_t> levelSizes = GetLevelSizes();
+	size_t arenaOffset = 0;
+	clError = CL_SUCCESS;
+	for (size_t i = 0; i < levelSizes.size(); i++)
+	{
+		size_t levelBytes = m_ElementSize * levelSizes[i];
+		if (pArena)
+		{
+			m_dLevelArrays.push_back(pArena->CreateSubBuffer(ArenaRegion, arenaOffset, levelBytes));
+			if (m_dLevelArrays.back() == NULL)
+				return false;
+			arenaOffset += pArena->Align(levelBytes);
+		}
+		else
+		{
+			m_dLevelArrays.push_back(clCreateBuffer(Context, CL_MEM_READ_WRITE, levelBytes, NULL, &clError2));
+			clError |= clError2;
+		}
+	}
+	V_RETURN_FALSE_CL(clError, "Error allocating scan level arrays");
+
+	m_BlockScanKernel = clCreateKernel(Program, BlockScanKernel, &clError);
+	V_RETURN_FALSE_CL(clError, "Failed to create the block scan kernel.");
+	m_BlockScanKernelName = BlockScanKernel;
+
+	m_ScanWorkEfficientAddKernel = clCreateKernel(Program, "Scan_WorkEfficientAdd", &clError);
+	V_RETURN_FALSE_CL(clError, "Failed to create kernel: Scan_WorkEfficientAdd.");
+
+	return true;
+}
+
+void CScanHierarchy::ReleaseResources()
+{
+	for (size_t i = 0; i < m_dLevelArrays.size(); i++)
+		SAFE_RELEASE_MEMOBJECT(m_dLevelArrays[i]);
+	m_dLevelArrays.clear();
+
+	SAFE_RELEASE_KERNEL(m_BlockScanKernel);
+	SAFE_RELEASE_KERNEL(m_ScanWorkEfficientAddKernel);
+}
+
+void CScanHierarchy::Scan(cl_command_queue CommandQueue, cl_mem dArray, size_t N, size_t LocalWorkSize)
+{
+	if (N == 0)
+		return;
+
+	cl_int clErr;
+	size_t globalWorkSize[1];
+	size_t localWorkSize[1];
+	size_t blockSize = 2 * LocalWorkSize;
+
+	localWorkSize[0] = LocalWorkSize;
+
+	// element count of every level that is used for this N
+	vector<cl_uint> levelSizes;
+	levelSizes.push_back((cl_uint)N);
+
+	// level 0 is the input array, level i > 0 is stored in m_dLevelArrays[i - 1]
+	vector<cl_mem> levels;
+	levels.push_back(dArray);
+	levels.insert(levels.end(), m_dLevelArrays.begin(), m_dLevelArrays.end());
+
+	// scan the blocks of each level and write their sums to the next level
+	for (size_t i = 0; ; i++)
+	{
+		cl_uint levelN = levelSizes[i];
+		size_t nBlocks = (levelN + blockSize - 1) / blockSize;
+		globalWorkSize[0] = nBlocks * localWorkSize[0];
+
+		//binding arguments
+		clErr = clSetKernelArg(m_BlockScanKernel, 0, sizeof(cl_mem), (void*)&levels[i]);
+		clErr |= clSetKernelArg(m_BlockScanKernel, 1, sizeof(cl_mem), (void*)&levels[i + 1]);
+		clErr |= clSetKernelArg(m_BlockScanKernel, 2, sizeof(cl_uint), (void*)&levelN);
+		clErr |= clSetKernelArg(m_BlockScanKernel, 3, 4 * localWorkSize[0] * m_ElementSize, NULL);
+		V_RETURN_CL(clErr, "Failed to set block scan arguments");
+
+		//launching kernel
+		cl_event* pEvent = m_pProfiler ? m_pProfiler->Event(m_BlockScanKernelName, (int)i) : NULL;
+		clErr = clEnqueueNDRangeKernel(CommandQueue, m_BlockScanKernel, 1, NULL, globalWorkSize, localWorkSize, 0, NULL, pEvent);
+		V_RETURN_CL(clErr, "Error executing block scan!");
+
+		if (nBlocks == 1)
+			break;
+		levelSizes.push_back((cl_uint)nBlocks);
+	}
+
+	// propagate the scanned block sums back down
+	for (size_t i = levelSizes.size() - 1; i > 0; i--)
+	{
+		cl_uint lowerN = levelSizes[i - 1];
+		globalWorkSize[0] = CLUtil::GetGlobalWorkSize(lowerN, localWorkSize[0]);
+
+		//binding arguments
+		clErr = clSetKernelArg(m_ScanWorkEfficientAddKernel, 0, sizeof(cl_mem), (void*)&levels[i]);
+		clErr |= clSetKernelArg(m_ScanWorkEfficientAddKernel, 1, sizeof(cl_mem), (void*)&levels[i - 1]);
+		clErr |= clSetKernelArg(m_ScanWorkEfficientAddKernel, 2, sizeof(cl_uint), (void*)&lowerN);
+		V_RETURN_CL(clErr, "Failed to set Scan_WorkEfficientAdd arguments");
+
+		//launching kernel
+		cl_event* pEvent = m_pProfiler ? m_pProfiler->Event("Scan_WorkEfficientAdd", (int)(i - 1)) : NULL;
+		clErr = clEnqueueNDRangeKernel(CommandQueue, m_ScanWorkEfficientAddKernel, 1, NULL, globalWorkSize, localWorkSize, 0, NULL, pEvent);
+		V_RETURN_CL(clErr, "Error executing Scan_WorkEfficientAdd!");
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
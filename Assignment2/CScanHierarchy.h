@@ -0,0 +1,88 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CSCAN_HIERARCHY_H
+#define _CSCAN_HIERARCHY_H
+
+#include "../Common/IComputeTask.h"
+#include "../Common/CDeviceArena.h"
+#include "../Common/CEventProfiler.h"
+
+#include <vector>
+
+//! Multi-level work-efficient prefix sum on an arbitrary device array
+/*!
+	This is the level hierarchy of the work-efficient scan (A2 / T2) in a form
+	that other tasks can use on their own device buffers.
+	Each block of 2 * LocalWorkSize elements is scanned in local memory, the block sums
+	are scanned recursively on the next level and then added back.
+
+	The kernels are taken from a program that contains Scan.cl. Tasks with their own
+	kernels simply build Scan.cl and their source into the same program.
+	A program built from GenericScan.cl provides the same kernels for other element types,
+	ElementSize is then the size of one element.
+*/
+class CScanHierarchy
+{
+public:
+	//! MaxElements and MinLocalWorkSize determine the size of the level arrays
+	CScanHierarchy(size_t MaxElements, size_t MinLocalWorkSize, size_t ElementSize = sizeof(cl_uint));
+
+	virtual ~CScanHierarchy();
+
+	//! BlockScanKernel selects the kernel that scans the blocks, e.g. "Scan_HillisSteele" (same interface)
+	//! If pArena is given, the level arrays are sub-buffers of the arena region ArenaRegion,
+	//! which has to hold GetLevelArraysSize(*pArena) bytes. Otherwise they are separate buffers.
+	bool InitResources(cl_context Context, cl_program Program, const char* BlockScanKernel = "Scan_WorkEfficient",
+		CDeviceArena* pArena = NULL, unsigned int ArenaRegion = 0);
+
+	//! Bytes of all level arrays when they are placed in Arena
+	size_t GetLevelArraysSize(const CDeviceArena& Arena) const;
+
+	void ReleaseResources();
+
+	//! If set, the kernels of Scan() record their events in pProfiler, by kernel name and level
+	void SetProfiler(CEventProfiler* pProfiler) { m_pProfiler = pProfiler; }
+
+	//! The kernel that scans the blocks, e.g. to query its work-group limits
+	cl_kernel GetBlockScanKernel() const { return m_BlockScanKernel; }
+
+	//! Inclusive in-place prefix sum of the first N elements of dArray (N <= MaxElements)
+	void Scan(cl_command_queue CommandQueue, cl_mem dArray, size_t N, size_t LocalWorkSize);
+
+protected:
+
+	//! Element counts of the level arrays
+	std::vector<size_t> GetLevelSizes() const;
+
+	size_t				m_MaxElements;
+	size_t				m_MinLocalWorkSize;
+	size_t				m_ElementSize;
+
+	// block sums of the levels above the array passed to Scan()
+	std::vector<cl_mem>	m_dLevelArrays;
+
+	cl_kernel			m_BlockScanKernel;
+	cl_kernel			m_ScanWorkEfficientAddKernel;
+	std::string			m_BlockScanKernelName;
+
+	CEventProfiler*		m_pProfiler;
+};
+
+#endif // _CSCAN_HIERARCHY_H
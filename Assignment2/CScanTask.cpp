@@ -6,7 +6,9 @@ GPU Computing / GPGPU Praktikum source code.
 #include "CScanTask.h"
 
 #include "../Common/CLUtil.h"
+#include "../Common/CProgramBuilder.h"
 #include "../Common/CTimer.h"
+#include "../Common/CAutoTuner.h"
 
 #include <string.h>
 
@@ -20,29 +22,23 @@ using namespace std;
 // CScanTask
 
 // only useful for debug info
-const string g_kernelNames[2] = 
+const string g_kernelNames[4] = 
 {
 	"scanNaive",
-	"scanWorkEfficient"
+	"scanWorkEfficient",
+	"scanNaiveLocal",
+	"scanWorkEfficientTuned"
 };
 
 CScanTask::CScanTask(size_t ArraySize, size_t MinLocalWorkSize)
-	: m_N(ArraySize), m_hArray(NULL), m_hResultCPU(NULL), m_hResultGPU(NULL),
+	: m_N(ArraySize), m_hArray(NULL), m_hResultCPU(NULL), m_hResultGPU(NULL), m_LevelRegion(0),
 	m_dPingArray(NULL), m_dPongArray(NULL),
+	m_MinLocalWorkSize(MinLocalWorkSize), m_WorkEfficientScan(ArraySize, MinLocalWorkSize),
+	m_NaiveLocalScan(ArraySize, MinLocalWorkSize),
 	m_Program(NULL), 
-	m_ScanNaiveKernel(NULL), m_ScanWorkEfficientKernel(NULL), m_ScanWorkEfficientAddKernel(NULL)
+	m_ScanNaiveKernel(NULL),
+	m_Device(NULL), m_TunedLocalWorkSize(MinLocalWorkSize), m_bTuned(false)
 {
-	// compute the number of levels that we need for the work-efficient algorithm
-
-	m_MinLocalWorkSize = MinLocalWorkSize;
-
-	m_nLevels = 1;
-	size_t N = ArraySize;
-	while (N > 0){
-		N /= 2 * m_MinLocalWorkSize;
-		m_nLevels++;
-	}
-
 	// Reset validation results
 	for (int i = 0; i < (int)ARRAYLEN(m_bValidationResults); i++)
 		m_bValidationResults[i] = false;
@@ -56,9 +52,11 @@ CScanTask::~CScanTask()
 bool CScanTask::InitResources(cl_device_id Device, cl_context Context)
 {
 	//CPU resources
-	m_hArray	 = new unsigned int[m_N];
+	m_PinnedArray.Allocate(Device, Context, m_N * sizeof(cl_uint));
+	m_PinnedResultGPU.Allocate(Device, Context, m_N * sizeof(cl_uint));
+	m_hArray	 = (unsigned int*)m_PinnedArray.GetPointer();
 	m_hResultCPU = new unsigned int[m_N];
-	m_hResultGPU = new unsigned int[m_N];
+	m_hResultGPU = (unsigned int*)m_PinnedResultGPU.GetPointer();
 
 	//fill the array with some values
 	for(unsigned int i = 0; i < m_N; i++)
@@ -66,22 +64,33 @@ bool CScanTask::InitResources(cl_device_id Device, cl_context Context)
 		//m_hArray[i] = rand() & 15;
 
 	//device resources
-	// ping-pong buffers
-	cl_int clError, clError2;
-	m_dPingArray = clCreateBuffer(Context, CL_MEM_READ_WRITE, sizeof(cl_uint) * m_N, NULL, &clError2);
-	clError = clError2;
-	m_dPongArray = clCreateBuffer(Context, CL_MEM_READ_WRITE, sizeof(cl_uint) * m_N, NULL, &clError2);
-	clError |= clError2;
-
-	// level buffer
-	m_dLevelArrays = new cl_mem[m_nLevels];
-	unsigned int N = m_N;
-	for (unsigned int i = 0; i < m_nLevels; i++) {
-		m_dLevelArrays[i] = clCreateBuffer(Context, CL_MEM_READ_WRITE, sizeof(cl_uint) * N, NULL, &clError2);
-		clError |= clError2;
-		N = max(N / (2 * m_MinLocalWorkSize), m_MinLocalWorkSize);
-	}
-	V_RETURN_FALSE_CL(clError, "Error allocating device arrays");
+	// one arena allocation for the ping-pong buffers and the level arrays.
+	// Both hierarchies share the level arrays, as their scans never run at the same time.
+	CTimer timer;
+	timer.Start();
+
+	m_Arena.Init(Device);
+	size_t levelArraysSize = m_WorkEfficientScan.GetLevelArraysSize(m_Arena);
+	unsigned int pingRegion = m_Arena.Reserve(sizeof(cl_uint) * m_N);
+	unsigned int pongRegion = m_Arena.Reserve(sizeof(cl_uint) * m_N);
+	m_LevelRegion = m_Arena.Reserve(levelArraysSize);
+	if (!m_Arena.Allocate(Context))
+		return false;
+
+	m_dPingArray = m_Arena.CreateSubBuffer(pingRegion);
+	m_dPongArray = m_Arena.CreateSubBuffer(pongRegion);
+	if (m_dPingArray == NULL || m_dPongArray == NULL)
+		return false;
+
+	timer.Stop();
+	m_Arena.PrintStatistics(2 * sizeof(cl_uint) * m_N + 2 * levelArraysSize, timer.GetElapsedMilliseconds());
+
+	return true;
+}
+
+bool CScanTask::InitPrograms(cl_device_id Device, cl_context Context)
+{
+	cl_int clError;
 
 	//load and compile kernels
 	string programCode;
@@ -94,36 +103,53 @@ bool CScanTask::InitResources(cl_device_id Device, cl_context Context)
 	m_ScanNaiveKernel = clCreateKernel(m_Program, "Scan_Naive", &clError);
 	V_RETURN_FALSE_CL(clError, "Failed to create kernel.");
 
-	m_ScanWorkEfficientKernel = clCreateKernel(m_Program, "Scan_WorkEfficient", &clError);
-	V_RETURN_FALSE_CL(clError, "Failed to create kernel.");
+	// the level arrays (sub-buffers of the arena) and kernels of the work-efficient scan
+	if (!m_WorkEfficientScan.InitResources(Context, m_Program, "Scan_WorkEfficient", &m_Arena, m_LevelRegion))
+		return false;
 
-	m_ScanWorkEfficientAddKernel = clCreateKernel(m_Program, "Scan_WorkEfficientAdd", &clError);
-	V_RETURN_FALSE_CL(clError, "Failed to create kernel.");
+	// same hierarchy with Hillis-Steele block scans
+	if (!m_NaiveLocalScan.InitResources(Context, m_Program, "Scan_HillisSteele", &m_Arena, m_LevelRegion))
+		return false;
+	m_WorkEfficientScan.SetProfiler(&m_Profiler);
+	m_NaiveLocalScan.SetProfiler(&m_Profiler);
+
+	// the level arrays were sized for m_MinLocalWorkSize, smaller tuned sizes do not fit
+	m_Device = Device;
+	STuningConfig tunedConfig;
+	m_bTuned = CTuningDatabase::Lookup("Scan_WorkEfficient", Device, m_N, tunedConfig) && tunedConfig.LocalWorkSize >= m_MinLocalWorkSize;
+	m_TunedLocalWorkSize = m_bTuned ? tunedConfig.LocalWorkSize : m_MinLocalWorkSize;
 
 	return true;
 }
 
+void CScanTask::StartProgramBuilds(cl_device_id Device, cl_context Context)
+{
+	string programCode;
+
+	if (CLUtil::LoadProgramSourceToMemory("Scan.cl", programCode))
+		CProgramBuilder::BuildAsync(Device, Context, programCode);
+}
+
 void CScanTask::ReleaseResources()
 {
 	// host resources
-	SAFE_DELETE_ARRAY(m_hArray);
+	m_PinnedArray.Release();
+	m_hArray = NULL;
 
 	SAFE_DELETE_ARRAY(m_hResultCPU);
-	SAFE_DELETE_ARRAY(m_hResultGPU);
+	m_PinnedResultGPU.Release();
+	m_hResultGPU = NULL;
 
 	// device resources
 	SAFE_RELEASE_MEMOBJECT(m_dPingArray);
 	SAFE_RELEASE_MEMOBJECT(m_dPongArray);
 
-	if(m_dLevelArrays)
-		for (unsigned int i = 0; i < m_nLevels; i++) {
-			SAFE_RELEASE_MEMOBJECT(m_dLevelArrays[i]);
-		}
-	SAFE_DELETE_ARRAY(m_dLevelArrays);
+	m_WorkEfficientScan.ReleaseResources();
+	m_NaiveLocalScan.ReleaseResources();
+
+	m_Arena.Release();
 
 	SAFE_RELEASE_KERNEL(m_ScanNaiveKernel);
-	SAFE_RELEASE_KERNEL(m_ScanWorkEfficientKernel);
-	SAFE_RELEASE_KERNEL(m_ScanWorkEfficientAddKernel);
 
 	SAFE_RELEASE_PROGRAM(m_Program);
 }
@@ -132,13 +158,22 @@ void CScanTask::ComputeGPU(cl_context Context, cl_command_queue CommandQueue, si
 {
 	cout << endl;
 
+	// the tuned scan ignores LocalWorkSize, it is tuned here if the tuning database has no entry for the device
+	if (!m_bTuned && CTuningDatabase::IsEnabled())
+		Tune(Context, CommandQueue);
+	cout << "Tuned work-efficient scan: local " << m_TunedLocalWorkSize << (m_bTuned ? "" : " (not tuned)") << endl;
+
 	ValidateTask(Context, CommandQueue, LocalWorkSize, 0);
 	ValidateTask(Context, CommandQueue, LocalWorkSize, 1);
+	ValidateTask(Context, CommandQueue, LocalWorkSize, 2);
+	ValidateTask(Context, CommandQueue, LocalWorkSize, 3);
 
 	cout << endl;
 
 	TestPerformance(Context, CommandQueue, LocalWorkSize, 0);
 	TestPerformance(Context, CommandQueue, LocalWorkSize, 1);
+	TestPerformance(Context, CommandQueue, LocalWorkSize, 2);
+	TestPerformance(Context, CommandQueue, LocalWorkSize, 3);
 
 	cout << endl;
 }
@@ -166,7 +201,7 @@ bool CScanTask::ValidateResults()
 {
 	bool success = true;
 
-	for(int i = 0; i < 2; i++)
+	for(int i = 0; i < (int)ARRAYLEN(m_bValidationResults); i++)
 		if(!m_bValidationResults[i])
 		{
 			cout<<"Validation of reduction kernel "<<g_kernelNames[i]<<" failed." << endl;
@@ -193,8 +228,9 @@ void CScanTask::Scan_Naive(cl_context Context, cl_command_queue CommandQueue, si
 	globalWorkSize[0] = CLUtil::GetGlobalWorkSize(m_N, LocalWorkSize[0]);
 	localWorkSize[0] = LocalWorkSize[0];
 	unsigned int offset;
+	int level = 0;
 
-	for (offset = 1; offset < m_N; offset *= 2)
+	for (offset = 1; offset < m_N; offset *= 2, level++)
 	{
 		//cout << "offset = " << offset << endl;
 
@@ -209,7 +245,7 @@ void CScanTask::Scan_Naive(cl_context Context, cl_command_queue CommandQueue, si
 		V_RETURN_CL(clErr, "Failed to set kernel offset argument");
 
 		//launching kernel
-		clErr = clEnqueueNDRangeKernel(CommandQueue, m_ScanNaiveKernel, 1, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+		clErr = clEnqueueNDRangeKernel(CommandQueue, m_ScanNaiveKernel, 1, NULL, globalWorkSize, localWorkSize, 0, NULL, m_Profiler.Event("Scan_Naive", level));
 		V_RETURN_CL(clErr, "Error Executing Kernel!");
 
 		//swap input with output
@@ -222,48 +258,66 @@ void CScanTask::Scan_WorkEfficient(cl_context Context, cl_command_queue CommandQ
 	// TO DO: Implement efficient version of scan
 	// Make sure that the local prefix sum works before you start experimenting with large arrays
 
-	cl_int clErr;
-	size_t globalWorkSize[1];
-	size_t localWorkSize[1];
-
-	globalWorkSize[0] = CLUtil::GetGlobalWorkSize(m_N, LocalWorkSize[0]);
-	localWorkSize[0] = LocalWorkSize[0];
-	unsigned int globalSizeTemp = m_N / 2;
-
-	for (int i = 0; i < m_nLevels - 1; i++)
-	{
-		globalWorkSize[0] = globalSizeTemp;
-
-		//binding arguments
-		clErr = clSetKernelArg(m_ScanWorkEfficientKernel, 0, sizeof(cl_mem), (void*)&m_dLevelArrays[i]);
-		V_RETURN_CL(clErr, "Failed to set kernel input array argument");
-		clErr = clSetKernelArg(m_ScanWorkEfficientKernel, 1, sizeof(cl_mem), (void*)&m_dLevelArrays[i + 1]);
-		V_RETURN_CL(clErr, "Failed to set kernel higher Level array argument");
-		clErr = clSetKernelArg(m_ScanWorkEfficientKernel, 2, 4 * localWorkSize[0] * sizeof(cl_int), NULL);
-		V_RETURN_CL(clErr, "Error allocating shared memory");
+	// NOTE: the scan is done in place on m_dPingArray, the level arrays are held by m_WorkEfficientScan
+	m_WorkEfficientScan.Scan(CommandQueue, m_dPingArray, m_N, LocalWorkSize[0]);
+}
 
-		//launching kernel
-		clErr = clEnqueueNDRangeKernel(CommandQueue, m_ScanWorkEfficientKernel, 1, NULL, &globalWorkSize[0], localWorkSize, 0, NULL, NULL);
-		V_RETURN_CL(clErr, "Error Executing Kernel!");
+void CScanTask::Scan_NaiveLocal(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
+{
+	// the log2 steps run in local memory, so the global traffic is one pass per level instead of log2(N) passes
+	m_NaiveLocalScan.Scan(CommandQueue, m_dPingArray, m_N, LocalWorkSize[0]);
+}
 
-		globalSizeTemp = max(globalSizeTemp / (2 * m_MinLocalWorkSize), m_MinLocalWorkSize);
+void CScanTask::RunTask(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task)
+{
+	switch (Task){
+		case 0:
+			Scan_Naive(Context, CommandQueue, LocalWorkSize);
+			break;
+		case 1:
+			Scan_WorkEfficient(Context, CommandQueue, LocalWorkSize);
+			break;
+		case 2:
+			Scan_NaiveLocal(Context, CommandQueue, LocalWorkSize);
+			break;
+		case 3:
+		{
+			size_t tunedLocalWorkSize[3] = { m_TunedLocalWorkSize, 1, 1 };
+			Scan_WorkEfficient(Context, CommandQueue, tunedLocalWorkSize);
+			break;
+		}
 	}
+}
 
-	for (int i = m_nLevels - 1; i > 1; i--) 
+void CScanTask::Tune(cl_context Context, cl_command_queue CommandQueue)
+{
+	// the block scan has no compile-time parameters, only the local work size is searched
+	CAutoTuner tuner(m_Device);
+	tuner.SetElementsPerThread(vector<unsigned int>(1, 1));
+	tuner.SetVectorWidths(vector<unsigned int>(1, 1));
+	tuner.SetUnrollFactors(vector<unsigned int>(1, 1));
+	tuner.SetLocalWorkSizeRange(m_MinLocalWorkSize, 1024);
+
+	STuningConfig best;
+	bool bFound = tuner.Tune("Scan_WorkEfficient", m_N,
+		[&](const STuningConfig& Config) -> cl_kernel {
+			return m_WorkEfficientScan.GetBlockScanKernel();
+		},
+		[&](const STuningConfig& Config) -> bool {
+			size_t localWorkSize[3] = { Config.LocalWorkSize, 1, 1 };
+			return ValidateVariant(Context, CommandQueue, localWorkSize, 1);
+		},
+		[&](const STuningConfig& Config) {
+			size_t localWorkSize[3] = { Config.LocalWorkSize, 1, 1 };
+			Scan_WorkEfficient(Context, CommandQueue, localWorkSize);
+			V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
+		},
+		best);
+
+	if (bFound)
 	{
-		globalWorkSize[0] = m_N / max(1, (i - 2) * 2 * localWorkSize[0]);
-		
-		//binding arguments
-		clErr = clSetKernelArg(m_ScanWorkEfficientAddKernel, 0, sizeof(cl_mem), (void*)&m_dLevelArrays[i - 1]);
-		V_RETURN_CL(clErr, "Failed to set kernel input array argument");
-		clErr = clSetKernelArg(m_ScanWorkEfficientAddKernel, 1, sizeof(cl_mem), (void*)&m_dLevelArrays[i - 2]);
-		V_RETURN_CL(clErr, "Failed to set kernel higher Level array argument");
-		clErr = clSetKernelArg(m_ScanWorkEfficientAddKernel, 2, 4 * localWorkSize[0] * sizeof(cl_int), NULL);
-		V_RETURN_CL(clErr, "Error allocating shared memory");
-
-		//launching kernel
-		clErr = clEnqueueNDRangeKernel(CommandQueue, m_ScanWorkEfficientKernel, 1, NULL, &globalWorkSize[0], localWorkSize, 0, NULL, NULL);
-		V_RETURN_CL(clErr, "Error Executing Kernel!");
+		m_TunedLocalWorkSize = best.LocalWorkSize;
+		m_bTuned = true;
 	}
 }
 
@@ -279,9 +333,19 @@ void CScanTask::ValidateTask(cl_context Context, cl_command_queue CommandQueue,
 			V_RETURN_CL(clEnqueueReadBuffer(CommandQueue, m_dPingArray, CL_TRUE, 0, m_N * sizeof(cl_uint), m_hResultGPU, 0, NULL, NULL), "Error reading data from device!");
 			break;
 		case 1:
-			V_RETURN_CL(clEnqueueWriteBuffer(CommandQueue, m_dLevelArrays[0], CL_FALSE, 0, m_N * sizeof(cl_uint), m_hArray, 0, NULL, NULL), "Error copying data from host to device!");
+			V_RETURN_CL(clEnqueueWriteBuffer(CommandQueue, m_dPingArray, CL_FALSE, 0, m_N * sizeof(cl_uint), m_hArray, 0, NULL, NULL), "Error copying data from host to device!");
 			Scan_WorkEfficient(Context, CommandQueue, LocalWorkSize);
-			V_RETURN_CL(clEnqueueReadBuffer(CommandQueue, m_dLevelArrays[0], CL_TRUE, 0, m_N * sizeof(cl_uint), m_hResultGPU, 0, NULL, NULL), "Error reading data from device!");
+			V_RETURN_CL(clEnqueueReadBuffer(CommandQueue, m_dPingArray, CL_TRUE, 0, m_N * sizeof(cl_uint), m_hResultGPU, 0, NULL, NULL), "Error reading data from device!");
+			break;
+		case 2:
+			V_RETURN_CL(clEnqueueWriteBuffer(CommandQueue, m_dPingArray, CL_FALSE, 0, m_N * sizeof(cl_uint), m_hArray, 0, NULL, NULL), "Error copying data from host to device!");
+			Scan_NaiveLocal(Context, CommandQueue, LocalWorkSize);
+			V_RETURN_CL(clEnqueueReadBuffer(CommandQueue, m_dPingArray, CL_TRUE, 0, m_N * sizeof(cl_uint), m_hResultGPU, 0, NULL, NULL), "Error reading data from device!");
+			break;
+		case 3:
+			V_RETURN_CL(clEnqueueWriteBuffer(CommandQueue, m_dPingArray, CL_FALSE, 0, m_N * sizeof(cl_uint), m_hArray, 0, NULL, NULL), "Error copying data from host to device!");
+			RunTask(Context, CommandQueue, LocalWorkSize, 3);
+			V_RETURN_CL(clEnqueueReadBuffer(CommandQueue, m_dPingArray, CL_TRUE, 0, m_N * sizeof(cl_uint), m_hResultGPU, 0, NULL, NULL), "Error reading data from device!");
 			break;
 	}
 
@@ -298,6 +362,25 @@ void CScanTask::ValidateTask(cl_context Context, cl_command_queue CommandQueue,
 	m_bValidationResults[Task] =( memcmp(m_hResultCPU, m_hResultGPU, m_N * sizeof(unsigned int)) == 0);
 }
 
+const char* CScanTask::GetVariantName(unsigned int Task)
+{
+	return g_kernelNames[Task].c_str();
+}
+
+bool CScanTask::ValidateVariant(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task)
+{
+	ValidateTask(Context, CommandQueue, LocalWorkSize, Task);
+	return m_bValidationResults[Task];
+}
+
+CBenchmark::SResult CScanTask::BenchmarkVariant(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task, CBenchmark& Benchmark)
+{
+	return Benchmark.Run([&]() {
+		RunTask(Context, CommandQueue, LocalWorkSize, Task);
+		V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
+	});
+}
+
 void CScanTask::TestPerformance(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task)
 {
 	cout << "Testing performance of task " << g_kernelNames[Task] << endl;
@@ -307,30 +390,19 @@ void CScanTask::TestPerformance(cl_context Context, cl_command_queue CommandQueu
 	//finish all before we start meassuring the time
 	V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
 
-	CTimer timer;
-	timer.Start();
+	//run the task until the timing is stable, every iteration waits for the device
+	CBenchmark benchmark;
+	CBenchmark::SResult result = BenchmarkVariant(Context, CommandQueue, LocalWorkSize, Task, benchmark);
+	CBenchmark::Print(result, m_N, GetBytesPerElement() * m_N);
 
-	//run the kernel N times
-	unsigned int nIterations = 100;
-	for(unsigned int i = 0; i < nIterations; i++) {
-		//run selected task
-		switch (Task){
-			case 0:
-				Scan_Naive(Context, CommandQueue, LocalWorkSize);
-				break;
-			case 1:
-				Scan_WorkEfficient(Context, CommandQueue, LocalWorkSize);
-				break;
-		}
-	}
-
-	//wait until the command queue is empty again
+	// one more run with events, the device timestamps show how the time splits over the levels
+	m_Profiler.Enable(true);
+	RunTask(Context, CommandQueue, LocalWorkSize, Task);
+	m_Profiler.Enable(false);
 	V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
 
-	timer.Stop();
-
-	double ms = timer.GetElapsedMilliseconds() / double(nIterations);
-	cout << "  average time: " << ms << " ms, throughput: " << 1.0e-6 * (double)m_N / ms << " Gelem/s" <<endl;
+	m_Profiler.Report(cout);
+	m_Profiler.Clear();
 }
 
 
@@ -21,6 +21,11 @@
 #define _CSCAN_TASK_H
 
 #include "../Common/IComputeTask.h"
+#include "../Common/CBenchmark.h"
+#include "../Common/CPinnedHostMemory.h"
+#include "../Common/CTuningDatabase.h"
+
+#include "CScanHierarchy.h"
 
 //! A2 / T2 Parallel prefix sum (scan)
 class CScanTask : public IComputeTask
@@ -33,6 +38,10 @@ public:
 
 	// IComputeTask
 	virtual bool InitResources(cl_device_id Device, cl_context Context);
+
+	virtual void StartProgramBuilds(cl_device_id Device, cl_context Context);
+
+	virtual bool InitPrograms(cl_device_id Device, cl_context Context);
 	
 	virtual void ReleaseResources();
 
@@ -42,10 +51,36 @@ public:
 
 	virtual bool ValidateResults();
 
+	// parameter sweep, see CAssignment2::DoSweep
+
+	//! The tuned work-efficient scan (variant 3) chooses its own local work size and is not part of the sweep
+	static unsigned int GetVariantCount() { return 3; }
+	static const char* GetVariantName(unsigned int Task);
+
+	//! Any N, the level arrays were sized for MinLocalWorkSize
+	bool SupportsSize(size_t LocalWorkSize) const { return LocalWorkSize >= m_MinLocalWorkSize; }
+
+	//! Runs variant Task once and compares it with the result of ComputeCPU()
+	bool ValidateVariant(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task);
+
+	//! Times variant Task until Benchmark considers the timing stable
+	CBenchmark::SResult BenchmarkVariant(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task, CBenchmark& Benchmark);
+
+	//! The input is read once and the result written once
+	static size_t GetBytesPerElement() { return 2 * sizeof(cl_uint); }
+
 protected:
 
 	void Scan_Naive(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
 	void Scan_WorkEfficient(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
+	//! Hillis-Steele in local memory per block, the blocks are composed like in the work-efficient scan
+	void Scan_NaiveLocal(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
+
+	//! Searches the local work size of the work-efficient scan with CAutoTuner and stores it in the tuning database
+	void Tune(cl_context Context, cl_command_queue CommandQueue);
+
+	//! Enqueues the kernels of Task without synchronization
+	void RunTask(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task);
 
 	void ValidateTask(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task);
 	void TestPerformance(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task);
@@ -57,7 +92,15 @@ protected:
 
 	unsigned int		*m_hResultCPU;
 	unsigned int		*m_hResultGPU;
-	bool				m_bValidationResults[2];
+	// the arrays that are uploaded and downloaded are pinned
+	CPinnedHostMemory	m_PinnedArray;
+	CPinnedHostMemory	m_PinnedResultGPU;
+	bool				m_bValidationResults[4];
+
+	// all device arrays are sub-buffers of one arena allocation
+	CDeviceArena		m_Arena;
+	// region of the level arrays, shared by both hierarchies
+	unsigned int		m_LevelRegion;
 
 	// ping-pong arrays for the naive scan
 	cl_mem				m_dPingArray;
@@ -65,14 +108,20 @@ protected:
 
 	// arrays for each level of the work-efficient scan
 	size_t				m_MinLocalWorkSize;
-	unsigned int		m_nLevels;
-	cl_mem				*m_dLevelArrays;
+	CScanHierarchy		m_WorkEfficientScan;
+	CScanHierarchy		m_NaiveLocalScan;
 
 	//OpenCL program and kernels
 	cl_program			m_Program;
 	cl_kernel			m_ScanNaiveKernel;
-	cl_kernel			m_ScanWorkEfficientKernel;
-	cl_kernel			m_ScanWorkEfficientAddKernel;
+
+	// local work size of the tuned work-efficient scan, from the tuning database
+	cl_device_id		m_Device;
+	size_t				m_TunedLocalWorkSize;
+	bool				m_bTuned;
+
+	// records the kernel launches of the profiled run in TestPerformance, shared with both hierarchies
+	CEventProfiler		m_Profiler;
 };
 
 #endif // _CSCAN_TASK_H
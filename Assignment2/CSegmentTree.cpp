@@ -0,0 +1,145 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+
+#include "CSegmentTree.h"
+
+#include "../Common/CLUtil.h"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// CSegmentTree
+
+CSegmentTree::CSegmentTree(size_t N)
+	: m_N(N), m_nNodes(0), m_dTree(NULL), m_dLevelOffsets(NULL),
+	m_BuildLevelKernel(NULL), m_QueryKernel(NULL), m_UpdateValuesKernel(NULL), m_UpdateLevelKernel(NULL)
+{
+	// halve the level until a single node remains
+	size_t levelSize = N;
+	for (;;)
+	{
+		m_LevelOffsets.push_back((cl_uint)m_nNodes);
+		m_LevelSizes.push_back((cl_uint)levelSize);
+		m_nNodes += levelSize;
+
+		if (levelSize <= 1)
+			break;
+		levelSize = (levelSize + 1) / 2;
+	}
+}
+
+CSegmentTree::~CSegmentTree()
+{
+	ReleaseResources();
+}
+
+bool CSegmentTree::InitResources(cl_context Context, cl_program Program)
+{
+	cl_int clError, clError2;
+	m_dTree = clCreateBuffer(Context, CL_MEM_READ_WRITE, sizeof(cl_uint) * m_nNodes, NULL, &clError2);
+	clError = clError2;
+	m_dLevelOffsets = clCreateBuffer(Context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, sizeof(cl_uint) * m_LevelOffsets.size(), &m_LevelOffsets[0], &clError2);
+	clError |= clError2;
+	V_RETURN_FALSE_CL(clError, "Error allocating the segment tree");
+
+	m_BuildLevelKernel = clCreateKernel(Program, "Seg_BuildLevel", &clError);
+	V_RETURN_FALSE_CL(clError, "Failed to create kernel: Seg_BuildLevel.");
+
+	m_QueryKernel = clCreateKernel(Program, "Seg_Query", &clError);
+	V_RETURN_FALSE_CL(clError, "Failed to create kernel: Seg_Query.");
+
+	m_UpdateValuesKernel = clCreateKernel(Program, "Seg_UpdateValues", &clError);
+	V_RETURN_FALSE_CL(clError, "Failed to create kernel: Seg_UpdateValues.");
+
+	m_UpdateLevelKernel = clCreateKernel(Program, "Seg_UpdateLevel", &clError);
+	V_RETURN_FALSE_CL(clError, "Failed to create kernel: Seg_UpdateLevel.");
+
+	return true;
+}
+
+void CSegmentTree::ReleaseResources()
+{
+	SAFE_RELEASE_MEMOBJECT(m_dTree);
+	SAFE_RELEASE_MEMOBJECT(m_dLevelOffsets);
+
+	SAFE_RELEASE_KERNEL(m_BuildLevelKernel);
+	SAFE_RELEASE_KERNEL(m_QueryKernel);
+	SAFE_RELEASE_KERNEL(m_UpdateValuesKernel);
+	SAFE_RELEASE_KERNEL(m_UpdateLevelKernel);
+}
+
+void CSegmentTree::Build(cl_command_queue CommandQueue, cl_mem dValues, size_t LocalWorkSize)
+{
+	cl_int clErr;
+	size_t globalWorkSize[1];
+	size_t localWorkSize[1] = { LocalWorkSize };
+
+	V_RETURN_CL(clEnqueueCopyBuffer(CommandQueue, dValues, m_dTree, 0, 0, m_N * sizeof(cl_uint), 0, NULL, NULL), "Error copying the values into the segment tree!");
+
+	for (size_t level = 1; level < m_LevelSizes.size(); level++)
+	{
+		globalWorkSize[0] = CLUtil::GetGlobalWorkSize(m_LevelSizes[level], localWorkSize[0]);
+
+		clErr = clSetKernelArg(m_BuildLevelKernel, 0, sizeof(cl_mem), (void*)&m_dTree);
+		clErr |= clSetKernelArg(m_BuildLevelKernel, 1, sizeof(cl_uint), (void*)&m_LevelOffsets[level - 1]);
+		clErr |= clSetKernelArg(m_BuildLevelKernel, 2, sizeof(cl_uint), (void*)&m_LevelSizes[level - 1]);
+		clErr |= clSetKernelArg(m_BuildLevelKernel, 3, sizeof(cl_uint), (void*)&m_LevelOffsets[level]);
+		V_RETURN_CL(clErr, "Failed to set Seg_BuildLevel arguments");
+
+		clErr = clEnqueueNDRangeKernel(CommandQueue, m_BuildLevelKernel, 1, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+		V_RETURN_CL(clErr, "Error executing Seg_BuildLevel!");
+	}
+}
+
+void CSegmentTree::Query(cl_command_queue CommandQueue, cl_mem dQueries, cl_mem dResults, cl_uint nQueries, size_t LocalWorkSize)
+{
+	cl_int clErr;
+	size_t globalWorkSize[1] = { CLUtil::GetGlobalWorkSize(nQueries, LocalWorkSize) };
+	size_t localWorkSize[1] = { LocalWorkSize };
+
+	clErr = clSetKernelArg(m_QueryKernel, 0, sizeof(cl_mem), (void*)&m_dTree);
+	clErr |= clSetKernelArg(m_QueryKernel, 1, sizeof(cl_mem), (void*)&m_dLevelOffsets);
+	clErr |= clSetKernelArg(m_QueryKernel, 2, sizeof(cl_mem), (void*)&dQueries);
+	clErr |= clSetKernelArg(m_QueryKernel, 3, sizeof(cl_mem), (void*)&dResults);
+	clErr |= clSetKernelArg(m_QueryKernel, 4, sizeof(cl_uint), (void*)&nQueries);
+	V_RETURN_CL(clErr, "Failed to set Seg_Query arguments");
+
+	clErr = clEnqueueNDRangeKernel(CommandQueue, m_QueryKernel, 1, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+	V_RETURN_CL(clErr, "Error executing Seg_Query!");
+}
+
+void CSegmentTree::Update(cl_command_queue CommandQueue, cl_mem dUpdates, cl_uint nUpdates, size_t LocalWorkSize)
+{
+	cl_int clErr;
+	size_t globalWorkSize[1] = { CLUtil::GetGlobalWorkSize(nUpdates, LocalWorkSize) };
+	size_t localWorkSize[1] = { LocalWorkSize };
+
+	clErr = clSetKernelArg(m_UpdateValuesKernel, 0, sizeof(cl_mem), (void*)&m_dTree);
+	clErr |= clSetKernelArg(m_UpdateValuesKernel, 1, sizeof(cl_mem), (void*)&dUpdates);
+	clErr |= clSetKernelArg(m_UpdateValuesKernel, 2, sizeof(cl_uint), (void*)&nUpdates);
+	V_RETURN_CL(clErr, "Failed to set Seg_UpdateValues arguments");
+
+	clErr = clEnqueueNDRangeKernel(CommandQueue, m_UpdateValuesKernel, 1, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+	V_RETURN_CL(clErr, "Error executing Seg_UpdateValues!");
+
+	// one launch per level, each level only reads the completed level below
+	for (cl_uint level = 1; level < (cl_uint)m_LevelSizes.size(); level++)
+	{
+		clErr = clSetKernelArg(m_UpdateLevelKernel, 0, sizeof(cl_mem), (void*)&m_dTree);
+		clErr |= clSetKernelArg(m_UpdateLevelKernel, 1, sizeof(cl_mem), (void*)&dUpdates);
+		clErr |= clSetKernelArg(m_UpdateLevelKernel, 2, sizeof(cl_uint), (void*)&nUpdates);
+		clErr |= clSetKernelArg(m_UpdateLevelKernel, 3, sizeof(cl_uint), (void*)&level);
+		clErr |= clSetKernelArg(m_UpdateLevelKernel, 4, sizeof(cl_uint), (void*)&m_LevelOffsets[level - 1]);
+		clErr |= clSetKernelArg(m_UpdateLevelKernel, 5, sizeof(cl_uint), (void*)&m_LevelSizes[level - 1]);
+		clErr |= clSetKernelArg(m_UpdateLevelKernel, 6, sizeof(cl_uint), (void*)&m_LevelOffsets[level]);
+		V_RETURN_CL(clErr, "Failed to set Seg_UpdateLevel arguments");
+
+		clErr = clEnqueueNDRangeKernel(CommandQueue, m_UpdateLevelKernel, 1, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+		V_RETURN_CL(clErr, "Error executing Seg_UpdateLevel!");
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
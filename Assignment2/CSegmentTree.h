@@ -0,0 +1,86 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CSEGMENT_TREE_H
+#define _CSEGMENT_TREE_H
+
+#include "../Common/IComputeTask.h"
+
+#include <vector>
+
+//! Operators of the segment tree, the values match SEG_OP in SegmentTree.cl
+enum ESegmentTreeOp
+{
+	SEGMENT_TREE_SUM = 0,
+	SEGMENT_TREE_MIN = 1,
+	SEGMENT_TREE_MAX = 2
+};
+
+//! Persistent device index for range queries with point updates
+/*!
+	Keeps all levels of a pairwise reduction of the values (a segment tree) in one device buffer,
+	instead of discarding the partials like the reduction does.
+	- Query(): a batch of range queries [l, r) in one kernel launch, O(log N) nodes per query
+	- Update(): a batch of point updates, O(log N) nodes per update (one launch per level)
+
+	The operator (sum, min or max) is selected when the program is built from SegmentTree.cl
+	with -D SEG_OP=SEG_OP_SUM|SEG_OP_MIN|SEG_OP_MAX.
+*/
+class CSegmentTree
+{
+public:
+	CSegmentTree(size_t N);
+
+	virtual ~CSegmentTree();
+
+	bool InitResources(cl_context Context, cl_program Program);
+
+	void ReleaseResources();
+
+	//! Builds the index from the N values in dValues
+	void Build(cl_command_queue CommandQueue, cl_mem dValues, size_t LocalWorkSize);
+
+	//! dQueries holds nQueries cl_uint2 (l, r), dResults receives one cl_uint per query
+	void Query(cl_command_queue CommandQueue, cl_mem dQueries, cl_mem dResults, cl_uint nQueries, size_t LocalWorkSize);
+
+	//! dUpdates holds nUpdates cl_uint2 (index, value), the indices of a batch have to be unique
+	void Update(cl_command_queue CommandQueue, cl_mem dUpdates, cl_uint nUpdates, size_t LocalWorkSize);
+
+	//! Total number of nodes, including the values
+	size_t GetNumNodes() const { return m_nNodes; }
+
+protected:
+
+	size_t					m_N;
+	size_t					m_nNodes;
+
+	// offset and size of every level in m_dTree, level 0 are the values
+	std::vector<cl_uint>	m_LevelOffsets;
+	std::vector<cl_uint>	m_LevelSizes;
+
+	cl_mem					m_dTree;
+	cl_mem					m_dLevelOffsets;
+
+	cl_kernel				m_BuildLevelKernel;
+	cl_kernel				m_QueryKernel;
+	cl_kernel				m_UpdateValuesKernel;
+	cl_kernel				m_UpdateLevelKernel;
+};
+
+#endif // _CSEGMENT_TREE_H
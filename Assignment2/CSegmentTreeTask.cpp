@@ -0,0 +1,283 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+
+#include "CSegmentTreeTask.h"
+
+#include "../Common/CLUtil.h"
+#include "../Common/CProgramBuilder.h"
+#include "../Common/CTimer.h"
+
+#include <stdlib.h>
+#include <sstream>
+
+using namespace std;
+
+// block size of the CPU reference
+#define CPU_BLOCK_SIZE	1024
+
+///////////////////////////////////////////////////////////////////////////////
+// CSegmentTreeTask
+
+// only useful for debug info
+static const string g_SegmentTreeOpNames[3] = { "sum", "min", "max" };
+
+static cl_uint Random32()
+{
+	return ((cl_uint)rand() << 16) ^ (cl_uint)rand();
+}
+
+CSegmentTreeTask::CSegmentTreeTask(size_t ArraySize, size_t nQueries, size_t nUpdates, ESegmentTreeOp Op)
+	: m_N(ArraySize), m_nQueries((cl_uint)nQueries), m_nUpdates((cl_uint)nUpdates), m_Op(Op),
+	m_nCheckedQueries(min(nQueries, (size_t)16384)),
+	m_bValidationResult(false),
+	m_dValues(NULL), m_dQueries(NULL), m_dUpdates(NULL), m_dResults(NULL),
+	m_Tree(ArraySize), m_Program(NULL)
+{
+}
+
+CSegmentTreeTask::~CSegmentTreeTask()
+{
+	ReleaseResources();
+}
+
+bool CSegmentTreeTask::InitResources(cl_device_id Device, cl_context Context)
+{
+	//CPU resources
+	m_hValues.resize(m_N);
+	m_hQueries.resize(m_nQueries);
+	m_hUpdates.resize(m_nUpdates);
+	m_hResultsGPU.resize(m_nQueries);
+
+	for (size_t i = 0; i < m_N; i++)
+		m_hValues[i] = rand() & 0xffff;
+
+	// random non-empty ranges [l, r)
+	for (cl_uint i = 0; i < m_nQueries; i++) {
+		cl_uint l = Random32() % m_N;
+		m_hQueries[i].s[0] = l;
+		m_hQueries[i].s[1] = l + 1 + Random32() % (cl_uint)(m_N - l);
+	}
+
+	// updates of unique random positions
+	vector<bool> updated(m_N, false);
+	for (cl_uint i = 0; i < m_nUpdates; i++) {
+		cl_uint index;
+		do {
+			index = Random32() % m_N;
+		} while (updated[index]);
+		updated[index] = true;
+
+		m_hUpdates[i].s[0] = index;
+		m_hUpdates[i].s[1] = rand() & 0xffff;
+	}
+
+	//device resources
+	cl_int clError, clError2;
+	m_dValues = clCreateBuffer(Context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, sizeof(cl_uint) * m_N, &m_hValues[0], &clError2);
+	clError = clError2;
+	m_dQueries = clCreateBuffer(Context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, sizeof(cl_uint2) * m_nQueries, &m_hQueries[0], &clError2);
+	clError |= clError2;
+	m_dUpdates = clCreateBuffer(Context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, sizeof(cl_uint2) * m_nUpdates, &m_hUpdates[0], &clError2);
+	clError |= clError2;
+	m_dResults = clCreateBuffer(Context, CL_MEM_WRITE_ONLY, sizeof(cl_uint) * m_nQueries, NULL, &clError2);
+	clError |= clError2;
+	V_RETURN_FALSE_CL(clError, "Error allocating device arrays");
+
+	return true;
+}
+
+bool CSegmentTreeTask::InitPrograms(cl_device_id Device, cl_context Context)
+{
+	//load and compile kernels
+	string programCode;
+
+	if (!CLUtil::LoadProgramSourceToMemory("SegmentTree.cl", programCode))
+		return false;
+
+	m_Program = CLUtil::BuildCLProgramFromMemory(Device, Context, programCode, GetCompileOptions());
+	if(m_Program == nullptr) return false;
+
+	if (!m_Tree.InitResources(Context, m_Program))
+		return false;
+
+	return true;
+}
+
+string CSegmentTreeTask::GetCompileOptions() const
+{
+	stringstream compileOptions;
+	compileOptions << "-D SEG_OP=" << (int)m_Op;
+
+	return compileOptions.str();
+}
+
+void CSegmentTreeTask::StartProgramBuilds(cl_device_id Device, cl_context Context)
+{
+	string programCode;
+
+	if (CLUtil::LoadProgramSourceToMemory("SegmentTree.cl", programCode))
+		CProgramBuilder::BuildAsync(Device, Context, programCode, GetCompileOptions());
+}
+
+void CSegmentTreeTask::ReleaseResources()
+{
+	// host resources
+	m_hValues.clear();
+	m_hQueries.clear();
+	m_hUpdates.clear();
+	m_hResultsCPU[0].clear();
+	m_hResultsCPU[1].clear();
+	m_hResultsGPU.clear();
+
+	// device resources
+	SAFE_RELEASE_MEMOBJECT(m_dValues);
+	SAFE_RELEASE_MEMOBJECT(m_dQueries);
+	SAFE_RELEASE_MEMOBJECT(m_dUpdates);
+	SAFE_RELEASE_MEMOBJECT(m_dResults);
+
+	m_Tree.ReleaseResources();
+
+	SAFE_RELEASE_PROGRAM(m_Program);
+}
+
+void CSegmentTreeTask::ComputeGPU(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
+{
+	cout << endl;
+
+	ValidateTask(Context, CommandQueue, LocalWorkSize);
+
+	cout << endl;
+
+	TestPerformance(Context, CommandQueue, LocalWorkSize);
+
+	cout << endl;
+}
+
+cl_uint CSegmentTreeTask::Combine(cl_uint A, cl_uint B) const
+{
+	switch (m_Op) {
+		case SEGMENT_TREE_MIN: return min(A, B);
+		case SEGMENT_TREE_MAX: return max(A, B);
+		default: return A + B;
+	}
+}
+
+void CSegmentTreeTask::QueryCPU(const vector<cl_uint>& Values, vector<cl_uint>& Results) const
+{
+	cl_uint identity = (m_Op == SEGMENT_TREE_MIN) ? 0xffffffffu : 0;
+
+	// aggregate of every block, full blocks inside a range are taken from here
+	size_t nBlocks = (m_N + CPU_BLOCK_SIZE - 1) / CPU_BLOCK_SIZE;
+	vector<cl_uint> blocks(nBlocks, identity);
+	for (size_t i = 0; i < m_N; i++)
+		blocks[i / CPU_BLOCK_SIZE] = Combine(blocks[i / CPU_BLOCK_SIZE], Values[i]);
+
+	Results.resize(m_nCheckedQueries);
+	for (size_t q = 0; q < m_nCheckedQueries; q++) {
+		size_t l = m_hQueries[q].s[0];
+		size_t r = m_hQueries[q].s[1];
+
+		cl_uint result = identity;
+		while (l < r && l % CPU_BLOCK_SIZE != 0)
+			result = Combine(result, Values[l++]);
+		while (l + CPU_BLOCK_SIZE <= r) {
+			result = Combine(result, blocks[l / CPU_BLOCK_SIZE]);
+			l += CPU_BLOCK_SIZE;
+		}
+		while (l < r)
+			result = Combine(result, Values[l++]);
+
+		Results[q] = result;
+	}
+}
+
+void CSegmentTreeTask::ComputeCPU()
+{
+	CTimer timer;
+	timer.Start();
+
+	// the queries before and after the updates
+	QueryCPU(m_hValues, m_hResultsCPU[0]);
+
+	vector<cl_uint> updatedValues(m_hValues);
+	for (cl_uint i = 0; i < m_nUpdates; i++)
+		updatedValues[m_hUpdates[i].s[0]] = m_hUpdates[i].s[1];
+	QueryCPU(updatedValues, m_hResultsCPU[1]);
+
+	timer.Stop();
+	double ms = timer.GetElapsedMilliseconds();
+	cout << "  average time: " << ms << " ms for " << m_nCheckedQueries << " queries before and after the updates" << endl;
+}
+
+bool CSegmentTreeTask::ValidateResults()
+{
+	if (!m_bValidationResult)
+		cout << "Validation of segment tree (" << g_SegmentTreeOpNames[m_Op] << ") failed." << endl;
+
+	return m_bValidationResult;
+}
+
+void CSegmentTreeTask::ValidateTask(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
+{
+	m_bValidationResult = false;
+
+	m_Tree.Build(CommandQueue, m_dValues, LocalWorkSize[0]);
+
+	for (int pass = 0; pass < 2; pass++)
+	{
+		// the second pass checks the queries after the updates
+		if (pass == 1)
+			m_Tree.Update(CommandQueue, m_dUpdates, m_nUpdates, LocalWorkSize[0]);
+
+		m_Tree.Query(CommandQueue, m_dQueries, m_dResults, m_nQueries, LocalWorkSize[0]);
+		V_RETURN_CL(clEnqueueReadBuffer(CommandQueue, m_dResults, CL_TRUE, 0, m_nCheckedQueries * sizeof(cl_uint), &m_hResultsGPU[0], 0, NULL, NULL), "Error reading data from device!");
+
+		for (size_t q = 0; q < m_nCheckedQueries; q++)
+			if (m_hResultsGPU[q] != m_hResultsCPU[pass][q])
+			{
+				cout << "  query " << q << (pass ? " after" : " before") << " the updates: GPU " << m_hResultsGPU[q] << ", CPU " << m_hResultsCPU[pass][q] << endl;
+				return;
+			}
+	}
+
+	m_bValidationResult = true;
+}
+
+void CSegmentTreeTask::TestPerformance(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
+{
+	cout << "Testing performance of segment tree (" << g_SegmentTreeOpNames[m_Op] << "), " << m_N << " values, "
+		<< m_nQueries << " queries, " << m_nUpdates << " updates per batch" << endl;
+
+	//finish all before we start meassuring the time
+	V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
+
+	unsigned int nIterations = 100;
+	CTimer timer;
+
+	// 0: rebuild, 1: query batch, 2: update batch
+	const char* names[3] = { "rebuild", "query batch", "update batch" };
+	for (int op = 0; op < 3; op++)
+	{
+		timer.Start();
+		for(unsigned int i = 0; i < nIterations; i++) {
+			switch (op) {
+				case 0: m_Tree.Build(CommandQueue, m_dValues, LocalWorkSize[0]); break;
+				case 1: m_Tree.Query(CommandQueue, m_dQueries, m_dResults, m_nQueries, LocalWorkSize[0]); break;
+				case 2: m_Tree.Update(CommandQueue, m_dUpdates, m_nUpdates, LocalWorkSize[0]); break;
+			}
+		}
+		V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
+		timer.Stop();
+
+		double ms = timer.GetElapsedMilliseconds() / double(nIterations);
+		cout << "  " << names[op] << ": average time " << ms << " ms";
+		if (op == 1) cout << ", " << 1.0e-6 * m_nQueries / ms << " Gqueries/s";
+		if (op == 2) cout << ", " << 1.0e-6 * m_nUpdates / ms << " Gupdates/s";
+		cout << endl;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
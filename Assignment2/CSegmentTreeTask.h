@@ -0,0 +1,98 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CSEGMENT_TREE_TASK_H
+#define _CSEGMENT_TREE_TASK_H
+
+#include "../Common/IComputeTask.h"
+
+#include "CSegmentTree.h"
+
+#include <string>
+#include <vector>
+
+//! Batched range queries and point updates on a CSegmentTree
+/*!
+	Builds the index, answers a batch of random range queries, applies a batch of point
+	updates and answers the queries again. The performance test compares one query batch
+	and one update batch with rebuilding the whole index.
+*/
+class CSegmentTreeTask : public IComputeTask
+{
+public:
+	CSegmentTreeTask(size_t ArraySize, size_t nQueries, size_t nUpdates, ESegmentTreeOp Op);
+
+	virtual ~CSegmentTreeTask();
+
+	// IComputeTask
+	virtual bool InitResources(cl_device_id Device, cl_context Context);
+
+	virtual void StartProgramBuilds(cl_device_id Device, cl_context Context);
+
+	virtual bool InitPrograms(cl_device_id Device, cl_context Context);
+
+	virtual void ReleaseResources();
+
+	virtual void ComputeGPU(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
+
+	virtual void ComputeCPU();
+
+	virtual bool ValidateResults();
+
+protected:
+
+	//! Program options selecting the tree operator
+	std::string GetCompileOptions() const;
+
+	//! Answers the first m_nCheckedQueries queries on Values on the CPU
+	void QueryCPU(const std::vector<cl_uint>& Values, std::vector<cl_uint>& Results) const;
+
+	cl_uint Combine(cl_uint A, cl_uint B) const;
+
+	void ValidateTask(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
+	void TestPerformance(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
+
+	size_t					m_N;
+	cl_uint					m_nQueries;
+	cl_uint					m_nUpdates;
+	ESegmentTreeOp			m_Op;
+
+	// the CPU reference only checks the first queries, a brute-force answer is expensive
+	size_t					m_nCheckedQueries;
+
+	std::vector<cl_uint>	m_hValues;
+	std::vector<cl_uint2>	m_hQueries;
+	std::vector<cl_uint2>	m_hUpdates;
+
+	std::vector<cl_uint>	m_hResultsCPU[2];
+	std::vector<cl_uint>	m_hResultsGPU;
+	bool					m_bValidationResult;
+
+	cl_mem					m_dValues;
+	cl_mem					m_dQueries;
+	cl_mem					m_dUpdates;
+	cl_mem					m_dResults;
+
+	CSegmentTree			m_Tree;
+
+	//OpenCL program, the kernels are owned by m_Tree
+	cl_program				m_Program;
+};
+
+#endif // _CSEGMENT_TREE_TASK_H
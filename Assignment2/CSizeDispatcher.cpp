@@ -0,0 +1,364 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+
+#include "CSizeDispatcher.h"
+
+#include "../Common/CLUtil.h"
+#include "../Common/CKeyValueFile.h"
+#include "../Common/CProgramBuilder.h"
+#include "../Common/CTimer.h"
+
+#include <stdlib.h>
+#include <sstream>
+
+using namespace std;
+
+// work-groups of the first pass of the multi-pass reduction
+#define REDUCTION_GROUPS	256
+// smallest size that is measured
+#define MIN_CALIBRATION_SIZE	64
+
+///////////////////////////////////////////////////////////////////////////////
+// CSizeDispatcher
+
+CSizeDispatcher::CSizeDispatcher(size_t MaxElements, size_t LocalWorkSize, const string& CalibrationFile)
+	: m_MaxElements(MaxElements), m_LocalWorkSize(LocalWorkSize), m_CalibrationFile(CalibrationFile),
+	m_bCalibrated(false), m_hScratch(NULL), m_dArray(NULL), m_dPartials(NULL), m_dResult(NULL),
+	m_Scan(MaxElements, LocalWorkSize), m_Program(NULL), m_ScanRowsKernel(NULL), m_ReduceKernel(NULL)
+{
+	// until calibrated, everything runs on the multi-pass path
+	for (int op = 0; op < DISPATCH_OP_COUNT; op++)
+		m_Crossovers[op][0] = m_Crossovers[op][1] = 0;
+}
+
+CSizeDispatcher::~CSizeDispatcher()
+{
+	ReleaseResources();
+}
+
+bool CSizeDispatcher::InitResources(cl_device_id Device, cl_context Context)
+{
+	//the device name, driver and work-group size identify the calibration
+	char name[256] = "", driver[256] = "";
+	clGetDeviceInfo(Device, CL_DEVICE_NAME, sizeof(name) - 1, name, NULL);
+	clGetDeviceInfo(Device, CL_DRIVER_VERSION, sizeof(driver) - 1, driver, NULL);
+
+	stringstream key;
+	key << name << " / " << driver << " / " << m_LocalWorkSize;
+	m_DeviceKey = key.str();
+
+	//CPU resources
+	m_hScratch = new cl_uint[m_MaxElements];
+	for (size_t i = 0; i < m_MaxElements; i++)
+		m_hScratch[i] = rand() & 15;
+
+	//device resources
+	cl_int clError, clError2;
+	m_dArray = clCreateBuffer(Context, CL_MEM_READ_WRITE, sizeof(cl_uint) * m_MaxElements, NULL, &clError2);
+	clError = clError2;
+	m_dPartials = clCreateBuffer(Context, CL_MEM_READ_WRITE, sizeof(cl_uint) * REDUCTION_GROUPS, NULL, &clError2);
+	clError |= clError2;
+	m_dResult = clCreateBuffer(Context, CL_MEM_READ_WRITE, sizeof(cl_uint), NULL, &clError2);
+	clError |= clError2;
+	V_RETURN_FALSE_CL(clError, "Error allocating device arrays");
+
+	return true;
+}
+
+bool CSizeDispatcher::InitPrograms(cl_device_id Device, cl_context Context)
+{
+	cl_int clError;
+
+	//load and compile kernels
+	string scanCode, streamingCode;
+
+	if (!CLUtil::LoadProgramSourceToMemory("Scan.cl", scanCode) ||
+		!CLUtil::LoadProgramSourceToMemory("Streaming.cl", streamingCode))
+		return false;
+
+	m_Program = CLUtil::BuildCLProgramFromMemory(Device, Context, scanCode + "\n" + streamingCode);
+	if(m_Program == nullptr) return false;
+
+	//create kernels
+	m_ScanRowsKernel = clCreateKernel(m_Program, "Scan_WorkEfficientRows", &clError);
+	V_RETURN_FALSE_CL(clError, "Failed to create kernel: Scan_WorkEfficientRows.");
+
+	m_ReduceKernel = clCreateKernel(m_Program, "Stream_ReduceChunk", &clError);
+	V_RETURN_FALSE_CL(clError, "Failed to create kernel: Stream_ReduceChunk.");
+
+	if (!m_Scan.InitResources(Context, m_Program))
+		return false;
+
+	return true;
+}
+
+void CSizeDispatcher::StartProgramBuilds(cl_device_id Device, cl_context Context)
+{
+	string scanCode, streamingCode;
+
+	if (CLUtil::LoadProgramSourceToMemory("Scan.cl", scanCode) &&
+		CLUtil::LoadProgramSourceToMemory("Streaming.cl", streamingCode))
+		CProgramBuilder::BuildAsync(Device, Context, scanCode + "\n" + streamingCode);
+}
+
+void CSizeDispatcher::ReleaseResources()
+{
+	// host resources
+	SAFE_DELETE_ARRAY(m_hScratch);
+
+	// device resources
+	SAFE_RELEASE_MEMOBJECT(m_dArray);
+	SAFE_RELEASE_MEMOBJECT(m_dPartials);
+	SAFE_RELEASE_MEMOBJECT(m_dResult);
+
+	m_Scan.ReleaseResources();
+
+	SAFE_RELEASE_KERNEL(m_ScanRowsKernel);
+	SAFE_RELEASE_KERNEL(m_ReduceKernel);
+
+	SAFE_RELEASE_PROGRAM(m_Program);
+}
+
+const char* CSizeDispatcher::GetPathName(EDispatchPath Path)
+{
+	static const char* names[DISPATCH_PATH_COUNT] = { "host", "single work-group", "multi-pass" };
+	return names[Path];
+}
+
+EDispatchPath CSizeDispatcher::SelectPath(EDispatchOp Op, size_t N) const
+{
+	if (N < m_Crossovers[Op][0])
+		return DISPATCH_HOST;
+	if (N < m_Crossovers[Op][1])
+		return DISPATCH_SINGLE_GROUP;
+	return DISPATCH_MULTI_PASS;
+}
+
+void CSizeDispatcher::Scan(cl_command_queue CommandQueue, const cl_uint* hInput, cl_uint* hOutput, size_t N)
+{
+	Scan(CommandQueue, hInput, hOutput, N, SelectPath(DISPATCH_SCAN, N));
+}
+
+cl_uint CSizeDispatcher::Reduce(cl_command_queue CommandQueue, const cl_uint* hInput, size_t N)
+{
+	return Reduce(CommandQueue, hInput, N, SelectPath(DISPATCH_REDUCE, N));
+}
+
+void CSizeDispatcher::Scan(cl_command_queue CommandQueue, const cl_uint* hInput, cl_uint* hOutput, size_t N, EDispatchPath Path)
+{
+	if (N == 0)
+		return;
+
+	if (Path == DISPATCH_HOST)
+	{
+		cl_uint sum = 0;
+		for (size_t i = 0; i < N; i++) {
+			sum += hInput[i];
+			hOutput[i] = sum;
+		}
+		return;
+	}
+
+	V_RETURN_CL(clEnqueueWriteBuffer(CommandQueue, m_dArray, CL_FALSE, 0, N * sizeof(cl_uint), hInput, 0, NULL, NULL), "Error copying data from host to device!");
+
+	if (Path == DISPATCH_SINGLE_GROUP)
+	{
+		// one row of N elements
+		cl_int clErr;
+		cl_uint width = (cl_uint)N;
+		size_t localWorkSize[2] = { m_LocalWorkSize, 1 };
+		size_t globalWorkSize[2] = { m_LocalWorkSize, 1 };
+
+		clErr = clSetKernelArg(m_ScanRowsKernel, 0, sizeof(cl_mem), (void*)&m_dArray);
+		clErr |= clSetKernelArg(m_ScanRowsKernel, 1, sizeof(cl_mem), (void*)&m_dArray);
+		clErr |= clSetKernelArg(m_ScanRowsKernel, 2, sizeof(cl_uint), (void*)&width);
+		clErr |= clSetKernelArg(m_ScanRowsKernel, 3, 4 * m_LocalWorkSize * sizeof(cl_uint), NULL);
+		V_RETURN_CL(clErr, "Failed to set Scan_WorkEfficientRows arguments");
+
+		clErr = clEnqueueNDRangeKernel(CommandQueue, m_ScanRowsKernel, 2, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+		V_RETURN_CL(clErr, "Error executing Scan_WorkEfficientRows!");
+	}
+	else
+	{
+		m_Scan.Scan(CommandQueue, m_dArray, N, m_LocalWorkSize);
+	}
+
+	V_RETURN_CL(clEnqueueReadBuffer(CommandQueue, m_dArray, CL_TRUE, 0, N * sizeof(cl_uint), hOutput, 0, NULL, NULL), "Error reading data from device!");
+}
+
+void CSizeDispatcher::EnqueueReduce(cl_command_queue CommandQueue, cl_mem dArray, size_t N, cl_mem dPartials, size_t nGroups)
+{
+	cl_int clErr;
+	cl_uint n = (cl_uint)N;
+	cl_uint partialOffset = 0;
+	size_t localWorkSize[1] = { m_LocalWorkSize };
+	size_t globalWorkSize[1] = { nGroups * m_LocalWorkSize };
+
+	clErr = clSetKernelArg(m_ReduceKernel, 0, sizeof(cl_mem), (void*)&dArray);
+	clErr |= clSetKernelArg(m_ReduceKernel, 1, sizeof(cl_uint), (void*)&n);
+	clErr |= clSetKernelArg(m_ReduceKernel, 2, sizeof(cl_mem), (void*)&dPartials);
+	clErr |= clSetKernelArg(m_ReduceKernel, 3, sizeof(cl_uint), (void*)&partialOffset);
+	clErr |= clSetKernelArg(m_ReduceKernel, 4, m_LocalWorkSize * sizeof(cl_uint), NULL);
+	V_RETURN_CL(clErr, "Failed to set Stream_ReduceChunk arguments");
+
+	clErr = clEnqueueNDRangeKernel(CommandQueue, m_ReduceKernel, 1, NULL, globalWorkSize, localWorkSize, 0, NULL, NULL);
+	V_RETURN_CL(clErr, "Error executing Stream_ReduceChunk!");
+}
+
+cl_uint CSizeDispatcher::Reduce(cl_command_queue CommandQueue, const cl_uint* hInput, size_t N, EDispatchPath Path)
+{
+	if (Path == DISPATCH_HOST)
+	{
+		// independent sums, so the compiler can vectorize the loop
+		cl_uint sums[4] = { 0, 0, 0, 0 };
+		size_t i = 0;
+		for (; i + 4 <= N; i += 4) {
+			sums[0] += hInput[i];
+			sums[1] += hInput[i + 1];
+			sums[2] += hInput[i + 2];
+			sums[3] += hInput[i + 3];
+		}
+		for (; i < N; i++)
+			sums[0] += hInput[i];
+		return sums[0] + sums[1] + sums[2] + sums[3];
+	}
+
+	if (N == 0)
+		return 0;
+
+	V_RETURN_0_CL(clEnqueueWriteBuffer(CommandQueue, m_dArray, CL_FALSE, 0, N * sizeof(cl_uint), hInput, 0, NULL, NULL), "Error copying data from host to device!");
+
+	if (Path == DISPATCH_SINGLE_GROUP)
+	{
+		EnqueueReduce(CommandQueue, m_dArray, N, m_dResult, 1);
+	}
+	else
+	{
+		size_t nGroups = min((size_t)REDUCTION_GROUPS, (N + m_LocalWorkSize - 1) / m_LocalWorkSize);
+		EnqueueReduce(CommandQueue, m_dArray, N, m_dPartials, nGroups);
+		EnqueueReduce(CommandQueue, m_dPartials, nGroups, m_dResult, 1);
+	}
+
+	cl_uint result = 0;
+	V_RETURN_0_CL(clEnqueueReadBuffer(CommandQueue, m_dResult, CL_TRUE, 0, sizeof(cl_uint), &result, 0, NULL, NULL), "Error reading data from device!");
+
+	return result;
+}
+
+double CSizeDispatcher::Measure(cl_command_queue CommandQueue, EDispatchOp Op, size_t N, EDispatchPath Path)
+{
+	// enough calls to be above the timer resolution, the scan works in place on the scratch array
+	unsigned int nIterations = (unsigned int)max((size_t)3, min((size_t)200, ((size_t)1 << 20) / N));
+
+	// warm up
+	if (Op == DISPATCH_SCAN)
+		Scan(CommandQueue, m_hScratch, m_hScratch, N, Path);
+	else
+		Reduce(CommandQueue, m_hScratch, N, Path);
+
+	CTimer timer;
+	timer.Start();
+
+	// every call returns with its result on the host
+	for (unsigned int i = 0; i < nIterations; i++)
+	{
+		if (Op == DISPATCH_SCAN)
+			Scan(CommandQueue, m_hScratch, m_hScratch, N, Path);
+		else
+			Reduce(CommandQueue, m_hScratch, N, Path);
+	}
+
+	timer.Stop();
+
+	return timer.GetElapsedMilliseconds() / double(nIterations);
+}
+
+void CSizeDispatcher::Calibrate(cl_command_queue CommandQueue, bool Force)
+{
+	const char* opNames[DISPATCH_OP_COUNT] = { "scan", "reduction" };
+
+	if (!Force && LoadCalibration())
+	{
+		for (int op = 0; op < DISPATCH_OP_COUNT; op++)
+			cout << "Loaded " << opNames[op] << " crossovers from " << m_CalibrationFile << ": host below " << m_Crossovers[op][0]
+				<< ", single work-group below " << m_Crossovers[op][1] << endl;
+		return;
+	}
+
+	for (int op = 0; op < DISPATCH_OP_COUNT; op++)
+	{
+		EDispatchOp dispatchOp = (EDispatchOp)op;
+
+		// the crossovers are the first measured sizes at which the smaller path is slower,
+		// a path that never loses is used up to the maximum size
+		size_t crossovers[2] = { m_MaxElements + 1, m_MaxElements + 1 };
+		bool bFound[2] = { false, false };
+
+		for (size_t N = MIN_CALIBRATION_SIZE; N <= m_MaxElements && !(bFound[0] && bFound[1]); N *= 2)
+		{
+			double ms[DISPATCH_PATH_COUNT];
+			ms[DISPATCH_MULTI_PASS] = Measure(CommandQueue, dispatchOp, N, DISPATCH_MULTI_PASS);
+			ms[DISPATCH_SINGLE_GROUP] = bFound[1] ? ms[DISPATCH_MULTI_PASS] : Measure(CommandQueue, dispatchOp, N, DISPATCH_SINGLE_GROUP);
+			ms[DISPATCH_HOST] = bFound[0] ? 0.0 : Measure(CommandQueue, dispatchOp, N, DISPATCH_HOST);
+
+			if (!bFound[0] && ms[DISPATCH_HOST] > min(ms[DISPATCH_SINGLE_GROUP], ms[DISPATCH_MULTI_PASS]))
+			{
+				crossovers[0] = N;
+				bFound[0] = true;
+			}
+			if (!bFound[1] && ms[DISPATCH_SINGLE_GROUP] > ms[DISPATCH_MULTI_PASS])
+			{
+				crossovers[1] = N;
+				bFound[1] = true;
+			}
+		}
+
+		m_Crossovers[op][0] = crossovers[0];
+		m_Crossovers[op][1] = max(crossovers[0], crossovers[1]);
+
+		cout << "Calibrated " << opNames[op] << " crossovers: host below " << m_Crossovers[op][0]
+			<< ", single work-group below " << m_Crossovers[op][1] << endl;
+	}
+
+	m_bCalibrated = true;
+	SaveCalibration();
+}
+
+bool CSizeDispatcher::LoadCalibration()
+{
+	string value;
+	if (!CKeyValueFile(m_CalibrationFile).Load(m_DeviceKey, value))
+		return false;
+
+	// the crossovers of all operations separated by tabs
+	size_t crossovers[DISPATCH_OP_COUNT][2];
+	stringstream values(value);
+	for (int op = 0; op < DISPATCH_OP_COUNT; op++)
+		values >> crossovers[op][0] >> crossovers[op][1];
+
+	if (values.fail())
+		return false;
+
+	for (int op = 0; op < DISPATCH_OP_COUNT; op++)
+	{
+		m_Crossovers[op][0] = crossovers[op][0];
+		m_Crossovers[op][1] = crossovers[op][1];
+	}
+	m_bCalibrated = true;
+	return true;
+}
+
+void CSizeDispatcher::SaveCalibration() const
+{
+	stringstream value;
+	for (int op = 0; op < DISPATCH_OP_COUNT; op++)
+		value << (op > 0 ? "\t" : "") << m_Crossovers[op][0] << '\t' << m_Crossovers[op][1];
+
+	if (!CKeyValueFile(m_CalibrationFile).Store(m_DeviceKey, value.str()))
+		cerr << "Could not write the dispatcher calibration to " << m_CalibrationFile << endl;
+}
+
+///////////////////////////////////////////////////////////////////////////////
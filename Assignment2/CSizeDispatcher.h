@@ -0,0 +1,129 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CSIZE_DISPATCHER_H
+#define _CSIZE_DISPATCHER_H
+
+#include "../Common/IComputeTask.h"
+
+#include "CScanHierarchy.h"
+
+#include <string>
+
+//! Operations of CSizeDispatcher
+enum EDispatchOp
+{
+	DISPATCH_SCAN = 0,
+	DISPATCH_REDUCE,
+	DISPATCH_OP_COUNT
+};
+
+//! Execution paths of CSizeDispatcher, from the smallest to the largest inputs
+enum EDispatchPath
+{
+	DISPATCH_HOST = 0,			// on the calling thread, no transfers
+	DISPATCH_SINGLE_GROUP,		// one launch of a single work-group
+	DISPATCH_MULTI_PASS,		// CScanHierarchy, two-pass reduction
+	DISPATCH_PATH_COUNT
+};
+
+//! Scan and reduction of host arrays that pick the fastest path for the size of each call
+/*!
+	Small inputs are dominated by the launch and transfer latency, so the dispatcher
+	routes a call of N elements to
+	- the host if N < crossover 0
+	- a single work-group kernel if N < crossover 1
+	- the multi-pass kernels otherwise
+
+	The crossovers are measured once per device (and work-group size) by Calibrate()
+	and stored in CalibrationFile, later runs load them from there.
+*/
+class CSizeDispatcher
+{
+public:
+	CSizeDispatcher(size_t MaxElements, size_t LocalWorkSize, const std::string& CalibrationFile = "DispatchCalibration.txt");
+
+	~CSizeDispatcher();
+
+	bool InitResources(cl_device_id Device, cl_context Context);
+
+	//! Queues the build of the program InitPrograms() needs, see CProgramBuilder
+	void StartProgramBuilds(cl_device_id Device, cl_context Context);
+
+	//! Builds the program and creates the kernels, after InitResources()
+	bool InitPrograms(cl_device_id Device, cl_context Context);
+
+	void ReleaseResources();
+
+	//! Loads the crossovers of the device, or measures and stores them if they are not known or Force is set
+	void Calibrate(cl_command_queue CommandQueue, bool Force = false);
+
+	EDispatchPath SelectPath(EDispatchOp Op, size_t N) const;
+
+	//! Inclusive prefix sum of N <= MaxElements elements, hOutput may be hInput
+	void Scan(cl_command_queue CommandQueue, const cl_uint* hInput, cl_uint* hOutput, size_t N);
+	void Scan(cl_command_queue CommandQueue, const cl_uint* hInput, cl_uint* hOutput, size_t N, EDispatchPath Path);
+
+	//! Sum of N <= MaxElements elements
+	cl_uint Reduce(cl_command_queue CommandQueue, const cl_uint* hInput, size_t N);
+	cl_uint Reduce(cl_command_queue CommandQueue, const cl_uint* hInput, size_t N, EDispatchPath Path);
+
+	//! Until the dispatcher is calibrated, every call takes the multi-pass path
+	bool IsCalibrated() const { return m_bCalibrated; }
+	size_t GetCrossover(EDispatchOp Op, int Index) const { return m_Crossovers[Op][Index]; }
+
+	static const char* GetPathName(EDispatchPath Path);
+
+protected:
+
+	//! Average time of a call in ms
+	double Measure(cl_command_queue CommandQueue, EDispatchOp Op, size_t N, EDispatchPath Path);
+
+	bool LoadCalibration();
+	void SaveCalibration() const;
+
+	//! Enqueues the partial sums of N elements of m_dArray into dPartials, one per work-group
+	void EnqueueReduce(cl_command_queue CommandQueue, cl_mem dArray, size_t N, cl_mem dPartials, size_t nGroups);
+
+	size_t				m_MaxElements;
+	size_t				m_LocalWorkSize;
+	std::string			m_CalibrationFile;
+	// identifies the device in the calibration file
+	std::string			m_DeviceKey;
+
+	// [op][0]: host below, [op][1]: single work-group below
+	size_t				m_Crossovers[DISPATCH_OP_COUNT][2];
+	bool				m_bCalibrated;
+
+	// scratch input for the calibration
+	cl_uint				*m_hScratch;
+
+	cl_mem				m_dArray;
+	cl_mem				m_dPartials;
+	cl_mem				m_dResult;
+
+	CScanHierarchy		m_Scan;
+
+	//OpenCL program and kernels
+	cl_program			m_Program;
+	cl_kernel			m_ScanRowsKernel;
+	cl_kernel			m_ReduceKernel;
+};
+
+#endif // _CSIZE_DISPATCHER_H
@@ -0,0 +1,370 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+
+#include "CStreamingTask.h"
+
+#include "../Common/CLUtil.h"
+#include "../Common/CProgramBuilder.h"
+#include "../Common/CTimer.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+using namespace std;
+
+// work-groups of the chunk reduction, i.e. partial sums per chunk
+#define REDUCTION_GROUPS	256
+
+///////////////////////////////////////////////////////////////////////////////
+// CStreamingTask
+
+// only useful for debug info
+static const string g_StreamingNames[2] =
+{
+	"streamingScan",
+	"streamingReduction"
+};
+
+CStreamingTask::CStreamingTask(size_t ArraySize, size_t ChunkSize, size_t MinLocalWorkSize)
+	: m_N(ArraySize), m_ChunkSize(ChunkSize), m_nChunks((ArraySize + ChunkSize - 1) / ChunkSize),
+	m_hInput(NULL), m_hScanCPU(NULL), m_hScanGPU(NULL), m_ReductionCPU(0), m_ReductionGPU(0), m_hPartials(NULL),
+	m_dPartials(NULL), m_TransferQueue(NULL),
+	m_MinLocalWorkSize(MinLocalWorkSize), m_ChunkScan(ChunkSize, MinLocalWorkSize),
+	m_Program(NULL), m_AddCarryKernel(NULL), m_ReduceChunkKernel(NULL)
+{
+	m_dChunks[0] = m_dChunks[1] = NULL;
+	m_dCarries[0] = m_dCarries[1] = NULL;
+
+	// Reset validation results
+	for (int i = 0; i < (int)ARRAYLEN(m_bValidationResults); i++)
+		m_bValidationResults[i] = false;
+}
+
+CStreamingTask::~CStreamingTask()
+{
+	ReleaseResources();
+}
+
+bool CStreamingTask::InitResources(cl_device_id Device, cl_context Context)
+{
+	//CPU resources
+	m_hInput	 = new unsigned int[m_N];
+	m_hScanCPU	 = new unsigned int[m_N];
+	m_hScanGPU	 = new unsigned int[m_N];
+	for (int i = 0; i < 2; i++) {
+		m_UploadStaging[i].Allocate(Device, Context, m_ChunkSize * sizeof(cl_uint));
+		m_DownloadStaging[i].Allocate(Device, Context, m_ChunkSize * sizeof(cl_uint));
+	}
+	m_hPartials	 = new unsigned int[m_nChunks * REDUCTION_GROUPS];
+
+	//fill the array with some values
+	for(size_t i = 0; i < m_N; i++)
+		m_hInput[i] = rand() & 15;
+
+	//device resources, only two chunks of the input are on the device at any time
+	cl_int clError, clError2;
+	clError = CL_SUCCESS;
+	for (int i = 0; i < 2; i++) {
+		m_dChunks[i] = clCreateBuffer(Context, CL_MEM_READ_WRITE, sizeof(cl_uint) * m_ChunkSize, NULL, &clError2);
+		clError |= clError2;
+		m_dCarries[i] = clCreateBuffer(Context, CL_MEM_READ_WRITE, sizeof(cl_uint), NULL, &clError2);
+		clError |= clError2;
+	}
+	m_dPartials = clCreateBuffer(Context, CL_MEM_READ_WRITE, sizeof(cl_uint) * m_nChunks * REDUCTION_GROUPS, NULL, &clError2);
+	clError |= clError2;
+	V_RETURN_FALSE_CL(clError, "Error allocating device arrays");
+
+	m_TransferQueue = clCreateCommandQueue(Context, Device, 0, &clError);
+	V_RETURN_FALSE_CL(clError, "Failed to create the transfer queue");
+
+	return true;
+}
+
+bool CStreamingTask::InitPrograms(cl_device_id Device, cl_context Context)
+{
+	cl_int clError;
+
+	//load and compile kernels
+	string scanCode, streamingCode;
+
+	if (!CLUtil::LoadProgramSourceToMemory("Scan.cl", scanCode) ||
+		!CLUtil::LoadProgramSourceToMemory("Streaming.cl", streamingCode))
+		return false;
+	m_Program = CLUtil::BuildCLProgramFromMemory(Device, Context, scanCode + "\n" + streamingCode);
+	if(m_Program == nullptr) return false;
+
+	//create kernels
+	m_AddCarryKernel = clCreateKernel(m_Program, "Stream_AddCarry", &clError);
+	V_RETURN_FALSE_CL(clError, "Failed to create kernel: Stream_AddCarry.");
+
+	m_ReduceChunkKernel = clCreateKernel(m_Program, "Stream_ReduceChunk", &clError);
+	V_RETURN_FALSE_CL(clError, "Failed to create kernel: Stream_ReduceChunk.");
+
+	if (!m_ChunkScan.InitResources(Context, m_Program))
+		return false;
+
+	return true;
+}
+
+void CStreamingTask::StartProgramBuilds(cl_device_id Device, cl_context Context)
+{
+	string scanCode, streamingCode;
+
+	if (CLUtil::LoadProgramSourceToMemory("Scan.cl", scanCode) &&
+		CLUtil::LoadProgramSourceToMemory("Streaming.cl", streamingCode))
+		CProgramBuilder::BuildAsync(Device, Context, scanCode + "\n" + streamingCode);
+}
+
+void CStreamingTask::ReleaseResources()
+{
+	// host resources
+	SAFE_DELETE_ARRAY(m_hInput);
+	SAFE_DELETE_ARRAY(m_hScanCPU);
+	SAFE_DELETE_ARRAY(m_hScanGPU);
+	for (int i = 0; i < 2; i++) {
+		m_UploadStaging[i].Release();
+		m_DownloadStaging[i].Release();
+	}
+	SAFE_DELETE_ARRAY(m_hPartials);
+
+	// device resources
+	for (int i = 0; i < 2; i++) {
+		SAFE_RELEASE_MEMOBJECT(m_dChunks[i]);
+		SAFE_RELEASE_MEMOBJECT(m_dCarries[i]);
+	}
+	SAFE_RELEASE_MEMOBJECT(m_dPartials);
+
+	if (m_TransferQueue) {
+		clReleaseCommandQueue(m_TransferQueue);
+		m_TransferQueue = NULL;
+	}
+
+	m_ChunkScan.ReleaseResources();
+
+	SAFE_RELEASE_KERNEL(m_AddCarryKernel);
+	SAFE_RELEASE_KERNEL(m_ReduceChunkKernel);
+
+	SAFE_RELEASE_PROGRAM(m_Program);
+}
+
+void CStreamingTask::ComputeGPU(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
+{
+	cout << endl;
+
+	ValidateTask(Context, CommandQueue, LocalWorkSize, 0);
+	ValidateTask(Context, CommandQueue, LocalWorkSize, 1);
+
+	cout << endl;
+
+	for (unsigned int task = 0; task < 2; task++) {
+		TestPerformance(Context, CommandQueue, LocalWorkSize, task, false);
+		TestPerformance(Context, CommandQueue, LocalWorkSize, task, true);
+	}
+
+	cout << endl;
+}
+
+void CStreamingTask::ComputeCPU()
+{
+	CTimer timer;
+	timer.Start();
+
+	unsigned int sum = 0;
+	for(size_t i = 0; i < m_N; i++) {
+		sum += m_hInput[i];
+		m_hScanCPU[i] = sum;
+	}
+	m_ReductionCPU = sum;
+
+	timer.Stop();
+	double ms = timer.GetElapsedMilliseconds();
+	cout << "  average time: " << ms << " ms, throughput: " << 1.0e-6 * (double)m_N / ms << " Gelem/s" <<endl;
+}
+
+bool CStreamingTask::ValidateResults()
+{
+	bool success = true;
+
+	for(int i = 0; i < (int)ARRAYLEN(m_bValidationResults); i++)
+		if(!m_bValidationResults[i])
+		{
+			cout<<"Validation of "<<g_StreamingNames[i]<<" failed." << endl;
+			success = false;
+		}
+
+	return success;
+}
+
+void CStreamingTask::Stream(cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task, bool Overlap)
+{
+	cl_int clErr;
+	size_t globalWorkSize[1];
+	size_t localWorkSize[1] = { LocalWorkSize[0] };
+
+	// last upload, compute and download command of each chunk buffer
+	cl_event uploaded[2] = { NULL, NULL };
+	cl_event computed[2] = { NULL, NULL };
+	cl_event downloaded[2] = { NULL, NULL };
+	// chunk in the download staging memory of each buffer that still has to go to m_hScanGPU, m_nChunks for none
+	size_t pendingDownload[2] = { m_nChunks, m_nChunks };
+
+	auto chunkCount = [this](size_t Chunk) { return (cl_uint)min(m_ChunkSize, m_N - Chunk * m_ChunkSize); };
+
+	// moves a finished download out of the staging memory, so the staging memory can take the next one
+	auto copyOutDownload = [&](unsigned int Buffer) {
+		if (pendingDownload[Buffer] == m_nChunks)
+			return;
+		clWaitForEvents(1, &downloaded[Buffer]);
+		memcpy(m_hScanGPU + pendingDownload[Buffer] * m_ChunkSize, m_DownloadStaging[Buffer].GetPointer(), chunkCount(pendingDownload[Buffer]) * sizeof(cl_uint));
+		pendingDownload[Buffer] = m_nChunks;
+	};
+
+	// the carry of the first chunk is 0
+	cl_uint zero = 0;
+	V_RETURN_CL(clEnqueueWriteBuffer(CommandQueue, m_dCarries[0], CL_TRUE, 0, sizeof(cl_uint), &zero, 0, NULL, NULL), "Error resetting the carry!");
+
+	// with overlap, chunk k + 1 is uploaded while chunk k is processed. Without, every chunk is
+	// uploaded, processed and downloaded before the upload of the next one is enqueued.
+	size_t lag = Overlap ? 1 : 0;
+
+	for (size_t chunk = 0; chunk < m_nChunks + lag; chunk++)
+	{
+		// upload chunk, the buffer has to be free again
+		if (chunk < m_nChunks)
+		{
+			unsigned int b = chunk % 2;
+			cl_uint count = chunkCount(chunk);
+
+			// the staging memory is free again once the previous upload from it is done
+			if (uploaded[b]) {
+				clWaitForEvents(1, &uploaded[b]);
+				clReleaseEvent(uploaded[b]);
+			}
+			memcpy(m_UploadStaging[b].GetPointer(), m_hInput + chunk * m_ChunkSize, count * sizeof(cl_uint));
+
+			cl_uint nWait = computed[b] ? 1 : 0;
+			clErr = clEnqueueWriteBuffer(m_TransferQueue, m_dChunks[b], CL_FALSE, 0, count * sizeof(cl_uint), m_UploadStaging[b].GetPointer(),
+				nWait, nWait ? &computed[b] : NULL, &uploaded[b]);
+			V_RETURN_CL(clErr, "Error uploading a chunk!");
+			clFlush(m_TransferQueue);
+		}
+
+		// process the chunk that was uploaded lag iterations ago
+		if (chunk < lag)
+			continue;
+
+		size_t current = chunk - lag;
+		unsigned int b = current % 2;
+		cl_uint count = chunkCount(current);
+
+		// the compute queue waits for the upload
+		V_RETURN_CL(clEnqueueBarrierWithWaitList(CommandQueue, 1, &uploaded[b], NULL), "Error waiting for the upload!");
+
+		if (computed[b]) clReleaseEvent(computed[b]);
+
+		if (Task == 0)
+		{
+			m_ChunkScan.Scan(CommandQueue, m_dChunks[b], count, localWorkSize[0]);
+
+			globalWorkSize[0] = CLUtil::GetGlobalWorkSize(count, localWorkSize[0]);
+			clErr = clSetKernelArg(m_AddCarryKernel, 0, sizeof(cl_mem), (void*)&m_dChunks[b]);
+			clErr |= clSetKernelArg(m_AddCarryKernel, 1, sizeof(cl_uint), (void*)&count);
+			clErr |= clSetKernelArg(m_AddCarryKernel, 2, sizeof(cl_mem), (void*)&m_dCarries[current % 2]);
+			clErr |= clSetKernelArg(m_AddCarryKernel, 3, sizeof(cl_mem), (void*)&m_dCarries[(current + 1) % 2]);
+			V_RETURN_CL(clErr, "Failed to set Stream_AddCarry arguments");
+
+			clErr = clEnqueueNDRangeKernel(CommandQueue, m_AddCarryKernel, 1, NULL, globalWorkSize, localWorkSize, 0, NULL, &computed[b]);
+			V_RETURN_CL(clErr, "Error executing Stream_AddCarry!");
+			clFlush(CommandQueue);
+
+			// download the scanned chunk on the transfer queue, the next upload into this buffer is queued behind it
+			copyOutDownload(b);
+			if (downloaded[b]) clReleaseEvent(downloaded[b]);
+			clErr = clEnqueueReadBuffer(m_TransferQueue, m_dChunks[b], CL_FALSE, 0, count * sizeof(cl_uint), m_DownloadStaging[b].GetPointer(),
+				1, &computed[b], &downloaded[b]);
+			V_RETURN_CL(clErr, "Error downloading a chunk!");
+			pendingDownload[b] = current;
+		}
+		else
+		{
+			cl_uint partialOffset = (cl_uint)(current * REDUCTION_GROUPS);
+			globalWorkSize[0] = REDUCTION_GROUPS * localWorkSize[0];
+			clErr = clSetKernelArg(m_ReduceChunkKernel, 0, sizeof(cl_mem), (void*)&m_dChunks[b]);
+			clErr |= clSetKernelArg(m_ReduceChunkKernel, 1, sizeof(cl_uint), (void*)&count);
+			clErr |= clSetKernelArg(m_ReduceChunkKernel, 2, sizeof(cl_mem), (void*)&m_dPartials);
+			clErr |= clSetKernelArg(m_ReduceChunkKernel, 3, sizeof(cl_uint), (void*)&partialOffset);
+			clErr |= clSetKernelArg(m_ReduceChunkKernel, 4, localWorkSize[0] * sizeof(cl_uint), NULL);
+			V_RETURN_CL(clErr, "Failed to set Stream_ReduceChunk arguments");
+
+			clErr = clEnqueueNDRangeKernel(CommandQueue, m_ReduceChunkKernel, 1, NULL, globalWorkSize, localWorkSize, 0, NULL, &computed[b]);
+			V_RETURN_CL(clErr, "Error executing Stream_ReduceChunk!");
+			clFlush(CommandQueue);
+		}
+
+		// without overlap, every chunk is finished before the next one is uploaded
+		if (!Overlap)
+		{
+			clFinish(CommandQueue);
+			clFinish(m_TransferQueue);
+		}
+	}
+
+	clFinish(CommandQueue);
+	clFinish(m_TransferQueue);
+
+	for (unsigned int i = 0; i < 2; i++) {
+		copyOutDownload(i);
+
+		if (uploaded[i]) clReleaseEvent(uploaded[i]);
+		if (computed[i]) clReleaseEvent(computed[i]);
+		if (downloaded[i]) clReleaseEvent(downloaded[i]);
+	}
+
+	// combine the partial sums of the reduction on the host
+	if (Task == 1)
+	{
+		V_RETURN_CL(clEnqueueReadBuffer(CommandQueue, m_dPartials, CL_TRUE, 0, m_nChunks * REDUCTION_GROUPS * sizeof(cl_uint), m_hPartials, 0, NULL, NULL), "Error reading the partial sums!");
+
+		m_ReductionGPU = 0;
+		for (size_t i = 0; i < m_nChunks * REDUCTION_GROUPS; i++)
+			m_ReductionGPU += m_hPartials[i];
+	}
+}
+
+void CStreamingTask::ValidateTask(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task)
+{
+	Stream(CommandQueue, LocalWorkSize, Task, true);
+
+	// validate results
+	if (Task == 0)
+		m_bValidationResults[Task] = (memcmp(m_hScanCPU, m_hScanGPU, m_N * sizeof(unsigned int)) == 0);
+	else
+		m_bValidationResults[Task] = (m_ReductionCPU == m_ReductionGPU);
+}
+
+void CStreamingTask::TestPerformance(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task, bool Overlap)
+{
+	cout << "Testing performance of " << g_StreamingNames[Task] << (Overlap ? " (double-buffered)" : " (synchronous)")
+		<< ", " << m_nChunks << " chunks of " << m_ChunkSize << " elements" << endl;
+
+	CTimer timer;
+	timer.Start();
+
+	//every iteration streams the whole input from the host
+	unsigned int nIterations = 5;
+	for(unsigned int i = 0; i < nIterations; i++)
+		Stream(CommandQueue, LocalWorkSize, Task, Overlap);
+
+	timer.Stop();
+
+	double ms = timer.GetElapsedMilliseconds() / double(nIterations);
+	// the scan moves the data in both directions
+	double transferredBytes = (double)m_N * sizeof(cl_uint) * (Task == 0 ? 2 : 1);
+	cout << "  average time: " << ms << " ms, throughput: " << 1.0e-6 * (double)m_N / ms << " Gelem/s, "
+		<< 1.0e-6 * transferredBytes / ms << " GB/s transferred" << endl;
+}
+
+///////////////////////////////////////////////////////////////////////////////
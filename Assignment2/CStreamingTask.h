@@ -0,0 +1,108 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CSTREAMING_TASK_H
+#define _CSTREAMING_TASK_H
+
+#include "../Common/IComputeTask.h"
+#include "../Common/CPinnedHostMemory.h"
+
+#include "CScanHierarchy.h"
+
+//! Scan and reduction of arrays that do not fit into device memory
+/*!
+	The input stays on the host and is streamed through two device buffers of ChunkSize elements.
+	Uploads run on a second command queue: while chunk k is processed, chunk k+1 is uploaded
+	into the other buffer. Events order the upload, compute and download of each buffer.
+
+	- scan: every chunk is scanned with CScanHierarchy and the total of the preceding chunks is
+	  added on the device (Stream_AddCarry), the scanned chunk is downloaded on the transfer queue
+	- reduction: every chunk is reduced to a fixed number of partial sums on the device,
+	  the partials of all chunks are combined on the host at the end
+
+	The performance test compares this with a synchronous version (one chunk at a time).
+*/
+class CStreamingTask : public IComputeTask
+{
+public:
+	CStreamingTask(size_t ArraySize, size_t ChunkSize, size_t MinLocalWorkSize);
+
+	virtual ~CStreamingTask();
+
+	// IComputeTask
+	virtual bool InitResources(cl_device_id Device, cl_context Context);
+
+	virtual void StartProgramBuilds(cl_device_id Device, cl_context Context);
+
+	virtual bool InitPrograms(cl_device_id Device, cl_context Context);
+
+	virtual void ReleaseResources();
+
+	virtual void ComputeGPU(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
+
+	virtual void ComputeCPU();
+
+	virtual bool ValidateResults();
+
+protected:
+
+	//! Task 0 is the scan (result in m_hScanGPU), task 1 the reduction (result in m_ReductionGPU)
+	void Stream(cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task, bool Overlap);
+
+	void ValidateTask(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task);
+	void TestPerformance(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3], unsigned int Task, bool Overlap);
+
+	size_t				m_N;
+	size_t				m_ChunkSize;
+	size_t				m_nChunks;
+
+	unsigned int		*m_hInput;
+
+	unsigned int		*m_hScanCPU;
+	unsigned int		*m_hScanGPU;
+	unsigned int		m_ReductionCPU;
+	unsigned int		m_ReductionGPU;
+	unsigned int		*m_hPartials;
+	bool				m_bValidationResults[2];
+
+	// the chunks are copied asynchronously, which only overlaps with pinned host memory:
+	// they go through chunk-sized pinned staging memory per chunk buffer, the full arrays stay pageable
+	CPinnedHostMemory	m_UploadStaging[2];
+	CPinnedHostMemory	m_DownloadStaging[2];
+
+	// double buffer for the chunks
+	cl_mem				m_dChunks[2];
+	// the carry of the scan alternates between two single-element buffers
+	cl_mem				m_dCarries[2];
+	// partial sums of all chunks of the reduction
+	cl_mem				m_dPartials;
+
+	// uploads and downloads, the compute queue is the one passed to ComputeGPU
+	cl_command_queue	m_TransferQueue;
+
+	size_t				m_MinLocalWorkSize;
+	CScanHierarchy		m_ChunkScan;
+
+	//OpenCL program and kernels
+	cl_program			m_Program;
+	cl_kernel			m_AddCarryKernel;
+	cl_kernel			m_ReduceChunkKernel;
+};
+
+#endif // _CSTREAMING_TASK_H
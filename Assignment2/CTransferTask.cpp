@@ -0,0 +1,155 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+
+#include "CTransferTask.h"
+
+#include "../Common/CLUtil.h"
+#include "../Common/CBenchmark.h"
+
+#include <vector>
+
+using namespace std;
+
+// the smallest array of the test, the sizes grow by 16x up to the array size of the task
+#define MIN_TRANSFER_SIZE	(64 * 1024)
+
+///////////////////////////////////////////////////////////////////////////////
+// CTransferTask
+
+CTransferTask::CTransferTask(size_t ArraySize)
+	: m_N(ArraySize), m_Device(NULL)
+{
+	// Reset validation results
+	for (int i = 0; i < (int)ARRAYLEN(m_bValidationResults); i++)
+		m_bValidationResults[i] = false;
+}
+
+CTransferTask::~CTransferTask()
+{
+	ReleaseResources();
+}
+
+bool CTransferTask::InitResources(cl_device_id Device, cl_context Context)
+{
+	// the buffers of each size are allocated in ComputeGPU, they need the command queue
+	m_Device = Device;
+
+	return true;
+}
+
+void CTransferTask::ReleaseResources()
+{
+}
+
+void CTransferTask::ComputeGPU(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3])
+{
+	for (int i = 0; i < (int)ARRAYLEN(m_bValidationResults); i++)
+		m_bValidationResults[i] = true;
+
+	cout << endl;
+
+	for (size_t n = min((size_t)MIN_TRANSFER_SIZE, m_N); n <= m_N; n *= 16)
+	{
+		cout << "Array of " << n * sizeof(cl_uint) / 1024 << " KB:" << endl;
+
+		for (int i = 0; i < TRANSFER_STRATEGY_COUNT; i++)
+		{
+			ETransferStrategy strategy = (ETransferStrategy)i;
+			if (!CTransferBuffer::IsSupported(m_Device, strategy))
+			{
+				cout << "  " << CTransferBuffer::GetStrategyName(strategy) << ": not supported by the device" << endl;
+				continue;
+			}
+
+			CTransferBuffer buffer;
+			if (!buffer.Init(m_Device, Context, CommandQueue, n * sizeof(cl_uint), strategy) || !ValidateStrategy(buffer, CommandQueue, n))
+			{
+				m_bValidationResults[i] = false;
+				continue;
+			}
+
+			TestPerformance(buffer, CommandQueue, n);
+		}
+
+		cout << endl;
+	}
+}
+
+void CTransferTask::ComputeCPU()
+{
+	// nothing to compute, the plain copies in ValidateStrategy are the reference
+}
+
+bool CTransferTask::ValidateResults()
+{
+	bool success = true;
+
+	for (int i = 0; i < (int)ARRAYLEN(m_bValidationResults); i++)
+		if (!m_bValidationResults[i])
+		{
+			cout << "Validation of " << CTransferBuffer::GetStrategyName((ETransferStrategy)i) << " transfers failed." << endl;
+			success = false;
+		}
+
+	return success;
+}
+
+bool CTransferTask::ValidateStrategy(CTransferBuffer& Buffer, cl_command_queue CommandQueue, size_t N)
+{
+	vector<cl_uint> reference(N);
+
+	// host to device: fill the host copy, read the device array back with a plain copy
+	cl_uint* hArray = (cl_uint*)Buffer.GetHostPointer();
+	for (size_t i = 0; i < N; i++)
+		hArray[i] = (cl_uint)i * 2654435761u;
+
+	if (!Buffer.Upload(CommandQueue))
+		return false;
+	V_RETURN_FALSE_CL(clEnqueueReadBuffer(CommandQueue, Buffer.GetDeviceBuffer(), CL_TRUE, 0, N * sizeof(cl_uint), &reference[0], 0, NULL, NULL), "Error copying data from device to host!");
+
+	for (size_t i = 0; i < N; i++)
+		if (reference[i] != (cl_uint)i * 2654435761u)
+		{
+			cout << "  " << CTransferBuffer::GetStrategyName(Buffer.GetStrategy()) << ": upload mismatch at element " << i << endl;
+			return false;
+		}
+
+	// device to host: overwrite the device array with a plain copy, download it
+	for (size_t i = 0; i < N; i++)
+		reference[i] = ~(cl_uint)i;
+	V_RETURN_FALSE_CL(clEnqueueWriteBuffer(CommandQueue, Buffer.GetDeviceBuffer(), CL_TRUE, 0, N * sizeof(cl_uint), &reference[0], 0, NULL, NULL), "Error copying data from host to device!");
+
+	if (!Buffer.Download(CommandQueue))
+		return false;
+
+	// the mapping strategies can return a new pointer
+	hArray = (cl_uint*)Buffer.GetHostPointer();
+	for (size_t i = 0; i < N; i++)
+		if (hArray[i] != reference[i])
+		{
+			cout << "  " << CTransferBuffer::GetStrategyName(Buffer.GetStrategy()) << ": download mismatch at element " << i << endl;
+			return false;
+		}
+
+	return true;
+}
+
+void CTransferTask::TestPerformance(CTransferBuffer& Buffer, cl_command_queue CommandQueue, size_t N)
+{
+	cout << "  " << CTransferBuffer::GetStrategyName(Buffer.GetStrategy()) << ", upload + download:" << endl;
+
+	// the mapping strategies cannot upload twice without a download in between,
+	// so all strategies are timed on the round trip
+	CBenchmark benchmark;
+	CBenchmark::SResult result = benchmark.Run([&]() {
+		Buffer.Upload(CommandQueue);
+		Buffer.Download(CommandQueue);
+		V_RETURN_CL(clFinish(CommandQueue), "Error finishing the queue!");
+	});
+	CBenchmark::Print(result, N, 2 * N * sizeof(cl_uint));
+}
+
+///////////////////////////////////////////////////////////////////////////////
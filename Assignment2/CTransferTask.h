@@ -0,0 +1,63 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CTRANSFER_TASK_H
+#define _CTRANSFER_TASK_H
+
+#include "../Common/IComputeTask.h"
+#include "../Common/CTransferBuffer.h"
+
+//! Host-device transfer bandwidth of the transfer strategies (see CTransferBuffer)
+/*!
+	For a few array sizes up to ArraySize elements, every strategy the device supports is validated
+	in both directions against plain clEnqueueWriteBuffer / clEnqueueReadBuffer copies, then an
+	upload and a download of the whole array are timed together. Strategies without support
+	(zero-copy on devices without unified host memory) are skipped.
+*/
+class CTransferTask : public IComputeTask
+{
+public:
+	CTransferTask(size_t ArraySize);
+
+	virtual ~CTransferTask();
+
+	// IComputeTask
+	virtual bool InitResources(cl_device_id Device, cl_context Context);
+
+	virtual void ReleaseResources();
+
+	virtual void ComputeGPU(cl_context Context, cl_command_queue CommandQueue, size_t LocalWorkSize[3]);
+
+	virtual void ComputeCPU();
+
+	virtual bool ValidateResults();
+
+protected:
+
+	bool ValidateStrategy(CTransferBuffer& Buffer, cl_command_queue CommandQueue, size_t N);
+	void TestPerformance(CTransferBuffer& Buffer, cl_command_queue CommandQueue, size_t N);
+
+	size_t				m_N;
+
+	cl_device_id		m_Device;
+
+	bool				m_bValidationResults[TRANSFER_STRATEGY_COUNT];
+};
+
+#endif // _CTRANSFER_TASK_H
@@ -0,0 +1,68 @@
+// Stream compaction (filter) on top of the work-efficient scan.
+// The host builds this file together with Scan.cl into one program and defines
+// PREDICATE(x) in front of the source, so any expression of the element x can be used.
+
+#ifndef PREDICATE
+	#define PREDICATE(x) ((x) != 0)
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Counts the selected elements of every block of 2 * localSize elements
+__kernel void Compact_CountBlocks(const __global uint* inArray, __global uint* blockCounts, uint N, __local uint* localBlock)
+{
+	uint LID = get_local_id(0);
+	uint localSize = get_local_size(0);
+	uint groupID = get_group_id(0);
+
+	uint indexA = 2 * localSize * groupID + LID;
+	uint indexB = indexA + localSize;
+
+	uint count = (indexA < N && PREDICATE(inArray[indexA])) ? 1 : 0;
+	count += (indexB < N && PREDICATE(inArray[indexB])) ? 1 : 0;
+
+	localBlock[LID] = count;
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for (uint localOffset = localSize / 2; localOffset >= 1; localOffset /= 2)
+	{
+		if (LID < localOffset)
+		{
+			localBlock[LID] += localBlock[LID + localOffset];
+		}
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+
+	if (LID == 0)
+	{
+		blockCounts[groupID] = localBlock[0];
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Evaluates the predicate again, scans the flags in local memory and writes the selected elements.
+// blockOffsets holds the inclusive prefix sum of the block counts, so the flags never go through global memory.
+__kernel void Compact_Scatter(const __global uint* inArray, const __global uint* blockOffsets, __global uint* outArray, uint N, __local uint* localBlock)
+{
+	uint LID = get_local_id(0);
+	uint localSize = get_local_size(0);
+	uint groupID = get_group_id(0);
+
+	uint indexA = 2 * localSize * groupID + LID;
+	uint indexB = indexA + localSize;
+
+	uint valA = (indexA < N) ? inArray[indexA] : 0;
+	uint valB = (indexB < N) ? inArray[indexB] : 0;
+	uint flagA = (indexA < N && PREDICATE(valA)) ? 1 : 0;
+	uint flagB = (indexB < N && PREDICATE(valB)) ? 1 : 0;
+
+	localBlock[OFFSET(LID)] = flagA;
+	localBlock[OFFSET(LID + localSize)] = flagB;
+
+	Scan_WorkEfficientLocal(localBlock);
+
+	uint blockOffset = (groupID > 0) ? blockOffsets[groupID - 1] : 0;
+
+	if (flagA) outArray[blockOffset + localBlock[OFFSET(LID)]] = valA;
+	if (flagB) outArray[blockOffset + localBlock[OFFSET(LID + localSize)]] = valB;
+}
@@ -0,0 +1,178 @@
+// Reduction and scan of compressed uint columns, the values are decoded in registers while they are loaded.
+// The host builds this file together with Scan.cl into one program.
+// Compile options: -D PACK_BITS=1..16|32 bits per value and -D PACK_DELTA if the column is delta-encoded
+// (value i is stored as column[i] - column[i - 1]).
+//
+// Value i occupies the bits [i * PACK_BITS, (i + 1) * PACK_BITS) of the packed words, lowest bits first.
+// Values may straddle two words, so the host allocates one padding word behind the packed data.
+// PACK_BITS=32 is the uncompressed column and reads the words directly.
+
+#ifndef PACK_BITS
+	#define PACK_BITS 32
+#endif
+
+// (2 << 31) - 1 wraps to all bits set, so no shift by 32 is needed
+#define PACK_MASK ((2u << (PACK_BITS - 1)) - 1)
+
+uint Packed_Load(const __global uint* packed, size_t i)
+{
+#if PACK_BITS == 32
+	return packed[i];
+#else
+	size_t bit = i * PACK_BITS;
+	size_t word = bit / 32;
+	ulong bits = packed[word] | ((ulong)packed[word + 1] << 32);
+	return (uint)(bits >> (bit % 32)) & PACK_MASK;
+#endif
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Sum of the decoded column, one partial sum per work-group, the work-groups stride over the whole input.
+// With PACK_DELTA the column is the prefix sum of the deltas, so delta i is counted N - i times.
+__kernel void Packed_Reduce(const __global uint* packed, __global uint* partials, uint N, __local uint* localSum)
+{
+	uint LID = get_local_id(0);
+	uint localSize = get_local_size(0);
+
+	uint sum = 0;
+	for (uint i = get_global_id(0); i < N; i += get_global_size(0))
+	{
+#ifdef PACK_DELTA
+		sum += Packed_Load(packed, i) * (N - i);
+#else
+		sum += Packed_Load(packed, i);
+#endif
+	}
+
+	localSum[LID] = sum;
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for (uint stride = localSize / 2; stride > 0; stride /= 2)
+	{
+		if (LID < stride)
+			localSum[LID] += localSum[LID + stride];
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+
+	if (LID == 0)
+	{
+		partials[get_group_id(0)] = localSum[0];
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Packed reduce-then-scan, pass 1: sum of the stored values of each tile (one work-group per tile).
+// With PACK_DELTA also the sum of the decoded column over the tile, assuming the column is 0 in front of it:
+// delta i is counted tileEnd - i times.
+__kernel void Packed_ReduceTiles(const __global uint* packed, __global uint* tileSums, __global uint* tileColumnSums, uint N, uint tileSize, __local uint* localSum)
+{
+	uint LID = get_local_id(0);
+	uint localSize = get_local_size(0);
+	uint tile = get_group_id(0);
+
+	size_t start = (size_t)tile * tileSize;
+	size_t end = min(start + tileSize, (size_t)N);
+
+	uint sum = 0;
+	uint columnSum = 0;
+	for (size_t i = start + LID; i < end; i += localSize)
+	{
+		uint value = Packed_Load(packed, i);
+		sum += value;
+		columnSum += value * (uint)(end - i);
+	}
+
+	localSum[LID] = sum;
+	localSum[localSize + LID] = columnSum;
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for (uint stride = localSize / 2; stride > 0; stride /= 2)
+	{
+		if (LID < stride)
+		{
+			localSum[LID] += localSum[LID + stride];
+			localSum[localSize + LID] += localSum[localSize + LID + stride];
+		}
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+
+	if (LID == 0)
+	{
+		tileSums[tile] = localSum[0];
+#ifdef PACK_DELTA
+		tileColumnSums[tile] = localSum[localSize];
+#endif
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Packed reduce-then-scan with PACK_DELTA, between scanning the tile sums and the tile column sums:
+// the column enters tile t with the value tileSums[t - 1], which adds tileSums[t - 1] to each of its elements.
+__kernel void Packed_DeltaTileCarries(const __global uint* tileSums, __global uint* tileColumnSums, uint N, uint tileSize, uint nTiles)
+{
+	uint tile = get_global_id(0);
+
+	if (tile == 0 || tile >= nTiles)
+	{
+		return;
+	}
+
+	uint count = (uint)min((size_t)tileSize, (size_t)N - (size_t)tile * tileSize);
+	tileColumnSums[tile] += count * tileSums[tile - 1];
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Packed reduce-then-scan, pass 3: inclusive scan of the decoded column of each tile, see Scan_RangeWithCarry.
+// With PACK_DELTA every block is scanned twice: the first scan restores the column, the second one is its prefix sum.
+// The scanned tileSums carry the column and the scanned tileColumnSums carry its prefix sum into the tile.
+__kernel void Packed_ScanTiles(const __global uint* packed, __global uint* outArray, const __global uint* tileSums, const __global uint* tileColumnSums, uint N, uint tileSize, __local uint* localBlock)
+{
+	uint LID = get_local_id(0);
+	uint localSize = get_local_size(0);
+	uint tile = get_group_id(0);
+
+	size_t start = (size_t)tile * tileSize;
+	uint count = (uint)min((size_t)tileSize, (size_t)N - start);
+
+#ifdef PACK_DELTA
+	uint column = (tile > 0) ? tileSums[tile - 1] : 0;
+	uint carry = (tile > 0) ? tileColumnSums[tile - 1] : 0;
+#else
+	uint carry = (tile > 0) ? tileSums[tile - 1] : 0;
+#endif
+
+	for (uint blockStart = 0; blockStart < count; blockStart += 2 * localSize)
+	{
+		uint indexA = blockStart + LID;
+		uint indexB = indexA + localSize;
+
+		uint valA = (indexA < count) ? Packed_Load(packed, start + indexA) : 0;
+		uint valB = (indexB < count) ? Packed_Load(packed, start + indexB) : 0;
+
+		localBlock[OFFSET(LID)] = valA;
+		localBlock[OFFSET(LID + localSize)] = valB;
+
+		uint total = Scan_WorkEfficientLocal(localBlock);
+
+#ifdef PACK_DELTA
+		// decoded column, zero behind the end of the tile
+		valA = (indexA < count) ? column + localBlock[OFFSET(LID)] + valA : 0;
+		valB = (indexB < count) ? column + localBlock[OFFSET(LID + localSize)] + valB : 0;
+		column += total;
+
+		localBlock[OFFSET(LID)] = valA;
+		localBlock[OFFSET(LID + localSize)] = valB;
+
+		total = Scan_WorkEfficientLocal(localBlock);
+#endif
+
+		if (indexA < count) outArray[start + indexA] = carry + localBlock[OFFSET(LID)] + valA;
+		if (indexB < count) outArray[start + indexB] = carry + localBlock[OFFSET(LID + localSize)] + valB;
+
+		carry += total;
+	}
+}
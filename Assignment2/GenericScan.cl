@@ -0,0 +1,143 @@
+// Work-efficient scan over an arbitrary element type and associative operator.
+// Provides the same kernels as Scan.cl (Scan_WorkEfficient, Scan_WorkEfficientAdd), so it can be
+// driven by CScanHierarchy. The operator does not need to be commutative: the left operand is
+// always the earlier part of the sequence.
+// Compile options: -D SCAN_T=<element type> -D SCAN_OP=SCAN_OP_ADD|SCAN_OP_MAX|SCAN_OP_LINREC
+// and -D SCAN_IDENTITY=<value> for SCAN_OP_ADD and SCAN_OP_MAX
+
+#define SCAN_OP_ADD		0
+#define SCAN_OP_MAX		1
+#define SCAN_OP_LINREC	2	// first-order linear recurrence x_i = a_i * x_(i-1) + b_i on (a, b) pairs
+
+#ifndef SCAN_T
+	#define SCAN_T uint
+#endif
+
+#ifndef SCAN_OP
+	#define SCAN_OP SCAN_OP_ADD
+#endif
+
+#if SCAN_OP == SCAN_OP_ADD
+	#define Scan_Op(A, B) ((A) + (B))
+#elif SCAN_OP == SCAN_OP_MAX
+	#define Scan_Op(A, B) max((A), (B))
+#elif SCAN_OP == SCAN_OP_LINREC
+	// SCAN_T is a 2-component vector (a, b): applying L and then R gives
+	// x -> R.a * (L.a * x + L.b) + R.b = (L.a * R.a) * x + (R.a * L.b + R.b)
+	SCAN_T Scan_LinRec(SCAN_T L, SCAN_T R)
+	{
+		SCAN_T result;
+		result.x = L.x * R.x;
+		result.y = R.x * L.y + R.y;
+		return result;
+	}
+	#define Scan_Op(A, B) Scan_LinRec((A), (B))
+	#undef SCAN_IDENTITY
+	#define SCAN_IDENTITY ((SCAN_T)(1, 0))
+#endif
+
+#ifndef SCAN_IDENTITY
+	#define SCAN_IDENTITY 0
+#endif
+
+#define NUM_BANKS			32
+
+#define AVOID_BANK_CONFLICTS
+#ifdef AVOID_BANK_CONFLICTS
+	#define OFFSET(A) (((A)/NUM_BANKS) + (A))
+#else
+	#define OFFSET(A) (A)
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Exclusive work-efficient scan of the 2 * localSize elements stored in localBlock.
+// Has to be called by all work-items of the group, returns the reduction of the whole block.
+SCAN_T Scan_WorkEfficientLocal(__local SCAN_T* localBlock)
+{
+	uint LID = get_local_id(0);
+	uint localSize = get_local_size(0);
+	uint blockSize = 2 * localSize;
+
+	// Up-Sweep
+	for (uint stride = 1; stride < blockSize; stride *= 2)
+	{
+		barrier(CLK_LOCAL_MEM_FENCE);
+
+		uint index = (LID + 1) * 2 * stride - 1;
+		if (index < blockSize)
+		{
+			localBlock[OFFSET(index)] = Scan_Op(localBlock[OFFSET(index - stride)], localBlock[OFFSET(index)]);
+		}
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	SCAN_T total = localBlock[OFFSET(blockSize - 1)];
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	if (LID == 0)
+	{
+		localBlock[OFFSET(blockSize - 1)] = SCAN_IDENTITY;
+	}
+
+	// Down-Sweep: the right child gets the prefix of its parent followed by the left subtree
+	for (uint stride = localSize; stride >= 1; stride /= 2)
+	{
+		barrier(CLK_LOCAL_MEM_FENCE);
+
+		uint index = (LID + 1) * 2 * stride - 1;
+		if (index < blockSize)
+		{
+			SCAN_T left = localBlock[OFFSET(index - stride)];
+			localBlock[OFFSET(index - stride)] = localBlock[OFFSET(index)];
+			localBlock[OFFSET(index)] = Scan_Op(localBlock[OFFSET(index)], left);
+		}
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	return total;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+__kernel void Scan_WorkEfficient(__global SCAN_T* array, __global SCAN_T* higherLevelArray, uint N, __local SCAN_T* localBlock)
+{
+	uint LID = get_local_id(0);
+	uint localSize = get_local_size(0);
+	uint groupID = get_group_id(0);
+
+	uint indexA = 2 * localSize * groupID + LID;
+	uint indexB = indexA + localSize;
+
+	SCAN_T valA = (indexA < N) ? array[indexA] : SCAN_IDENTITY;
+	SCAN_T valB = (indexB < N) ? array[indexB] : SCAN_IDENTITY;
+
+	localBlock[OFFSET(LID)] = valA;
+	localBlock[OFFSET(LID + localSize)] = valB;
+
+	SCAN_T total = Scan_WorkEfficientLocal(localBlock);
+
+	//exclusive prefix followed by the own value = inclusive prefix
+	if (indexA < N) array[indexA] = Scan_Op(localBlock[OFFSET(LID)], valA);
+	if (indexB < N) array[indexB] = Scan_Op(localBlock[OFFSET(LID + localSize)], valB);
+
+	if (LID == 0)
+	{
+		higherLevelArray[groupID] = total;
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+__kernel void Scan_WorkEfficientAdd(__global SCAN_T* higherLevelArray, __global SCAN_T* array, uint N)
+{
+	// Two work-groups of this kernel cover one block of Scan_WorkEfficient
+	uint GID = get_global_id(0);
+	uint blockID = get_group_id(0) / 2;
+
+	if (blockID == 0 || GID >= N)
+	{
+		return;
+	}
+
+	array[GID] = Scan_Op(higherLevelArray[blockID - 1], array[GID]);
+}
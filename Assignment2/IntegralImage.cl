@@ -0,0 +1,71 @@
+// Summed-area table (integral image).
+// The host builds this file together with Scan.cl: the rows are scanned with Scan_WorkEfficientRows,
+// then the columns are scanned here in strips of stripHeight rows, so that there is enough parallelism
+// also for images with few columns.
+// Neighbouring work-items always access neighbouring columns, so all row accesses are coalesced.
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// In-place inclusive scan of every column (used for the strip sums)
+__kernel void SAT_ScanColumns(__global uint* image, uint width, uint height)
+{
+	uint x = get_global_id(0);
+
+	if (x >= width)
+	{
+		return;
+	}
+
+	uint sum = 0;
+	for (uint y = 0; y < height; y++)
+	{
+		size_t index = (size_t)y * width + x;
+		sum += image[index];
+		image[index] = sum;
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Sum of every column strip, 2D NDRange: (column, strip)
+__kernel void SAT_ColumnStripSums(const __global uint* image, __global uint* stripSums, uint width, uint height, uint stripHeight)
+{
+	uint x = get_global_id(0);
+	uint strip = get_global_id(1);
+
+	if (x >= width)
+	{
+		return;
+	}
+
+	uint yEnd = min(height, (strip + 1) * stripHeight);
+	uint sum = 0;
+	for (uint y = strip * stripHeight; y < yEnd; y++)
+	{
+		sum += image[(size_t)y * width + x];
+	}
+
+	stripSums[(size_t)strip * width + x] = sum;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// In-place scan of every column strip, starting with the (inclusively scanned) sum of the strips above
+__kernel void SAT_ScanColumnStrips(__global uint* image, const __global uint* stripSums, uint width, uint height, uint stripHeight)
+{
+	uint x = get_global_id(0);
+	uint strip = get_global_id(1);
+
+	if (x >= width)
+	{
+		return;
+	}
+
+	uint sum = (strip > 0) ? stripSums[(size_t)(strip - 1) * width + x] : 0;
+	uint yEnd = min(height, (strip + 1) * stripHeight);
+	for (uint y = strip * stripHeight; y < yEnd; y++)
+	{
+		size_t index = (size_t)y * width + x;
+		sum += image[index];
+		image[index] = sum;
+	}
+}
@@ -0,0 +1,182 @@
+// Reduction and scan of 8- and 16-bit inputs, accumulated in a wider type.
+// The host builds this file together with GenericScan.cl into one program, SCAN_T is the accumulator.
+// Compile options: -D IN_T=uchar|ushort|half -D SCAN_T=uint|ulong|float -D SCAN_OP=SCAN_OP_ADD -D SCAN_IDENTITY=0
+// and -D IN_HALF for half inputs (they are read with vload_half, so cl_khr_fp16 is not required).
+//
+// Every work-item reads 4 consecutive inputs with one vector load and widens them in registers.
+
+#ifndef IN_T
+	#define IN_T uchar
+#endif
+
+#define NARROW_CONCAT2(A, B) A##B
+#define NARROW_CONCAT(A, B) NARROW_CONCAT2(A, B)
+
+// vector of 4 accumulators
+#define ACC_T4 NARROW_CONCAT(SCAN_T, 4)
+
+#ifdef IN_HALF
+	#define NARROW_LOAD4(p) vload_half4(0, (p))
+	#define NARROW_LOAD(p) vload_half(0, (p))
+#else
+	#define NARROW_LOAD4(p) NARROW_CONCAT(convert_, ACC_T4)(vload4(0, (p)))
+	#define NARROW_LOAD(p) ((SCAN_T)*(p))
+#endif
+
+// inputs [i, i + 4) widened, the ones behind end are 0
+ACC_T4 Narrow_Load4(const __global IN_T* inArray, size_t i, size_t end)
+{
+	if (i + 4 <= end)
+	{
+		return NARROW_LOAD4(inArray + i);
+	}
+
+	ACC_T4 v = (ACC_T4)(0);
+	if (i < end) v.x = NARROW_LOAD(inArray + i);
+	if (i + 1 < end) v.y = NARROW_LOAD(inArray + i + 1);
+	if (i + 2 < end) v.z = NARROW_LOAD(inArray + i + 2);
+	return v;
+}
+
+// stores the elements of v in front of end to [i, i + 4)
+void Narrow_Store4(ACC_T4 v, __global SCAN_T* outArray, size_t i, size_t end)
+{
+	if (i + 4 <= end)
+	{
+		vstore4(v, 0, outArray + i);
+		return;
+	}
+
+	if (i < end) outArray[i] = v.x;
+	if (i + 1 < end) outArray[i + 1] = v.y;
+	if (i + 2 < end) outArray[i + 2] = v.z;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Sum of the widened inputs, one partial sum per work-group, the work-groups stride over the whole input.
+__kernel void Narrow_Reduce(const __global IN_T* inArray, __global SCAN_T* partials, uint N, __local SCAN_T* localSum)
+{
+	uint LID = get_local_id(0);
+	uint localSize = get_local_size(0);
+
+	ACC_T4 sum4 = (ACC_T4)(0);
+	for (size_t i = 4 * get_global_id(0); i < N; i += 4 * get_global_size(0))
+		sum4 += Narrow_Load4(inArray, i, N);
+
+	localSum[LID] = sum4.x + sum4.y + sum4.z + sum4.w;
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for (uint stride = localSize / 2; stride > 0; stride /= 2)
+	{
+		if (LID < stride)
+			localSum[LID] += localSum[LID + stride];
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+
+	if (LID == 0)
+	{
+		partials[get_group_id(0)] = localSum[0];
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Reduce-then-scan, pass 1: sum of each tile of tileSize inputs (one work-group per tile).
+__kernel void Narrow_ReduceTiles(const __global IN_T* inArray, __global SCAN_T* tileSums, uint N, uint tileSize, __local SCAN_T* localSum)
+{
+	uint LID = get_local_id(0);
+	uint localSize = get_local_size(0);
+	uint tile = get_group_id(0);
+
+	size_t start = (size_t)tile * tileSize;
+	size_t end = min(start + tileSize, (size_t)N);
+
+	ACC_T4 sum4 = (ACC_T4)(0);
+	for (size_t i = start + 4 * LID; i < end; i += 4 * localSize)
+		sum4 += Narrow_Load4(inArray, i, end);
+
+	localSum[LID] = sum4.x + sum4.y + sum4.z + sum4.w;
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for (uint stride = localSize / 2; stride > 0; stride /= 2)
+	{
+		if (LID < stride)
+			localSum[LID] += localSum[LID + stride];
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+
+	if (LID == 0)
+	{
+		tileSums[tile] = localSum[0];
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Reduce-then-scan, pass 2: inclusive scan of the nTiles tile sums in place, with a single work-group.
+__kernel void Narrow_ScanTileSums(__global SCAN_T* tileSums, uint nTiles, __local SCAN_T* localBlock)
+{
+	uint LID = get_local_id(0);
+	uint localSize = get_local_size(0);
+
+	SCAN_T carry = 0;
+	for (uint blockStart = 0; blockStart < nTiles; blockStart += 2 * localSize)
+	{
+		uint indexA = blockStart + LID;
+		uint indexB = indexA + localSize;
+
+		SCAN_T valA = (indexA < nTiles) ? tileSums[indexA] : 0;
+		SCAN_T valB = (indexB < nTiles) ? tileSums[indexB] : 0;
+
+		localBlock[OFFSET(LID)] = valA;
+		localBlock[OFFSET(LID + localSize)] = valB;
+
+		SCAN_T total = Scan_WorkEfficientLocal(localBlock);
+
+		if (indexA < nTiles) tileSums[indexA] = carry + localBlock[OFFSET(LID)] + valA;
+		if (indexB < nTiles) tileSums[indexB] = carry + localBlock[OFFSET(LID + localSize)] + valB;
+
+		carry += total;
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Reduce-then-scan, pass 3: inclusive scan of each tile, starting with the sum of the preceding tiles.
+// The group walks over the tile in blocks of 8 * localSize inputs: every work-item scans its 2 x 4 inputs
+// in registers, only their sums go through the work-efficient scan in local memory.
+// tileSize has to be a multiple of 4.
+__kernel void Narrow_ScanTiles(const __global IN_T* inArray, __global SCAN_T* outArray, const __global SCAN_T* tileSums, uint N, uint tileSize, __local SCAN_T* localBlock)
+{
+	uint LID = get_local_id(0);
+	uint localSize = get_local_size(0);
+	uint tile = get_group_id(0);
+
+	size_t start = (size_t)tile * tileSize;
+	size_t end = min(start + tileSize, (size_t)N);
+	SCAN_T carry = (tile > 0) ? tileSums[tile - 1] : 0;
+
+	for (size_t blockStart = start; blockStart < end; blockStart += 8 * localSize)
+	{
+		size_t indexA = blockStart + 8 * LID;
+		size_t indexB = indexA + 4;
+
+		ACC_T4 a = Narrow_Load4(inArray, indexA, end);
+		ACC_T4 b = Narrow_Load4(inArray, indexB, end);
+
+		// inclusive scan of the 4 elements
+		a.y += a.x; a.z += a.y; a.w += a.z;
+		b.y += b.x; b.z += b.y; b.w += b.z;
+
+		localBlock[OFFSET(2 * LID)] = a.w;
+		localBlock[OFFSET(2 * LID + 1)] = b.w;
+
+		SCAN_T total = Scan_WorkEfficientLocal(localBlock);
+
+		Narrow_Store4(a + (carry + localBlock[OFFSET(2 * LID)]), outArray, indexA, end);
+		Narrow_Store4(b + (carry + localBlock[OFFSET(2 * LID + 1)]), outArray, indexB, end);
+
+		carry += total;
+	}
+}
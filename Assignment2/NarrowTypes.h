@@ -0,0 +1,129 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _NARROW_TYPES_H
+#define _NARROW_TYPES_H
+
+#include "../Common/IComputeTask.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+//! Narrow input types and their accumulators for CNarrowTask
+/*!
+	Each input type describes
+	- Type: the narrow element type on the host and on the device
+	- AccType: the accumulator on the device, also the type of the widened input
+	- HostType: the type the CPU reference is computed in
+	- CompileOptions(), WideCompileOptions(): the -D specialization of Narrow.cl for the narrow and the widened input
+	- Widen(), ToHost(): the value of an input as accumulator and for the reference
+	- Equal(): compares a GPU result with the reference
+	- Random(): input values
+*/
+
+//! 8-bit counters summed in 32 bits
+struct CNarrowUChar
+{
+	typedef cl_uchar Type;
+	typedef cl_uint AccType;
+	typedef cl_uint HostType;
+
+	static const char* Name() { return "uchar -> uint"; }
+	static const char* CompileOptions() { return "-D IN_T=uchar -D SCAN_T=uint"; }
+	static const char* WideCompileOptions() { return "-D IN_T=uint -D SCAN_T=uint"; }
+
+	static AccType Widen(Type Value) { return Value; }
+	static HostType ToHost(Type Value) { return Value; }
+	static bool Equal(AccType GPU, HostType CPU) { return GPU == CPU; }
+	static Type Random() { return (cl_uchar)(rand() & 0xFF); }
+};
+
+//! 16-bit counters summed in 32 bits
+struct CNarrowUShort
+{
+	typedef cl_ushort Type;
+	typedef cl_uint AccType;
+	typedef cl_uint HostType;
+
+	static const char* Name() { return "ushort -> uint"; }
+	static const char* CompileOptions() { return "-D IN_T=ushort -D SCAN_T=uint"; }
+	static const char* WideCompileOptions() { return "-D IN_T=uint -D SCAN_T=uint"; }
+
+	static AccType Widen(Type Value) { return Value; }
+	static HostType ToHost(Type Value) { return Value; }
+	static bool Equal(AccType GPU, HostType CPU) { return GPU == CPU; }
+	static Type Random() { return (cl_ushort)(rand() & 0xFFFF); }
+};
+
+//! 16-bit counters summed in 64 bits, the sums of large arrays do not wrap around
+struct CNarrowUShortULong
+{
+	typedef cl_ushort Type;
+	typedef cl_ulong AccType;
+	typedef cl_ulong HostType;
+
+	static const char* Name() { return "ushort -> ulong"; }
+	static const char* CompileOptions() { return "-D IN_T=ushort -D SCAN_T=ulong"; }
+	static const char* WideCompileOptions() { return "-D IN_T=ulong -D SCAN_T=ulong"; }
+
+	static AccType Widen(Type Value) { return Value; }
+	static HostType ToHost(Type Value) { return Value; }
+	static bool Equal(AccType GPU, HostType CPU) { return GPU == CPU; }
+	static Type Random() { return (cl_ushort)(rand() & 0xFFFF); }
+};
+
+//! Half-precision samples summed in single precision
+/*!
+	The inputs are multiples of 1/1024 in [0, 1), they are exact in half precision.
+*/
+struct CNarrowHalf
+{
+	typedef cl_half Type;
+	typedef cl_float AccType;
+	typedef double HostType;
+
+	static const char* Name() { return "half -> float"; }
+	static const char* CompileOptions() { return "-D IN_T=half -D IN_HALF -D SCAN_T=float"; }
+	static const char* WideCompileOptions() { return "-D IN_T=float -D SCAN_T=float"; }
+
+	static AccType Widen(Type Value)
+	{
+		// no negative values, infinities or NaNs are generated
+		int exponent = (Value >> 10) & 0x1F;
+		int mantissa = Value & 0x3FF;
+		if (exponent == 0)
+			return ldexpf((float)mantissa, -24);
+		return ldexpf((float)(mantissa | 0x400), exponent - 25);
+	}
+	static HostType ToHost(Type Value) { return Widen(Value); }
+	static bool Equal(AccType GPU, HostType CPU) { return fabs(GPU - CPU) <= 1e-4 * fabs(CPU) + 1e-4; }
+	static Type Random()
+	{
+		// k / 1024 = 2^(e - 10) * (k / 2^e) with the leading bit of k at e
+		int k = rand() & 0x3FF;
+		if (k == 0)
+			return 0;
+		int e = 9;
+		while (!(k & (1 << e)))
+			e--;
+		return (cl_half)(((e + 5) << 10) | ((k << (10 - e)) & 0x3FF));
+	}
+};
+
+#endif // _NARROW_TYPES_H
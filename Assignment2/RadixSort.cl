@@ -0,0 +1,117 @@
+// LSD radix sort on top of the work-efficient scan.
+// The host builds this file together with Scan.cl into one program.
+// Compile options: -D KEY_TYPE=uint|ulong -D RADIX_BITS=4|8 and -D WITH_VALUES for key-value pairs
+
+#ifndef KEY_TYPE
+	#define KEY_TYPE uint
+#endif
+
+#ifndef RADIX_BITS
+	#define RADIX_BITS 4
+#endif
+
+#define RADIX (1 << RADIX_BITS)
+#define DIGIT(key, shift) ((uint)((key) >> (shift)) & (RADIX - 1))
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Digit histogram of every block of 2 * localSize keys
+__kernel void RadixSort_Histogram(const __global KEY_TYPE* keys, __global uint* histograms, uint N, uint shift, __local uint* localHistogram)
+{
+	uint LID = get_local_id(0);
+	uint localSize = get_local_size(0);
+	uint groupID = get_group_id(0);
+	uint nGroups = get_num_groups(0);
+
+	for (uint d = LID; d < RADIX; d += localSize)
+		localHistogram[d] = 0;
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	uint indexA = 2 * localSize * groupID + LID;
+	uint indexB = indexA + localSize;
+
+	if (indexA < N) atomic_inc(&localHistogram[DIGIT(keys[indexA], shift)]);
+	if (indexB < N) atomic_inc(&localHistogram[DIGIT(keys[indexB], shift)]);
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	// digit-major layout: the scan over the whole array yields the output offset of each (digit, block)
+	for (uint d = LID; d < RADIX; d += localSize)
+		histograms[d * nGroups + groupID] = localHistogram[d];
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Sorts each block by the digit in local memory (one stable split per bit) and writes it to its global offsets.
+// histogramOffsets is the inclusive prefix sum of the histograms.
+__kernel void RadixSort_Scatter(const __global KEY_TYPE* inKeys, __global KEY_TYPE* outKeys,
+	const __global uint* inValues, __global uint* outValues,
+	const __global uint* histogramOffsets, uint N, uint shift,
+	__local KEY_TYPE* localKeys, __local uint* localValues, __local uint* localBlock, __local uint* localDigitStart)
+{
+	uint LID = get_local_id(0);
+	uint localSize = get_local_size(0);
+	uint groupID = get_group_id(0);
+	uint nGroups = get_num_groups(0);
+
+	uint blockStart = 2 * localSize * groupID;
+	uint validCount = min(2 * localSize, N - blockStart);
+
+	// the padding of the last block sorts behind all valid keys
+	localKeys[LID] = (LID < validCount) ? inKeys[blockStart + LID] : ~(KEY_TYPE)0;
+	localKeys[LID + localSize] = (LID + localSize < validCount) ? inKeys[blockStart + LID + localSize] : ~(KEY_TYPE)0;
+#ifdef WITH_VALUES
+	localValues[LID] = (LID < validCount) ? inValues[blockStart + LID] : 0;
+	localValues[LID + localSize] = (LID + localSize < validCount) ? inValues[blockStart + LID + localSize] : 0;
+#endif
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	// stable split by each bit of the digit, keys with a 0 bit go first
+	for (uint bit = shift; bit < shift + RADIX_BITS; bit++)
+	{
+		KEY_TYPE keyA = localKeys[LID];
+		KEY_TYPE keyB = localKeys[LID + localSize];
+#ifdef WITH_VALUES
+		uint valueA = localValues[LID];
+		uint valueB = localValues[LID + localSize];
+#endif
+		uint flagA = ((keyA >> bit) & 1) == 0;
+		uint flagB = ((keyB >> bit) & 1) == 0;
+
+		localBlock[OFFSET(LID)] = flagA;
+		localBlock[OFFSET(LID + localSize)] = flagB;
+
+		uint nZeros = Scan_WorkEfficientLocal(localBlock);
+
+		uint posA = flagA ? localBlock[OFFSET(LID)] : nZeros + LID - localBlock[OFFSET(LID)];
+		uint posB = flagB ? localBlock[OFFSET(LID + localSize)] : nZeros + LID + localSize - localBlock[OFFSET(LID + localSize)];
+
+		localKeys[posA] = keyA;
+		localKeys[posB] = keyB;
+#ifdef WITH_VALUES
+		localValues[posA] = valueA;
+		localValues[posB] = valueB;
+#endif
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+
+	// first position of every digit in the sorted block
+	for (uint p = LID; p < validCount; p += localSize)
+	{
+		uint d = DIGIT(localKeys[p], shift);
+		if (p == 0 || DIGIT(localKeys[p - 1], shift) != d)
+			localDigitStart[d] = p;
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for (uint p = LID; p < validCount; p += localSize)
+	{
+		uint d = DIGIT(localKeys[p], shift);
+		uint histogramIndex = d * nGroups + groupID;
+		uint globalOffset = (histogramIndex > 0) ? histogramOffsets[histogramIndex - 1] : 0;
+		uint dest = globalOffset + p - localDigitStart[d];
+
+		outKeys[dest] = localKeys[p];
+#ifdef WITH_VALUES
+		outValues[dest] = localValues[p];
+#endif
+	}
+}
@@ -67,30 +67,39 @@ __kernel void Reduction_Decomp(const __global uint* inArray, __global uint* outA
 
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-__kernel void Reduction_DecompUnroll(const __global uint* inArray, __global uint* outArray, uint N, __local uint* localBlock)
+// With -D WORK_GROUP_SIZE the work-group size is a compile-time constant (see CLUtil::BuildSpecializedProgram):
+// the kernel requires it with reqd_work_group_size and the loop over the local block unrolls completely.
+#ifdef WORK_GROUP_SIZE
+	#define UNROLL_LOCAL_SIZE WORK_GROUP_SIZE
+	#define UNROLL_REQD_WORK_GROUP_SIZE __attribute__((reqd_work_group_size(WORK_GROUP_SIZE, 1, 1)))
+#else
+	#define UNROLL_LOCAL_SIZE get_local_size(0)
+	#define UNROLL_REQD_WORK_GROUP_SIZE
+#endif
+
+__kernel UNROLL_REQD_WORK_GROUP_SIZE
+void Reduction_DecompUnroll(const __global uint* inArray, __global uint* outArray, uint N, __local uint* localBlock)
 {
 	// TO DO: Kernel implementation
 	int GID = get_global_id(0);
 	int LID = get_local_id(0);
-	int offset = get_local_size(0);
+	int offset = UNROLL_LOCAL_SIZE;
 
 	localBlock[LID] = inArray[GID + offset] + inArray[GID];
 	barrier(CLK_LOCAL_MEM_FENCE);
 
-	uint localOffset = offset / 2;
-
 	__attribute__((opencl_unroll_hint)) //specify that a loop can be unrolled
-	for (localOffset; localOffset > 1; localOffset /= 2)  //Halve area
+	for (uint localOffset = UNROLL_LOCAL_SIZE / 2; localOffset > 1; localOffset /= 2)  //Halve area
 	{
 		if (LID < localOffset) 
 		{
 			//printf("%d\n", localOffset);
 			//printf("GID (%d): idx [%d] + [%d] = %d + %d with stride %d \n",GID,  LID, LID+localOffset, localBlock[LID], localBlock[LID+localOffset], localOffset);
 			localBlock[LID] += localBlock[LID + localOffset];
-
-			barrier(CLK_LOCAL_MEM_FENCE);
-
 		}
+
+		// outside of the branch, every work-item of the group has to reach the barrier
+		barrier(CLK_LOCAL_MEM_FENCE);
 	}
 
 	//Write back
@@ -120,3 +129,72 @@ __kernel void Reduction_DecompAtomics(const __global uint* inArray, __global uin
 
 	if (LID == 0) outArray[groupID] = localSum[0];
 }
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Decomposition with compile-time launch parameters, the host picks them with CAutoTuner:
+// every work-item sums ELEMENTS_PER_THREAD vectors of VECTOR_WIDTH (1, 2 or 4) inputs, the loop over them
+// is unrolled UNROLL times. One partial sum per work-group, N can be any size.
+
+#ifndef ELEMENTS_PER_THREAD
+	#define ELEMENTS_PER_THREAD 2
+#endif
+#ifndef VECTOR_WIDTH
+	#define VECTOR_WIDTH 1
+#endif
+#ifndef UNROLL
+	#define UNROLL 1
+#endif
+
+#if VECTOR_WIDTH == 4
+	#define REDUCTION_VLOAD(i, p) vload4(i, p)
+	#define REDUCTION_HSUM(v) ((v).x + (v).y + (v).z + (v).w)
+#elif VECTOR_WIDTH == 2
+	#define REDUCTION_VLOAD(i, p) vload2(i, p)
+	#define REDUCTION_HSUM(v) ((v).x + (v).y)
+#else
+	#define REDUCTION_VLOAD(i, p) ((p)[i])
+	#define REDUCTION_HSUM(v) (v)
+#endif
+
+__kernel void Reduction_Tuned(const __global uint* inArray, __global uint* outArray, uint N, __local uint* localSum)
+{
+	uint LID = get_local_id(0);
+	uint localSize = get_local_size(0);
+
+	// the vectors of a work-group are contiguous, consecutive work-items read consecutive vectors
+	size_t groupStart = (size_t)get_group_id(0) * localSize * ELEMENTS_PER_THREAD;
+	size_t nVectors = N / VECTOR_WIDTH;
+
+	uint sum = 0;
+	__attribute__((opencl_unroll_hint(UNROLL)))
+	for (uint k = 0; k < ELEMENTS_PER_THREAD; k++)
+	{
+		size_t v = groupStart + k * localSize + LID;
+		if (v < nVectors)
+		{
+			sum += REDUCTION_HSUM(REDUCTION_VLOAD(v, inArray));
+		}
+		else if (v == nVectors)
+		{
+			// the inputs behind the last full vector
+			for (size_t i = v * VECTOR_WIDTH; i < N; i++)
+				sum += inArray[i];
+		}
+	}
+
+	localSum[LID] = sum;
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for (uint stride = localSize / 2; stride > 0; stride /= 2)
+	{
+		if (LID < stride)
+			localSum[LID] += localSum[LID + stride];
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+
+	if (LID == 0)
+	{
+		outArray[get_group_id(0)] = localSum[0];
+	}
+}
@@ -0,0 +1,97 @@
+// Run-length encoding, decoding and unique on top of the work-efficient scan.
+// The host builds this file together with Scan.cl into one program.
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Adjacent difference: 1 for the first element of every run
+__kernel void RLE_HeadFlags(const __global uint* inArray, __global uint* heads, uint N)
+{
+	uint GID = get_global_id(0);
+
+	if (GID >= N)
+	{
+		return;
+	}
+
+	heads[GID] = (GID == 0 || inArray[GID] != inArray[GID - 1]) ? 1 : 0;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Writes the value and the start position of each run.
+// runIndex is the inclusive prefix sum of the head flags, so the first element of run r holds r + 1
+__kernel void RLE_Scatter(const __global uint* inArray, const __global uint* runIndex, __global uint* values, __global uint* runStarts, uint N)
+{
+	uint GID = get_global_id(0);
+
+	if (GID >= N)
+	{
+		return;
+	}
+
+	if (GID == 0 || inArray[GID] != inArray[GID - 1])
+	{
+		uint run = runIndex[GID] - 1;
+		values[run] = inArray[GID];
+		runStarts[run] = GID;
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+__kernel void RLE_Lengths(const __global uint* runStarts, __global uint* lengths, uint nRuns, uint N)
+{
+	uint GID = get_global_id(0);
+
+	if (GID >= nRuns)
+	{
+		return;
+	}
+
+	uint runEnd = (GID + 1 < nRuns) ? runStarts[GID + 1] : N;
+	lengths[GID] = runEnd - runStarts[GID];
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Every work-item expands 4 consecutive output elements and writes them with one vector store.
+// runEnds is the inclusive prefix sum of the run lengths.
+__kernel void RLE_Expand(const __global uint* values, const __global uint* runEnds, __global uint* outArray, uint nRuns, uint N)
+{
+	uint base = 4 * get_global_id(0);
+
+	if (base >= N)
+	{
+		return;
+	}
+
+	// first run that ends behind base
+	uint lo = 0;
+	uint hi = nRuns - 1;
+	while (lo < hi)
+	{
+		uint mid = (lo + hi) / 2;
+		if (runEnds[mid] > base)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+
+	uint out[4];
+	uint run = lo;
+	for (uint k = 0; k < 4; k++)
+	{
+		while (run < nRuns - 1 && base + k >= runEnds[run])
+			run++;
+		out[k] = values[run];
+	}
+
+	if (base + 4 <= N)
+	{
+		vstore4((uint4)(out[0], out[1], out[2], out[3]), get_global_id(0), outArray);
+	}
+	else
+	{
+		for (uint k = 0; base + k < N; k++)
+			outArray[base + k] = out[k];
+	}
+}
@@ -7,7 +7,7 @@ __kernel void Scan_Naive(const __global uint* inArray, __global uint* outArray,
 	// TO DO: Kernel implementation
     uint GID = get_global_id(0);
 
-	if (GID > N) //out of bounds
+	if (GID >= N) //out of bounds
 	{
 		return;
 	}
@@ -40,98 +40,308 @@ __kernel void Scan_Naive(const __global uint* inArray, __global uint* outArray,
 #endif
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-__kernel void Scan_WorkEfficient(__global uint* array, __global uint* higherLevelArray, __local uint* localBlock) 
+// Exclusive work-efficient scan of the 2 * localSize elements stored in localBlock.
+// Has to be called by all work-items of the group, returns the sum of the whole block.
+uint Scan_WorkEfficientLocal(__local uint* localBlock)
 {
-	// TO DO: Kernel implementation
-	uint GID = get_global_id(0);
 	uint LID = get_local_id(0);
 	uint localSize = get_local_size(0);
-	uint globalSize = get_global_size(0);
-	uint groupID = get_group_id(0);
-
-	//store in a 2N elements local memory block the values of the input array
-	//each thread stores 2 elements
+	uint blockSize = 2 * localSize;
 
-	//localBlock[LID * 2] = array[GID * 2];
-	//localBlock[LID * 2 + 1] = array[GID * 2 + 1];
+	// Up-Sweep
+	for (uint stride = 1; stride < blockSize; stride *= 2)
+	{
+		barrier(CLK_LOCAL_MEM_FENCE);
 
-	localBlock[OFFSET(LID)] = array[LID + 2*localSize*groupID];
-	localBlock[OFFSET(LID + localSize)] = array[LID * 2 * localSize * groupID + localSize];
+		uint index = (LID + 1) * 2 * stride - 1;
+		if (index < blockSize)
+		{
+			localBlock[OFFSET(index)] += localBlock[OFFSET(index - stride)];
+		}
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
 
+	uint total = localBlock[OFFSET(blockSize - 1)];
 	barrier(CLK_LOCAL_MEM_FENCE);
 
-	// Up-Sweep
-	for (uint stride = 1; stride*2 <= localSize*2; stride *= 2)
+	if (LID == 0)
 	{
-		if (LID < localSize/(2*stride)) 
-		{
-			//uint index1 = LID * (2 * stride) + stride * 2 - 1;
-			//uint index2 = LID * (2 * stride) + stride - 1;
+		localBlock[OFFSET(blockSize - 1)] = 0;
+	}
 
-			uint index1 = OFFSET(localSize - LID * (2 * stride) - 1);
-			uint index2 = OFFSET(localSize - LID * (2 * stride) - stride - 1);
+	// Down-Sweep
+	for (uint stride = localSize; stride >= 1; stride /= 2)
+	{
+		barrier(CLK_LOCAL_MEM_FENCE);
 
-			localBlock[index1] += localBlock[index2];
+		uint index = (LID + 1) * 2 * stride - 1;
+		if (index < blockSize)
+		{
+			uint val = localBlock[OFFSET(index - stride)];
+			localBlock[OFFSET(index - stride)] = localBlock[OFFSET(index)];
+			localBlock[OFFSET(index)] += val;
 		}
-		barrier(CLK_LOCAL_MEM_FENCE);
 	}
+	barrier(CLK_LOCAL_MEM_FENCE);
 
-	//if (GID == 0) localBlock[localSize * 2 - 1] = 0;
+	return total;
+}
 
-	localBlock[OFFSET(localSize - 1)] = 0;
 
-	barrier(CLK_LOCAL_MEM_FENCE);
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+__kernel void Scan_WorkEfficient(__global uint* array, __global uint* higherLevelArray, uint N, __local uint* localBlock) 
+{
+	uint LID = get_local_id(0);
+	uint localSize = get_local_size(0);
+	uint groupID = get_group_id(0);
 
-	// Down-Sweep
-	for (uint stride = localSize; stride >= 1; stride /= 2)
+	//store in a 2N elements local memory block the values of the input array
+	//each thread stores 2 elements, elements beyond the end of the array are treated as 0
+	uint indexA = 2 * localSize * groupID + LID;
+	uint indexB = indexA + localSize;
+
+	uint valA = (indexA < N) ? array[indexA] : 0;
+	uint valB = (indexB < N) ? array[indexB] : 0;
+
+	localBlock[OFFSET(LID)] = valA;
+	localBlock[OFFSET(LID + localSize)] = valB;
+
+	uint total = Scan_WorkEfficientLocal(localBlock);
+
+	//exclusive prefix sum + own value = inclusive prefix sum
+	if (indexA < N) array[indexA] = localBlock[OFFSET(LID)] + valA;
+	if (indexB < N) array[indexB] = localBlock[OFFSET(LID + localSize)] + valB;
+
+	//the sum of the block goes to the next level
+	if (LID == 0)
 	{
-		if (LID < localSize/stride) 
-		{
-			//uint index1 = LID * (2 * stride) + stride * 2 - 1;
-			//uint index2 = LID * (2 * stride) + stride - 1;
-			//uint val1 = localBlock[index1];
-			//uint val2 = localBlock[index2] + localBlock[index1];
-			//localBlock[index2] = val1;
-			//localBlock[index1] = val2;
-
-			uint index1 = OFFSET(localSize * 2 - LID * (2 * stride) - 1);
-			uint index2 = OFFSET(localSize * 2 - LID * (2 * stride) - stride - 1);
-
-			uint val = localBlock[index1];
-			localBlock[index1] += localBlock[index2];
-			localBlock[index2] = val;
-			
-		}
-		barrier(CLK_LOCAL_MEM_FENCE);
+		higherLevelArray[groupID] = total;
 	}
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Hillis-Steele scan of a block of 2 * localSize elements in local memory, same interface as Scan_WorkEfficient.
+// The log2 steps ping-pong between the two halves of localBlock instead of global buffers,
+// so every element is read and written only once in global memory. The blocks are composed by CScanHierarchy.
+__kernel void Scan_HillisSteele(__global uint* array, __global uint* higherLevelArray, uint N, __local uint* localBlock)
+{
+	uint LID = get_local_id(0);
+	uint localSize = get_local_size(0);
+	uint groupID = get_group_id(0);
+	uint blockSize = 2 * localSize;
+
+	uint indexA = blockSize * groupID + LID;
+	uint indexB = indexA + localSize;
+
+	__local uint* ping = localBlock;
+	__local uint* pong = localBlock + blockSize;
+
+	ping[LID] = (indexA < N) ? array[indexA] : 0;
+	ping[LID + localSize] = (indexB < N) ? array[indexB] : 0;
+
+	for (uint offset = 1; offset < blockSize; offset *= 2)
+	{
+		barrier(CLK_LOCAL_MEM_FENCE);
 
-	//array[GID * 2] = array[GID * 2] + localBlock[LID * 2];
-	//array[GID * 2 + 1] = array[GID * 2 + 1] + localBlock[LID * 2 + 1];
-	array[LID + 2 * localSize * groupID] += localBlock[OFFSET(LID)];
-	array[localSize + LID + 2 * localSize * groupID] += localBlock[OFFSET(localSize + LID)];
+		pong[LID] = (LID >= offset) ? ping[LID] + ping[LID - offset] : ping[LID];
+		pong[LID + localSize] = (LID + localSize >= offset) ? ping[LID + localSize] + ping[LID + localSize - offset] : ping[LID + localSize];
 
-	//if (GID == 0) printf("GID %d: %d \n", GID, localBlock[GID]);
+		__local uint* tmp = ping;
+		ping = pong;
+		pong = tmp;
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	if (indexA < N) array[indexA] = ping[LID];
+	if (indexB < N) array[indexB] = ping[LID + localSize];
 
-	//load from
-	if (LID == localSize - 1)
+	//the sum of the block goes to the next level
+	if (LID == 0)
 	{
-		higherLevelArray[groupID] = array[LID + 2*localSize * groupID + localSize];
+		higherLevelArray[groupID] = ping[blockSize - 1];
 	}
 }
 
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-__kernel void Scan_WorkEfficientAdd(__global uint* higherLevelArray, __global uint* array, __local uint* localBlock) 
+__kernel void Scan_WorkEfficientAdd(__global uint* higherLevelArray, __global uint* array, uint N) 
 {
-	// TO DO: Kernel implementation (large arrays)
 	// Kernel that should add the group PPS to the local PPS (Figure 14)
+	// Two work-groups of this kernel cover one block of Scan_WorkEfficient
 	uint GID = get_global_id(0);
-	uint groupID = get_group_id(0);
+	uint blockID = get_group_id(0) / 2;
 
-	if ((groupID / 2 - 1) < 0)
+	if (blockID == 0 || GID >= N)
 	{
 		return;
 	}
 	
-	array[GID] += higherLevelArray[groupID / 2 - 1];
-}
\ No newline at end of file
+	array[GID] += higherLevelArray[blockID - 1];
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Inclusive scan of count elements starting at start, carry is added to all of them.
+// The group walks over the range in blocks of 2 * localSize elements and carries the running sum.
+void Scan_RangeWithCarry(const __global uint* inArray, __global uint* outArray, size_t start, uint count, uint carry, __local uint* localBlock)
+{
+	uint LID = get_local_id(0);
+	uint localSize = get_local_size(0);
+
+	for (uint blockStart = 0; blockStart < count; blockStart += 2 * localSize)
+	{
+		uint indexA = blockStart + LID;
+		uint indexB = indexA + localSize;
+
+		uint valA = (indexA < count) ? inArray[start + indexA] : 0;
+		uint valB = (indexB < count) ? inArray[start + indexB] : 0;
+
+		localBlock[OFFSET(LID)] = valA;
+		localBlock[OFFSET(LID + localSize)] = valB;
+
+		uint total = Scan_WorkEfficientLocal(localBlock);
+
+		if (indexA < count) outArray[start + indexA] = carry + localBlock[OFFSET(LID)] + valA;
+		if (indexB < count) outArray[start + indexB] = carry + localBlock[OFFSET(LID + localSize)] + valB;
+
+		carry += total;
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Inclusive scan of independent rows, one work-group per row (2D NDRange, get_group_id(1) is the row).
+__kernel void Scan_WorkEfficientRows(const __global uint* inArray, __global uint* outArray, uint width, __local uint* localBlock)
+{
+	Scan_RangeWithCarry(inArray, outArray, (size_t)get_group_id(1) * width, width, 0, localBlock);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Batched scan of independent rows with several work-groups per row, 2D NDRange: (block of the row, row).
+// Pass 1: scans every block of 2 * localSize elements and writes the block sums of each row to
+// blockSums[row * blocksPerRow + block].
+// Pass 2 is Scan_WorkEfficientRows on the block sums, pass 3 is Scan_WorkEfficientBatchedAdd.
+__kernel void Scan_WorkEfficientBatched(const __global uint* inArray, __global uint* outArray, __global uint* blockSums, uint width, __local uint* localBlock)
+{
+	uint LID = get_local_id(0);
+	uint localSize = get_local_size(0);
+	uint block = get_group_id(0);
+	uint blocksPerRow = get_num_groups(0);
+	uint row = get_group_id(1);
+	size_t rowStart = (size_t)row * width;
+
+	uint indexA = 2 * localSize * block + LID;
+	uint indexB = indexA + localSize;
+
+	uint valA = (indexA < width) ? inArray[rowStart + indexA] : 0;
+	uint valB = (indexB < width) ? inArray[rowStart + indexB] : 0;
+
+	localBlock[OFFSET(LID)] = valA;
+	localBlock[OFFSET(LID + localSize)] = valB;
+
+	uint total = Scan_WorkEfficientLocal(localBlock);
+
+	if (indexA < width) outArray[rowStart + indexA] = localBlock[OFFSET(LID)] + valA;
+	if (indexB < width) outArray[rowStart + indexB] = localBlock[OFFSET(LID + localSize)] + valB;
+
+	if (LID == 0)
+	{
+		blockSums[row * blocksPerRow + block] = total;
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Pass 3 of the batched scan: adds the scanned sums of the preceding blocks of the row, 2D NDRange: (element, row)
+__kernel void Scan_WorkEfficientBatchedAdd(const __global uint* blockSums, __global uint* array, uint width)
+{
+	uint x = get_global_id(0);
+	uint row = get_global_id(1);
+	uint blockSize = 2 * get_local_size(0);
+	uint block = x / blockSize;
+
+	if (block == 0 || x >= width)
+	{
+		return;
+	}
+
+	uint blocksPerRow = (width + blockSize - 1) / blockSize;
+	array[(size_t)row * width + x] += blockSums[row * blocksPerRow + block - 1];
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Reduce-then-scan, pass 1: sum of each tile of tileSize elements (one work-group per tile, starting with firstTile).
+// Every work-item accumulates a strided part of the tile, the partial sums are reduced
+// with sequential addressing like in the decomposition reduction.
+__kernel void Scan_ReduceTiles(const __global uint* array, __global uint* tileSums, uint N, uint tileSize, uint firstTile, __local uint* localSum)
+{
+	uint LID = get_local_id(0);
+	uint localSize = get_local_size(0);
+	uint tile = firstTile + get_group_id(0);
+
+	size_t start = (size_t)tile * tileSize;
+	size_t end = min(start + tileSize, (size_t)N);
+
+	uint sum = 0;
+	for (size_t i = start + LID; i < end; i += localSize)
+		sum += array[i];
+
+	localSum[LID] = sum;
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for (uint stride = localSize / 2; stride > 0; stride /= 2)
+	{
+		if (LID < stride)
+			localSum[LID] += localSum[LID + stride];
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+
+	if (LID == 0)
+	{
+		tileSums[tile] = localSum[0];
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Reduce-then-scan, pass 3: scan of each tile (starting with firstTile), starting with the sum of the preceding tiles.
+// Pass 2 is Scan_WorkEfficientRows with a single work-group on the tile sums. inArray and outArray may be the same.
+__kernel void Scan_ScanTiles(const __global uint* inArray, __global uint* outArray, const __global uint* tileSums, uint N, uint tileSize, uint firstTile, __local uint* localBlock)
+{
+	uint tile = firstTile + get_group_id(0);
+
+	size_t start = (size_t)tile * tileSize;
+	uint count = (uint)min((size_t)tileSize, (size_t)N - start);
+	uint carry = (tile > 0) ? tileSums[tile - 1] : 0;
+
+	Scan_RangeWithCarry(inArray, outArray, start, count, carry, localBlock);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Incremental scan: adds the change of the prefix of tile to all elements from start to N.
+// Every work-item adds to 4 consecutive elements, start has to be a multiple of 4.
+__kernel void Scan_AddTileDelta(__global uint* array, uint start, uint N, const __global uint* newTileSums, const __global uint* oldTileSums, uint tile)
+{
+	uint index = start + 4 * get_global_id(0);
+
+	if (index >= N)
+	{
+		return;
+	}
+
+	uint delta = newTileSums[tile] - oldTileSums[tile];
+
+	if (index + 3 < N)
+	{
+		vstore4(vload4(0, array + index) + delta, 0, array + index);
+	}
+	else
+	{
+		for (uint i = index; i < N; i++)
+			array[i] += delta;
+	}
+}
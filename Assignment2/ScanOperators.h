@@ -0,0 +1,119 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _SCAN_OPERATORS_H
+#define _SCAN_OPERATORS_H
+
+#include "../Common/IComputeTask.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+//! Element types and associative operators for CGenericScanTask
+/*!
+	Each operator describes
+	- Type: the element type on the device
+	- HostType: the type the CPU reference is computed in (double for floats,
+	  so the reference is not less accurate than the tree order of the GPU)
+	- CompileOptions(): the -D specialization of GenericScan.cl
+	- Identity(), Apply(): the operator on the host, Apply(L, R) with L preceding R
+	- Equal(): compares a GPU result with the reference
+	- Random(): input values
+*/
+
+//! Running maximum of unsigned integers
+struct CScanOpMaxUInt
+{
+	typedef cl_uint Type;
+	typedef cl_uint HostType;
+
+	static const char* Name() { return "max (uint)"; }
+	static const char* CompileOptions() { return "-D SCAN_T=uint -D SCAN_OP=SCAN_OP_MAX -D SCAN_IDENTITY=0"; }
+
+	static HostType Identity() { return 0; }
+	static HostType ToHost(Type Value) { return Value; }
+	static HostType Apply(HostType L, HostType R) { return L > R ? L : R; }
+	static bool Equal(Type GPU, HostType CPU) { return GPU == CPU; }
+	static Type Random() { return (cl_uint)rand() * (cl_uint)rand(); }
+};
+
+//! Prefix sum of floats
+struct CScanOpAddFloat
+{
+	typedef cl_float Type;
+	typedef double HostType;
+
+	static const char* Name() { return "sum (float)"; }
+	static const char* CompileOptions() { return "-D SCAN_T=float -D SCAN_OP=SCAN_OP_ADD -D SCAN_IDENTITY=0.0f"; }
+
+	static HostType Identity() { return 0.0; }
+	static HostType ToHost(Type Value) { return Value; }
+	static HostType Apply(HostType L, HostType R) { return L + R; }
+	static bool Equal(Type GPU, HostType CPU) { return fabs(GPU - CPU) <= 1e-4 * fabs(CPU) + 1e-4; }
+	static Type Random() { return (float)rand() / (float)RAND_MAX; }
+};
+
+//! Running maximum of floats
+struct CScanOpMaxFloat
+{
+	typedef cl_float Type;
+	typedef cl_float HostType;
+
+	static const char* Name() { return "max (float)"; }
+	static const char* CompileOptions() { return "-D SCAN_T=float -D SCAN_OP=SCAN_OP_MAX -D SCAN_IDENTITY=-INFINITY"; }
+
+	static HostType Identity() { return -INFINITY; }
+	static HostType ToHost(Type Value) { return Value; }
+	static HostType Apply(HostType L, HostType R) { return L > R ? L : R; }
+	static bool Equal(Type GPU, HostType CPU) { return GPU == CPU; }
+	static Type Random() { return 2.0f * (float)rand() / (float)RAND_MAX - 1.0f; }
+};
+
+//! First-order linear recurrence x_i = a_i * x_(i-1) + b_i (first-order IIR filter), elements are (a_i, b_i)
+/*!
+	The scan composes the affine maps, so with x_(-1) = 0 the second component of the
+	i-th result is x_i.
+*/
+struct CScanOpLinearRecurrence
+{
+	typedef cl_float2 Type;
+	struct HostType { double a, b; };
+
+	static const char* Name() { return "linear recurrence (float2)"; }
+	static const char* CompileOptions() { return "-D SCAN_T=float2 -D SCAN_OP=SCAN_OP_LINREC"; }
+
+	static HostType Identity() { HostType h = { 1.0, 0.0 }; return h; }
+	static HostType ToHost(Type Value) { HostType h = { Value.s[0], Value.s[1] }; return h; }
+	static HostType Apply(HostType L, HostType R) { HostType h = { L.a * R.a, R.a * L.b + R.b }; return h; }
+	static bool Equal(Type GPU, HostType CPU)
+	{
+		return fabs(GPU.s[0] - CPU.a) <= 1e-4 * fabs(CPU.a) + 1e-6 &&
+			fabs(GPU.s[1] - CPU.b) <= 1e-4 * fabs(CPU.b) + 1e-4;
+	}
+	static Type Random()
+	{
+		// |a| < 1 keeps the filter stable
+		Type v;
+		v.s[0] = 0.5f + 0.49f * (float)rand() / (float)RAND_MAX;
+		v.s[1] = (float)rand() / (float)RAND_MAX;
+		return v;
+	}
+};
+
+#endif // _SCAN_OPERATORS_H
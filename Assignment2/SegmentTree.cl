@@ -0,0 +1,109 @@
+// Segment tree over uint values, stored level by level in one buffer:
+// level 0 are the values, node i of level l + 1 combines the nodes 2i and 2i + 1 of level l.
+// Compile options: -D SEG_OP=SEG_OP_SUM|SEG_OP_MIN|SEG_OP_MAX
+
+#define SEG_OP_SUM	0
+#define SEG_OP_MIN	1
+#define SEG_OP_MAX	2
+
+#ifndef SEG_OP
+	#define SEG_OP SEG_OP_SUM
+#endif
+
+#if SEG_OP == SEG_OP_SUM
+	#define Seg_Op(A, B) ((A) + (B))
+	#define SEG_IDENTITY 0
+#elif SEG_OP == SEG_OP_MIN
+	#define Seg_Op(A, B) min((A), (B))
+	#define SEG_IDENTITY UINT_MAX
+#elif SEG_OP == SEG_OP_MAX
+	#define Seg_Op(A, B) max((A), (B))
+	#define SEG_IDENTITY 0
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Computes the level above lowerOffset, one work-item per node of the upper level
+__kernel void Seg_BuildLevel(__global uint* tree, uint lowerOffset, uint lowerN, uint upperOffset)
+{
+	uint GID = get_global_id(0);
+	uint left = 2 * GID;
+
+	if (left >= lowerN)
+	{
+		return;
+	}
+
+	uint right = (left + 1 < lowerN) ? tree[lowerOffset + left + 1] : SEG_IDENTITY;
+	tree[upperOffset + GID] = Seg_Op(tree[lowerOffset + left], right);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Answers one query per work-item, a query (l, r) covers the values [l, r).
+// Walks up the levels and takes the nodes at the borders of the range: at most 2 nodes per level.
+__kernel void Seg_Query(const __global uint* tree, __constant uint* levelOffsets, const __global uint2* queries, __global uint* results, uint nQueries)
+{
+	uint GID = get_global_id(0);
+
+	if (GID >= nQueries)
+	{
+		return;
+	}
+
+	uint2 query = queries[GID];
+	uint l = query.x;
+	uint r = query.y;
+
+	uint result = SEG_IDENTITY;
+	for (uint level = 0; l < r; level++)
+	{
+		__global const uint* nodes = tree + levelOffsets[level];
+
+		if (l & 1)
+			result = Seg_Op(result, nodes[l++]);
+		if (r & 1)
+			result = Seg_Op(result, nodes[--r]);
+
+		l >>= 1;
+		r >>= 1;
+	}
+
+	results[GID] = result;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Point updates (index, value), step 1: writes the new values.
+// The indices of a batch have to be unique.
+__kernel void Seg_UpdateValues(__global uint* tree, const __global uint2* updates, uint nUpdates)
+{
+	uint GID = get_global_id(0);
+
+	if (GID >= nUpdates)
+	{
+		return;
+	}
+
+	uint2 update = updates[GID];
+	tree[update.x] = update.y;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Point updates, step 2: recomputes the ancestor of every update on the level above lowerOffset.
+// One launch per level, so the lower level is complete. Updates that share an ancestor write the same value.
+__kernel void Seg_UpdateLevel(__global uint* tree, const __global uint2* updates, uint nUpdates, uint upperLevel, uint lowerOffset, uint lowerN, uint upperOffset)
+{
+	uint GID = get_global_id(0);
+
+	if (GID >= nUpdates)
+	{
+		return;
+	}
+
+	uint node = updates[GID].x >> upperLevel;
+	uint left = 2 * node;
+
+	uint right = (left + 1 < lowerN) ? tree[lowerOffset + left + 1] : SEG_IDENTITY;
+	tree[upperOffset + node] = Seg_Op(tree[lowerOffset + left], right);
+}
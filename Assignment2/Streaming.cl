@@ -0,0 +1,52 @@
+// Kernels for scans and reductions that stream the input through the device in chunks.
+// The host builds this file together with Scan.cl into one program.
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Adds the total of all preceding chunks to the scanned chunk and passes the new total on.
+// The two carries are separate buffers, so no work-item overwrites the carry that others still read.
+__kernel void Stream_AddCarry(__global uint* array, uint N, const __global uint* carryIn, __global uint* carryOut)
+{
+	uint GID = get_global_id(0);
+
+	if (GID >= N)
+	{
+		return;
+	}
+
+	uint value = array[GID] + carryIn[0];
+	array[GID] = value;
+
+	if (GID == N - 1)
+	{
+		carryOut[0] = value;
+	}
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Partial sums of a chunk, one per work-group, written to partials[partialOffset + group].
+// The work-groups stride over the whole chunk, so the number of partials does not depend on the chunk size.
+__kernel void Stream_ReduceChunk(const __global uint* array, uint N, __global uint* partials, uint partialOffset, __local uint* localSum)
+{
+	uint LID = get_local_id(0);
+	uint localSize = get_local_size(0);
+
+	uint sum = 0;
+	for (uint i = get_global_id(0); i < N; i += get_global_size(0))
+		sum += array[i];
+
+	localSum[LID] = sum;
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for (uint stride = localSize / 2; stride > 0; stride /= 2)
+	{
+		if (LID < stride)
+			localSum[LID] += localSum[LID + stride];
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+
+	if (LID == 0)
+	{
+		partials[partialOffset + get_group_id(0)] = localSum[0];
+	}
+}
@@ -6,8 +6,11 @@ GPU Computing / GPGPU Praktikum source code.
 #include "CAssignmentBase.h"
 
 #include "CLUtil.h"
+#include "CProgramBuilder.h"
+#include "CTuningDatabase.h"
 #include "CTimer.h"
 
+#include <algorithm>
 #include <vector>
 #include <iostream>
 
@@ -45,8 +48,21 @@ CAssignmentBase::~CAssignmentBase()
 	ReleaseCLContext();
 }
 
-bool CAssignmentBase::EnterMainLoop(int, char**)
+bool CAssignmentBase::EnterMainLoop(int argc, char** argv)
 {
+	m_Arguments.assign(argv + min(argc, 1), argv + argc);
+
+	// --kernel-dir Directory: load the kernel sources from Directory instead of the embedded copies
+	string kernelDirectory = GetArgumentValue("--kernel-dir", "");
+	if (!kernelDirectory.empty())
+		CLUtil::SetKernelSourceDirectory(kernelDirectory);
+
+	// --no-tune: keep the default launch configurations, --retune: tune again despite stored entries,
+	// --tuning-db File: the tuning database (TuningDatabase.txt)
+	CTuningDatabase::SetEnabled(!HasArgument("--no-tune"));
+	CTuningDatabase::SetRetune(HasArgument("--retune"));
+	CTuningDatabase::SetFileName(GetArgumentValue("--tuning-db", "TuningDatabase.txt"));
+
 	if(!InitCLContext())
 		return false;
 
@@ -81,8 +97,11 @@ bool CAssignmentBase::InitCLContext()
 	int countAllDevices = 0;
 
 	// Searching for the graphics device with the most dedicated video memory.
+	// --unified-memory: searching among the devices that share the host memory instead (integrated GPUs),
+	// where the zero-copy transfers of CTransferBuffer avoid copies.
 
 	cl_device_type deviceType = CL_DEVICE_TYPE_GPU;
+	bool preferUnifiedMemory = HasArgument("--unified-memory");
 
 	cl_ulong maxGlobalMemorySize = 0;
 	cl_device_id bestDeviceId = NULL;
@@ -108,7 +127,7 @@ bool CAssignmentBase::InitCLContext()
 			clGetDeviceInfo(currentDeviceId, CL_DEVICE_GLOBAL_MEM_SIZE, sizeof(cl_ulong), &globalMemorySize, NULL);
 			clGetDeviceInfo(currentDeviceId, CL_DEVICE_HOST_UNIFIED_MEMORY, sizeof(cl_bool), &isUsingUnifiedMemory, NULL);
 
-			if (!isUsingUnifiedMemory && globalMemorySize > maxGlobalMemorySize)
+			if ((isUsingUnifiedMemory == CL_TRUE) == preferUnifiedMemory && globalMemorySize > maxGlobalMemorySize)
 			{
 				bestDeviceId = currentDeviceId;
 				maxGlobalMemorySize = globalMemorySize;
@@ -125,7 +144,7 @@ bool CAssignmentBase::InitCLContext()
 		return false;
 	}
 
-	// No discrete graphics device was found: falling back to the first found device.
+	// No device of the preferred memory type was found: falling back to the first found device.
 	if (bestDeviceId == NULL)
 	{
 		bestDeviceId = deviceIds[0];
@@ -151,6 +170,9 @@ bool CAssignmentBase::InitCLContext()
 	cl_ulong localMemorySize;
 	clGetDeviceInfo(m_CLDevice, CL_DEVICE_LOCAL_MEM_SIZE, sizeof(cl_ulong), &localMemorySize, &bufferSize);
 	std::cout << "Local memory size: " << localMemorySize << " Byte" << std::endl;
+	cl_bool hostUnifiedMemory = CL_FALSE;
+	clGetDeviceInfo(m_CLDevice, CL_DEVICE_HOST_UNIFIED_MEMORY, sizeof(cl_bool), &hostUnifiedMemory, NULL);
+	std::cout << "Host unified memory: " << (hostUnifiedMemory ? "yes (zero-copy transfers available)" : "no") << std::endl;
 	std::cout << std::endl << "******************************" << std::endl << std::endl;
 
         
@@ -163,8 +185,9 @@ bool CAssignmentBase::InitCLContext()
 	// Finally, create a command queue. All the asynchronous commands to the device will be issued
 	// from the CPU into this queue. This way the host program can continue the execution until some results
 	// from that device are needed.
+	// Profiling is enabled so that the tasks can read the device timestamps of their commands from events.
 
-	m_CLCommandQueue = clCreateCommandQueue(m_CLContext, m_CLDevice, 0, &clError);
+	m_CLCommandQueue = clCreateCommandQueue(m_CLContext, m_CLDevice, CL_QUEUE_PROFILING_ENABLE, &clError);
 	V_RETURN_FALSE_CL(clError, "Failed to create the command queue in the context");
 
 	return true;
@@ -172,6 +195,10 @@ bool CAssignmentBase::InitCLContext()
 
 void CAssignmentBase::ReleaseCLContext()
 {
+	// builds nobody picked up and the cached specializations still use the context
+	CProgramBuilder::Shutdown();
+	CLUtil::ReleaseSpecializedPrograms();
+
 	if (m_CLCommandQueue != nullptr)
 	{
 		clReleaseCommandQueue(m_CLCommandQueue);
@@ -199,11 +226,18 @@ bool CAssignmentBase::RunComputeTask(IComputeTask& Task, size_t LocalWorkSize[3]
 		return false;
 	}
 
-	// Compute the golden result.
+	// Compute the golden result, the programs of the task keep compiling in the background meanwhile.
 	cout << "Computing CPU reference result..." << endl;
 	Task.ComputeCPU();
 	cout << "DONE" << endl;
 
+	if(!Task.InitPrograms(m_CLDevice, m_CLContext))
+	{
+		std::cerr << "Error during program creation. Aborting execution." <<endl;
+		Task.ReleaseResources();
+		return false;
+	}
+
 	// Running the same task on the GPU.
 	cout << "Computing GPU result...";
 
@@ -227,4 +261,18 @@ bool CAssignmentBase::RunComputeTask(IComputeTask& Task, size_t LocalWorkSize[3]
 	return true;
 }
 
+bool CAssignmentBase::HasArgument(const string& Argument) const
+{
+	return find(m_Arguments.begin(), m_Arguments.end(), Argument) != m_Arguments.end();
+}
+
+string CAssignmentBase::GetArgumentValue(const string& Argument, const string& Default) const
+{
+	vector<string>::const_iterator it = find(m_Arguments.begin(), m_Arguments.end(), Argument);
+	if (it == m_Arguments.end() || it + 1 == m_Arguments.end())
+		return Default;
+
+	return *(it + 1);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
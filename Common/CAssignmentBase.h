@@ -24,6 +24,9 @@
 
 #include "CommonDefs.h"
 
+#include <string>
+#include <vector>
+
 //! Base class for all assignments
 /*! 
 	Inherit a new class for each specific assignment.
@@ -55,10 +58,19 @@ protected:
 
 	virtual bool RunComputeTask(IComputeTask& Task, size_t LocalWorkSize[3]);
 
+	//! True if Argument was passed on the command line
+	bool HasArgument(const std::string& Argument) const;
+
+	//! The command line argument behind Argument, or Default if there is none
+	std::string GetArgumentValue(const std::string& Argument, const std::string& Default) const;
+
 	cl_platform_id		m_CLPlatform;
 	cl_device_id		m_CLDevice;
 	cl_context			m_CLContext;
 	cl_command_queue	m_CLCommandQueue;
+
+	// command line arguments without the program name
+	std::vector<std::string>	m_Arguments;
 };
 
 #endif // _CASSIGNMENT_BASE_H
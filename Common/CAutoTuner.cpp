@@ -0,0 +1,124 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+
+#include "CAutoTuner.h"
+
+#include "CTimer.h"
+
+#include <algorithm>
+#include <iostream>
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// CAutoTuner
+
+CAutoTuner::CAutoTuner(cl_device_id Device)
+	: m_Device(Device), m_MinLocalWorkSize(1), m_MaxLocalWorkSize(1024)
+{
+	unsigned int elementsPerThread[] = { 1, 2, 4, 8, 16 };
+	unsigned int vectorWidths[] = { 1, 2, 4 };
+	unsigned int unrollFactors[] = { 1, 2, 4 };
+	m_ElementsPerThread.assign(elementsPerThread, elementsPerThread + ARRAYLEN(elementsPerThread));
+	m_VectorWidths.assign(vectorWidths, vectorWidths + ARRAYLEN(vectorWidths));
+	m_UnrollFactors.assign(unrollFactors, unrollFactors + ARRAYLEN(unrollFactors));
+
+	CBenchmark::SSettings& settings = m_Benchmark.GetSettings();
+	settings.WarmupIterations = 1;
+	settings.MinIterations = 5;
+	settings.MaxIterations = 50;
+	settings.MaxSeconds = 0.5;
+	settings.TargetRelativeCI = 0.05;
+}
+
+vector<size_t> CAutoTuner::GetLocalWorkSizes(cl_kernel Kernel) const
+{
+	vector<size_t> localWorkSizes;
+
+	size_t maxWorkGroupSize = 0;
+	size_t preferredMultiple = 1;
+	cl_int clError = clGetKernelWorkGroupInfo(Kernel, m_Device, CL_KERNEL_WORK_GROUP_SIZE, sizeof(size_t), &maxWorkGroupSize, NULL);
+	if (clError != CL_SUCCESS)
+	{
+		cerr << "Error: Failed to query CL_KERNEL_WORK_GROUP_SIZE [" << CLUtil::GetCLErrorString(clError) << "]" << endl;
+		return localWorkSizes;
+	}
+	if (clGetKernelWorkGroupInfo(Kernel, m_Device, CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE, sizeof(size_t), &preferredMultiple, NULL) != CL_SUCCESS ||
+		preferredMultiple == 0)
+		preferredMultiple = 1;
+
+	// the kernels reduce in local memory by halving, so only powers of two
+	for (size_t localWorkSize = 1; localWorkSize <= min(maxWorkGroupSize, m_MaxLocalWorkSize); localWorkSize *= 2)
+		if (localWorkSize >= preferredMultiple && localWorkSize >= m_MinLocalWorkSize)
+			localWorkSizes.push_back(localWorkSize);
+
+	return localWorkSizes;
+}
+
+bool CAutoTuner::Tune(const string& Kernel, size_t N, const TBuildFunction& Build, const TValidateFunction& Validate,
+	const TRunFunction& Run, STuningConfig& Best)
+{
+	cout << "Tuning " << Kernel << " for " << N << " elements..." << endl;
+
+	CTimer timer;
+	timer.Start();
+
+	double bestTime = -1.0;
+	unsigned int nTried = 0, nSkipped = 0;
+
+	for (size_t e = 0; e < m_ElementsPerThread.size(); e++)
+		for (size_t v = 0; v < m_VectorWidths.size(); v++)
+			for (size_t u = 0; u < m_UnrollFactors.size(); u++)
+			{
+				// unrolling further than the loop is long does not change the code
+				if (m_UnrollFactors[u] > m_ElementsPerThread[e])
+					continue;
+
+				STuningConfig config(0, m_ElementsPerThread[e], m_VectorWidths[v], m_UnrollFactors[u]);
+				cl_kernel kernel = Build(config);
+				if (kernel == NULL)
+				{
+					nSkipped++;
+					continue;
+				}
+
+				vector<size_t> localWorkSizes = GetLocalWorkSizes(kernel);
+				for (size_t l = 0; l < localWorkSizes.size(); l++)
+				{
+					config.LocalWorkSize = localWorkSizes[l];
+					if (!Validate(config))
+					{
+						nSkipped++;
+						continue;
+					}
+
+					CBenchmark::SResult result = m_Benchmark.Run([&]() { Run(config); });
+					nTried++;
+
+					if (bestTime < 0.0 || result.Median < bestTime)
+					{
+						bestTime = result.Median;
+						Best = config;
+					}
+				}
+			}
+
+	timer.Stop();
+
+	if (bestTime < 0.0)
+	{
+		cout << "  no valid configuration found (" << nSkipped << " skipped)" << endl;
+		return false;
+	}
+
+	cout << "  " << nTried << " configurations timed, " << nSkipped << " skipped in " << timer.GetElapsedMilliseconds() / 1000.0 << " s" << endl;
+	cout << "  best: " << Best.ToString() << ", " << bestTime << " ms" << endl;
+
+	CTuningDatabase::Store(Kernel, m_Device, N, Best, bestTime);
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
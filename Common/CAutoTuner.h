@@ -0,0 +1,84 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CAUTO_TUNER_H
+#define _CAUTO_TUNER_H
+
+#include "CLUtil.h"
+#include "CBenchmark.h"
+#include "CTuningDatabase.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+//! Exhaustive search over the launch configurations of a kernel
+/*!
+	For every combination of elements per thread, vector width and unroll factor the task
+	builds the kernel, then every local work size the built kernel supports is validated and timed.
+	The fastest valid configuration is stored in CTuningDatabase.
+
+	The local work sizes are powers of two of at least CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE
+	and at most CL_KERNEL_WORK_GROUP_SIZE, which depends on the compile options, so it is queried per build.
+*/
+class CAutoTuner
+{
+public:
+	//! Builds the kernel for the compile-time parameters of Config (LocalWorkSize is not set), NULL if it does not build.
+	//! The caller keeps the ownership of the kernel.
+	typedef std::function<cl_kernel(const STuningConfig& Config)> TBuildFunction;
+
+	//! False if the task does not support Config or its result is wrong, the configuration is then skipped
+	typedef std::function<bool(const STuningConfig& Config)> TValidateFunction;
+
+	//! One timed run, it has to wait for the device (e.g. with clFinish)
+	typedef std::function<void(const STuningConfig& Config)> TRunFunction;
+
+	CAutoTuner(cl_device_id Device);
+
+	//! Candidate values of the compile-time parameters, a single value leaves the parameter out of the search
+	void SetElementsPerThread(const std::vector<unsigned int>& Values) { m_ElementsPerThread = Values; }
+	void SetVectorWidths(const std::vector<unsigned int>& Values) { m_VectorWidths = Values; }
+	void SetUnrollFactors(const std::vector<unsigned int>& Values) { m_UnrollFactors = Values; }
+
+	//! Local work sizes outside [Min, Max] are not tried
+	void SetLocalWorkSizeRange(size_t Min, size_t Max) { m_MinLocalWorkSize = Min; m_MaxLocalWorkSize = Max; }
+
+	//! Local work sizes in the range that the built Kernel can be launched with on the device
+	std::vector<size_t> GetLocalWorkSizes(cl_kernel Kernel) const;
+
+	//! Searches all configurations of Kernel for N elements and stores the fastest, false if none was valid
+	bool Tune(const std::string& Kernel, size_t N, const TBuildFunction& Build, const TValidateFunction& Validate,
+		const TRunFunction& Run, STuningConfig& Best);
+
+protected:
+
+	cl_device_id				m_Device;
+
+	std::vector<unsigned int>	m_ElementsPerThread;
+	std::vector<unsigned int>	m_VectorWidths;
+	std::vector<unsigned int>	m_UnrollFactors;
+	size_t						m_MinLocalWorkSize;
+	size_t						m_MaxLocalWorkSize;
+
+	// fewer iterations than the performance tests, the search only has to rank the configurations
+	CBenchmark					m_Benchmark;
+};
+
+#endif // _CAUTO_TUNER_H
@@ -0,0 +1,128 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+#include "CBenchmark.h"
+
+#include "CTimer.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// CBenchmark
+
+CBenchmark::SSettings::SSettings()
+	: WarmupIterations(3), MinIterations(10), MaxIterations(1000), MaxSeconds(5.0),
+	TargetRelativeCI(0.02), OutlierThreshold(5.0)
+{
+}
+
+CBenchmark::CBenchmark()
+{
+}
+
+CBenchmark::CBenchmark(const SSettings& Settings)
+	: m_Settings(Settings)
+{
+}
+
+CBenchmark::SResult CBenchmark::Run(const function<void()>& Iteration)
+{
+	for (unsigned int i = 0; i < m_Settings.WarmupIterations; i++)
+		Iteration();
+
+	vector<double> samples;
+	vector<double> sorted;
+	SResult result = SResult();
+
+	CTimer totalTimer;
+	totalTimer.Start();
+
+	CTimer timer;
+	while (samples.size() < max(m_Settings.MaxIterations, 1u))
+	{
+		timer.Start();
+		Iteration();
+		timer.Stop();
+		samples.push_back(timer.GetElapsedMilliseconds());
+
+		if (samples.size() < m_Settings.MinIterations)
+			continue;
+
+		sorted = samples;
+		result = Evaluate(sorted, m_Settings.OutlierThreshold);
+		if (result.ConfidenceInterval <= m_Settings.TargetRelativeCI * result.Mean)
+		{
+			result.bConverged = true;
+			return result;
+		}
+
+		totalTimer.Stop();
+		if (totalTimer.GetElapsedMilliseconds() > 1000.0 * m_Settings.MaxSeconds)
+			break;
+	}
+
+	sorted = samples;
+	return Evaluate(sorted, m_Settings.OutlierThreshold);
+}
+
+CBenchmark::SResult CBenchmark::Evaluate(vector<double>& Samples, double OutlierThreshold)
+{
+	SResult result = SResult();
+	if (Samples.empty())
+		return result;
+
+	sort(Samples.begin(), Samples.end());
+	result.Min = Samples.front();
+
+	// the median absolute deviation is not inflated by the outliers themselves, 1.4826 scales it to a standard deviation
+	double median = Samples[Samples.size() / 2];
+	vector<double> deviations(Samples.size());
+	for (size_t i = 0; i < Samples.size(); i++)
+		deviations[i] = fabs(Samples[i] - median);
+	sort(deviations.begin(), deviations.end());
+	double robustStddev = 1.4826 * deviations[deviations.size() / 2];
+
+	// only slow samples are dropped (interrupts, other processes), a fast sample is a real measurement
+	size_t n = Samples.size();
+	if (robustStddev > 0.0)
+		while (n > 1 && Samples[n - 1] > median + OutlierThreshold * robustStddev)
+			n--;
+
+	result.Iterations = (unsigned int)Samples.size();
+	result.Outliers = (unsigned int)(Samples.size() - n);
+	result.Median = (n % 2) ? Samples[n / 2] : 0.5 * (Samples[n / 2 - 1] + Samples[n / 2]);
+	result.P95 = Samples[min(n - 1, (size_t)ceil(0.95 * (double)n) - 1)];
+
+	double sum = 0.0;
+	for (size_t i = 0; i < n; i++)
+		sum += Samples[i];
+	result.Mean = sum / (double)n;
+
+	double squares = 0.0;
+	for (size_t i = 0; i < n; i++)
+		squares += (Samples[i] - result.Mean) * (Samples[i] - result.Mean);
+	result.Stddev = (n > 1) ? sqrt(squares / (double)(n - 1)) : 0.0;
+	result.ConfidenceInterval = 1.96 * result.Stddev / sqrt((double)n);
+
+	return result;
+}
+
+void CBenchmark::Print(const SResult& Result, size_t Elements, size_t Bytes, ostream& Stream)
+{
+	Stream << "  median time: " << Result.Median << " ms, throughput: "
+		<< 1.0e-6 * (double)Elements / Result.Median << " Gelem/s, "
+		<< 1.0e-6 * (double)Bytes / Result.Median << " GB/s" << endl;
+	Stream << "  min " << Result.Min << " ms, p95 " << Result.P95 << " ms, mean " << Result.Mean
+		<< " +- " << Result.ConfidenceInterval << " ms (95%), stddev " << Result.Stddev << " ms" << endl;
+	Stream << "  " << Result.Iterations << " iterations, " << Result.Outliers << " outliers dropped";
+	if (!Result.bConverged)
+		Stream << ", confidence target not reached";
+	Stream << endl;
+}
+
+///////////////////////////////////////////////////////////////////////////////
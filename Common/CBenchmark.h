@@ -0,0 +1,90 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CBENCHMARK_H
+#define _CBENCHMARK_H
+
+#include <functional>
+#include <iostream>
+#include <vector>
+
+//! Repeats a measured operation until its timing is stable and reports robust statistics
+/*!
+	Run() first calls the operation WarmupIterations times without timing it (JIT compilation,
+	lazy allocations, clock ramp-up), then times single iterations until the 95% confidence
+	interval of the mean is within TargetRelativeCI of the mean, or until MaxIterations or
+	MaxSeconds is reached.
+
+	The operation has to synchronize with the device itself (e.g. end with clFinish),
+	every iteration is timed on the host.
+*/
+class CBenchmark
+{
+public:
+
+	struct SSettings
+	{
+		SSettings();
+
+		unsigned int	WarmupIterations;
+		unsigned int	MinIterations;
+		unsigned int	MaxIterations;
+		//! stop iterating after this time even if the confidence target was not met
+		double			MaxSeconds;
+		//! half width of the 95% confidence interval relative to the mean
+		double			TargetRelativeCI;
+		//! samples further than OutlierThreshold robust standard deviations (median absolute deviation) above the median are dropped
+		double			OutlierThreshold;
+	};
+
+	//! All times in ms, computed from the samples that remain after the outlier rejection (except Min)
+	struct SResult
+	{
+		unsigned int	Iterations;
+		unsigned int	Outliers;
+		double			Min;
+		double			Median;
+		double			P95;
+		double			Mean;
+		double			Stddev;
+		//! half width of the 95% confidence interval of the mean
+		double			ConfidenceInterval;
+		bool			bConverged;
+	};
+
+	CBenchmark();
+
+	CBenchmark(const SSettings& Settings);
+
+	SSettings& GetSettings() { return m_Settings; }
+
+	SResult Run(const std::function<void()>& Iteration);
+
+	//! Prints Result, the throughput is based on the median time
+	static void Print(const SResult& Result, size_t Elements, size_t Bytes, std::ostream& Stream = std::cout);
+
+protected:
+
+	//! Statistics of the samples in ms, Samples is sorted in place
+	static SResult Evaluate(std::vector<double>& Samples, double OutlierThreshold);
+
+	SSettings		m_Settings;
+};
+
+#endif // _CBENCHMARK_H
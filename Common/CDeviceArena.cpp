@@ -0,0 +1,83 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+#include "CDeviceArena.h"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// CDeviceArena
+
+CDeviceArena::CDeviceArena()
+	: m_Alignment(128), m_Size(0), m_dBuffer(NULL)
+{
+}
+
+CDeviceArena::~CDeviceArena()
+{
+	Release();
+}
+
+void CDeviceArena::Init(cl_device_id Device)
+{
+	// the device reports the alignment in bits
+	cl_uint baseAddrAlign = 0;
+	if (clGetDeviceInfo(Device, CL_DEVICE_MEM_BASE_ADDR_ALIGN, sizeof(cl_uint), &baseAddrAlign, NULL) == CL_SUCCESS && baseAddrAlign >= 8)
+		m_Alignment = baseAddrAlign / 8;
+}
+
+size_t CDeviceArena::Align(size_t Size) const
+{
+	return (Size + m_Alignment - 1) / m_Alignment * m_Alignment;
+}
+
+unsigned int CDeviceArena::Reserve(size_t Size)
+{
+	m_RegionOffsets.push_back(m_Size);
+	m_RegionSizes.push_back(Size);
+	m_Size += Align(Size);
+
+	return (unsigned int)m_RegionSizes.size() - 1;
+}
+
+bool CDeviceArena::Allocate(cl_context Context, cl_mem_flags Flags)
+{
+	cl_int clError;
+	m_dBuffer = clCreateBuffer(Context, Flags, m_Size, NULL, &clError);
+	V_RETURN_FALSE_CL(clError, "Error allocating the device arena");
+
+	return true;
+}
+
+cl_mem CDeviceArena::CreateSubBuffer(unsigned int Region, size_t Offset, size_t Size, cl_mem_flags Flags)
+{
+	if (Size == 0)
+		Size = m_RegionSizes[Region] - Offset;
+
+	cl_buffer_region region = { m_RegionOffsets[Region] + Offset, Size };
+
+	cl_int clError;
+	cl_mem subBuffer = clCreateSubBuffer(m_dBuffer, Flags, CL_BUFFER_CREATE_TYPE_REGION, &region, &clError);
+	V_RETURN_0_CL(clError, "Error creating a sub-buffer of the device arena");
+
+	return subBuffer;
+}
+
+void CDeviceArena::Release()
+{
+	SAFE_RELEASE_MEMOBJECT(m_dBuffer);
+
+	m_Size = 0;
+	m_RegionOffsets.clear();
+	m_RegionSizes.clear();
+}
+
+void CDeviceArena::PrintStatistics(size_t SeparateSize, double AllocationTimeMs) const
+{
+	cout << "  device arena: " << GetNumRegions() << " regions, " << m_Size / (1024.0 * 1024.0) << " MB in one allocation"
+		<< " (separate buffers: " << SeparateSize / (1024.0 * 1024.0) << " MB), allocated in " << AllocationTimeMs << " ms" << endl;
+}
+
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,79 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CDEVICE_ARENA_H
+#define _CDEVICE_ARENA_H
+
+#include "CLUtil.h"
+
+#include <vector>
+
+//! One device allocation that is split into sub-buffers
+/*!
+	A task reserves all regions it needs first, then Allocate() creates a single buffer
+	and the regions are handed out as sub-buffers with CreateSubBuffer().
+	The regions start at multiples of CL_DEVICE_MEM_BASE_ADDR_ALIGN, as required for sub-buffers.
+
+	The sub-buffers are owned by the caller and released with SAFE_RELEASE_MEMOBJECT as usual,
+	the backing buffer stays alive until the arena and all its sub-buffers are released.
+*/
+class CDeviceArena
+{
+public:
+	CDeviceArena();
+
+	virtual ~CDeviceArena();
+
+	//! Queries the sub-buffer alignment of the device, call before reserving regions
+	void Init(cl_device_id Device);
+
+	//! Size rounded up to the sub-buffer alignment
+	size_t Align(size_t Size) const;
+
+	//! Reserves a region of Size bytes and returns its index
+	unsigned int Reserve(size_t Size);
+
+	//! Creates the backing buffer for all reserved regions
+	bool Allocate(cl_context Context, cl_mem_flags Flags = CL_MEM_READ_WRITE);
+
+	//! Sub-buffer of Size bytes at Offset within a region, Size 0 means up to the end of the region.
+	//! Offset has to be aligned (see Align()).
+	cl_mem CreateSubBuffer(unsigned int Region, size_t Offset = 0, size_t Size = 0, cl_mem_flags Flags = CL_MEM_READ_WRITE);
+
+	void Release();
+
+	//! Size of the backing buffer in bytes
+	size_t GetSize() const { return m_Size; }
+
+	unsigned int GetNumRegions() const { return (unsigned int)m_RegionSizes.size(); }
+
+	//! Prints the footprint of the arena, SeparateSize is the footprint without the arena for comparison
+	void PrintStatistics(size_t SeparateSize, double AllocationTimeMs) const;
+
+protected:
+	size_t					m_Alignment;
+	size_t					m_Size;
+
+	std::vector<size_t>		m_RegionOffsets;
+	std::vector<size_t>		m_RegionSizes;
+
+	cl_mem					m_dBuffer;
+};
+
+#endif // _CDEVICE_ARENA_H
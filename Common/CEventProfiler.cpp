@@ -0,0 +1,154 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+#include "CEventProfiler.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// CEventProfiler
+
+CEventProfiler::CEventProfiler()
+	: m_bEnabled(false)
+{
+}
+
+CEventProfiler::~CEventProfiler()
+{
+	Clear();
+}
+
+cl_event* CEventProfiler::Event(const string& Name, int Level)
+{
+	if (!m_bEnabled)
+		return NULL;
+
+	SRecord record;
+	record.Name = Name;
+	record.Level = Level;
+	record.Event = NULL;
+	m_Records.push_back(record);
+
+	return &m_Records.back().Event;
+}
+
+bool CEventProfiler::GetTimes(cl_event Event, cl_ulong Times[4])
+{
+	const cl_profiling_info infos[4] = { CL_PROFILING_COMMAND_QUEUED, CL_PROFILING_COMMAND_SUBMIT, CL_PROFILING_COMMAND_START, CL_PROFILING_COMMAND_END };
+
+	if (Event == NULL || clWaitForEvents(1, &Event) != CL_SUCCESS)
+		return false;
+
+	for (int i = 0; i < 4; i++)
+		if (clGetEventProfilingInfo(Event, infos[i], sizeof(cl_ulong), &Times[i], NULL) != CL_SUCCESS)
+			return false;
+
+	return true;
+}
+
+double CEventProfiler::GetDeviceTime()
+{
+	cl_ulong total = 0;
+	for (size_t i = 0; i < m_Records.size(); i++)
+	{
+		cl_ulong times[4];
+		if (GetTimes(m_Records[i].Event, times))
+			total += times[3] - times[2];
+	}
+
+	return 1.0e-6 * (double)total;
+}
+
+void CEventProfiler::Report(ostream& Stream)
+{
+	if (m_Records.empty())
+		return;
+
+	// the timestamps of all commands, the earliest queued time is the origin
+	vector<cl_ulong> times(4 * m_Records.size());
+	vector<bool> bValid(m_Records.size());
+	cl_ulong origin = 0;
+	bool bHaveOrigin = false;
+	for (size_t i = 0; i < m_Records.size(); i++)
+	{
+		bValid[i] = GetTimes(m_Records[i].Event, &times[4 * i]);
+		if (bValid[i] && (!bHaveOrigin || times[4 * i] < origin))
+		{
+			origin = times[4 * i];
+			bHaveOrigin = true;
+		}
+	}
+
+	if (!bHaveOrigin)
+	{
+		Stream << "  no profiling information, the queue needs CL_QUEUE_PROFILING_ENABLE" << endl;
+		return;
+	}
+
+	Stream << "  device profile (us since the first command was queued):" << endl;
+	Stream << "    " << left << setw(36) << "command" << right << setw(12) << "queued" << setw(12) << "submit"
+		<< setw(12) << "start" << setw(12) << "end" << setw(12) << "duration" << endl;
+
+	// device time per command name, in the order of the first launch
+	vector<string> names;
+	vector<cl_ulong> nameTimes;
+	vector<unsigned int> nameCounts;
+
+	Stream << fixed << setprecision(1);
+	for (size_t i = 0; i < m_Records.size(); i++)
+	{
+		if (!bValid[i])
+			continue;
+
+		const SRecord& record = m_Records[i];
+		const cl_ulong* t = &times[4 * i];
+
+		string label = record.Name;
+		if (record.Level >= 0)
+		{
+			stringstream levelLabel;
+			levelLabel << record.Name << " level " << record.Level;
+			label = levelLabel.str();
+		}
+
+		Stream << "    " << left << setw(36) << label << right;
+		for (int j = 0; j < 4; j++)
+			Stream << setw(12) << 1.0e-3 * (double)(t[j] - origin);
+		Stream << setw(12) << 1.0e-3 * (double)(t[3] - t[2]) << endl;
+
+		size_t n = find(names.begin(), names.end(), record.Name) - names.begin();
+		if (n == names.size())
+		{
+			names.push_back(record.Name);
+			nameTimes.push_back(0);
+			nameCounts.push_back(0);
+		}
+		nameTimes[n] += t[3] - t[2];
+		nameCounts[n]++;
+	}
+
+	for (size_t n = 0; n < names.size(); n++)
+		Stream << "    " << left << setw(36) << names[n] << right << nameCounts[n] << " commands, "
+			<< 1.0e-3 * (double)nameTimes[n] << " us on the device" << endl;
+
+	Stream.unsetf(ios_base::floatfield);
+	Stream << setprecision(6);
+}
+
+void CEventProfiler::Clear()
+{
+	for (size_t i = 0; i < m_Records.size(); i++)
+		if (m_Records[i].Event != NULL)
+			clReleaseEvent(m_Records[i].Event);
+
+	m_Records.clear();
+}
+
+///////////////////////////////////////////////////////////////////////////////
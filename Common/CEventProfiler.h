@@ -0,0 +1,79 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CEVENT_PROFILER_H
+#define _CEVENT_PROFILER_H
+
+#include "CLUtil.h"
+
+#include <deque>
+#include <iostream>
+#include <string>
+
+//! Records the events of enqueued commands and reports their device timestamps
+/*!
+	The command queue has to be created with CL_QUEUE_PROFILING_ENABLE.
+	Pass Event() as the event argument of an enqueue call:
+
+		clEnqueueNDRangeKernel(..., 0, NULL, profiler.Event("Scan_WorkEfficient", level));
+
+	While the profiler is disabled Event() returns NULL, so the same code runs without
+	events in timing loops. Report() waits for the recorded commands and prints the
+	queued, submit, start and end time of each of them.
+*/
+class CEventProfiler
+{
+public:
+	CEventProfiler();
+
+	~CEventProfiler();
+
+	void Enable(bool bEnable) { m_bEnabled = bEnable; }
+	bool IsEnabled() const { return m_bEnabled; }
+
+	//! Event for the next enqueue of the command Name (on level Level if >= 0), NULL if disabled
+	cl_event* Event(const std::string& Name, int Level = -1);
+
+	//! Prints every recorded command (times in us relative to the first queued command) and the device time per command name
+	void Report(std::ostream& Stream = std::cout);
+
+	//! Sum of end - start of all recorded commands in ms
+	double GetDeviceTime();
+
+	//! Releases the recorded events
+	void Clear();
+
+protected:
+
+	struct SRecord
+	{
+		std::string		Name;
+		int				Level;
+		cl_event		Event;
+	};
+
+	//! The four timestamps of an event in ns, false if they are not available
+	static bool GetTimes(cl_event Event, cl_ulong Times[4]);
+
+	// a deque keeps the returned event pointers valid while records are added
+	std::deque<SRecord>	m_Records;
+	bool				m_bEnabled;
+};
+
+#endif // _CEVENT_PROFILER_H
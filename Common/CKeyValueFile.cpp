@@ -0,0 +1,99 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+
+#include "CKeyValueFile.h"
+
+#include <fstream>
+#include <vector>
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// CKeyValueFile
+
+CKeyValueFile::CKeyValueFile(const string& FileName)
+	: m_FileName(FileName)
+{
+}
+
+string CKeyValueFile::SanitizeKey(const string& Key)
+{
+	string key = Key;
+	for (size_t i = 0; i < key.size(); i++)
+		if (key[i] == '\t' || key[i] == '\n' || key[i] == '\r')
+			key[i] = ' ';
+	return key;
+}
+
+bool CKeyValueFile::ParseLine(string Line, string& Key, string& Value)
+{
+	// files edited on Windows
+	if (!Line.empty() && Line[Line.size() - 1] == '\r')
+		Line.erase(Line.size() - 1);
+
+	size_t tab = Line.find('\t');
+	if (tab == string::npos || tab == 0 || tab + 1 == Line.size())
+		return false;
+
+	Key = Line.substr(0, tab);
+	Value = Line.substr(tab + 1);
+	return true;
+}
+
+bool CKeyValueFile::Load(const string& Key, string& Value) const
+{
+	ifstream file(m_FileName.c_str());
+	if (!file)
+		return false;
+
+	string key = SanitizeKey(Key);
+
+	// the last line of a key wins, like it would after Store()
+	bool bFound = false;
+	string line, lineKey, lineValue;
+	while (getline(file, line))
+	{
+		if (ParseLine(line, lineKey, lineValue) && lineKey == key)
+		{
+			Value = lineValue;
+			bFound = true;
+		}
+	}
+
+	return bFound;
+}
+
+bool CKeyValueFile::Store(const string& Key, const string& Value) const
+{
+	string key = SanitizeKey(Key);
+
+	// keep the other keys
+	vector<string> lines;
+	{
+		ifstream file(m_FileName.c_str());
+		string line, lineKey, lineValue;
+		while (getline(file, line))
+			if (ParseLine(line, lineKey, lineValue) && lineKey != key)
+				lines.push_back(lineKey + '\t' + lineValue);
+	}
+
+	// the value must not start a new line either
+	string value = Value;
+	for (size_t i = 0; i < value.size(); i++)
+		if (value[i] == '\n' || value[i] == '\r')
+			value[i] = ' ';
+	lines.push_back(key + '\t' + value);
+
+	ofstream file(m_FileName.c_str());
+	if (!file)
+		return false;
+	for (size_t i = 0; i < lines.size(); i++)
+		file << lines[i] << endl;
+
+	return file.good();
+}
+
+///////////////////////////////////////////////////////////////////////////////
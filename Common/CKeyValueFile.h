@@ -0,0 +1,55 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CKEY_VALUE_FILE_H
+#define _CKEY_VALUE_FILE_H
+
+#include <string>
+
+//! Text file of "key<TAB>value" lines, one line per key
+/*!
+	Used for the per-device settings that outlive a run (CTuningDatabase, the dispatcher
+	calibration). Keys are sanitized the same way on load and store, lines without a key
+	or a value are skipped when loading and dropped when the file is rewritten.
+*/
+class CKeyValueFile
+{
+public:
+	CKeyValueFile(const std::string& FileName);
+
+	//! Value stored for Key, false if the file or the key does not exist
+	bool Load(const std::string& Key, std::string& Value) const;
+
+	//! Adds or replaces the line of Key, the lines of the other keys are kept
+	bool Store(const std::string& Key, const std::string& Value) const;
+
+	const std::string& GetFileName() const { return m_FileName; }
+
+	//! Tabs and line breaks would split the line, they are replaced by spaces
+	static std::string SanitizeKey(const std::string& Key);
+
+protected:
+
+	//! Splits a line into key and value, false if it is malformed
+	static bool ParseLine(std::string Line, std::string& Key, std::string& Value);
+
+	std::string		m_FileName;
+};
+
+#endif // _CKEY_VALUE_FILE_H
@@ -5,9 +5,13 @@ GPU Computing / GPGPU Praktikum source code.
 
 #include "CLUtil.h"
 #include "CTimer.h"
+#include "CProgramCache.h"
+#include "CProgramBuilder.h"
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <vector>
 
 using namespace std;
 
@@ -23,16 +27,33 @@ size_t CLUtil::GetGlobalWorkSize(size_t DataElemCount, size_t LocalWorkSize)
 		return DataElemCount + LocalWorkSize - r;
 }
 
-bool CLUtil::LoadProgramSourceToMemory(const std::string& Path, std::string& SourceCode)
+// the registry is created on first use, the embedded sources register during static initialization
+static vector<CLUtil::SEmbeddedSource>& GetEmbeddedSources()
+{
+	static vector<CLUtil::SEmbeddedSource> sources;
+	return sources;
+}
+
+// built specializations by device, context, source name and options
+static map<string, cl_program>& GetSpecializedPrograms()
+{
+	static map<string, cl_program> programs;
+	return programs;
+}
+
+static string& GetKernelSourceDirectory()
+{
+	static string directory;
+	return directory;
+}
+
+static bool ReadSourceFile(const std::string& Path, std::string& SourceCode)
 {
 	ifstream sourceFile;
 	
 	sourceFile.open(Path.c_str());
 	if (!sourceFile.is_open())
-	{
-		cerr << "Failed to open file '" << Path << "'." << endl;
 		return false;
-	}
 
 	// read the entire file into a string
 	sourceFile.seekg(0, ios::end);
@@ -46,16 +67,72 @@ bool CLUtil::LoadProgramSourceToMemory(const std::string& Path, std::string& Sou
 	return true;
 }
 
+bool CLUtil::RegisterEmbeddedSources(const SEmbeddedSource* pSources, size_t Count)
+{
+	GetEmbeddedSources().insert(GetEmbeddedSources().end(), pSources, pSources + Count);
+	return true;
+}
+
+void CLUtil::SetKernelSourceDirectory(const std::string& Directory)
+{
+	GetKernelSourceDirectory() = Directory;
+}
+
+bool CLUtil::LoadProgramSourceToMemory(const std::string& Path, std::string& SourceCode)
+{
+	string name = Path.substr(Path.find_last_of("/\\") + 1);
+
+	const string& directory = GetKernelSourceDirectory();
+	if (!directory.empty() && ReadSourceFile(directory + "/" + name, SourceCode))
+	{
+		cout << "Using kernel source " << directory << "/" << name << endl;
+		return true;
+	}
+
+	const vector<SEmbeddedSource>& embeddedSources = GetEmbeddedSources();
+	for (size_t i = 0; i < embeddedSources.size(); i++)
+	{
+		if (name == embeddedSources[i].Name)
+		{
+			SourceCode.assign(embeddedSources[i].Source, embeddedSources[i].Size);
+			return true;
+		}
+	}
+
+	// not embedded, e.g. a build without the embedding step
+	if (!ReadSourceFile(Path, SourceCode))
+	{
+		cerr << "Failed to open file '" << Path << "'." << endl;
+		return false;
+	}
+
+	return true;
+}
+
 cl_program CLUtil::BuildCLProgramFromMemory(cl_device_id Device, cl_context Context, const std::string& SourceCode, const std::string& CompileOptions)
+{
+	// started in the background by IComputeTask::StartProgramBuilds?
+	cl_program prog = CProgramBuilder::Claim(Device, Context, SourceCode, CompileOptions);
+	if(prog != nullptr)
+	{
+		PrintBuildLog(prog, Device);
+		return prog;
+	}
+
+	return CompileCLProgram(Device, Context, SourceCode, CompileOptions);
+}
+
+cl_program CLUtil::CompileCLProgram(cl_device_id Device, cl_context Context, const std::string& SourceCode, const std::string& CompileOptions, bool PrintLog)
 {
 	
 	// Ignore the last parameter CompileOptions in assignment 1
 	// This may be used later to pass flags and macro definitions to the OpenCL compiler
 
-	cl_program prog = nullptr;
+	cl_program prog = CProgramCache::Load(Device, Context, SourceCode, CompileOptions);
+	if(prog != nullptr)
+		return prog;
 
-
-		string srcSolution = SourceCode;
+	string srcSolution = SourceCode;
 
 	const char* src = srcSolution.c_str();
 	size_t length = srcSolution.size();
@@ -71,7 +148,8 @@ cl_program CLUtil::BuildCLProgramFromMemory(cl_device_id Device, cl_context Cont
 	// program created, now build it:
 	const char* pCompileOptions = CompileOptions.size() > 0 ? CompileOptions.c_str() : nullptr;
 	clError = clBuildProgram(prog, 1, &Device, pCompileOptions, NULL, NULL);
-	PrintBuildLog(prog, Device);
+	if(PrintLog || CL_SUCCESS != clError)
+		PrintBuildLog(prog, Device);
 	if(CL_SUCCESS != clError)
 	{
 		cerr<<"Failed to build CL program.";
@@ -79,10 +157,56 @@ cl_program CLUtil::BuildCLProgramFromMemory(cl_device_id Device, cl_context Cont
 		return nullptr;
 	}
 
+	CProgramCache::Store(prog, Device, SourceCode, CompileOptions);
 
 	return prog;
 }
 
+string CLUtil::GetSpecializationOptions(const TSpecialization& Specialization)
+{
+	stringstream options;
+	for (TSpecialization::const_iterator it = Specialization.begin(); it != Specialization.end(); ++it)
+		options << (it == Specialization.begin() ? "" : " ") << "-D " << it->first << "=" << it->second;
+	return options.str();
+}
+
+cl_program CLUtil::BuildSpecializedProgram(cl_device_id Device, cl_context Context, const std::string& SourceName,
+	const TSpecialization& Specialization, const std::string& CompileOptions)
+{
+	string options = GetSpecializationOptions(Specialization);
+	if (!CompileOptions.empty())
+		options += " " + CompileOptions;
+
+	stringstream key;
+	key << Device << " " << Context << " " << SourceName << " " << options;
+
+	map<string, cl_program>& programs = GetSpecializedPrograms();
+	map<string, cl_program>::iterator it = programs.find(key.str());
+	if (it == programs.end())
+	{
+		string sourceCode;
+		if (!LoadProgramSourceToMemory(SourceName, sourceCode))
+			return nullptr;
+
+		cl_program prog = BuildCLProgramFromMemory(Device, Context, sourceCode, options);
+		if (prog == nullptr)
+			return nullptr;
+
+		it = programs.insert(make_pair(key.str(), prog)).first;
+	}
+
+	clRetainProgram(it->second);
+	return it->second;
+}
+
+void CLUtil::ReleaseSpecializedPrograms()
+{
+	map<string, cl_program>& programs = GetSpecializedPrograms();
+	for (map<string, cl_program>::iterator it = programs.begin(); it != programs.end(); ++it)
+		clReleaseProgram(it->second);
+	programs.clear();
+}
+
 void CLUtil::PrintBuildLog(cl_program Program, cl_device_id Device)
 {
 	cl_build_status buildStatus;
@@ -106,6 +230,17 @@ void CLUtil::PrintBuildLog(cl_program Program, cl_device_id Device)
 	cout<<buildLog<<endl;
 }
 
+string CLUtil::GetDeviceInfoString(cl_device_id Device, cl_device_info Info)
+{
+	size_t size = 0;
+	if(clGetDeviceInfo(Device, Info, 0, NULL, &size) != CL_SUCCESS || size == 0)
+		return string();
+
+	string value(size, '\0');
+	clGetDeviceInfo(Device, Info, size, &value[0], NULL);
+	return value.c_str();
+}
+
 double CLUtil::ProfileKernel(cl_command_queue CommandQueue, cl_kernel Kernel, cl_uint Dimensions, 
 		const size_t* pGlobalWorkSize, const size_t* pLocalWorkSize, int NIterations)
 {
@@ -118,10 +253,14 @@ double CLUtil::ProfileKernel(cl_command_queue CommandQueue, cl_kernel Kernel, cl
 
 	timer.Start();
 
-	// run the kernel N times for better average accuracy
+	// run the kernel N times for better average accuracy, the first and the last launch record an event
+	// so the device time can be read from their timestamps
+	cl_event firstEvent = NULL;
+	cl_event lastEvent = NULL;
 	for(int i = 0; i < NIterations; i++)
 	{
-		clErr |= clEnqueueNDRangeKernel(CommandQueue, Kernel, Dimensions, NULL, pGlobalWorkSize, pLocalWorkSize, 0, NULL, NULL);
+		cl_event* pEvent = (i == 0) ? &firstEvent : ((i == NIterations - 1) ? &lastEvent : NULL);
+		clErr |= clEnqueueNDRangeKernel(CommandQueue, Kernel, Dimensions, NULL, pGlobalWorkSize, pLocalWorkSize, 0, NULL, pEvent);
 	}
 	// wait again to sync
 	clErr |= clFinish(CommandQueue);
@@ -134,7 +273,24 @@ double CLUtil::ProfileKernel(cl_command_queue CommandQueue, cl_kernel Kernel, cl
 		cerr<<"Kernel execution failure: "<<errorString<<endl;
 	}
 
-	return timer.GetElapsedMilliseconds() / double(NIterations);
+	// start of the first to end of the last launch on the device, without the host side launch overhead.
+	// Falls back to the host timer if the queue was created without CL_QUEUE_PROFILING_ENABLE.
+	double time = timer.GetElapsedMilliseconds();
+	cl_ulong start = 0, end = 0;
+	if(firstEvent != NULL &&
+		clGetEventProfilingInfo(firstEvent, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &start, NULL) == CL_SUCCESS &&
+		clGetEventProfilingInfo((lastEvent != NULL) ? lastEvent : firstEvent, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &end, NULL) == CL_SUCCESS &&
+		end > start)
+	{
+		time = 1.0e-6 * (double)(end - start);
+	}
+
+	if(firstEvent != NULL)
+		clReleaseEvent(firstEvent);
+	if(lastEvent != NULL)
+		clReleaseEvent(lastEvent);
+
+	return time / double(NIterations);
 }
 
 #define CL_ERROR(x) case (x): return #x;
@@ -31,6 +31,7 @@
 
 #include "CommonDefs.h"
 
+#include <map>
 #include <string>
 #include <iostream>
 #include <algorithm>
@@ -43,14 +44,57 @@ public:
 	//! Determines the OpenCL global work size given the number of data elements and threads per workgroup
 	static size_t GetGlobalWorkSize(size_t DataElemCount, size_t LocalWorkSize);
 
+	//! A kernel source compiled into the executable, see cmake/EmbedKernels.cmake
+	struct SEmbeddedSource
+	{
+		const char*		Name;
+		const char*		Source;
+		size_t			Size;
+	};
+
+	//! Makes the sources available to LoadProgramSourceToMemory, called by the generated EmbeddedKernels.cpp
+	static bool RegisterEmbeddedSources(const SEmbeddedSource* pSources, size_t Count);
+
+	//! Sources in this directory take precedence over the embedded ones, for editing kernels without a rebuild
+	static void SetKernelSourceDirectory(const std::string& Directory);
+
 	//! Loads a program source to memory as a string
+	/*!
+		Looks up the file name of Path in the kernel source directory, then in the embedded sources
+		and finally reads Path relative to the working directory.
+	*/
 	static bool LoadProgramSourceToMemory(const std::string& Path, std::string& SourceCode);
 
-	//! Builds a CL program
+	//! Builds a CL program, or takes it from a background build (see CProgramBuilder)
 	static cl_program BuildCLProgramFromMemory(cl_device_id Device, cl_context Context, const std::string& SourceCode, const std::string& CompileOptions = "");
 
+	//! Builds a CL program on the calling thread, or loads it from the program binary cache (see CProgramCache)
+	static cl_program CompileCLProgram(cl_device_id Device, cl_context Context, const std::string& SourceCode, const std::string& CompileOptions = "", bool PrintLog = true);
+
+	//! Compile-time constants of a specialized program, e.g. WORK_GROUP_SIZE -> "256"
+	typedef std::map<std::string, std::string> TSpecialization;
+
+	//! "-D NAME=VALUE" for every constant, in the order of the names
+	static std::string GetSpecializationOptions(const TSpecialization& Specialization);
+
+	//! Builds the kernel source SourceName with the constants of Specialization
+	/*!
+		Baking the work-group size, element type, operator or unroll factor into the program lets the
+		compiler fold the constants and fully unroll loops over them. Every specialization is built
+		once per device and context and kept until ReleaseSpecializedPrograms(), the caller gets its
+		own reference and releases it as usual.
+	*/
+	static cl_program BuildSpecializedProgram(cl_device_id Device, cl_context Context, const std::string& SourceName,
+		const TSpecialization& Specialization, const std::string& CompileOptions = "");
+
+	//! Releases the programs of BuildSpecializedProgram, before their context is released
+	static void ReleaseSpecializedPrograms();
+
 	static void PrintBuildLog(cl_program Program, cl_device_id Device);
 
+	//! A string property of the device (CL_DEVICE_NAME, CL_DRIVER_VERSION, ...), empty on failure
+	static std::string GetDeviceInfoString(cl_device_id Device, cl_device_info Info);
+
 	//! Measures the execution time of a kernel by executing it N times and returning the average time in milliseconds.
 	/*!
 		The scheduling cost of the kernel can be amortized if we enqueue
@@ -0,0 +1,66 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+
+#include "CPinnedHostMemory.h"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// CPinnedHostMemory
+
+CPinnedHostMemory::CPinnedHostMemory()
+	: m_MapQueue(NULL), m_dBuffer(NULL), m_hPointer(NULL)
+{
+}
+
+CPinnedHostMemory::~CPinnedHostMemory()
+{
+	Release();
+}
+
+void CPinnedHostMemory::Allocate(cl_device_id Device, cl_context Context, size_t Size)
+{
+	Release();
+
+	cl_int clError;
+	m_MapQueue = clCreateCommandQueue(Context, Device, 0, &clError);
+	if (clError == CL_SUCCESS)
+		m_dBuffer = clCreateBuffer(Context, CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR, Size, NULL, &clError);
+	if (clError == CL_SUCCESS)
+		m_hPointer = clEnqueueMapBuffer(m_MapQueue, m_dBuffer, CL_TRUE, CL_MAP_READ | CL_MAP_WRITE, 0, Size, 0, NULL, NULL, &clError);
+
+	if (clError != CL_SUCCESS)
+	{
+		cerr << "Warning: no pinned host memory of " << Size << " bytes (" << CLUtil::GetCLErrorString(clError)
+			<< "), using pageable memory." << endl;
+
+		Release();
+
+		m_PageableMemory.resize(Size);
+		m_hPointer = m_PageableMemory.empty() ? NULL : &m_PageableMemory[0];
+	}
+}
+
+void CPinnedHostMemory::Release()
+{
+	if (m_dBuffer != NULL && m_hPointer != NULL)
+	{
+		clEnqueueUnmapMemObject(m_MapQueue, m_dBuffer, m_hPointer, 0, NULL, NULL);
+		clFinish(m_MapQueue);
+	}
+
+	SAFE_RELEASE_MEMOBJECT(m_dBuffer);
+	if (m_MapQueue != NULL)
+	{
+		clReleaseCommandQueue(m_MapQueue);
+		m_MapQueue = NULL;
+	}
+
+	vector<char>().swap(m_PageableMemory);
+	m_hPointer = NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
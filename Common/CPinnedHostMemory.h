@@ -0,0 +1,62 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CPINNED_HOST_MEMORY_H
+#define _CPINNED_HOST_MEMORY_H
+
+#include "CLUtil.h"
+
+#include <vector>
+
+//! Page-locked host memory for fast transfers
+/*!
+	The memory is a CL_MEM_ALLOC_HOST_PTR buffer that stays mapped until Release(). Drivers back
+	such buffers with pinned pages, so clEnqueueWriteBuffer and clEnqueueReadBuffer from and to the
+	mapped pointer run as DMA without the extra copy through the driver's staging memory that pageable
+	arrays need, and non-blocking transfers really overlap with the host.
+
+	If the buffer cannot be created or mapped, ordinary host memory is used instead (IsPinned() is false).
+*/
+class CPinnedHostMemory
+{
+public:
+	CPinnedHostMemory();
+
+	virtual ~CPinnedHostMemory();
+
+	//! Allocates Size bytes, the mapping uses its own command queue on Device
+	void Allocate(cl_device_id Device, cl_context Context, size_t Size);
+
+	//! Unmaps and frees the memory, GetPointer() is invalid afterwards
+	void Release();
+
+	void* GetPointer() const { return m_hPointer; }
+
+	bool IsPinned() const { return m_dBuffer != NULL; }
+
+protected:
+	cl_command_queue	m_MapQueue;
+	cl_mem				m_dBuffer;
+	void*				m_hPointer;
+
+	// used if no pinned buffer is available
+	std::vector<char>	m_PageableMemory;
+};
+
+#endif // _CPINNED_HOST_MEMORY_H
@@ -0,0 +1,134 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+#include "CProgramBuilder.h"
+
+#include "CTimer.h"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// CProgramBuilder
+
+mutex CProgramBuilder::s_Mutex;
+condition_variable CProgramBuilder::s_Condition;
+list<shared_ptr<CProgramBuilder::SBuild> > CProgramBuilder::s_Builds;
+vector<thread> CProgramBuilder::s_Workers;
+bool CProgramBuilder::s_bQuit = false;
+
+void CProgramBuilder::BuildAsync(cl_device_id Device, cl_context Context, const string& SourceCode, const string& CompileOptions)
+{
+	unique_lock<mutex> lock(s_Mutex);
+
+	// the same program is queued only once, e.g. by several tasks that share a program
+	for (list<shared_ptr<SBuild> >::iterator it = s_Builds.begin(); it != s_Builds.end(); ++it)
+	{
+		const SBuild& build = **it;
+		if (build.Device == Device && build.Context == Context && build.CompileOptions == CompileOptions && build.SourceCode == SourceCode)
+			return;
+	}
+
+	shared_ptr<SBuild> build(new SBuild);
+	build->Device = Device;
+	build->Context = Context;
+	build->SourceCode = SourceCode;
+	build->CompileOptions = CompileOptions;
+	build->State = BUILD_QUEUED;
+	build->Program = NULL;
+	s_Builds.push_back(build);
+
+	// one worker per hardware thread, but the device compiler usually parallelizes badly beyond a few
+	if (s_Workers.empty())
+	{
+		s_bQuit = false;
+		unsigned int nWorkers = min(max(thread::hardware_concurrency(), 1u), 4u);
+		for (unsigned int i = 0; i < nWorkers; i++)
+			s_Workers.push_back(thread(&CProgramBuilder::WorkerLoop));
+	}
+
+	s_Condition.notify_all();
+}
+
+cl_program CProgramBuilder::Claim(cl_device_id Device, cl_context Context, const string& SourceCode, const string& CompileOptions)
+{
+	unique_lock<mutex> lock(s_Mutex);
+
+	list<shared_ptr<SBuild> >::iterator it = s_Builds.begin();
+	for (; it != s_Builds.end(); ++it)
+	{
+		const SBuild& build = **it;
+		if (build.Device == Device && build.Context == Context && build.CompileOptions == CompileOptions && build.SourceCode == SourceCode)
+			break;
+	}
+	if (it == s_Builds.end())
+		return NULL;
+
+	shared_ptr<SBuild> build = *it;
+	s_Builds.erase(it);
+	if (build->State == BUILD_QUEUED)
+		return NULL;
+
+	CTimer timer;
+	timer.Start();
+	s_Condition.wait(lock, [&build]() { return build->State == BUILD_DONE; });
+	timer.Stop();
+
+	if (timer.GetElapsedMilliseconds() >= 1.0)
+		cout << "Waited " << timer.GetElapsedMilliseconds() << " ms for the background program build" << endl;
+
+	return build->Program;
+}
+
+void CProgramBuilder::Shutdown()
+{
+	{
+		unique_lock<mutex> lock(s_Mutex);
+		s_bQuit = true;
+	}
+	s_Condition.notify_all();
+
+	for (size_t i = 0; i < s_Workers.size(); i++)
+		s_Workers[i].join();
+	s_Workers.clear();
+
+	for (list<shared_ptr<SBuild> >::iterator it = s_Builds.begin(); it != s_Builds.end(); ++it)
+		SAFE_RELEASE_PROGRAM((*it)->Program);
+	s_Builds.clear();
+}
+
+void CProgramBuilder::WorkerLoop()
+{
+	unique_lock<mutex> lock(s_Mutex);
+
+	for (;;)
+	{
+		// the oldest queued build
+		shared_ptr<SBuild> build;
+		for (list<shared_ptr<SBuild> >::iterator it = s_Builds.begin(); it != s_Builds.end() && !build; ++it)
+			if ((*it)->State == BUILD_QUEUED)
+				build = *it;
+
+		if (s_bQuit)
+			return;
+		if (!build)
+		{
+			s_Condition.wait(lock);
+			continue;
+		}
+
+		build->State = BUILD_RUNNING;
+		lock.unlock();
+
+		// the build log is printed when the program is claimed
+		cl_program program = CLUtil::CompileCLProgram(build->Device, build->Context, build->SourceCode, build->CompileOptions, false);
+
+		lock.lock();
+		build->Program = program;
+		build->State = BUILD_DONE;
+		s_Condition.notify_all();
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,84 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CPROGRAM_BUILDER_H
+#define _CPROGRAM_BUILDER_H
+
+#include "CLUtil.h"
+
+#include <condition_variable>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//! Builds OpenCL programs on background threads
+/*!
+	The tasks queue their programs with BuildAsync() before they run (IComputeTask::StartProgramBuilds),
+	CLUtil::BuildCLProgramFromMemory claims a queued build of the same source and options and only
+	waits if it is still running. Builds run in the order they were queued, so the programs of the
+	first task are ready first while the later ones overlap with its input generation and CPU reference.
+
+	Worker threads are used rather than the notify callback of clBuildProgram,
+	because some implementations build synchronously even if a callback is passed.
+*/
+class CProgramBuilder
+{
+public:
+	//! Queues the build, the workers are started on first use
+	static void BuildAsync(cl_device_id Device, cl_context Context, const std::string& SourceCode, const std::string& CompileOptions = "");
+
+	//! Takes the build of the same program out of the queue and waits for it, NULL if none was queued
+	//! or if it had not started yet (building it on the calling thread is faster than waiting)
+	static cl_program Claim(cl_device_id Device, cl_context Context, const std::string& SourceCode, const std::string& CompileOptions);
+
+	//! Stops the workers after their current build and releases the programs nobody claimed
+	static void Shutdown();
+
+protected:
+
+	enum EBuildState
+	{
+		BUILD_QUEUED,
+		BUILD_RUNNING,
+		BUILD_DONE
+	};
+
+	struct SBuild
+	{
+		cl_device_id	Device;
+		cl_context		Context;
+		std::string		SourceCode;
+		std::string		CompileOptions;
+		EBuildState		State;
+		cl_program		Program;
+	};
+
+	static void WorkerLoop();
+
+	static std::mutex								s_Mutex;
+	static std::condition_variable					s_Condition;
+	static std::list<std::shared_ptr<SBuild> >		s_Builds;
+	static std::vector<std::thread>					s_Workers;
+	static bool										s_bQuit;
+};
+
+#endif // _CPROGRAM_BUILDER_H
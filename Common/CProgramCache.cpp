@@ -0,0 +1,204 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+#include "CProgramCache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+	#include <windows.h>
+	#include <process.h>
+	#define getpid _getpid
+#else
+	#include <unistd.h>
+#endif
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// CProgramCache
+
+// the first bytes of every cache file, a new format needs a new magic
+static const char c_CacheMagic[8] = { 'C', 'L', 'P', 'R', 'O', 'G', '0', '2' };
+
+// entries larger than this are treated as corrupt
+static const cl_ulong c_MaxBinarySize = 256 * 1024 * 1024;
+
+bool CProgramCache::s_bEnabled = true;
+string CProgramCache::s_Directory;
+
+string CProgramCache::GetDescription(cl_device_id Device, const string& SourceCode, const string& CompileOptions)
+{
+	string platformVersion;
+	cl_platform_id platform = NULL;
+	size_t size = 0;
+	if (clGetDeviceInfo(Device, CL_DEVICE_PLATFORM, sizeof(cl_platform_id), &platform, NULL) == CL_SUCCESS &&
+		clGetPlatformInfo(platform, CL_PLATFORM_VERSION, 0, NULL, &size) == CL_SUCCESS && size > 0)
+	{
+		string version(size, '\0');
+		clGetPlatformInfo(platform, CL_PLATFORM_VERSION, size, &version[0], NULL);
+		platformVersion = version.c_str();
+	}
+
+	stringstream description;
+	description << "options: " << CompileOptions << "\n"
+		<< "device: " << CLUtil::GetDeviceInfoString(Device, CL_DEVICE_NAME) << "\n"
+		<< "driver: " << CLUtil::GetDeviceInfoString(Device, CL_DRIVER_VERSION) << "\n"
+		<< "platform: " << platformVersion << "\n"
+		<< "source:\n" << SourceCode;
+	return description.str();
+}
+
+string CProgramCache::GetFileName(const string& SourceCode, const string& Description)
+{
+	// 64 bit FNV-1a over the source and the description
+	unsigned long long hash = 14695981039346656037ULL;
+	const string* parts[2] = { &SourceCode, &Description };
+	for (int p = 0; p < 2; p++)
+	{
+		for (size_t i = 0; i < parts[p]->size(); i++)
+		{
+			hash ^= (unsigned char)(*parts[p])[i];
+			hash *= 1099511628211ULL;
+		}
+		hash ^= 0xff;
+		hash *= 1099511628211ULL;
+	}
+
+	stringstream name;
+	if (!s_Directory.empty())
+		name << s_Directory << "/";
+	name << "ProgramCache_" << hex << hash << ".bin";
+	return name.str();
+}
+
+string CProgramCache::GetTempFileName(const string& FileName)
+{
+	stringstream name;
+	name << FileName << "." << getpid() << "." << hex << std::hash<thread::id>()(this_thread::get_id()) << ".tmp";
+	return name.str();
+}
+
+// moves Source over Target in one step, readers see either the old or the new Target
+static bool ReplaceCacheFile(const string& Source, const string& Target)
+{
+#ifdef _WIN32
+	return MoveFileExA(Source.c_str(), Target.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+	return rename(Source.c_str(), Target.c_str()) == 0;
+#endif
+}
+
+cl_program CProgramCache::Load(cl_device_id Device, cl_context Context, const string& SourceCode, const string& CompileOptions)
+{
+	if (!s_bEnabled)
+		return NULL;
+
+	string description = GetDescription(Device, SourceCode, CompileOptions);
+	string fileName = GetFileName(SourceCode, description);
+
+	ifstream file(fileName.c_str(), ios::binary);
+	if (!file.is_open())
+		return NULL;
+
+	// header: magic, description, binary size and binary
+	char magic[sizeof(c_CacheMagic)];
+	cl_ulong descriptionSize = 0, binarySize = 0;
+	string storedDescription;
+	vector<unsigned char> binary;
+
+	bool bValid = file.read(magic, sizeof(magic)) && equal(magic, magic + sizeof(magic), c_CacheMagic) &&
+		file.read((char*)&descriptionSize, sizeof(descriptionSize)) && descriptionSize == description.size();
+	if (bValid)
+	{
+		storedDescription.resize((size_t)descriptionSize);
+		bValid = file.read(&storedDescription[0], (streamsize)descriptionSize) && storedDescription == description &&
+			file.read((char*)&binarySize, sizeof(binarySize)) && binarySize > 0 && binarySize <= c_MaxBinarySize;
+	}
+	if (bValid)
+	{
+		binary.resize((size_t)binarySize);
+		bValid = file.read((char*)&binary[0], (streamsize)binarySize) && file.peek() == EOF;
+	}
+	file.close();
+
+	cl_program program = NULL;
+	if (bValid)
+	{
+		const unsigned char* pBinary = &binary[0];
+		size_t length = binary.size();
+		cl_int binaryStatus = CL_SUCCESS, clError;
+		program = clCreateProgramWithBinary(Context, 1, &Device, &length, &pBinary, &binaryStatus, &clError);
+		if (clError != CL_SUCCESS || binaryStatus != CL_SUCCESS)
+			SAFE_RELEASE_PROGRAM(program);
+	}
+
+	// a binary program still has to be built, the driver may reject it as well
+	if (program != NULL)
+	{
+		const char* pCompileOptions = CompileOptions.size() > 0 ? CompileOptions.c_str() : nullptr;
+		if (clBuildProgram(program, 1, &Device, pCompileOptions, NULL, NULL) != CL_SUCCESS)
+			SAFE_RELEASE_PROGRAM(program);
+	}
+
+	if (program == NULL)
+	{
+		cout << "Discarding invalid program cache entry " << fileName << endl;
+		remove(fileName.c_str());
+	}
+
+	return program;
+}
+
+void CProgramCache::Store(cl_program Program, cl_device_id Device, const string& SourceCode, const string& CompileOptions)
+{
+	if (!s_bEnabled)
+		return;
+
+	size_t binarySize = 0;
+	if (clGetProgramInfo(Program, CL_PROGRAM_BINARY_SIZES, sizeof(size_t), &binarySize, NULL) != CL_SUCCESS ||
+		binarySize == 0 || binarySize > c_MaxBinarySize)
+		return;
+
+	vector<unsigned char> binary(binarySize);
+	unsigned char* pBinary = &binary[0];
+	if (clGetProgramInfo(Program, CL_PROGRAM_BINARIES, sizeof(unsigned char*), &pBinary, NULL) != CL_SUCCESS)
+		return;
+
+	string description = GetDescription(Device, SourceCode, CompileOptions);
+	string fileName = GetFileName(SourceCode, description);
+
+	// write to a temporary file of this process and thread first, so a crash or a concurrent writer
+	// never leaves a truncated entry behind
+	string tempName = GetTempFileName(fileName);
+	ofstream file(tempName.c_str(), ios::binary);
+	if (!file.is_open())
+		return;
+
+	cl_ulong descriptionSize = description.size();
+	cl_ulong size = binarySize;
+	file.write(c_CacheMagic, sizeof(c_CacheMagic));
+	file.write((const char*)&descriptionSize, sizeof(descriptionSize));
+	file.write(description.data(), (streamsize)description.size());
+	file.write((const char*)&size, sizeof(size));
+	file.write((const char*)&binary[0], (streamsize)binarySize);
+	file.close();
+
+	if (!file)
+	{
+		remove(tempName.c_str());
+		return;
+	}
+
+	if (!ReplaceCacheFile(tempName, fileName))
+		remove(tempName.c_str());
+}
+
+///////////////////////////////////////////////////////////////////////////////
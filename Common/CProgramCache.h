@@ -0,0 +1,66 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CPROGRAM_CACHE_H
+#define _CPROGRAM_CACHE_H
+
+#include "CLUtil.h"
+
+#include <string>
+
+//! On-disk cache of built program binaries
+/*!
+	An entry is keyed by a hash of the source, the compile options, the device name and
+	the driver and platform versions; the file also stores all of them, including the full
+	source, so a hash collision or a file from another driver is detected and rebuilt.
+	Unreadable, mismatching or rejected entries are deleted and the program is built from source.
+	Entries are written to a temporary file of the writing process and thread and then
+	renamed over the entry, so concurrent writers never see or leave a partial file.
+	CLUtil::BuildCLProgramFromMemory goes through the cache.
+*/
+class CProgramCache
+{
+public:
+	static void SetEnabled(bool bEnabled) { s_bEnabled = bEnabled; }
+	static bool IsEnabled() { return s_bEnabled; }
+
+	//! Directory of the cache files (it has to exist), the working directory by default
+	static void SetDirectory(const std::string& Directory) { s_Directory = Directory; }
+
+	//! Built program from the cache, NULL on a miss
+	static cl_program Load(cl_device_id Device, cl_context Context, const std::string& SourceCode, const std::string& CompileOptions);
+
+	//! Stores the binary of the built Program
+	static void Store(cl_program Program, cl_device_id Device, const std::string& SourceCode, const std::string& CompileOptions);
+
+protected:
+
+	//! Options, device, driver and platform version, one per line, followed by the source
+	static std::string GetDescription(cl_device_id Device, const std::string& SourceCode, const std::string& CompileOptions);
+
+	//! Name of the temporary file that Store writes before renaming it to FileName
+	static std::string GetTempFileName(const std::string& FileName);
+
+	static std::string GetFileName(const std::string& SourceCode, const std::string& Description);
+
+	static bool			s_bEnabled;
+	static std::string	s_Directory;
+};
+
+#endif // _CPROGRAM_CACHE_H
@@ -0,0 +1,146 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+#include "CResultLog.h"
+
+#include "CLUtil.h"
+
+#include <sstream>
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// CResultLog
+
+CResultLog::CResultLog()
+	: m_nRows(0), m_ComputeUnits(0), m_ClockFrequency(0), m_GlobalMemorySize(0), m_LocalMemorySize(0)
+{
+}
+
+CResultLog::~CResultLog()
+{
+	Close();
+}
+
+bool CResultLog::Open(const string& BaseName, cl_device_id Device)
+{
+	Close();
+
+	cl_platform_id platform = NULL;
+	clGetDeviceInfo(Device, CL_DEVICE_PLATFORM, sizeof(cl_platform_id), &platform, NULL);
+	size_t size = 0;
+	if (platform != NULL && clGetPlatformInfo(platform, CL_PLATFORM_NAME, 0, NULL, &size) == CL_SUCCESS && size > 0)
+	{
+		string name(size, '\0');
+		clGetPlatformInfo(platform, CL_PLATFORM_NAME, size, &name[0], NULL);
+		m_PlatformName = name.c_str();
+	}
+
+	m_DeviceName = CLUtil::GetDeviceInfoString(Device, CL_DEVICE_NAME);
+	m_DeviceVendor = CLUtil::GetDeviceInfoString(Device, CL_DEVICE_VENDOR);
+	m_DriverVersion = CLUtil::GetDeviceInfoString(Device, CL_DRIVER_VERSION);
+	clGetDeviceInfo(Device, CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(cl_uint), &m_ComputeUnits, NULL);
+	clGetDeviceInfo(Device, CL_DEVICE_MAX_CLOCK_FREQUENCY, sizeof(cl_uint), &m_ClockFrequency, NULL);
+	clGetDeviceInfo(Device, CL_DEVICE_GLOBAL_MEM_SIZE, sizeof(cl_ulong), &m_GlobalMemorySize, NULL);
+	clGetDeviceInfo(Device, CL_DEVICE_LOCAL_MEM_SIZE, sizeof(cl_ulong), &m_LocalMemorySize, NULL);
+
+	m_CSV.open((BaseName + ".csv").c_str());
+	m_JSON.open((BaseName + ".json").c_str());
+	if (!m_CSV || !m_JSON)
+	{
+		cerr << "Error: could not create " << BaseName << ".csv / .json" << endl;
+		Close();
+		return false;
+	}
+
+	m_CSV << "platform,device,vendor,driver,compute_units,clock_mhz,global_mem_bytes,local_mem_bytes,"
+		"task,variant,n,local_work_size,valid,iterations,outliers,converged,"
+		"min_ms,median_ms,p95_ms,mean_ms,stddev_ms,ci95_ms,gelem_per_s,gb_per_s" << endl;
+	m_JSON << "[" << endl;
+	m_nRows = 0;
+
+	return true;
+}
+
+void CResultLog::Write(const SRow& Row)
+{
+	if (!m_CSV.is_open())
+		return;
+
+	const CBenchmark::SResult& r = Row.Result;
+	double gelems = (r.Median > 0.0) ? 1.0e-6 * (double)Row.N / r.Median : 0.0;
+	double gbytes = (r.Median > 0.0) ? 1.0e-6 * (double)(Row.N * Row.BytesPerElement) / r.Median : 0.0;
+
+	m_CSV << QuoteCSV(m_PlatformName) << "," << QuoteCSV(m_DeviceName) << "," << QuoteCSV(m_DeviceVendor) << ","
+		<< QuoteCSV(m_DriverVersion) << "," << m_ComputeUnits << "," << m_ClockFrequency << ","
+		<< m_GlobalMemorySize << "," << m_LocalMemorySize << ","
+		<< QuoteCSV(Row.Task) << "," << QuoteCSV(Row.Variant) << "," << Row.N << "," << Row.LocalWorkSize << ","
+		<< (Row.bValid ? 1 : 0) << "," << r.Iterations << "," << r.Outliers << "," << (r.bConverged ? 1 : 0) << ","
+		<< r.Min << "," << r.Median << "," << r.P95 << "," << r.Mean << "," << r.Stddev << "," << r.ConfidenceInterval << ","
+		<< gelems << "," << gbytes << endl;
+
+	m_JSON << ((m_nRows > 0) ? ",\n" : "")
+		<< "  {\"device\": {\"platform\": " << QuoteJSON(m_PlatformName) << ", \"name\": " << QuoteJSON(m_DeviceName)
+		<< ", \"vendor\": " << QuoteJSON(m_DeviceVendor) << ", \"driver\": " << QuoteJSON(m_DriverVersion)
+		<< ", \"compute_units\": " << m_ComputeUnits << ", \"clock_mhz\": " << m_ClockFrequency
+		<< ", \"global_mem_bytes\": " << m_GlobalMemorySize << ", \"local_mem_bytes\": " << m_LocalMemorySize << "},"
+		<< " \"task\": " << QuoteJSON(Row.Task) << ", \"variant\": " << QuoteJSON(Row.Variant)
+		<< ", \"n\": " << Row.N << ", \"local_work_size\": " << Row.LocalWorkSize
+		<< ", \"valid\": " << (Row.bValid ? "true" : "false")
+		<< ", \"iterations\": " << r.Iterations << ", \"outliers\": " << r.Outliers
+		<< ", \"converged\": " << (r.bConverged ? "true" : "false")
+		<< ", \"min_ms\": " << r.Min << ", \"median_ms\": " << r.Median << ", \"p95_ms\": " << r.P95
+		<< ", \"mean_ms\": " << r.Mean << ", \"stddev_ms\": " << r.Stddev << ", \"ci95_ms\": " << r.ConfidenceInterval
+		<< ", \"gelem_per_s\": " << gelems << ", \"gb_per_s\": " << gbytes << "}";
+	m_JSON.flush();
+
+	m_nRows++;
+}
+
+void CResultLog::Close()
+{
+	if (m_JSON.is_open())
+	{
+		m_JSON << endl << "]" << endl;
+		m_JSON.close();
+	}
+	if (m_CSV.is_open())
+		m_CSV.close();
+}
+
+string CResultLog::QuoteCSV(const string& Value)
+{
+	if (Value.find_first_of(",\"\n") == string::npos)
+		return Value;
+
+	string quoted = "\"";
+	for (size_t i = 0; i < Value.size(); i++)
+	{
+		if (Value[i] == '"')
+			quoted += '"';
+		quoted += Value[i];
+	}
+	return quoted + "\"";
+}
+
+string CResultLog::QuoteJSON(const string& Value)
+{
+	stringstream quoted;
+	quoted << "\"";
+	for (size_t i = 0; i < Value.size(); i++)
+	{
+		unsigned char c = (unsigned char)Value[i];
+		if (c == '"' || c == '\\')
+			quoted << '\\' << c;
+		else if (c < 0x20)
+			quoted << "\\u00" << "0123456789abcdef"[c >> 4] << "0123456789abcdef"[c & 15];
+		else
+			quoted << c;
+	}
+	quoted << "\"";
+	return quoted.str();
+}
+
+///////////////////////////////////////////////////////////////////////////////
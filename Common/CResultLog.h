@@ -0,0 +1,82 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CRESULT_LOG_H
+#define _CRESULT_LOG_H
+
+#include "CLUtil.h"
+#include "CBenchmark.h"
+
+#include <fstream>
+#include <string>
+
+//! Writes benchmark data points as rows of a CSV file and a JSON array
+/*!
+	Every row carries the metadata of the device it was measured on, so the files of
+	several devices can be concatenated and compared.
+*/
+class CResultLog
+{
+public:
+
+	struct SRow
+	{
+		std::string		Task;
+		std::string		Variant;
+		size_t			N;
+		size_t			LocalWorkSize;
+		//! bytes moved per element, for the bandwidth column
+		size_t			BytesPerElement;
+		bool			bValid;
+		CBenchmark::SResult	Result;
+	};
+
+	CResultLog();
+
+	~CResultLog();
+
+	//! Creates BaseName.csv and BaseName.json and reads the metadata of Device
+	bool Open(const std::string& BaseName, cl_device_id Device);
+
+	void Write(const SRow& Row);
+
+	//! Terminates the JSON array, also done by the destructor
+	void Close();
+
+protected:
+
+	static std::string QuoteCSV(const std::string& Value);
+	static std::string QuoteJSON(const std::string& Value);
+
+	std::ofstream		m_CSV;
+	std::ofstream		m_JSON;
+	unsigned int		m_nRows;
+
+	// device metadata
+	std::string			m_PlatformName;
+	std::string			m_DeviceName;
+	std::string			m_DeviceVendor;
+	std::string			m_DriverVersion;
+	cl_uint				m_ComputeUnits;
+	cl_uint				m_ClockFrequency;
+	cl_ulong			m_GlobalMemorySize;
+	cl_ulong			m_LocalMemorySize;
+};
+
+#endif // _CRESULT_LOG_H
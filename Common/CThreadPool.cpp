@@ -0,0 +1,75 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+#include "CThreadPool.h"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// CThreadPool
+
+CThreadPool::CThreadPool(unsigned int NumThreads)
+	: m_Generation(0), m_nRunning(0), m_bQuit(false)
+{
+	if (NumThreads == 0)
+		NumThreads = max(thread::hardware_concurrency(), 1u);
+
+	for (unsigned int i = 0; i < NumThreads; i++)
+		m_Threads.push_back(thread(&CThreadPool::WorkerLoop, this, i));
+}
+
+CThreadPool::~CThreadPool()
+{
+	{
+		lock_guard<mutex> lock(m_Mutex);
+		m_bQuit = true;
+	}
+	m_StartCondition.notify_all();
+
+	for (size_t i = 0; i < m_Threads.size(); i++)
+		m_Threads[i].join();
+}
+
+void CThreadPool::Run(const function<void(unsigned int)>& Job)
+{
+	unique_lock<mutex> lock(m_Mutex);
+
+	m_Job = Job;
+	m_nRunning = (unsigned int)m_Threads.size();
+	m_Generation++;
+	m_StartCondition.notify_all();
+
+	m_DoneCondition.wait(lock, [this] { return m_nRunning == 0; });
+	m_Job = nullptr;
+}
+
+void CThreadPool::WorkerLoop(unsigned int ThreadIndex)
+{
+	unsigned int generation = 0;
+
+	for (;;)
+	{
+		function<void(unsigned int)> job;
+		{
+			unique_lock<mutex> lock(m_Mutex);
+			m_StartCondition.wait(lock, [&] { return m_bQuit || m_Generation != generation; });
+			if (m_bQuit)
+				return;
+
+			generation = m_Generation;
+			job = m_Job;
+		}
+
+		job(ThreadIndex);
+
+		{
+			lock_guard<mutex> lock(m_Mutex);
+			if (--m_nRunning == 0)
+				m_DoneCondition.notify_one();
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,65 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CTHREAD_POOL_H
+#define _CTHREAD_POOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//! Fixed set of host threads that run the same job together
+/*!
+	Run() hands Job(ThreadIndex) to every thread of the pool and returns when all of them
+	have finished. The threads are created once and wait between the jobs, so a job does
+	not pay for thread creation.
+*/
+class CThreadPool
+{
+public:
+	//! NumThreads = 0 uses one thread per hardware thread
+	CThreadPool(unsigned int NumThreads = 0);
+
+	~CThreadPool();
+
+	unsigned int GetNumThreads() const { return (unsigned int)m_Threads.size(); }
+
+	//! Runs Job(ThreadIndex) on all threads and waits for them, ThreadIndex is in [0, GetNumThreads())
+	void Run(const std::function<void(unsigned int)>& Job);
+
+protected:
+
+	void WorkerLoop(unsigned int ThreadIndex);
+
+	std::vector<std::thread>				m_Threads;
+
+	std::mutex								m_Mutex;
+	std::condition_variable					m_StartCondition;
+	std::condition_variable					m_DoneCondition;
+
+	// the current job, m_Generation is incremented for every job
+	std::function<void(unsigned int)>		m_Job;
+	unsigned int							m_Generation;
+	unsigned int							m_nRunning;
+	bool									m_bQuit;
+};
+
+#endif // _CTHREAD_POOL_H
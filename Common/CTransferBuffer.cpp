@@ -0,0 +1,166 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+
+#include "CTransferBuffer.h"
+
+#include <stdint.h>
+
+using namespace std;
+
+// CL_MEM_USE_HOST_PTR memory is page-aligned and padded to a multiple of the cache line,
+// otherwise integrated GPUs copy it instead of using it in place
+#define HOST_PTR_ALIGNMENT		4096
+#define HOST_PTR_SIZE_MULTIPLE	64
+
+///////////////////////////////////////////////////////////////////////////////
+// CTransferBuffer
+
+static const char* g_TransferStrategyNames[TRANSFER_STRATEGY_COUNT] =
+{
+	"pageable",
+	"pinned",
+	"useHostPtr",
+	"zeroCopy"
+};
+
+CTransferBuffer::CTransferBuffer()
+	: m_Strategy(TRANSFER_PAGEABLE), m_Size(0), m_dBuffer(NULL), m_hPointer(NULL), m_MapQueue(NULL)
+{
+}
+
+CTransferBuffer::~CTransferBuffer()
+{
+	Release();
+}
+
+const char* CTransferBuffer::GetStrategyName(ETransferStrategy Strategy)
+{
+	return g_TransferStrategyNames[Strategy];
+}
+
+bool CTransferBuffer::IsSupported(cl_device_id Device, ETransferStrategy Strategy)
+{
+	if (Strategy != TRANSFER_ZERO_COPY)
+		return true;
+
+	cl_bool isUsingUnifiedMemory = CL_FALSE;
+	clGetDeviceInfo(Device, CL_DEVICE_HOST_UNIFIED_MEMORY, sizeof(cl_bool), &isUsingUnifiedMemory, NULL);
+	return isUsingUnifiedMemory == CL_TRUE;
+}
+
+bool CTransferBuffer::Init(cl_device_id Device, cl_context Context, cl_command_queue CommandQueue, size_t Size, ETransferStrategy Strategy)
+{
+	Release();
+
+	if (!IsSupported(Device, Strategy))
+	{
+		cerr << "Error: the device has no unified host memory, the " << GetStrategyName(Strategy) << " transfer strategy is not available." << endl;
+		return false;
+	}
+
+	m_Strategy = Strategy;
+	m_Size = Size;
+
+	cl_int clError = CL_SUCCESS;
+	switch (m_Strategy)
+	{
+	case TRANSFER_PAGEABLE:
+		m_HostMemory.resize(Size);
+		m_hPointer = &m_HostMemory[0];
+		m_dBuffer = clCreateBuffer(Context, CL_MEM_READ_WRITE, Size, NULL, &clError);
+		break;
+
+	case TRANSFER_PINNED:
+		m_PinnedMemory.Allocate(Device, Context, Size);
+		m_hPointer = m_PinnedMemory.GetPointer();
+		m_dBuffer = clCreateBuffer(Context, CL_MEM_READ_WRITE, Size, NULL, &clError);
+		break;
+
+	case TRANSFER_USE_HOST_PTR:
+		{
+			size_t paddedSize = (Size + HOST_PTR_SIZE_MULTIPLE - 1) / HOST_PTR_SIZE_MULTIPLE * HOST_PTR_SIZE_MULTIPLE;
+			m_HostMemory.resize(paddedSize + HOST_PTR_ALIGNMENT);
+			uintptr_t address = ((uintptr_t)&m_HostMemory[0] + HOST_PTR_ALIGNMENT - 1) & ~(uintptr_t)(HOST_PTR_ALIGNMENT - 1);
+			m_dBuffer = clCreateBuffer(Context, CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR, paddedSize, (void*)address, &clError);
+		}
+		break;
+
+	case TRANSFER_ZERO_COPY:
+		m_dBuffer = clCreateBuffer(Context, CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR, Size, NULL, &clError);
+		break;
+
+	default:
+		break;
+	}
+	V_RETURN_FALSE_CL(clError, "Error allocating the device array of a transfer buffer");
+
+	// the mapping strategies start with the array on the host side
+	if (IsMapped())
+		return Download(CommandQueue);
+
+	return true;
+}
+
+void CTransferBuffer::Release()
+{
+	if (m_dBuffer != NULL && IsMapped() && m_hPointer != NULL)
+	{
+		clEnqueueUnmapMemObject(m_MapQueue, m_dBuffer, m_hPointer, 0, NULL, NULL);
+		clFinish(m_MapQueue);
+	}
+
+	SAFE_RELEASE_MEMOBJECT(m_dBuffer);
+	m_PinnedMemory.Release();
+	vector<char>().swap(m_HostMemory);
+
+	m_hPointer = NULL;
+	m_MapQueue = NULL;
+	m_Size = 0;
+}
+
+bool CTransferBuffer::Upload(cl_command_queue CommandQueue, size_t Size)
+{
+	if (IsMapped())
+	{
+		// unmapped already, the device has the data
+		if (m_hPointer == NULL)
+			return true;
+
+		V_RETURN_FALSE_CL(clEnqueueUnmapMemObject(CommandQueue, m_dBuffer, m_hPointer, 0, NULL, NULL), "Error unmapping the transfer buffer!");
+		m_hPointer = NULL;
+		return true;
+	}
+
+	if (Size == 0)
+		Size = m_Size;
+
+	V_RETURN_FALSE_CL(clEnqueueWriteBuffer(CommandQueue, m_dBuffer, CL_FALSE, 0, Size, m_hPointer, 0, NULL, NULL), "Error copying data from host to device!");
+	return true;
+}
+
+bool CTransferBuffer::Download(cl_command_queue CommandQueue, size_t Size)
+{
+	if (IsMapped())
+	{
+		// still mapped, the host has the data
+		if (m_hPointer != NULL)
+			return true;
+
+		cl_int clError;
+		m_hPointer = clEnqueueMapBuffer(CommandQueue, m_dBuffer, CL_TRUE, CL_MAP_READ | CL_MAP_WRITE, 0, m_Size, 0, NULL, NULL, &clError);
+		V_RETURN_FALSE_CL(clError, "Error mapping the transfer buffer!");
+		m_MapQueue = CommandQueue;
+		return true;
+	}
+
+	if (Size == 0)
+		Size = m_Size;
+
+	V_RETURN_FALSE_CL(clEnqueueReadBuffer(CommandQueue, m_dBuffer, CL_TRUE, 0, Size, m_hPointer, 0, NULL, NULL), "Error copying data from device to host!");
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
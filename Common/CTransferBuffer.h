@@ -0,0 +1,102 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CTRANSFER_BUFFER_H
+#define _CTRANSFER_BUFFER_H
+
+#include "CLUtil.h"
+#include "CPinnedHostMemory.h"
+
+#include <vector>
+
+//! How the host copy of a CTransferBuffer reaches the device
+enum ETransferStrategy
+{
+	TRANSFER_PAGEABLE = 0,		// ordinary host memory, clEnqueueWriteBuffer / clEnqueueReadBuffer
+	TRANSFER_PINNED,			// the same copies from and to pinned staging memory (CPinnedHostMemory)
+	TRANSFER_USE_HOST_PTR,		// the device array is created on page-aligned host memory (CL_MEM_USE_HOST_PTR), map / unmap
+	TRANSFER_ZERO_COPY,			// CL_MEM_ALLOC_HOST_PTR array that the kernels read in place, map / unmap (unified memory only)
+
+	TRANSFER_STRATEGY_COUNT
+};
+
+//! A device array with a host copy that is kept in sync with one of the transfer strategies
+/*!
+	The host fills GetHostPointer() and calls Upload() before the kernels use GetDeviceBuffer(),
+	Download() brings the device data back to GetHostPointer().
+
+	With TRANSFER_USE_HOST_PTR and TRANSFER_ZERO_COPY the host copy is the mapped device array:
+	the host may only touch it between Download() (or Init()) and Upload(), and the pointer can
+	change with every Download(). Upload() and Download() ignore the size there, the whole array
+	is unmapped and mapped. On devices with CL_DEVICE_HOST_UNIFIED_MEMORY mapping does not copy.
+*/
+class CTransferBuffer
+{
+public:
+	CTransferBuffer();
+
+	virtual ~CTransferBuffer();
+
+	static const char* GetStrategyName(ETransferStrategy Strategy);
+
+	//! TRANSFER_ZERO_COPY needs a device with CL_DEVICE_HOST_UNIFIED_MEMORY, the others work everywhere
+	static bool IsSupported(cl_device_id Device, ETransferStrategy Strategy);
+
+	//! Allocates a device array of Size bytes and the host memory of the strategy,
+	//! the mapping strategies map the array on CommandQueue
+	bool Init(cl_device_id Device, cl_context Context, cl_command_queue CommandQueue, size_t Size, ETransferStrategy Strategy);
+
+	void Release();
+
+	ETransferStrategy GetStrategy() const { return m_Strategy; }
+
+	size_t GetSize() const { return m_Size; }
+
+	void* GetHostPointer() const { return m_hPointer; }
+
+	//! The array the kernels work on
+	cl_mem GetDeviceBuffer() const { return m_dBuffer; }
+
+	//! Makes the first Size bytes of the host copy (0: all) visible to the commands enqueued after it.
+	//! Does not block, the host copy must not change until these commands are done.
+	bool Upload(cl_command_queue CommandQueue, size_t Size = 0);
+
+	//! Copies the first Size bytes of the device array (0: all) to the host copy, blocking
+	bool Download(cl_command_queue CommandQueue, size_t Size = 0);
+
+protected:
+	bool IsMapped() const { return m_Strategy == TRANSFER_USE_HOST_PTR || m_Strategy == TRANSFER_ZERO_COPY; }
+
+	ETransferStrategy	m_Strategy;
+	size_t				m_Size;
+
+	cl_mem				m_dBuffer;
+
+	// current host copy, NULL while a mapping strategy has the array unmapped
+	void*				m_hPointer;
+	// queue of the last map, the array is unmapped there on release
+	cl_command_queue	m_MapQueue;
+
+	// TRANSFER_PAGEABLE, and the page-aligned memory behind the array of TRANSFER_USE_HOST_PTR
+	std::vector<char>	m_HostMemory;
+	// TRANSFER_PINNED
+	CPinnedHostMemory	m_PinnedMemory;
+};
+
+#endif // _CTRANSFER_BUFFER_H
@@ -0,0 +1,116 @@
+/******************************************************************************
+GPU Computing / GPGPU Praktikum source code.
+
+******************************************************************************/
+
+
+#include "CTuningDatabase.h"
+#include "CKeyValueFile.h"
+
+#include <sstream>
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// STuningConfig
+
+STuningConfig::STuningConfig(size_t LocalWorkSize, unsigned int ElementsPerThread, unsigned int VectorWidth, unsigned int Unroll)
+	: LocalWorkSize(LocalWorkSize), ElementsPerThread(ElementsPerThread), VectorWidth(VectorWidth), Unroll(Unroll)
+{
+}
+
+string STuningConfig::GetCompileOptions() const
+{
+	stringstream options;
+	options << "-D ELEMENTS_PER_THREAD=" << ElementsPerThread << " -D VECTOR_WIDTH=" << VectorWidth << " -D UNROLL=" << Unroll;
+	return options.str();
+}
+
+string STuningConfig::ToString() const
+{
+	stringstream description;
+	description << "local " << LocalWorkSize << ", " << ElementsPerThread << " elements/thread, vector width "
+		<< VectorWidth << ", unroll " << Unroll;
+	return description.str();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// CTuningDatabase
+
+bool CTuningDatabase::s_bEnabled = true;
+bool CTuningDatabase::s_bRetune = false;
+string CTuningDatabase::s_FileName = "TuningDatabase.txt";
+
+unsigned int CTuningDatabase::GetSizeBucket(size_t N)
+{
+	unsigned int bucket = 0;
+	while (N > 1)
+	{
+		N /= 2;
+		bucket++;
+	}
+	return bucket;
+}
+
+string CTuningDatabase::GetKey(const string& Kernel, cl_device_id Device, size_t N)
+{
+	stringstream key;
+	key << Kernel << " / " << CLUtil::GetDeviceInfoString(Device, CL_DEVICE_NAME) << " / "
+		<< CLUtil::GetDeviceInfoString(Device, CL_DRIVER_VERSION) << " / 2^" << GetSizeBucket(N);
+	return key.str();
+}
+
+bool CTuningDatabase::Lookup(const string& Kernel, cl_device_id Device, size_t N, STuningConfig& Config)
+{
+	if (!s_bEnabled || s_bRetune)
+		return false;
+
+	string value;
+	if (!CKeyValueFile(s_FileName).Load(GetKey(Kernel, Device, N), value))
+		return false;
+
+	// local work size, elements per thread, vector width, unroll and time separated by tabs
+	STuningConfig config;
+	stringstream values(value);
+	values >> config.LocalWorkSize >> config.ElementsPerThread >> config.VectorWidth >> config.Unroll;
+
+	if (values.fail() || !IsValid(config, Device))
+		return false;
+
+	Config = config;
+	return true;
+}
+
+bool CTuningDatabase::IsValid(const STuningConfig& Config, cl_device_id Device)
+{
+	// the kernels only have vector paths for 1, 2 and 4 elements
+	if (Config.VectorWidth != 1 && Config.VectorWidth != 2 && Config.VectorWidth != 4)
+		return false;
+	if (Config.ElementsPerThread == 0 || Config.Unroll == 0)
+		return false;
+
+	// the tree reductions halve the work-group, so it has to be a power of two the device can launch
+	if (Config.LocalWorkSize == 0 || (Config.LocalWorkSize & (Config.LocalWorkSize - 1)) != 0)
+		return false;
+
+	size_t maxWorkGroupSize = 0;
+	if (clGetDeviceInfo(Device, CL_DEVICE_MAX_WORK_GROUP_SIZE, sizeof(size_t), &maxWorkGroupSize, NULL) != CL_SUCCESS)
+		return false;
+
+	return Config.LocalWorkSize <= maxWorkGroupSize;
+}
+
+void CTuningDatabase::Store(const string& Kernel, cl_device_id Device, size_t N, const STuningConfig& Config, double Milliseconds)
+{
+	if (!s_bEnabled)
+		return;
+
+	stringstream value;
+	value << Config.LocalWorkSize << '\t' << Config.ElementsPerThread << '\t' << Config.VectorWidth
+		<< '\t' << Config.Unroll << '\t' << Milliseconds;
+
+	if (!CKeyValueFile(s_FileName).Store(GetKey(Kernel, Device, N), value.str()))
+		cerr << "Could not write the tuning database " << s_FileName << endl;
+}
+
+///////////////////////////////////////////////////////////////////////////////
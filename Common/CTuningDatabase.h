@@ -0,0 +1,84 @@
+/******************************************************************************
+                         .88888.   888888ba  dP     dP 
+                        d8'   `88  88    `8b 88     88 
+                        88        a88aaaa8P' 88     88 
+                        88   YP88  88        88     88 
+                        Y8.   .88  88        Y8.   .8P 
+                         `88888'   dP        `Y88888P' 
+                                                       
+                                                       
+   a88888b.                                         dP   oo                   
+  d8'   `88                                         88                        
+  88        .d8888b. 88d8b.d8b. 88d888b. dP    dP d8888P dP 88d888b. .d8888b. 
+  88        88'  `88 88'`88'`88 88'  `88 88    88   88   88 88'  `88 88'  `88 
+  Y8.   .88 88.  .88 88  88  88 88.  .88 88.  .88   88   88 88    88 88.  .88 
+   Y88888P' `88888P' dP  dP  dP 88Y888P' `88888P'   dP   dP dP    dP `8888P88 
+                                88                                        .88 
+                                dP                                    d8888P  
+******************************************************************************/
+
+#ifndef _CTUNING_DATABASE_H
+#define _CTUNING_DATABASE_H
+
+#include "CLUtil.h"
+
+#include <string>
+
+//! Launch configuration of a kernel that CAutoTuner searches
+struct STuningConfig
+{
+	STuningConfig(size_t LocalWorkSize = 256, unsigned int ElementsPerThread = 1, unsigned int VectorWidth = 1, unsigned int Unroll = 1);
+
+	size_t			LocalWorkSize;
+	//! compile-time parameters, the kernel gets them as -D ELEMENTS_PER_THREAD, VECTOR_WIDTH and UNROLL
+	unsigned int	ElementsPerThread;
+	unsigned int	VectorWidth;
+	unsigned int	Unroll;
+
+	std::string GetCompileOptions() const;
+
+	//! e.g. "local 256, 4 elements/thread, vector width 2, unroll 1"
+	std::string ToString() const;
+};
+
+//! Best launch configurations per kernel, device and input size, persisted in a text file
+/*!
+	One CKeyValueFile line per entry: the kernel name, the device name, the driver version and
+	the input size bucket (floor(log2(N))) form the key, followed by the configuration and its time.
+	The tasks look up their configuration in StartProgramBuilds() and InitPrograms() and run
+	CAutoTuner if there is none. Entries the device cannot launch are ignored.
+*/
+class CTuningDatabase
+{
+public:
+	//! If disabled, Lookup() fails and the tasks keep their default configurations without tuning
+	static void SetEnabled(bool bEnabled) { s_bEnabled = bEnabled; }
+	static bool IsEnabled() { return s_bEnabled; }
+
+	//! If set, Lookup() ignores the stored entries, so every tunable kernel is tuned again
+	static void SetRetune(bool bRetune) { s_bRetune = bRetune; }
+
+	//! "TuningDatabase.txt" in the working directory by default
+	static void SetFileName(const std::string& FileName) { s_FileName = FileName; }
+
+	//! Best known configuration of Kernel on Device for inputs of about N elements
+	static bool Lookup(const std::string& Kernel, cl_device_id Device, size_t N, STuningConfig& Config);
+
+	//! Adds or replaces the entry, the entries of other kernels, devices and sizes are kept
+	static void Store(const std::string& Kernel, cl_device_id Device, size_t N, const STuningConfig& Config, double Milliseconds);
+
+	static unsigned int GetSizeBucket(size_t N);
+
+protected:
+
+	static std::string GetKey(const std::string& Kernel, cl_device_id Device, size_t N);
+
+	//! Vector width 1, 2 or 4 and a power-of-two local work size within the device limit
+	static bool IsValid(const STuningConfig& Config, cl_device_id Device);
+
+	static bool			s_bEnabled;
+	static bool			s_bRetune;
+	static std::string	s_FileName;
+};
+
+#endif // _CTUNING_DATABASE_H
@@ -45,7 +45,15 @@ public:
 	//! Init any resources specific to the current task
 	virtual bool InitResources(cl_device_id Device, cl_context Context) = 0;
 
-	//! Release everything allocated in InitResources()
+	//! Optional: queue the program builds InitPrograms() will need with CProgramBuilder,
+	//! so that they compile while earlier tasks run. InitPrograms() picks them up.
+	virtual void StartProgramBuilds(cl_device_id Device, cl_context Context) {}
+
+	//! Optional: build the programs and create the kernels and everything else that depends on them.
+	//! Runs after ComputeCPU(), so the CPU reference overlaps the background builds of this task.
+	virtual bool InitPrograms(cl_device_id Device, cl_context Context) { return true; }
+
+	//! Release everything allocated in InitResources() and InitPrograms()
 	virtual void ReleaseResources() = 0;
 
 	//! Perform calculations on the GPU
@@ -0,0 +1,74 @@
+# Embeds OpenCL kernel sources into an executable
+#
+# embed_kernels(OutputFile Sources...) adds a custom command that generates the C++ file OutputFile.
+# It holds every source as a byte array and registers them with CLUtil::RegisterEmbeddedSources
+# under their file names, so CLUtil::LoadProgramSourceToMemory needs no file access.
+# Add OutputFile to the sources of the executable; it is regenerated whenever a kernel changes.
+#
+# The generation runs this file in script mode with EMBED_KERNELS_OUTPUT and EMBED_KERNELS_SOURCES set.
+
+if (EMBED_KERNELS_OUTPUT)
+
+	# script mode: the list separator is passed as | to survive the command line
+	string(REPLACE "|" ";" sources "${EMBED_KERNELS_SOURCES}")
+
+	set(arrays "")
+	set(table "")
+	set(index 0)
+	foreach(source ${sources})
+		get_filename_component(name "${source}" NAME)
+		file(READ "${source}" hex HEX)
+		string(LENGTH "${hex}" hexLength)
+		math(EXPR size "${hexLength} / 2")
+
+		# 0x.., per byte, 16 bytes per line
+		set(bytes "")
+		set(offset 0)
+		while (offset LESS hexLength)
+			math(EXPR lineLength "${hexLength} - ${offset}")
+			if (lineLength GREATER 32)
+				set(lineLength 32)
+			endif ()
+			string(SUBSTRING "${hex}" ${offset} ${lineLength} line)
+			string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," line "${line}")
+			set(bytes "${bytes}\t${line}\n")
+			math(EXPR offset "${offset} + 32")
+		endwhile ()
+
+		set(arrays "${arrays}// ${name}\nstatic const unsigned char c_Source${index}[] = {\n${bytes}\t0x00\n};\n\n")
+		set(table "${table}\t{ \"${name}\", (const char*)c_Source${index}, ${size} },\n")
+		math(EXPR index "${index} + 1")
+	endforeach()
+
+	file(WRITE "${EMBED_KERNELS_OUTPUT}"
+		"// Generated by cmake/EmbedKernels.cmake from the kernel sources, do not edit.\n\n"
+		"#include \"CLUtil.h\"\n\n"
+		"${arrays}"
+		"static const CLUtil::SEmbeddedSource c_EmbeddedSources[] = {\n${table}};\n\n"
+		"// registers the sources before main() runs\n"
+		"static struct SRegisterEmbeddedSources\n{\n"
+		"\tSRegisterEmbeddedSources() { CLUtil::RegisterEmbeddedSources(c_EmbeddedSources, ARRAYLEN(c_EmbeddedSources)); }\n"
+		"} s_RegisterEmbeddedSources;\n")
+
+else (EMBED_KERNELS_OUTPUT)
+
+	set(EMBED_KERNELS_SCRIPT "${CMAKE_CURRENT_LIST_FILE}")
+
+	function(embed_kernels OutputFile)
+		set(sources "")
+		foreach(source ${ARGN})
+			get_filename_component(path "${source}" ABSOLUTE)
+			list(APPEND sources "${path}")
+		endforeach()
+		string(REPLACE ";" "|" sourceList "${sources}")
+
+		add_custom_command(
+			OUTPUT ${OutputFile}
+			COMMAND ${CMAKE_COMMAND} "-DEMBED_KERNELS_OUTPUT=${OutputFile}" "-DEMBED_KERNELS_SOURCES=${sourceList}" -P "${EMBED_KERNELS_SCRIPT}"
+			DEPENDS ${sources} "${EMBED_KERNELS_SCRIPT}"
+			COMMENT "Embedding OpenCL kernel sources"
+			VERBATIM
+			)
+	endfunction()
+
+endif (EMBED_KERNELS_OUTPUT)